@@ -64,6 +64,12 @@ bool hal_fib_is_route_ready (int if_index);
 
 dn_hal_route_err hal_fib_set_ecmp_max_paths (uint32_t max_ecmp_paths);
 
+void hal_fib_set_ecmp_native_weight (bool is_native_weight);
+
+void hal_fib_set_ecmp_resilient_hash (bool is_resilient_hash);
+
+dn_hal_route_err hal_fib_set_ecmp_resilient_buckets (uint32_t num_buckets);
+
 dn_hal_route_err hal_fib_proc_egr_index_map (char *);
 
 dn_hal_route_err hal_fib_get_cam_string (int pefix_len, uint8_t af_index, uint8_t is_host_add, uint8_t *p_str);
@@ -82,6 +88,12 @@ dn_hal_route_err hal_fib_ecmp_route_add_un_supp_mask (uint32_t vrf_id, t_fib_dr
 
 bool hal_fib_is_route_really_ecmp (t_fib_dr *p_dr, bool *p_out_is_cpu_route);
 
+t_std_error hal_fib_nh_indirect_grp_update (t_fib_nh *p_nh);
+
+t_fib_nh *hal_fib_get_indirect_nh (t_fib_dr *p_dr);
+
+dn_hal_route_err hal_fib_indirect_route_add (uint32_t vrf_id, t_fib_dr *p_dr, t_fib_nh *p_nh);
+
 int hal_fib_set_all_dr_fh_to_un_written (t_fib_dr *p_dr);
 
 dn_hal_route_err _hal_fib_host_add (uint32_t vrf_id, t_fib_nh *p_fh);
@@ -100,4 +112,68 @@ t_std_error hal_form_nbr_entry(ndi_neighbor_t *p_nbr_entry, t_fib_nh *p_nh);
 
 dn_hal_route_err hal_fib_next_hop_del(t_fib_nh *p_nh);
 
+void hal_rt_route_bulk_begin (uint8_t af_index);
+
+void hal_rt_route_bulk_end (uint8_t af_index);
+
+void hal_rt_route_bulk_flush (uint8_t af_index);
+
+void hal_rt_route_bulk_wait (uint8_t af_index);
+
+void hal_rt_route_bulk_sync_dr (t_fib_dr *p_dr);
+
+t_std_error hal_rt_route_ndi_add (ndi_route_t *p_route_entry, t_fib_dr *p_dr,
+                                  bool is_rif_update, hal_ifindex_t if_index);
+
+t_std_error hal_rt_route_ndi_set (ndi_route_t *p_route_entry, t_fib_dr *p_dr,
+                                  bool is_rif_update, hal_ifindex_t if_index);
+
+void hal_rt_nbr_bulk_begin (uint8_t af_index);
+
+void hal_rt_nbr_bulk_end (uint8_t af_index);
+
+void hal_rt_nbr_bulk_flush (uint8_t af_index);
+
+void hal_rt_nbr_bulk_wait (uint8_t af_index);
+
+void hal_rt_nbr_bulk_sync_nh (t_fib_nh *p_fh, npu_id_t unit);
+
+t_std_error hal_rt_nbr_ndi_add (ndi_neighbor_t *p_nbr_entry, uint32_t vrf_id, t_fib_nh *p_fh);
+
+void hal_rt_nbr_ndi_del (ndi_neighbor_t *p_nbr_entry, uint32_t vrf_id, t_fib_nh *p_fh);
+
+bool hal_rt_route_shadow_is_same (t_fib_dr *p_dr, ndi_route_t *p_route_entry);
+
+bool hal_rt_route_shadow_is_nh_same (t_fib_dr *p_dr, ndi_route_t *p_route_entry);
+
+void hal_rt_route_shadow_set (t_fib_dr *p_dr, ndi_route_t *p_route_entry);
+
+void hal_rt_route_shadow_clear (t_fib_dr *p_dr, npu_id_t unit);
+
+bool hal_rt_nbr_shadow_is_same (t_fib_nh *p_fh, ndi_neighbor_t *p_nbr_entry);
+
+void hal_rt_nbr_shadow_set (t_fib_nh *p_fh, ndi_neighbor_t *p_nbr_entry);
+
+void hal_rt_nbr_shadow_clear (t_fib_nh *p_fh, npu_id_t unit);
+
+t_std_error hal_rt_nh_obj_init (void);
+
+next_hop_id_t hal_rt_nh_obj_id_get (t_fib_nh *p_fh, npu_id_t unit);
+
+std_dll_head *hal_rt_nh_obj_mp_obj_list (npu_id_t unit, next_hop_id_t nh_handle);
+
+void hal_rt_nh_obj_mp_obj_unlinked (npu_id_t unit, next_hop_id_t nh_handle);
+
+t_std_error hal_rt_nh_obj_get (t_fib_nh *p_fh, npu_id_t unit, next_hop_id_t *p_nh_handle);
+
+void hal_rt_nh_obj_create_bulk (t_fib_nh *ap_fh [], uint32_t count, npu_id_t unit);
+
+void hal_rt_nh_obj_ref (npu_id_t unit, next_hop_id_t nh_handle);
+
+void hal_rt_nh_obj_unref (npu_id_t unit, next_hop_id_t nh_handle);
+
+t_std_error hal_rt_nh_obj_delete (t_fib_nh *p_fh);
+
+void hal_rt_nh_obj_free (t_fib_nh *p_fh);
+
 #endif /* __HAL_RT_API_H__ */
@@ -92,6 +92,40 @@ void fib_dump_all_vrf_cntrs (void);
 
 void fib_dump_all_cntrs (void);
 
+void fib_dump_ecmp_grp_stats_per_vrf_per_af (uint32_t vrf_id, uint32_t af_index, uint32_t top_n);
+
+void fib_dump_all_ecmp_grp_stats (uint32_t top_n);
+
+void fib_dump_route_bulk_stats (void);
+
+void fib_dump_nbr_bulk_stats (void);
+
+void fib_dump_npu_worker_stats (void);
+
+void fib_dump_pgm_stats (void);
+
+void fib_dump_nbr_queue_stats (void);
+
+void fib_dump_shadow_stats (void);
+
+void fib_dump_nh_obj_stats (void);
+
+void fib_dump_cam_stats (void);
+
+void fib_dump_retry_stats (void);
+
+void fib_dump_audit_stats (void);
+
+void fib_start_audit (void);
+
+void fib_dump_lock_stats (void);
+
+void fib_set_lock_prof (int is_enabled);
+
+void fib_dump_thread_config (void);
+
+void fib_set_thread_sched (uint32_t thread, uint32_t cpu_mask, int policy, int priority);
+
 void fib_dump_all_db (void);
 
 void fib_dbg_clear_global_cntrs (void);
@@ -30,7 +30,10 @@
 #include "nas_ndi_router_interface.h"
 #include "std_llist.h"
 #include "std_mutex_lock.h"
+#include "std_thread_tools.h"
 
+#include <pthread.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <sys/socket.h>
 #include <stdint.h>
@@ -40,11 +43,19 @@
 #define HAL_RT_V6_ADDR_LEN                HAL_INET6_LEN
 #define HAL_RT_V4_AFINDEX                 HAL_INET4_FAMILY
 #define HAL_RT_V6_AFINDEX                 HAL_INET6_FAMILY
-#define HAL_RT_MAX_INSTANCE               1
+/* Max NPUs programmed, the per NPU state of the routes and NHs is sized by it */
+#define HAL_RT_MAX_INSTANCE               4
 #define HAL_RT_V4_PREFIX_LEN              (8 * HAL_INET4_LEN)
 #define HAL_RT_V6_PREFIX_LEN              (8 * HAL_INET6_LEN)
 #define HAL_RT_DEF_MAX_ECMP_PATH          16   /* Default Maximum supported ECMP paths per Group */
-#define HAL_RT_MAX_ECMP_PATH              64   /* Maximum supported ECMP paths per Group */
+/*
+ * Maximum supported ECMP paths per Group, the configured ECMP width
+ * (ecmp_max_paths) is limited by this. It can be raised at build time
+ * upto the member list size of the NDI next-hop group.
+ */
+#ifndef HAL_RT_MAX_ECMP_PATH
+#define HAL_RT_MAX_ECMP_PATH              64
+#endif
 #define MAX_LEN_VRF_NAME                  32
 #define FIB_MIN_AFINDEX                   HAL_RT_V4_AFINDEX
 #define FIB_MAX_AFINDEX                   (HAL_RT_V6_AFINDEX + 1)
@@ -93,6 +104,7 @@ typedef hal_ip_addr_t t_fib_ip_addr;
 typedef struct _t_fib_audit_host_key {
     hal_vrf_id_t  vrf_id;
     t_fib_ip_addr ip_addr;
+    uint32_t      if_index;
 } t_fib_audit_host_key;
 
 typedef struct _t_fib_audit_cfg {
@@ -120,14 +132,96 @@ typedef struct _t_fib_link_node {
     void    *self;
 } t_fib_link_node;
 
+/*
+ * Route programming when the ECMP group table is full
+ */
+#define HAL_RT_ECMP_GRP_SHARE_NONE        0 /* Single path through the first NH */
+#define HAL_RT_ECMP_GRP_SHARE_SUBSET      1 /* Share a group with a subset of the paths */
+#define HAL_RT_ECMP_GRP_SHARE_SUPERSET    2 /* Else share a group with extra paths too */
+
+/*
+ * Routes programmed by the DR walker are written to the NPU in batches
+ * of route_bulk_size routes, 0 or 1 - one route at a time.
+ */
+#define HAL_RT_ROUTE_BULK_DEFAULT_SIZE    64
+#define HAL_RT_ROUTE_BULK_MAX_SIZE        512
+
+/*
+ * Neighbors programmed by the NH walker are written to the NPU in batches
+ * of nbr_bulk_size neighbors, 0 or 1 - one neighbor at a time.
+ */
+#define HAL_RT_NBR_BULK_DEFAULT_SIZE      64
+#define HAL_RT_NBR_BULK_MAX_SIZE          512
+
+/* Table occupancy thresholds, percent of the table capacity */
+#define HAL_RT_CAM_DEF_HIGH_THRESHOLD     90
+#define HAL_RT_CAM_DEF_LOW_THRESHOLD      80
+
+/* Threads of the CPS operation handler, the GETs and SETs run in parallel */
+#define HAL_RT_CPS_DEF_NUM_THREADS        1
+#define HAL_RT_CPS_MAX_NUM_THREADS        16
+
+/*
+ * Routing threads. Each kind has a name, the CPUs it runs on and the
+ * scheduling policy, read from NAS_RT_THREAD_<KIND> at init, e.g.
+ * NAS_RT_THREAD_DR="name=rt-dr,cpus=0xc,policy=rr,prio=10". The CPS handler
+ * threads are created by the CPS thread and take its settings.
+ */
+typedef enum {
+    HAL_RT_THREAD_MAIN = 0,
+    HAL_RT_THREAD_DR,
+    HAL_RT_THREAD_NH,
+    HAL_RT_THREAD_CPS,
+    HAL_RT_THREAD_PGM,
+    HAL_RT_THREAD_NPU,
+    HAL_RT_THREAD_AUDIT,
+    HAL_RT_THREAD_NBR_RX,
+    HAL_RT_THREAD_NBR,
+    HAL_RT_THREAD_MAX,
+} t_hal_rt_thread;
+
+#define HAL_RT_THREAD_NAME_LEN            16     /* With the NUL, as pthread names */
+#define HAL_RT_THREAD_MAX_RUNNING         (HAL_RT_THREAD_MAX + HAL_RT_MAX_INSTANCE)
+
+typedef struct _t_hal_rt_thread_config {
+    char      name [HAL_RT_THREAD_NAME_LEN];
+    uint64_t  cpu_mask;  /* CPUs 0-63 the thread runs on, 0 - not changed */
+    int       policy;    /* SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+    int       priority;  /* Priority for SCHED_FIFO/RR, nice value for SCHED_OTHER */
+    bool      is_sched_set; /* policy and priority configured, else those of the process */
+} t_hal_rt_thread_config;
+
 typedef struct _t_fib_config {
     uint32_t         max_num_npu;
     uint32_t         ecmp_max_paths;
     uint32_t         hw_ecmp_max_paths;
     bool             ecmp_path_fall_back;
     uint8_t          ecmp_hash_sel;
+    bool             ecmp_grp_incr_update; /* Add/remove members of a non-shared group in place */
+    bool             ecmp_nh_fast_reroute; /* Remove a failed NH from all groups on NH failure */
+    bool             hierarchical_fib; /* Recursive routes point to the indirect group of the NH */
+    bool             ecmp_native_weight; /* NPU supports weighted group members, else replicate */
+    bool             ecmp_resilient_hash; /* Groups are programmed as a fixed size bucket table */
+    uint32_t         ecmp_resilient_buckets; /* Number of buckets of a resilient group */
+    uint32_t         ecmp_grp_gc_grace_period; /* Secs an unused group is parked, 0 - delete now */
+    uint32_t         ecmp_grp_max;       /* Group table capacity, 0 - learnt from NDI */
+    uint32_t         ecmp_grp_share_policy; /* HAL_RT_ECMP_GRP_SHARE_XXX */
+    uint32_t         route_bulk_size;    /* Routes per bulk NDI call from the DR walker */
+    uint32_t         nbr_bulk_size;      /* Neighbors per bulk NDI call from the NH walker */
+    bool             ndi_async_pgm;      /* Walker batches are written by the programming thread */
+    uint32_t         cam_high_threshold; /* Percent of a table in use to raise the high event */
+    uint32_t         cam_low_threshold;  /* Percent of a table in use to clear the high event */
+    uint32_t         cps_num_threads;    /* Threads of the CPS operation handler */
+    t_hal_rt_thread_config a_thread [HAL_RT_THREAD_MAX];
 } t_fib_config;
 
+/* ECMP width in use, the configured max paths limited by the NPU max paths */
+#define HAL_RT_ECMP_MAX_PATHS()                                              \
+        (((hal_rt_access_fib_config())->ecmp_max_paths <                     \
+          (hal_rt_access_fib_config())->hw_ecmp_max_paths) ?                 \
+         (hal_rt_access_fib_config())->ecmp_max_paths :                      \
+         (hal_rt_access_fib_config())->hw_ecmp_max_paths)
+
 typedef struct _t_fib_tnl_key {
     hal_ifindex_t if_index;
     hal_vrf_id_t  vrf_id;
@@ -150,6 +244,7 @@ typedef struct _t_fib_nh_msg_info {
     hal_vrf_id_t   vrf_id;
     t_fib_ip_addr  ip_addr;
     hal_ifindex_t  if_index;
+    uint32_t       weight;
 } t_fib_nh_msg_info;
 
 typedef struct _t_fib_arp_msg_info {
@@ -208,6 +303,7 @@ typedef struct _t_fib_vrf_info {
     std_radix_version_t dr_ha_max_radix_ver;
     std_radix_version_t nh_ha_max_radix_ver;
     t_fib_route_summary route_summary;
+    pthread_rwlock_t    rw_lock;  /* Guards the DR and NH trees of the AF */
 } t_fib_vrf_info;
 
 typedef struct _t_fib_vrf_cntrs {
@@ -226,8 +322,35 @@ typedef struct _t_fib_vrf_cntrs {
     uint32_t  num_fib_route_entries;
     uint32_t  num_cam_host_entries;
     uint32_t  num_cam_route_entries;
+    uint32_t  num_ecmp_grp_parked;
+    uint32_t  num_ecmp_grp_reused;
+    uint32_t  num_ecmp_grp_freed;
+    uint32_t  num_ecmp_grp_created;
+    uint32_t  num_ecmp_grp_replaced;
+    uint32_t  num_ecmp_grp_deleted;
 } t_fib_vrf_cntrs;
 
+/*
+ * The VRF counters are kept in per thread shards, a thread updates only its
+ * shard and a read adds up the shards. The threads after the first
+ * HAL_RT_CNTRS_MAX_SHARDS - 1 share the last shard, the updates are atomic
+ * for it.
+ */
+#define HAL_RT_CNTRS_MAX_SHARDS            8
+#define HAL_RT_CNTRS_RATE_INTERVAL         1000   /* msecs */
+
+typedef struct _t_fib_vrf_cntrs_shard {
+    t_fib_vrf_cntrs  cntrs [FIB_MAX_AFINDEX];
+} __attribute__ ((aligned (64))) t_fib_vrf_cntrs_shard;
+
+/* Per second rates of the counters, over the interval between two reads */
+typedef struct _t_fib_vrf_cntrs_rate {
+    uint32_t  route_add_rate;
+    uint32_t  route_del_rate;
+    uint32_t  nbr_add_rate;
+    uint32_t  nbr_del_rate;
+} t_fib_vrf_cntrs_rate;
+
 typedef struct _t_peer_routing_config {
     ndi_vrf_id_t     obj_id; /* NDI handle */
     uint8_t          peer_mac_addr [HAL_RT_MAC_ADDR_LEN];
@@ -238,7 +361,7 @@ typedef struct _t_fib_vrf {
     hal_vrf_id_t     vrf_id;
     ndi_vrf_id_t     vrf_obj_id;
     t_fib_vrf_info   info [FIB_MAX_AFINDEX];
-    t_fib_vrf_cntrs  cntrs [FIB_MAX_AFINDEX];
+    t_fib_vrf_cntrs_shard  a_cntrs_shard [HAL_RT_CNTRS_MAX_SHARDS];
     t_peer_routing_config peer_routing_config[HAL_RT_MAX_PEER_ENTRY];
 } t_fib_vrf;
 
@@ -328,119 +451,138 @@ typedef enum _t_fib_cmp_result {
 #define FIB_GET_ROUTE_SUMMARY(_vrf_id, _af_index)                            \
         (&((hal_rt_access_fib_vrf_info(_vrf_id, _af_index))->route_summary))
 
+#define FIB_CNTRS_ADD(_cntr, _val)                                       \
+        ((void) __atomic_fetch_add (&(_cntr), (uint32_t) (_val), __ATOMIC_RELAXED))
+
+#define FIB_CNTRS_INCR(_vrf_id, _af_index, _cntr)                        \
+        FIB_CNTRS_ADD ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->_cntr, 1)
+
+#define FIB_CNTRS_DECR(_vrf_id, _af_index, _cntr)                        \
+        FIB_CNTRS_ADD ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->_cntr, -1)
+
+/* The sum of the shards */
+#define FIB_CNTRS_GET(_vrf_id, _af_index, _cntr)                         \
+        (hal_rt_fib_vrf_cntr_get(_vrf_id, _af_index, offsetof (t_fib_vrf_cntrs, _cntr)))
+
 #define FIB_INCR_CNTRS_ROUTE_ADD(_vrf_id, _af_index)                     \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_route_add)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_route_add)
 
 #define FIB_INCR_CNTRS_ROUTE_DEL(_vrf_id, _af_index)                     \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_route_del)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_route_del)
 
 #define FIB_INCR_CNTRS_VRF_ADD(_vrf_id, _af_index)                       \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_vrf_add)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_vrf_add)
 
 #define FIB_INCR_CNTRS_VRF_DEL(_vrf_id, _af_index)                       \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_vrf_del)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_vrf_del)
 
 #define FIB_INCR_CNTRS_ROUTE_CLR(_vrf_id, _af_index)                     \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_route_clear)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_route_clear)
 
 #define FIB_INCR_CNTRS_UNKNOWN_MSG(_vrf_id, _af_index)                   \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_unknown_msg)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_unknown_msg)
 
 #define FIB_INCR_CNTRS_NBR_ADD(_vrf_id, _af_index)                          \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_add)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_nbr_add)
 
 #define FIB_INCR_CNTRS_NBR_DEL(_vrf_id, _af_index)                          \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_del)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_nbr_del)
 
 #define FIB_INCR_CNTRS_NBR_RESOLVING(_vrf_id, _af_index)                    \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_resolving)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_nbr_resolving)
 
 #define FIB_INCR_CNTRS_NBR_UNRSLVD(_vrf_id, _af_index)                      \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_un_rslvd)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_nbr_un_rslvd)
 
 #define FIB_INCR_CNTRS_NBR_VRF_DEL(_vrf_id, _af_index)                      \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_vrf_del)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_nbr_vrf_del)
 
 #define FIB_INCR_CNTRS_NBR_CLR(_vrf_id, _af_index)                          \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_clear)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_nbr_clear)
 
 #define FIB_INCR_CNTRS_FIB_HOST_ENTRIES(_vrf_id, _af_index)                  \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_fib_host_entries)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_fib_host_entries)
 
 #define FIB_INCR_CNTRS_FIB_ROUTE_ENTRIES(_vrf_id, _af_index)                 \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_fib_route_entries)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_fib_route_entries)
 
 #define FIB_INCR_CNTRS_CAM_HOST_ENTRIES(_vrf_id, _af_index)                  \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_cam_host_entries)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_cam_host_entries)
 
 #define FIB_INCR_CNTRS_CAM_ROUTE_ENTRIES(_vrf_id, _af_index)                 \
-        (((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_cam_route_entries)++)
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_cam_route_entries)
+
+#define FIB_INCR_CNTRS_ECMP_GRP_PARKED(_vrf_id, _af_index)                  \
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_ecmp_grp_parked)
+
+#define FIB_INCR_CNTRS_ECMP_GRP_REUSED(_vrf_id, _af_index)                  \
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_ecmp_grp_reused)
+
+#define FIB_INCR_CNTRS_ECMP_GRP_FREED(_vrf_id, _af_index)                   \
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_ecmp_grp_freed)
+
+#define FIB_INCR_CNTRS_ECMP_GRP_CREATED(_vrf_id, _af_index)                 \
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_ecmp_grp_created)
+
+#define FIB_INCR_CNTRS_ECMP_GRP_REPLACED(_vrf_id, _af_index)                \
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_ecmp_grp_replaced)
+
+#define FIB_INCR_CNTRS_ECMP_GRP_DELETED(_vrf_id, _af_index)                 \
+        FIB_CNTRS_INCR (_vrf_id, _af_index, num_ecmp_grp_deleted)
 
 #define FIB_DECR_CNTRS_FIB_HOST_ENTRIES(_vrf_id, _af_index)                  \
-        if ((FIB_GET_CNTRS_FIB_HOST_ENTRIES ((_vrf_id), (_af_index))) > 0)   \
-        {                                                                  \
-            ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_fib_host_entries)--;   \
-        }
+        FIB_CNTRS_DECR (_vrf_id, _af_index, num_fib_host_entries)
 
 #define FIB_DECR_CNTRS_FIB_ROUTE_ENTRIES(_vrf_id, _af_index)                 \
-        if ((FIB_GET_CNTRS_FIB_ROUTE_ENTRIES ((_vrf_id), (_af_index))) > 0)  \
-        {                                                                  \
-            ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_fib_route_entries)--;  \
-        }
+        FIB_CNTRS_DECR (_vrf_id, _af_index, num_fib_route_entries)
 
 #define FIB_DECR_CNTRS_CAM_HOST_ENTRIES(_vrf_id, _af_index)                  \
-        if ((FIB_GET_CNTRS_CAM_HOST_ENTRIES ((_vrf_id), (_af_index))) > 0)   \
-        {                                                                  \
-            ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_cam_host_entries)--;   \
-        }
+        FIB_CNTRS_DECR (_vrf_id, _af_index, num_cam_host_entries)
 
 #define FIB_DECR_CNTRS_CAM_ROUTE_ENTRIES(_vrf_id, _af_index)                 \
-        if ((FIB_GET_CNTRS_CAM_ROUTE_ENTRIES ((_vrf_id), (_af_index))) > 0)  \
-        {                                                                  \
-            ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_cam_route_entries)--;  \
-        }
+        FIB_CNTRS_DECR (_vrf_id, _af_index, num_cam_route_entries)
 
 #define FIB_GET_CNTRS_ROUTE_ADD(_vrf_id, _af_index)                      \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_route_add)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_route_add)
 
 #define FIB_GET_CNTRS_ROUTE_DEL(_vrf_id, _af_index)                      \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_route_del)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_route_del)
 
 #define FIB_GET_CNTRS_VRF_ADD(_vrf_id, _af_index)                        \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_vrf_add)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_vrf_add)
 
 #define FIB_GET_CNTRS_VRF_DEL(_vrf_id, _af_index)                        \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_vrf_del)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_vrf_del)
 
 #define FIB_GET_CNTRS_ROUTE_CLR(_vrf_id, _af_index)                      \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_route_clear)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_route_clear)
 
 #define FIB_GET_CNTRS_UNKNOWN_MSG(_vrf_id, _af_index)                    \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_unknown_msg)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_unknown_msg)
 
 #define FIB_GET_CNTRS_NBR_ADD(_vrf_id, _af_index)                           \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_add)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_nbr_add)
 
 #define FIB_GET_CNTRS_NBR_DEL(_vrf_id, _af_index)                           \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_del)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_nbr_del)
 
 #define FIB_GET_CNTRS_NBR_UNRSLVD(_vrf_id, _af_index)                       \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_un_rslvd)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_nbr_un_rslvd)
 
 #define FIB_GET_CNTRS_NBR_CLR(_vrf_id, _af_index)                           \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_nbr_clear)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_nbr_clear)
 
 #define FIB_GET_CNTRS_FIB_HOST_ENTRIES(_vrf_id, _af_index)                   \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_fib_host_entries)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_fib_host_entries)
 
 #define FIB_GET_CNTRS_FIB_ROUTE_ENTRIES(_vrf_id, _af_index)                  \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_fib_route_entries)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_fib_route_entries)
 
 #define FIB_GET_CNTRS_CAM_HOST_ENTRIES(_vrf_id, _af_index)                   \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_cam_host_entries)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_cam_host_entries)
 
 #define FIB_GET_CNTRS_CAM_ROUTE_ENTRIES(_vrf_id, _af_index)                  \
-        ((hal_rt_access_fib_vrf_cntrs(_vrf_id, _af_index))->num_cam_route_entries)
+        FIB_CNTRS_GET (_vrf_id, _af_index, num_cam_route_entries)
 
 /*
  * Function Prototypes
@@ -462,18 +604,96 @@ t_fib_vrf * hal_rt_access_fib_vrf(uint32_t vrf_id);
 
 t_fib_vrf_info * hal_rt_access_fib_vrf_info(uint32_t vrf_id, uint8_t af_index);
 
+/* The counters of the calling thread, to be updated with FIB_CNTRS_ADD */
 t_fib_vrf_cntrs * hal_rt_access_fib_vrf_cntrs(uint32_t vrf_id, uint8_t af_index);
 
+uint32_t hal_rt_fib_vrf_cntr_get(uint32_t vrf_id, uint8_t af_index, size_t offset);
+
+void hal_rt_fib_vrf_cntrs_get(uint32_t vrf_id, uint8_t af_index, t_fib_vrf_cntrs *p_cntrs);
+
+void hal_rt_fib_vrf_cntrs_clear(uint32_t vrf_id, uint8_t af_index);
+
+void hal_rt_fib_vrf_cntrs_rate_get(uint32_t vrf_id, uint8_t af_index,
+                                   t_fib_vrf_cntrs_rate *p_rate);
+
 std_rt_table * hal_rt_access_fib_vrf_dr_tree(uint32_t vrf_id, uint8_t af_index);
 
 std_rt_table * hal_rt_access_fib_vrf_nh_tree(uint32_t vrf_id, uint8_t af_index);
 
 std_rt_table * hal_rt_access_intf_tree(void);
 
+t_std_error hal_rt_thread_create (std_thread_create_param_t *p_thr, t_hal_rt_thread thread,
+                                  std_thread_function_t thread_function, void *param);
+
+t_std_error hal_rt_thread_set_sched (t_hal_rt_thread thread, uint64_t cpu_mask,
+                                     int policy, int priority);
+
+const char *hal_rt_thread_kind_name (t_hal_rt_thread thread);
+
+/* Callers of the L3 locks, the lock profiler counts per site */
+typedef enum {
+    HAL_RT_LOCK_SITE_OTHER = 0,
+    HAL_RT_LOCK_SITE_ROUTE_INGEST,
+    HAL_RT_LOCK_SITE_NBR_INGEST,
+    HAL_RT_LOCK_SITE_DR_WALKER,
+    HAL_RT_LOCK_SITE_NH_WALKER,
+    HAL_RT_LOCK_SITE_AUDIT,
+    HAL_RT_LOCK_SITE_CPS_GET,
+    HAL_RT_LOCK_SITE_PEER_CONFIG,
+    HAL_RT_LOCK_SITE_MAX,
+} t_hal_rt_lock_site;
+
 void nas_l3_lock();
 
 void nas_l3_unlock();
 
+void nas_l3_lock_at (t_hal_rt_lock_site site);
+
+void nas_l3_lock_af_at (uint8_t af_index, t_hal_rt_lock_site site);
+
+void nas_l3_unlock_af (uint8_t af_index);
+
+void hal_rt_vrf_read_lock (uint32_t vrf_id, uint8_t af_index);
+
+void hal_rt_vrf_write_lock (uint32_t vrf_id, uint8_t af_index);
+
+void hal_rt_vrf_unlock (uint32_t vrf_id, uint8_t af_index);
+
+void hal_rt_vrf_write_lock_all (void);
+
+void hal_rt_vrf_unlock_all (void);
+
+void hal_rt_af_write_lock (uint8_t af_index);
+
+void hal_rt_af_unlock (uint8_t af_index);
+
+void hal_rt_intf_lock (void);
+
+void hal_rt_intf_unlock (void);
+
+typedef void (*t_hal_rt_npu_job_fn) (npu_id_t unit, void *p_arg);
+
+t_std_error hal_rt_npu_worker_init (void);
+
+void hal_rt_npu_run_all (t_hal_rt_npu_job_fn job_fn, void *p_arg);
+
+/* A job of the programming thread, run for all the NPUs */
+typedef struct _t_hal_rt_pgm_job {
+    t_hal_rt_npu_job_fn  job_fn;
+    void                *p_arg;
+    bool                 is_pending;   /* Submitted and not done yet */
+} t_hal_rt_pgm_job;
+
+t_std_error hal_rt_pgm_init (void);
+
+void hal_rt_pgm_submit (t_hal_rt_pgm_job *p_job);
+
+bool hal_rt_pgm_is_pending (t_hal_rt_pgm_job *p_job);
+
+void hal_rt_pgm_wait (t_hal_rt_pgm_job *p_job);
+
+t_std_error hal_rt_nbr_queue_init (void);
+
 int hal_rt_process_peer_routing_config (uint32_t vrf_id, t_peer_routing_config *p_status);
 
 #endif /* __HAL_RT_MAIN_H__ */
@@ -36,7 +36,10 @@
 #define FIB_DR_MEM_MALLOC()            (t_fib_dr *)FIB_MALLOC(sizeof (t_fib_dr))
 #define FIB_DR_MEM_FREE(_p_)           FIB_FREE(_p_)
 
-#define FIB_NH_MEM_MALLOC()            (t_fib_nh *)FIB_MALLOC(sizeof (t_fib_nh))
+#define FIB_NH_MEM_SIZE()              (sizeof (t_fib_nh) +                             \
+                                        ((hal_rt_access_fib_config())->max_num_npu *    \
+                                         sizeof (t_fib_nbr_shadow)))
+#define FIB_NH_MEM_MALLOC()            (t_fib_nh *)FIB_MALLOC(FIB_NH_MEM_SIZE())
 #define FIB_NH_MEM_FREE(_p_)           FIB_FREE(_p_)
 
 #define FIB_DR_NH_TLV_MEM_MALLOC()     (t_fib_dr_nh *)FIB_MALLOC(sizeof (t_fib_dr_nh))
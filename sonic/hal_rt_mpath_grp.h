@@ -25,6 +25,7 @@
 #define __HAL_RT_MPATH_GROUP_H__
 
 #include <stdint.h>
+#include <time.h>
 
 #include "hal_rt_route.h"
 #include "std_radix.h"
@@ -39,8 +40,14 @@ typedef struct _t_fib_nh_obj {
     uint32_t            flags;
     uint32_t            ref_count;
     next_hop_id_t       sai_nh_id;
+    hal_vrf_id_t        vrf_id;         /* VRF and interface of the RIF reference */
+    hal_ifindex_t       if_index;
+    std_dll_head        mp_obj_list;    /* Each node is of type 't_fib_mp_obj_link' */
 } t_fib_nh_obj;
 
+/* The FH was freed, the object is deleted when its last route or group reference goes */
+#define FIB_NH_OBJ_FLAG_ORPHAN            0x1
+
 #define HAL_RT_MD5_DIGEST_LEN             16
 #define HAL_RT_3_SPACE_INDENT "  "
 #define HAL_RT_17_SPACE_INDENT "                 "
@@ -64,16 +71,106 @@ typedef struct _t_fib_mp_md5_node {
 } t_fib_mp_md5_node;
 
 
+/*
+ * Member storage size classes of the multipath object. The member arrays
+ * are allocated along with the object for the smallest class that fits
+ * the group, so the small groups are compact. The last class is
+ * HAL_RT_MAX_ECMP_PATH, the NDI member list capacity.
+ */
+#define HAL_RT_MP_OBJ_SIZE_CLASSES        {2, 4, 8, 16, HAL_RT_MAX_ECMP_PATH}
+
+/*
+ * Deferred reclamation of the groups that are no longer used by any route.
+ * Such a group is parked for the grace period (secs) so that it can be
+ * reused if the same member set comes back, then deleted from the hardware
+ * by the DR walker in batches of HAL_RT_MP_OBJ_GC_BATCH groups.
+ */
+#define HAL_RT_MP_OBJ_GC_GRACE_PERIOD     5
+#define HAL_RT_MP_OBJ_GC_BATCH            16
+
 typedef struct _t_fib_mp_obj {
     std_dll             glue;
     npu_id_t            unit;
     int                 ecmp_count;
-    next_hop_id_t       a_nh_obj_id [HAL_RT_MAX_ECMP_PATH];
+    int                 max_ecmp_count; /* Member capacity of the size class */
+    bool                is_resilient;   /* Members are the buckets of a resilient group */
+    bool                is_parked;      /* Unused, waiting for reuse or deletion */
+    std_dll             gc_glue;        /* Node in the parked group list */
+    time_t              park_time;
+    uint32_t            vrf_id;
+    uint8_t             af_index;
+    struct _t_fib_mp_obj_link *a_link;  /* Member storage follows the object */
+    next_hop_id_t       *a_nh_obj_id;
+    uint32_t            *a_nh_weight;   /* WECMP weight of each member */
     next_hop_id_t       sai_ecmp_gid;
     t_fib_mp_md5_node   *p_md5_node;
     uint32_t            ref_count;
 } t_fib_mp_obj;
 
+/*
+ * Back reference from a next hop object to a multipath object using it,
+ * one per distinct member of the multipath object. The fast reroute finds
+ * the groups of a failed next hop from the list of its next hop object.
+ */
+typedef struct _t_fib_mp_obj_link {
+    std_dll             glue;
+    std_dll_head        *p_list;        /* List of the next hop object, NULL if not linked */
+    t_fib_mp_obj        *p_mp_obj;
+} t_fib_mp_obj_link;
+
+/*
+ * ECMP group table pressure
+ */
+typedef struct _t_fib_ecmp_grp_pressure {
+    uint32_t  num_grps_in_use;     /* Of the unit with the least free groups */
+    uint32_t  grp_capacity;        /* 0 - Not known yet */
+    uint32_t  a_num_grps_in_use [HAL_RT_MAX_INSTANCE];
+    uint32_t  a_grp_capacity [HAL_RT_MAX_INSTANCE];
+    uint32_t  num_degraded_routes; /* Routes on a shared group or single path */
+    uint32_t  num_table_full;
+    uint32_t  num_shared;
+    uint32_t  num_upgraded;
+    bool      is_grp_freed;        /* A group is freed after the table got full */
+} t_fib_ecmp_grp_pressure;
+
+/*
+ * ECMP group statistics of a VRF/AF. The histogram bucket i counts the
+ * values up to 2^(i-1) (bucket 0 - value 0, 1 - value 1, 2 - value 2,
+ * 3 - values 3-4, 4 - values 5-8 ...), the last bucket counts the rest.
+ */
+#define HAL_RT_ECMP_GRP_HIST_BUCKETS      12
+#define HAL_RT_ECMP_GRP_STATS_MAX_TOP_N   16
+
+typedef struct _t_fib_ecmp_grp_top {
+    uint32_t       vrf_id;
+    uint8_t        af_index;
+    npu_id_t       unit;
+    next_hop_id_t  sai_ecmp_gid;
+    int            ecmp_count;
+    uint32_t       ref_count;
+} t_fib_ecmp_grp_top;
+
+typedef struct _t_fib_ecmp_grp_stats {
+    uint32_t            num_grps;
+    uint32_t            a_num_grps [HAL_RT_MAX_INSTANCE]; /* Per NPU */
+    uint32_t            num_parked;
+    uint32_t            num_resilient;
+    uint32_t            num_md5_nodes;
+    uint32_t            num_collisions;     /* MD5 nodes with more than one group */
+    uint32_t            num_collided_grps;
+    uint32_t            a_width_hist [HAL_RT_ECMP_GRP_HIST_BUCKETS];
+    uint32_t            a_share_hist [HAL_RT_ECMP_GRP_HIST_BUCKETS]; /* Of ref_count */
+    uint32_t            num_top;
+    t_fib_ecmp_grp_top  a_top [HAL_RT_ECMP_GRP_STATS_MAX_TOP_N]; /* By ref_count */
+} t_fib_ecmp_grp_stats;
+
+/* Route as written to a NPU */
+typedef struct _t_fib_route_shadow {
+    uint8_t            is_valid;
+    uint32_t           action;
+    next_hop_id_t      nh_handle;
+} t_fib_route_shadow;
+
 typedef struct _t_fib_hal_dr_info {
     /*
      * Need to have 'a_obj_status' per unit, because, the route could change
@@ -83,11 +180,18 @@ typedef struct _t_fib_hal_dr_info {
      */
     t_fib_ecmp_status  a_obj_status [HAL_RT_MAX_INSTANCE];
     t_fib_mp_obj       *ap_mp_obj [HAL_RT_MAX_INSTANCE];
+    /*
+     * Hierarchical FIB: indirect group of the recursive NH,
+     * when the route is programmed to point to it.
+     */
+    t_fib_mp_obj       *ap_indirect_mp_obj [HAL_RT_MAX_INSTANCE];
+    /* Per unit, max_num_npu entries are allocated after the info */
+    t_fib_route_shadow  a_shadow [];
 } t_fib_hal_dr_info;
 
 typedef struct _t_fib_hal_nh_info {
     t_fib_nh_obj *ap_nh_obj [HAL_RT_MAX_INSTANCE];
-    t_fib_mp_obj  *ap_mp_obj [HAL_RT_MAX_INSTANCE];
+    t_fib_mp_obj  *ap_mp_obj [HAL_RT_MAX_INSTANCE]; /* Indirect group of a recursive NH */
 } t_fib_hal_nh_info;
 
 
@@ -114,23 +218,66 @@ t_std_error hal_rt_delete_ecmp_group(t_fib_dr *p_dr, ndi_route_t  *entry,
                                      next_hop_id_t gid_handle, bool route_delete);
 t_fib_mp_md5_node *hal_rt_fib_calloc_mp_md5_node (void);
 void hal_rt_fib_free_mp_md5_node (t_fib_mp_md5_node *p_mp_md5_node);
-t_fib_mp_obj *hal_rt_fib_calloc_mp_obj_node (void);
+t_fib_mp_obj *hal_rt_fib_calloc_mp_obj_node (npu_id_t unit, int ecmp_count);
 void hal_rt_fib_free_mp_obj_node (t_fib_mp_obj *p_mp_obj);
-void *fib_calloc_hal_nh_info_node (void);
-void fib_free_hal_nh_info_node (void *p_hal_nh_info);
+void *hal_rt_fib_calloc_hal_nh_info_node (void);
+void hal_rt_fib_free_hal_nh_info_node (void *p_hal_nh_info);
 t_fib_mp_obj *hal_rt_fib_get_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry, uint8_t *pu1_md5_digest,
-                        int ecmp_count, next_hop_id_t a_nh_obj_id[]);
+                        int ecmp_count, next_hop_id_t a_nh_obj_id[],
+                        uint32_t a_nh_weight[]);
 t_std_error hal_rt_fib_check_and_delete_mp_obj (t_fib_dr *p_dr, t_fib_mp_obj *p_mp_obj, npu_id_t  unit,
                                                 bool is_sai_del, bool route_delete);
 t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry, uint8_t *pu1_md5_digest,
                                  int ecmp_count, next_hop_id_t a_nh_obj_id [],
-                                 bool is_with_id, uint32_t sai_ecmp_gid,
+                                 uint32_t a_nh_weight [], bool is_with_id, uint32_t sai_ecmp_gid,
                                  bool *p_out_is_mp_table_full);
+t_std_error hal_rt_fib_update_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
+                                      t_fib_mp_obj *p_mp_obj, uint8_t *pu1_md5_digest,
+                                      int ecmp_count, next_hop_id_t a_nh_obj_id [],
+                                      uint32_t a_nh_weight []);
 void hal_rt_fib_form_md5_key (uint8_t t_md5_digest [], next_hop_id_t a_nh_obj_id [],
-                        uint32_t ecmp_count, uint32_t debug);
+                        uint32_t a_nh_weight [], uint32_t ecmp_count, uint32_t debug);
+int hal_rt_fib_apply_nh_weights (ndi_nh_group_t *entry);
+void hal_rt_fib_form_resilient_buckets (next_hop_id_t a_old_bucket [], int old_num_buckets,
+                                        next_hop_id_t a_member_id [], uint32_t a_member_weight [],
+                                        int num_members, next_hop_id_t a_bucket [],
+                                        int num_buckets);
+int hal_rt_fib_form_resilient_group (ndi_nh_group_t *entry, t_fib_mp_obj *p_old_mp_obj,
+                                     next_hop_id_t a_nh_obj_id [], uint32_t a_nh_weight []);
 void hal_rt_fib_sort_nh_obj_id (next_hop_id_t a_nh_obj_id [], t_fib_nh_obj *ap_nh_obj [],
                           uint32_t ecmp_count, uint32_t debug);
 t_std_error hal_rt_fib_check_and_delete_old_groupid(t_fib_dr *p_dr, npu_id_t  unit);
+int hal_rt_fib_mp_obj_gc_af (uint8_t af_index, bool is_force);
+int hal_rt_fib_mp_obj_gc (bool is_force);
+t_fib_mp_obj *hal_rt_fib_get_shared_mp_obj (t_fib_dr *p_dr, npu_id_t unit, int ecmp_count,
+                                            next_hop_id_t a_nh_obj_id []);
+t_fib_ecmp_grp_pressure *hal_rt_access_ecmp_grp_pressure (void);
+void hal_rt_ecmp_grp_pressure_grp_add (npu_id_t unit);
+void hal_rt_ecmp_grp_pressure_grp_del (npu_id_t unit);
+void hal_rt_ecmp_grp_pressure_table_full (npu_id_t unit);
+void hal_rt_ecmp_grp_pressure_grp_shared (void);
+void hal_rt_ecmp_degraded_route_add (t_fib_dr *p_dr);
+void hal_rt_ecmp_degraded_route_del (t_fib_dr *p_dr);
+uint32_t hal_rt_ecmp_num_degraded_routes (void);
+int hal_rt_ecmp_degraded_routes_upgrade (void);
+uint32_t hal_rt_fib_num_parked_mp_objs (void);
+uint32_t hal_rt_fib_ecmp_grp_hist_bucket (uint32_t value);
+void hal_rt_fib_get_ecmp_grp_stats (uint32_t vrf_id, uint8_t af_index, uint32_t top_n,
+                                    t_fib_ecmp_grp_stats *p_stats);
+void hal_rt_fib_unlink_mp_obj_members (t_fib_mp_obj *p_mp_obj);
+int hal_rt_fib_shrink_mp_objs_for_nh (npu_id_t unit, next_hop_id_t nh_id);
+t_fib_mp_obj *hal_rt_fib_create_indirect_mp_obj (ndi_nh_group_t *entry, int ecmp_count,
+                                                 next_hop_id_t a_nh_obj_id []);
+t_std_error hal_rt_fib_update_indirect_mp_obj (ndi_nh_group_t *entry, t_fib_mp_obj *p_mp_obj,
+                                               int ecmp_count, next_hop_id_t a_nh_obj_id []);
+void hal_rt_fib_release_indirect_mp_obj (t_fib_mp_obj *p_mp_obj);
+t_fib_mp_obj *hal_rt_get_dr_mp_obj (t_fib_dr *p_dr, npu_id_t unit);
+t_fib_mp_obj *hal_rt_get_nh_indirect_mp_obj (t_fib_nh *p_nh, npu_id_t unit);
+void hal_rt_set_dr_indirect_mp_obj (t_fib_dr *p_dr, npu_id_t unit, t_fib_mp_obj *p_mp_obj);
+bool hal_rt_is_dr_indirect_mp_obj_stale (t_fib_dr *p_dr, t_fib_nh *p_nh);
+void hal_rt_nh_indirect_mp_obj_detach (t_fib_nh *p_nh);
+void fib_dump_ecmp_grp_stats (t_fib_ecmp_grp_stats *p_stats);
 void hal_dump_ecmp_route_entry(ndi_nh_group_t *p_route_entry);
 void hal_rt_format_nh_list(next_hop_id_t nh_list[],  int count, char *buf, int s_buf);
+const t_fib_route_shadow *hal_rt_route_shadow_get (t_fib_dr *p_dr, npu_id_t unit);
 #endif /* __HAL_RT_MPATH_GROUP_H__ */
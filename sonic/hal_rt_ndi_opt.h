@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+
+/*!
+ * \file   hal_rt_ndi_opt.h
+ * \brief  Optional NDI APIs
+ *
+ * The NDI APIs that are not there in the older NDI versions. They are
+ * linked weak, the address of an API is NULL if the NDI library does not
+ * have it and the caller falls back to the per entry API. The NDI header
+ * is included first, so a prototype here that does not match the NDI one
+ * fails the build.
+ */
+
+#ifndef __HAL_RT_NDI_OPT_H__
+#define __HAL_RT_NDI_OPT_H__
+
+#include "nas_ndi_route.h"
+#include "std_error_codes.h"
+
+#include <stddef.h>
+
+#define HAL_RT_NDI_OPT  __attribute__ ((weak))
+
+/*
+ * Status of an entry before the bulk call, an entry that still has it
+ * after a failed bulk call was not written and is written one by one.
+ */
+#define HAL_RT_NDI_BULK_STATUS_NOT_DONE  STD_ERR(ROUTE, FAIL, 1)
+
+/* Bulk route programming, p_status has the result of each route */
+t_std_error ndi_route_bulk_add (ndi_route_t *p_route_entry, size_t count,
+                                t_std_error *p_status) HAL_RT_NDI_OPT;
+t_std_error ndi_route_bulk_set_attribute (ndi_route_t *p_route_entry, size_t count,
+                                          t_std_error *p_status) HAL_RT_NDI_OPT;
+
+/* Bulk neighbor programming, p_status has the result of each neighbor */
+t_std_error ndi_route_neighbor_bulk_add (ndi_neighbor_t *p_nbr_entry, size_t count,
+                                         t_std_error *p_status) HAL_RT_NDI_OPT;
+t_std_error ndi_route_neighbor_bulk_delete (ndi_neighbor_t *p_nbr_entry, size_t count,
+                                            t_std_error *p_status) HAL_RT_NDI_OPT;
+
+/* Bulk next hop object create, a_nh_handle has the handle of each neighbor */
+t_std_error ndi_route_next_hop_bulk_add (ndi_neighbor_t *p_nbr_entry, size_t count,
+                                         next_hop_id_t *p_nh_handle,
+                                         t_std_error *p_status) HAL_RT_NDI_OPT;
+
+/* Size of a route table (t_hal_rt_cam) of the NPU */
+t_std_error ndi_route_table_size_get (npu_id_t npu_id, uint32_t table,
+                                      uint32_t *p_size) HAL_RT_NDI_OPT;
+
+#endif /* __HAL_RT_NDI_OPT_H__ */
@@ -364,7 +364,7 @@
 #define FIB_IS_FH_VALID_ECMP(_p_fh, _ecmp_count)                               \
         (((FIB_IS_NH_WRITTEN ((_p_fh))) &&                                    \
           ((_p_fh)->p_arp_info->state == FIB_ARP_RESOLVED) &&                   \
-          ((_ecmp_count) < HAL_RT_MAX_ECMP_PATH)))
+          ((_ecmp_count) < HAL_RT_ECMP_MAX_PATHS ())))
 
 #define FIB_IS_L2_FH(_p_fh)                                         \
         ((_p_fh)->p_arp_info->is_l3_fh)
@@ -433,18 +433,10 @@ typedef struct _t_fib_dr_fh {
      t_fib_link_node link_node;
      uint8_t         status;
      std_dll_head    tunnel_fh_list;
-     uint32_t        ecmp_weight_count; /* count the number of occurrences of same FH in the DR */
+     uint32_t        ecmp_weight_count; /* Sum of the weights of the DR NHs resolving to this FH */
 } t_fib_dr_fh;
 
 
-typedef struct _t_fib_nh_list {
-    int  nh_count;
-    struct {
-        next_hop_id_t   id;
-        uint32_t        weight;
-    } nh_list[HAL_RT_MAX_ECMP_PATH];
-} t_fib_nh_list;
-
 typedef struct _t_fib_dr {
     std_radical_head_t radical;
     t_fib_dr_key       key;
@@ -456,7 +448,7 @@ typedef struct _t_fib_dr {
     uint32_t           num_nh;
     uint32_t           num_fh;
     uint32_t           nh_count;  /* ECMP NH count */
-    t_fib_nh_list      ofh_list; /* previous valid old fh list */
+    uint32_t           ofh_count; /* previous valid old fh count, the members are in the mp_obj */
     std_dll_head       nh_list;
     std_dll_head       fh_list;
     std_dll_head       dep_nh_list;
@@ -467,6 +459,8 @@ typedef struct _t_fib_dr {
     next_hop_id_t      onh_handle;  /* old nh_handle or ECMP group_handle */
     bool               remove_old_handle;
     bool               ecmp_handle_created; /* true if ecmp handle is present */
+    void              *p_ecmp_degraded; /* Entry in the ECMP degraded route list, if degraded */
+    void              *p_retry;     /* Entry in the retry queue, if the write failed */
     void              *p_hal_dr_handle; /* mp_obj details per SAI instance */
 } t_fib_dr;
 
@@ -475,6 +469,16 @@ typedef struct _t_fib_nh_key {
     hal_ifindex_t      if_index;
 } t_fib_nh_key;
 
+/* Neighbor as written to a NPU */
+typedef struct _t_fib_nbr_shadow {
+    uint8_t            is_valid;
+    uint32_t           action;
+    ndi_rif_id_t       rif_id;
+    uint32_t           vlan_id;
+    uint32_t           port_tgid;
+    uint8_t            mac_addr [HAL_RT_MAC_ADDR_LEN];
+} t_fib_nbr_shadow;
+
 /*
  * t_fib_nh will either be a First Hop node or a Next Hope node. If 'key.if_index'
  * is non NULL, then it is a First hop node, else it is a next hop node.
@@ -505,11 +509,15 @@ typedef struct _t_fib_nh {
     std_rt_table      *dep_dr_tree;
     uint64_t           arp_last_update_time;
     uint8_t            is_cam_host_count_incremented;
+    uint8_t            is_fh_resolved; /* ARP resolved when last walked, for the fast reroute */
     uint8_t            is_audit_egr_info_matched;
     uint8_t            is_audit_egr_id_in_hw;
     uint8_t            is_audit_egr_id_corrupt;
     uint8_t            a_is_written [HAL_RT_MAX_INSTANCE];
+    void              *p_retry;     /* Entry in the retry queue, if the write failed */
     void              *p_hal_nh_handle; /* Lower NPU Handle */
+    /* Per unit, max_num_npu entries are allocated after the NH */
+    t_fib_nbr_shadow   a_nbr_shadow [];
 } t_fib_nh;
 
 /*
@@ -531,6 +539,7 @@ typedef struct _t_fib_nh_holder {
 
 typedef struct _t_fib_dr_nh {
     t_fib_link_node  link_node;
+    uint32_t         weight; /* WECMP weight of the NH in the route */
     /* Add any new fields above this */
     uint32_t         tlv_info_len;
     uint8_t          tlv_info [0];
@@ -838,6 +847,11 @@ int fib_create_tnl_dest_tree (void);
 
 t_std_error fib_proc_nbr_download (cps_api_object_t obj);
 
+t_std_error fib_proc_nbr_msg (db_neighbour_entry_t *p_arp_info_msg);
+
+bool fib_nbr_msg_is_route_nh (cps_api_object_t obj, db_neighbour_entry_t *p_arp_msg,
+                              uint32_t *p_hash);
+
 t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info);
 
 t_std_error fib_proc_arp_del (uint8_t af_index, void *p_arp_info);
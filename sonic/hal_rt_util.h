@@ -40,20 +40,116 @@
 #define HAL_RT_MAX_HAL_ERR_LEN            64
 #define HAL_RT_GET_ERR_STR(_hal_err)      hal_rt_get_hal_err_str(_hal_err)
 
+/* NDI fails a write with STD_ERR(ROUTE, FAIL, <SAI status>) */
+#define HAL_RT_NDI_SAI_STATUS_INSUFFICIENT_RESOURCES  (-0x00000003L)
+#define HAL_RT_NDI_SAI_STATUS_TABLE_FULL              (-0x00000006L)
+
 #define HAL_RT_RIF_TABLE_MAX              512
 
+#define HAL_RT_CAM_NAME_LEN               32
+#define HAL_RT_CAM_IPV6_LPM_64_LEN        64
+
+#define HAL_RT_RETRY_MIN_BACKOFF          1000   /* msecs */
+#define HAL_RT_RETRY_MAX_BACKOFF          64000  /* msecs */
+#define HAL_RT_RETRY_BATCH                256
+#define HAL_RT_RETRY_STUCK_ATTEMPTS       6
+
+#define HAL_RT_AUDIT_CHUNK                256    /* Entries audited per lock */
+#define HAL_RT_AUDIT_CHUNK_DELAY          10     /* msecs between chunks */
+
+#define HAL_RT_GET_CHUNK                  128    /* Entries read by a CPS GET per lock */
+
+#define HAL_RT_LOCK_HIST_BUCKETS          7      /* Bucket n is below 10^(n+1) usecs */
+
 #define FIB_IP_ADDR_TO_STR(_p_ip_addr)                                       \
         (((_p_ip_addr)->af_index == HAL_RT_V4_AFINDEX) ?                     \
          FIB_IPV4_ADDR_TO_STR (&((_p_ip_addr)->u.v4_addr)) :                 \
          FIB_IPV6_ADDR_TO_STR (&((_p_ip_addr)->u.v6_addr)))
 
 #define FIB_IPV4_ADDR_TO_STR(_p_ip_addr)                                     \
-        (inet_ntop (AF_INET, (const void *) (_p_ip_addr),                    \
-                    (char *) fib_get_scratch_buf (), FIB_MAX_SCRATCH_BUFSZ))
+        (fib_ipv4_addr_to_str ((const void *) (_p_ip_addr),                  \
+                               (char *) fib_get_scratch_buf ()))
 
 #define FIB_IPV6_ADDR_TO_STR(_p_ip_addr)                                     \
-        (inet_ntop (AF_INET6, (const void *) (_p_ip_addr),                   \
-                   (char *) fib_get_scratch_buf (), FIB_MAX_SCRATCH_BUFSZ))
+        (fib_ipv6_addr_to_str ((const void *) (_p_ip_addr),                  \
+                               (char *) fib_get_scratch_buf ()))
+
+/*
+ * NPU tables counted by the occupancy model. The IPv6 routes are split at
+ * /64, most NPUs keep the longer prefixes in a smaller partition.
+ */
+typedef enum {
+    HAL_RT_CAM_IPV4_LPM = 0,
+    HAL_RT_CAM_IPV6_LPM_64,
+    HAL_RT_CAM_IPV6_LPM_128,
+    HAL_RT_CAM_HOST,
+    HAL_RT_CAM_NH,
+    HAL_RT_CAM_NH_GRP,
+    HAL_RT_CAM_MAX,
+} t_hal_rt_cam;
+
+typedef enum {
+    HAL_RT_CAM_LEVEL_NORMAL = 0,
+    HAL_RT_CAM_LEVEL_HIGH,
+    HAL_RT_CAM_LEVEL_FULL,
+} t_hal_rt_cam_level;
+
+typedef struct _t_hal_rt_cam_usage {
+    uint32_t  in_use;
+    uint32_t  capacity;        /* 0 - not known yet */
+    bool      is_learnt;       /* Capacity learnt from a failed write */
+    uint32_t  level;           /* HAL_RT_CAM_LEVEL_XXX */
+    uint32_t  num_write_failed;
+    uint32_t  num_rejected;
+    uint32_t  num_events;
+} t_hal_rt_cam_usage;
+
+/* Why a DR or NH write is retried */
+typedef enum {
+    HAL_RT_RETRY_RSN_NDI_FAIL = 0,     /* NDI failed the write */
+    HAL_RT_RETRY_RSN_TABLE_FULL,       /* The table of the entry is full */
+    HAL_RT_RETRY_RSN_ECMP_FAIL,        /* The ECMP group could not be programmed */
+    HAL_RT_RETRY_RSN_MAX,
+} t_hal_rt_retry_reason;
+
+typedef struct _t_hal_rt_retry_stats {
+    uint32_t  num_pending;
+    uint32_t  a_num_pending [HAL_RT_RETRY_RSN_MAX];
+    uint32_t  a_num_table_full [HAL_RT_CAM_MAX];
+    uint32_t  num_stuck;       /* Pending after HAL_RT_RETRY_STUCK_ATTEMPTS retries */
+    uint32_t  num_failed;
+    uint32_t  num_retried;
+    uint32_t  num_recovered;
+    uint32_t  max_attempts;
+} t_hal_rt_retry_stats;
+
+typedef struct _t_hal_rt_audit_stats {
+    uint32_t  num_routes_audited;  /* Of the last audit */
+    uint32_t  num_hosts_audited;
+    uint32_t  num_route_mismatch;
+    uint32_t  num_host_mismatch;
+    uint32_t  num_egr_mismatch;    /* Next hop id mismatch, not repaired */
+    uint32_t  num_skipped;         /* Being resolved or retried when audited */
+    uint32_t  num_repaired;
+    uint32_t  tot_mismatch;        /* Of all the audits */
+    uint32_t  tot_repaired;
+} t_hal_rt_audit_stats;
+
+typedef struct _t_hal_rt_lock_site_stats {
+    uint32_t  num_acquired;
+    uint64_t  tot_wait_usecs;
+    uint64_t  tot_hold_usecs;
+    uint32_t  max_wait_usecs;
+    uint32_t  max_hold_usecs;
+    uint32_t  a_wait_hist [HAL_RT_LOCK_HIST_BUCKETS];
+    uint32_t  a_hold_hist [HAL_RT_LOCK_HIST_BUCKETS];
+} t_hal_rt_lock_site_stats;
+
+typedef struct _t_hal_rt_lock_stats {
+    bool                      is_enabled;
+    uint32_t                  max_hold_site;   /* Site of the longest hold */
+    t_hal_rt_lock_site_stats  a_site [HAL_RT_LOCK_SITE_MAX];
+} t_hal_rt_lock_stats;
 
 typedef struct _dn_hal_route_err_to_str {
     dn_hal_route_err   error;
@@ -61,12 +157,24 @@ typedef struct _dn_hal_route_err_to_str {
 } dn_hal_route_err_to_str;
 
 /*!
- * @brief Get scratch buffer for temporary calculations
+ * @brief Get scratch buffer for temporary calculations, the buffers are
+ *        per thread and reused after FIB_NUM_SCRATCH_BUF calls
  * @param none
  * @return scratch buffer pointer
  */
 uint8_t *fib_get_scratch_buf ();
 
+/*!
+ * @brief Format an address in network order without allocating, as
+ *        inet_ntop does
+ * @param p_addr  IPv4/IPv6 address
+ * @param p_buf   buffer of at least INET_ADDRSTRLEN/INET6_ADDRSTRLEN bytes
+ * @return p_buf
+ */
+char *fib_ipv4_addr_to_str (const void *p_addr, char *p_buf);
+
+char *fib_ipv6_addr_to_str (const void *p_addr, char *p_buf);
+
 int fib_get_mask_from_prefix_len (uint8_t af_index, uint8_t prefix_len, t_fib_ip_addr *p_out_mask);
 
 int fib_cmp_ip_addr (t_fib_ip_addr *p_ip_addr1, t_fib_ip_addr *p_ip_addr2);
@@ -75,6 +183,60 @@ void fib_cam_sys_log (dn_hal_route_err hal_err, int slot_id, uint8_t *p_cam_str,
 
 void fib_check_threshold_for_all_cams (int action);
 
+t_std_error hal_rt_cam_init (void);
+
+const t_hal_rt_cam_usage *hal_rt_access_cam_usage (t_hal_rt_cam cam);
+
+const char *hal_rt_cam_name (t_hal_rt_cam cam);
+
+t_hal_rt_cam hal_rt_cam_get_route_cam (uint8_t af_index, uint8_t prefix_len);
+
+void hal_rt_cam_entry_add (t_hal_rt_cam cam);
+
+void hal_rt_cam_entry_del (t_hal_rt_cam cam);
+
+void hal_rt_cam_write_failed (t_hal_rt_cam cam, bool is_table_full);
+
+bool hal_rt_cam_is_full (t_hal_rt_cam cam);
+
+void hal_rt_cam_route_add (t_fib_dr *p_dr);
+
+void hal_rt_cam_route_del (t_fib_dr *p_dr);
+
+bool hal_rt_cam_route_defer (t_fib_dr *p_dr);
+
+void hal_rt_retry_dr_add (t_fib_dr *p_dr, t_hal_rt_retry_reason reason);
+
+void hal_rt_retry_dr_del (t_fib_dr *p_dr);
+
+void hal_rt_retry_nh_add (t_fib_nh *p_nh, t_hal_rt_retry_reason reason);
+
+void hal_rt_retry_nh_del (t_fib_nh *p_nh);
+
+uint32_t hal_rt_retry_num_pending (void);
+
+uint32_t hal_rt_retry_num_table_full (t_hal_rt_cam cam);
+
+const t_hal_rt_retry_stats *hal_rt_access_retry_stats (void);
+
+int hal_rt_retry_run (bool *p_is_nh_marked);
+
+t_std_error hal_rt_audit_init (void);
+
+void hal_rt_audit_start (void);
+
+void hal_rt_audit_set_interval (uint32_t interval);
+
+const t_fib_audit *hal_rt_access_fib_audit (void);
+
+const t_hal_rt_audit_stats *hal_rt_access_audit_stats (void);
+
+void hal_rt_lock_prof_enable (bool is_enabled);
+
+const t_hal_rt_lock_stats *hal_rt_access_lock_stats (void);
+
+const char *hal_rt_lock_site_name (uint32_t site);
+
 unsigned long fib_tick_get( void );
 
 t_std_error hal_rt_validate_intf(int if_index);
@@ -93,6 +255,13 @@ char *hal_rt_mac_to_str (hal_mac_addr_t *mac_addr, char *p_buf, size_t len);
  */
 uint8_t *hal_rt_get_hal_err_str(dn_hal_route_err _hal_err);
 
+/*!
+ * @brief  This routine checks whether NDI failed a write as the table is full
+ * @param  NDI return code
+ * @return true if the table has no room for the entry
+ */
+bool hal_rt_ndi_rc_is_table_full (t_std_error rc);
+
 bool hal_rt_is_mac_address_zero (const hal_mac_addr_t *p_mac);
 
 bool hal_rt_is_reserved_ipv6(hal_ip_addr_t *p_ip_addr);
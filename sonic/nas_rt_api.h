@@ -143,6 +143,212 @@ typedef struct  {
     uint32_t                    ecmp_grp_id;
 }  nas_rt_fib_show_config_t;
 
+/*
+ * Routing statistics objects. They are not part of the base route model,
+ * the keys are formed with cps_api_key_init() on the BASE_ROUTE category
+ * with the sub-categories below. The attribute ids are local to the object.
+ */
+typedef enum {
+    NAS_RT_STATS_ECMP_GRP_PRESSURE_OBJ = 0x7f01,
+    NAS_RT_STATS_ECMP_GRP_OBJ          = 0x7f02,
+    NAS_RT_STATS_CAM_OBJ               = 0x7f03,
+    NAS_RT_STATS_RETRY_OBJ             = 0x7f04,
+    NAS_RT_STATS_AUDIT_OBJ             = 0x7f05,
+    NAS_RT_STATS_LOCK_OBJ              = 0x7f06,
+    NAS_RT_STATS_VRF_CNTRS_OBJ         = 0x7f07,
+    NAS_RT_STATS_ROUTE_GRP_OBJ         = 0x7f08,
+    NAS_RT_STATS_ECMP_CONFIG_OBJ       = 0x7f09,
+} nas_rt_stats_obj_t;
+
+typedef enum {
+    NAS_RT_ECMP_GRP_PRESSURE_GRPS_IN_USE = 1,
+    NAS_RT_ECMP_GRP_PRESSURE_CAPACITY,
+    NAS_RT_ECMP_GRP_PRESSURE_DEGRADED_ROUTES,
+    NAS_RT_ECMP_GRP_PRESSURE_TABLE_FULL,
+    NAS_RT_ECMP_GRP_PRESSURE_SHARED,
+    NAS_RT_ECMP_GRP_PRESSURE_UPGRADED,
+} nas_rt_ecmp_grp_pressure_attr_t;
+
+/*
+ * ECMP group statistics, one object per VRF/AF. The histograms and the
+ * per NPU group counts are lists indexed by the bucket/NPU, the top groups
+ * are a list of {GID, WIDTH, REF_COUNT, NPU_ID}. TOP_N in the GET filter
+ * gives the number of top groups.
+ */
+typedef enum {
+    NAS_RT_ECMP_GRP_STATS_VRF_ID = 1,
+    NAS_RT_ECMP_GRP_STATS_AF,
+    NAS_RT_ECMP_GRP_STATS_TOP_N,
+    NAS_RT_ECMP_GRP_STATS_NUM_GRPS,
+    NAS_RT_ECMP_GRP_STATS_NPU_GRPS,
+    NAS_RT_ECMP_GRP_STATS_PARKED,
+    NAS_RT_ECMP_GRP_STATS_COLLISIONS,
+    NAS_RT_ECMP_GRP_STATS_COLLIDED_GRPS,
+    NAS_RT_ECMP_GRP_STATS_CREATED,
+    NAS_RT_ECMP_GRP_STATS_REPLACED,
+    NAS_RT_ECMP_GRP_STATS_DELETED,
+    NAS_RT_ECMP_GRP_STATS_WIDTH_HIST,
+    NAS_RT_ECMP_GRP_STATS_SHARE_HIST,
+    NAS_RT_ECMP_GRP_STATS_TOP,
+    NAS_RT_ECMP_GRP_STATS_TOP_GID,
+    NAS_RT_ECMP_GRP_STATS_TOP_WIDTH,
+    NAS_RT_ECMP_GRP_STATS_TOP_REF_COUNT,
+    NAS_RT_ECMP_GRP_STATS_TOP_NPU_ID,
+} nas_rt_ecmp_grp_stats_attr_t;
+
+/*
+ * NPU table occupancy, one object per table. The same object is published
+ * as an event when the level of the table changes.
+ */
+typedef enum {
+    NAS_RT_CAM_TABLE = 1,
+    NAS_RT_CAM_NAME,
+    NAS_RT_CAM_IN_USE,
+    NAS_RT_CAM_CAPACITY,
+    NAS_RT_CAM_LEVEL,
+    NAS_RT_CAM_WRITE_FAILED,
+    NAS_RT_CAM_REJECTED,
+    NAS_RT_CAM_DEFERRED,
+} nas_rt_cam_attr_t;
+
+/*
+ * Failed route and neighbor writes queued for retry. STUCK is the number
+ * of entries still pending after several retries.
+ */
+typedef enum {
+    NAS_RT_RETRY_PENDING = 1,
+    NAS_RT_RETRY_NDI_FAIL,
+    NAS_RT_RETRY_TABLE_FULL,
+    NAS_RT_RETRY_ECMP_FAIL,
+    NAS_RT_RETRY_STUCK,
+    NAS_RT_RETRY_RETRIED,
+    NAS_RT_RETRY_RECOVERED,
+    NAS_RT_RETRY_MAX_ATTEMPTS,
+} nas_rt_retry_attr_t;
+
+/*
+ * FIB audit against the route and neighbor shadows, the NPU tables are
+ * not read back. The counts are of the last audit, the TOT counts of all
+ * the audits. The times are in seconds since the epoch. A SET with
+ * INTERVAL (minutes, 0 to stop) changes the audit interval, a SET with
+ * START starts an audit.
+ */
+typedef enum {
+    NAS_RT_AUDIT_STATUS = 1,
+    NAS_RT_AUDIT_INTERVAL,
+    NAS_RT_AUDIT_START,
+    NAS_RT_AUDIT_COMPLETED,
+    NAS_RT_AUDIT_START_TIME,
+    NAS_RT_AUDIT_END_TIME,
+    NAS_RT_AUDIT_ROUTES,
+    NAS_RT_AUDIT_HOSTS,
+    NAS_RT_AUDIT_ROUTE_MISMATCH,
+    NAS_RT_AUDIT_HOST_MISMATCH,
+    NAS_RT_AUDIT_EGR_MISMATCH,
+    NAS_RT_AUDIT_SKIPPED,
+    NAS_RT_AUDIT_REPAIRED,
+    NAS_RT_AUDIT_TOT_MISMATCH,
+    NAS_RT_AUDIT_TOT_REPAIRED,
+} nas_rt_audit_attr_t;
+
+/*
+ * L3 lock profile, one object per call site. The times are in usecs,
+ * the histograms are lists indexed by the bucket, bucket n counts the
+ * times below 10^(n+1) usecs. IS_MAX_HOLDER is set on the site of the
+ * longest hold. A SET with ENABLE turns the profiler on or off, turning
+ * it on clears the stats.
+ */
+typedef enum {
+    NAS_RT_LOCK_SITE = 1,
+    NAS_RT_LOCK_SITE_NAME,
+    NAS_RT_LOCK_ENABLE,
+    NAS_RT_LOCK_ACQUIRED,
+    NAS_RT_LOCK_TOT_WAIT,
+    NAS_RT_LOCK_MAX_WAIT,
+    NAS_RT_LOCK_TOT_HOLD,
+    NAS_RT_LOCK_MAX_HOLD,
+    NAS_RT_LOCK_WAIT_HIST,
+    NAS_RT_LOCK_HOLD_HIST,
+    NAS_RT_LOCK_IS_MAX_HOLDER,
+} nas_rt_lock_attr_t;
+
+/*
+ * Route and neighbor counters, one object per VRF/AF. VRF_ID and AF in the
+ * GET filter select the VRF/AF. The rates are per second, over the interval
+ * since the last read of the VRF/AF. A SET with CLEAR clears the counters
+ * of the VRF/AF given, or of all.
+ */
+typedef enum {
+    NAS_RT_VRF_CNTRS_VRF_ID = 1,
+    NAS_RT_VRF_CNTRS_AF,
+    NAS_RT_VRF_CNTRS_CLEAR,
+    NAS_RT_VRF_CNTRS_ROUTE_ADD,
+    NAS_RT_VRF_CNTRS_ROUTE_DEL,
+    NAS_RT_VRF_CNTRS_VRF_ADD,
+    NAS_RT_VRF_CNTRS_VRF_DEL,
+    NAS_RT_VRF_CNTRS_ROUTE_CLEAR,
+    NAS_RT_VRF_CNTRS_UNKNOWN_MSG,
+    NAS_RT_VRF_CNTRS_NBR_ADD,
+    NAS_RT_VRF_CNTRS_NBR_DEL,
+    NAS_RT_VRF_CNTRS_NBR_RESOLVING,
+    NAS_RT_VRF_CNTRS_NBR_UNRSLVD,
+    NAS_RT_VRF_CNTRS_NBR_CLEAR,
+    NAS_RT_VRF_CNTRS_FIB_HOST_ENTRIES,
+    NAS_RT_VRF_CNTRS_FIB_ROUTE_ENTRIES,
+    NAS_RT_VRF_CNTRS_CAM_HOST_ENTRIES,
+    NAS_RT_VRF_CNTRS_CAM_ROUTE_ENTRIES,
+    NAS_RT_VRF_CNTRS_ECMP_GRP_PARKED,
+    NAS_RT_VRF_CNTRS_ECMP_GRP_REUSED,
+    NAS_RT_VRF_CNTRS_ECMP_GRP_FREED,
+    NAS_RT_VRF_CNTRS_ECMP_GRP_CREATED,
+    NAS_RT_VRF_CNTRS_ECMP_GRP_REPLACED,
+    NAS_RT_VRF_CNTRS_ECMP_GRP_DELETED,
+    NAS_RT_VRF_CNTRS_ROUTE_ADD_RATE,
+    NAS_RT_VRF_CNTRS_ROUTE_DEL_RATE,
+    NAS_RT_VRF_CNTRS_NBR_ADD_RATE,
+    NAS_RT_VRF_CNTRS_NBR_DEL_RATE,
+} nas_rt_vrf_cntrs_attr_t;
+
+/*
+ * Group of a route as written to NPU 0. VRF_ID, AF, PREFIX and PREFIX_LEN
+ * in the GET filter select the route. GID is 0 for a route to a single
+ * next hop. NUM_MEMBERS is the member count of the group, with the WECMP
+ * replicas and the buckets of a resilient group. FH is a list of the first
+ * hops of the route, {ADDR, IF_INDEX, WEIGHT, COUNT}, COUNT is the number
+ * of members of the first hop in the group and WEIGHT its NDI weight.
+ */
+typedef enum {
+    NAS_RT_ROUTE_GRP_VRF_ID = 1,
+    NAS_RT_ROUTE_GRP_AF,
+    NAS_RT_ROUTE_GRP_PREFIX,
+    NAS_RT_ROUTE_GRP_PREFIX_LEN,
+    NAS_RT_ROUTE_GRP_GID,
+    NAS_RT_ROUTE_GRP_IS_INDIRECT,
+    NAS_RT_ROUTE_GRP_IS_RESILIENT,
+    NAS_RT_ROUTE_GRP_NUM_MEMBERS,
+    NAS_RT_ROUTE_GRP_FH,
+    NAS_RT_ROUTE_GRP_FH_ADDR,
+    NAS_RT_ROUTE_GRP_FH_IF_INDEX,
+    NAS_RT_ROUTE_GRP_FH_WEIGHT,
+    NAS_RT_ROUTE_GRP_FH_COUNT,
+} nas_rt_route_grp_attr_t;
+
+/*
+ * ECMP group config. A SET changes the attributes given, the change
+ * applies to the groups programmed after it. NATIVE_WEIGHT selects the
+ * WECMP member weights of the NPU instead of the member replication.
+ * MAX_PATHS is the ECMP width, 1 to HW_MAX_PATHS (read only).
+ * RESILIENT_HASH programs the groups as RESILIENT_BUCKETS buckets, 1 to
+ * HW_MAX_PATHS.
+ */
+typedef enum {
+    NAS_RT_ECMP_CONFIG_NATIVE_WEIGHT = 1,
+    NAS_RT_ECMP_CONFIG_MAX_PATHS,
+    NAS_RT_ECMP_CONFIG_HW_MAX_PATHS,
+    NAS_RT_ECMP_CONFIG_RESILIENT_HASH,
+    NAS_RT_ECMP_CONFIG_RESILIENT_BUCKETS,
+} nas_rt_ecmp_config_attr_t;
+
 typedef struct  {
     unsigned long               rfid;
     hal_ip_addr_t               ip_prefix;
@@ -169,4 +375,15 @@ t_std_error nas_route_process_cps_peer_routing(cps_api_transaction_params_t * pa
 t_std_error nas_route_get_all_peer_routing_config(cps_api_object_list_t list);
 t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af,
                                          hal_ip_addr_t prefix, uint32_t pref_len, bool is_specific_prefix_get);
+t_std_error nas_route_get_ecmp_grp_pressure(cps_api_object_list_t list);
+t_std_error nas_route_get_ecmp_grp_stats(cps_api_object_list_t list, uint32_t top_n);
+cps_api_object_t nas_route_cam_usage_to_cps_obj(uint32_t cam);
+t_std_error nas_route_get_cam_usage(cps_api_object_list_t list);
+t_std_error nas_route_get_retry_stats(cps_api_object_list_t list);
+t_std_error nas_route_get_audit_stats(cps_api_object_list_t list);
+t_std_error nas_route_get_lock_stats(cps_api_object_list_t list);
+t_std_error nas_route_get_vrf_cntrs(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af);
+t_std_error nas_route_get_route_grp(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af,
+                                    hal_ip_addr_t *p_prefix, uint32_t pref_len);
+t_std_error nas_route_get_ecmp_config(cps_api_object_list_t list);
 #endif /* NAS_RT_API_H */
@@ -131,8 +131,17 @@ t_std_error fib_proc_nbr_download (cps_api_object_t obj)
 {
     db_neighbour_entry_t     arp_msg;
 
-    db_neighbour_entry_t      *p_arp_info_msg = NULL;
+    cps_obj_to_neigh(obj,&arp_msg);
+
+    return fib_proc_nbr_msg (&arp_msg);
+}
 
+/*
+ * Applies a neighbor message already parsed from its CPS object, the
+ * neighbor pipeline parses the events once when it queues them.
+ */
+t_std_error fib_proc_nbr_msg (db_neighbour_entry_t *p_arp_info_msg)
+{
     uint32_t           vrf_id = 0;
 
     uint32_t           sub_cmd = 0;
@@ -140,9 +149,6 @@ t_std_error fib_proc_nbr_download (cps_api_object_t obj)
     bool               nbr_change = false;
     char               p_buf[HAL_RT_MAX_BUFSZ];
 
-    cps_obj_to_neigh(obj,&arp_msg);
-
-    p_arp_info_msg = &arp_msg;
     if(!p_arp_info_msg) {
         EV_LOG_ERR (ev_log_t_ROUTE, 3, "HAL-RT-ARP", "%s (): NULL nbr entry\n", __FUNCTION__);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
@@ -217,6 +223,53 @@ t_std_error fib_proc_nbr_download (cps_api_object_t obj)
     return STD_ERR_OK;
 }
 
+/*
+ * Classifies a neighbor event for the neighbor pipeline. Returns true if the
+ * neighbor resolves a next hop used by routes, p_hash is set to the hash of
+ * the neighbor for the ordering of the events of the same neighbor. The
+ * event is parsed to p_arp_msg, to be applied with fib_proc_nbr_msg.
+ */
+bool fib_nbr_msg_is_route_nh (cps_api_object_t obj, db_neighbour_entry_t *p_arp_msg,
+                              uint32_t *p_hash)
+{
+    t_fib_arp_msg_info    fib_arp_msg_info;
+    t_fib_nh             *p_nh;
+    const uint8_t        *p_byte;
+    uint8_t               af_index;
+    uint32_t              hash = 2166136261u;
+    uint32_t              index;
+    bool                  is_route_nh = false;
+
+    cps_obj_to_neigh (obj, p_arp_msg);
+
+    af_index = HAL_RT_ADDR_FAM_TO_AFINDEX (p_arp_msg->family);
+    fib_form_arp_msg_info (af_index, p_arp_msg, &fib_arp_msg_info, false);
+
+    p_byte = (const uint8_t *) &fib_arp_msg_info.ip_addr.u;
+    for (index = 0; index < STD_IP_AFINDEX_TO_ADDR_LEN (af_index); index++)
+        hash = (hash ^ p_byte [index]) * 16777619u;
+    *p_hash = (hash ^ fib_arp_msg_info.if_index) * 16777619u;
+
+    if ((!FIB_IS_VRF_ID_VALID (fib_arp_msg_info.vrf_id)) ||
+        (hal_rt_access_fib_vrf (fib_arp_msg_info.vrf_id) == NULL))
+        return false;
+
+    hal_rt_vrf_read_lock (fib_arp_msg_info.vrf_id, af_index);
+
+    p_nh = fib_get_nh (fib_arp_msg_info.vrf_id, &fib_arp_msg_info.ip_addr,
+                       fib_arp_msg_info.if_index);
+    if ((p_nh != NULL) && (p_nh->rtm_ref_count > 0)) {
+        is_route_nh = true;
+    } else {
+        p_nh = fib_get_nh (fib_arp_msg_info.vrf_id, &fib_arp_msg_info.ip_addr, 0);
+        is_route_nh = ((p_nh != NULL) && (p_nh->rtm_ref_count > 0));
+    }
+
+    hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
+
+    return is_route_nh;
+}
+
 t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info)
 {
     t_fib_arp_msg_info   fib_arp_msg_info;
@@ -233,7 +286,8 @@ t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info)
 
     fib_form_arp_msg_info (af_index, p_arp_info, &fib_arp_msg_info, false);
 
-    nas_l3_lock();
+    hal_rt_vrf_write_lock (fib_arp_msg_info.vrf_id, af_index);
+    nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_NBR_INGEST);
 
     p_nh = fib_get_nh (fib_arp_msg_info.vrf_id, &fib_arp_msg_info.ip_addr,
                        fib_arp_msg_info.if_index);
@@ -248,7 +302,8 @@ t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info)
                     fib_arp_msg_info.if_index, fib_arp_msg_info.status);
 
             p_nh->p_arp_info->arp_status = fib_arp_msg_info.status;
-            nas_l3_unlock();
+            nas_l3_unlock_af (af_index);
+            hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
             return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
         }
 
@@ -269,7 +324,8 @@ t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info)
                     fib_arp_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&fib_arp_msg_info.ip_addr),
                     fib_arp_msg_info.if_index);
 
-        nas_l3_unlock();
+        nas_l3_unlock_af (af_index);
+        hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
@@ -279,7 +335,8 @@ t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info)
                 fib_arp_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&fib_arp_msg_info.ip_addr),
                 fib_arp_msg_info.if_index);
 
-        nas_l3_unlock();
+        nas_l3_unlock_af (af_index);
+        hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
@@ -294,7 +351,8 @@ t_std_error fib_proc_arp_add (uint8_t af_index, void *p_arp_info)
     }
     p_nh->p_arp_info->is_l2_fh = fib_arp_msg_info.is_l2_fh;
 
-    nas_l3_unlock();
+    nas_l3_unlock_af (af_index);
+    hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
     return STD_ERR_OK;
 }
 
@@ -326,7 +384,8 @@ t_std_error fib_proc_arp_del (uint8_t af_index, void *p_arp_info)
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
-    nas_l3_lock();
+    hal_rt_vrf_write_lock (fib_arp_msg_info.vrf_id, af_index);
+    nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_NBR_INGEST);
 
     p_nh = fib_get_nh (fib_arp_msg_info.vrf_id,
                        &fib_arp_msg_info.ip_addr, fib_arp_msg_info.if_index);
@@ -336,7 +395,8 @@ t_std_error fib_proc_arp_del (uint8_t af_index, void *p_arp_info)
                    fib_arp_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&fib_arp_msg_info.ip_addr),
                    fib_arp_msg_info.if_index);
 
-        nas_l3_unlock();
+        nas_l3_unlock_af (af_index);
+        hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
@@ -346,13 +406,15 @@ t_std_error fib_proc_arp_del (uint8_t af_index, void *p_arp_info)
                    fib_arp_msg_info.vrf_id, FIB_IP_ADDR_TO_STR (&fib_arp_msg_info.ip_addr),
                    fib_arp_msg_info.if_index);
 
-        nas_l3_unlock();
+        nas_l3_unlock_af (af_index);
+        hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
     fib_proc_nh_delete (p_nh, FIB_NH_OWNER_TYPE_ARP, 0);
 
-    nas_l3_unlock();
+    nas_l3_unlock_af (af_index);
+    hal_rt_vrf_unlock (fib_arp_msg_info.vrf_id, af_index);
 
     return STD_ERR_OK;
 }
@@ -507,8 +569,12 @@ t_std_error nas_route_get_all_arp_info(cps_api_object_list_t list, unsigned shor
 
     t_fib_nh *p_nh = NULL;
     const unsigned int vrf_id =0;
+    t_fib_ip_addr key_ip_addr;
+    uint32_t key_if_index;
+    uint32_t count = 0;
 
-    nas_l3_lock();
+    /* The neighbors of the AF are read while the other AF is written */
+    hal_rt_vrf_read_lock (vrf_id, af);
 
     p_nh = fib_get_first_nh (vrf_id, af);
 
@@ -520,13 +586,24 @@ t_std_error nas_route_get_all_arp_info(cps_api_object_list_t list, unsigned shor
                 if (!cps_api_object_list_append(list,obj)) {
                     cps_api_object_delete(obj);
                     EV_LOG(ERR,ROUTE,0,"HAL-RT-ARP","Failed to append object to object list");
-                    nas_l3_unlock();
+                    hal_rt_vrf_unlock (vrf_id, af);
                     return STD_ERR(ROUTE,FAIL,0);
                 }
             }
         }
-        p_nh = fib_get_next_nh (vrf_id, &p_nh->key.ip_addr, p_nh->key.if_index);
+
+        memcpy (&key_ip_addr, &p_nh->key.ip_addr, sizeof (t_fib_ip_addr));
+        key_if_index = p_nh->key.if_index;
+
+        /* Let the writers of the AF in after a chunk, the walk resumes from the key */
+        if (++count >= HAL_RT_GET_CHUNK) {
+            hal_rt_vrf_unlock (vrf_id, af);
+            count = 0;
+            hal_rt_vrf_read_lock (vrf_id, af);
+        }
+
+        p_nh = fib_get_next_nh (vrf_id, &key_ip_addr, key_if_index);
     }
-    nas_l3_unlock();
+    hal_rt_vrf_unlock (vrf_id, af);
     return STD_ERR_OK;
 }
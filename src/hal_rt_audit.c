@@ -0,0 +1,498 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_audit.c
+ * \brief  Shadow consistency audit of the routes and neighbors
+ *
+ * The audit thread walks the DR and NH trees of each VRF every audit
+ * interval, or when an audit is started, HAL_RT_AUDIT_CHUNK entries at a
+ * time under the NAS L3 lock and HAL_RT_AUDIT_CHUNK_DELAY apart, so the
+ * route updates go on during the audit. The walk resumes from the key of
+ * the last entry audited. The written state of a route or neighbor is
+ * checked against its shadow, the record of the last NPU write, and a
+ * host against the FIB entry it was written from. An entry that differs
+ * is written again by the DR or NH walker. The NPU tables are not read
+ * back, an entry changed or left in the NPU behind the FIB is not seen.
+ * The entries being resolved or retried are skipped, they are written
+ * anyway. A next hop object that differs from the next hop id of the FH
+ * is reported only.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_api.h"
+#include "hal_rt_util.h"
+#include "hal_rt_debug.h"
+#include "hal_rt_mpath_grp.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+#include "std_thread_tools.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static t_fib_audit                g_fib_audit;
+static t_hal_rt_audit_stats       g_fib_audit_stats;
+static t_fib_audit_route_key      g_fib_audit_route_key;
+static t_fib_audit_host_key       g_fib_audit_host_key;
+static bool                       g_fib_audit_is_requested = false;
+static std_thread_create_param_t  g_fib_audit_thr;
+static pthread_mutex_t            g_fib_audit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t             g_fib_audit_cond = PTHREAD_COND_INITIALIZER;
+
+static void fib_audit_sleep (uint32_t msecs)
+{
+    struct timespec delay;
+
+    delay.tv_sec  = msecs / 1000;
+    delay.tv_nsec = (msecs % 1000) * 1000000;
+    nanosleep (&delay, NULL);
+}
+
+/*
+ * Returns true if the route is to be written again to the unit. A route
+ * written without a shadow is replaced, a shadow left behind a route not
+ * written is cleared and the route resolved again.
+ */
+static bool fib_audit_dr_unit (t_fib_dr *p_dr, npu_id_t unit)
+{
+    const t_fib_route_shadow *p_shadow = hal_rt_route_shadow_get (p_dr, unit);
+    bool                      is_shadow_valid = ((p_shadow != NULL) && (p_shadow->is_valid));
+
+    if (p_dr->a_is_written [unit] == is_shadow_valid)
+        return false;
+
+    if (is_shadow_valid)
+        hal_rt_route_shadow_clear (p_dr, unit);
+
+    return true;
+}
+
+/*
+ * Returns true if the DR was marked for resolution.
+ */
+static bool fib_audit_dr (t_fib_dr *p_dr)
+{
+    npu_id_t  unit;
+    bool      is_mismatch = false;
+
+    if ((p_dr->status_flag & FIB_DR_STATUS_REQ_RESOLVE) || (p_dr->p_retry != NULL)) {
+        g_fib_audit_stats.num_skipped++;
+        return false;
+    }
+
+    g_fib_audit_stats.num_routes_audited++;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        if (fib_audit_dr_unit (p_dr, unit))
+            is_mismatch = true;
+    }
+
+    if (!is_mismatch)
+        return false;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-AUDIT",
+            "Route mismatch. VRF %d. Prefix: %s/%d, status_flag: 0x%x\r\n",
+            p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+            p_dr->status_flag);
+
+    g_fib_audit_stats.num_route_mismatch++;
+    g_fib_audit_stats.num_repaired++;
+    fib_mark_dr_for_resolution (p_dr);
+
+    return true;
+}
+
+/*
+ * Returns true if the host is to be written again to the unit. A host
+ * written without a shadow, or whose shadow is not of the FH as it is
+ * now, is replaced by the NH walker, its shadow being cleared.
+ */
+static bool fib_audit_fh_unit (t_fib_nh *p_fh, npu_id_t unit)
+{
+    const t_fib_nbr_shadow *p_shadow = &p_fh->a_nbr_shadow [unit];
+    ndi_neighbor_t          nbr_entry;
+    bool                    is_written = p_fh->a_is_written [unit];
+
+    if (is_written != (bool) p_shadow->is_valid) {
+        hal_rt_nbr_shadow_clear (p_fh, unit);
+        return true;
+    }
+
+    if (!is_written)
+        return false;
+
+    memset (&nbr_entry, 0, sizeof (nbr_entry));
+    if (hal_form_nbr_entry (&nbr_entry, p_fh) != STD_ERR_OK)
+        return false;
+
+    nbr_entry.rif_id = hal_rif_index_get (unit, p_fh->vrf_id, p_fh->key.if_index);
+
+    /* The MAC of a host not forwarded is not the one of the FH */
+    if ((p_shadow->rif_id != nbr_entry.rif_id) ||
+        ((p_shadow->action == (uint32_t) NDI_ROUTE_PACKET_ACTION_FORWARD) &&
+         ((p_shadow->vlan_id != (uint32_t) nbr_entry.egress_data.vlan_id) ||
+          (p_shadow->port_tgid != (uint32_t) nbr_entry.egress_data.port_tgid) ||
+          (memcmp (p_shadow->mac_addr, &nbr_entry.egress_data.neighbor_mac,
+                   HAL_RT_MAC_ADDR_LEN))))) {
+        hal_rt_nbr_shadow_clear (p_fh, unit);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * The next hop object of the FH on the first unit is checked against the
+ * next hop id of the FH.
+ */
+static void fib_audit_fh_egr (t_fib_nh *p_fh)
+{
+    next_hop_id_t  nh_handle;
+    npu_id_t       unit;
+
+    p_fh->is_audit_egr_id_in_hw   = false;
+    p_fh->is_audit_egr_id_corrupt = false;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        nh_handle = hal_rt_nh_obj_id_get (p_fh, unit);
+        if (nh_handle == 0)
+            continue;
+
+        p_fh->is_audit_egr_id_in_hw = true;
+        if ((unit == 0) && (p_fh->next_hop_id != nh_handle))
+            p_fh->is_audit_egr_id_corrupt = true;
+    }
+
+    if (p_fh->is_audit_egr_id_corrupt) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-AUDIT",
+                "Next hop id mismatch. VRF %d. Addr: %s, Interface: %d, NH id: %d\r\n",
+                p_fh->vrf_id, FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
+                p_fh->key.if_index, p_fh->next_hop_id);
+        g_fib_audit_stats.num_egr_mismatch++;
+    }
+}
+
+/*
+ * Returns true if the NH was marked for resolution. Only the FHs learnt
+ * from ARP are written as hosts.
+ */
+static bool fib_audit_nh (t_fib_nh *p_nh)
+{
+    npu_id_t  unit;
+    bool      is_mismatch = false;
+
+    if ((!(FIB_IS_NH_FH (p_nh))) || (!(FIB_IS_NH_OWNER_ARP (p_nh))) ||
+        (FIB_IS_NH_LOOP_BACK (p_nh)) || (FIB_IS_NH_ZERO (p_nh)))
+        return false;
+
+    if ((p_nh->status_flag & (FIB_NH_STATUS_REQ_RESOLVE | FIB_NH_STATUS_PENDING)) ||
+        (p_nh->p_retry != NULL)) {
+        g_fib_audit_stats.num_skipped++;
+        return false;
+    }
+
+    g_fib_audit_stats.num_hosts_audited++;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        if (fib_audit_fh_unit (p_nh, unit))
+            is_mismatch = true;
+    }
+
+    fib_audit_fh_egr (p_nh);
+    p_nh->is_audit_egr_info_matched = (!is_mismatch);
+
+    if (!is_mismatch)
+        return false;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-AUDIT",
+            "Host mismatch. VRF %d. Addr: %s, Interface: %d, status_flag: 0x%x\r\n",
+            p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
+            p_nh->status_flag);
+
+    g_fib_audit_stats.num_host_mismatch++;
+    g_fib_audit_stats.num_repaired++;
+    fib_mark_nh_for_resolution (p_nh);
+
+    return true;
+}
+
+/*
+ * Audits the next HAL_RT_AUDIT_CHUNK DRs of the VRF from the saved key.
+ * Returns true when the DR tree is done.
+ */
+static bool fib_audit_dr_chunk (uint32_t vrf_id, uint8_t af_index, bool *p_is_marked)
+{
+    t_fib_audit_route_key *p_key = &g_fib_audit_route_key;
+    t_fib_dr              *p_dr;
+    uint32_t               count;
+
+    if (g_fib_audit.is_first) {
+        p_dr = fib_get_first_dr (vrf_id, af_index);
+        g_fib_audit.is_first = false;
+    } else {
+        p_dr = fib_get_next_dr (p_key->vrf_id, &p_key->prefix, p_key->prefix_len);
+    }
+
+    for (count = 0; (p_dr != NULL) && (count < HAL_RT_AUDIT_CHUNK); count++) {
+        if (fib_audit_dr (p_dr))
+            *p_is_marked = true;
+
+        p_key->vrf_id = p_dr->vrf_id;
+        memcpy (&p_key->prefix, &p_dr->key.prefix, sizeof (t_fib_ip_addr));
+        p_key->prefix_len = p_dr->prefix_len;
+
+        p_dr = fib_get_next_dr (p_key->vrf_id, &p_key->prefix, p_key->prefix_len);
+    }
+
+    return (p_dr == NULL);
+}
+
+/*
+ * Audits the next HAL_RT_AUDIT_CHUNK NHs of the VRF from the saved key.
+ * Returns true when the NH tree is done.
+ */
+static bool fib_audit_nh_chunk (uint32_t vrf_id, uint8_t af_index, bool *p_is_marked)
+{
+    t_fib_audit_host_key *p_key = &g_fib_audit_host_key;
+    t_fib_nh             *p_nh;
+    uint32_t              count;
+
+    if (g_fib_audit.is_first) {
+        p_nh = fib_get_first_nh (vrf_id, af_index);
+        g_fib_audit.is_first = false;
+    } else {
+        p_nh = fib_get_next_nh (p_key->vrf_id, &p_key->ip_addr, p_key->if_index);
+    }
+
+    for (count = 0; (p_nh != NULL) && (count < HAL_RT_AUDIT_CHUNK); count++) {
+        if (fib_audit_nh (p_nh))
+            *p_is_marked = true;
+
+        p_key->vrf_id = p_nh->vrf_id;
+        memcpy (&p_key->ip_addr, &p_nh->key.ip_addr, sizeof (t_fib_ip_addr));
+        p_key->if_index = p_nh->key.if_index;
+
+        p_nh = fib_get_next_nh (p_key->vrf_id, &p_key->ip_addr, p_key->if_index);
+    }
+
+    return (p_nh == NULL);
+}
+
+/*
+ * Walks a tree of the VRF a chunk at a time. The queued writes are done
+ * before each chunk, the NPU is then as in the FIB.
+ */
+static void fib_audit_tree (uint32_t vrf_id, uint8_t af_index, bool is_dr_tree)
+{
+    bool  is_over = false;
+    bool  is_marked;
+
+    g_fib_audit.is_first = true;
+
+    while ((!is_over) && (!g_fib_audit.to_be_stopped)) {
+        is_marked = false;
+
+        hal_rt_vrf_write_lock (vrf_id, af_index);
+        nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_AUDIT);
+        hal_rt_route_bulk_flush (af_index);
+        hal_rt_nbr_bulk_flush (af_index);
+
+        if (is_dr_tree)
+            is_over = fib_audit_dr_chunk (vrf_id, af_index, &is_marked);
+        else
+            is_over = fib_audit_nh_chunk (vrf_id, af_index, &is_marked);
+        nas_l3_unlock_af (af_index);
+        hal_rt_vrf_unlock (vrf_id, af_index);
+
+        if ((is_marked) && (is_dr_tree))
+            fib_resume_dr_walker_thread (af_index);
+        else if (is_marked)
+            fib_resume_nh_walker_thread (af_index);
+
+        if (!is_over)
+            fib_audit_sleep (HAL_RT_AUDIT_CHUNK_DELAY);
+    }
+}
+
+static void fib_audit_run (void)
+{
+    uint32_t  vrf_id;
+    uint8_t   af_index;
+
+    g_fib_audit.status = FIB_AUDIT_STARTED;
+    g_fib_audit.to_be_stopped = false;
+    g_fib_audit.last_audit_start_time = (uint64_t) time (NULL);
+
+    g_fib_audit_stats.num_routes_audited = 0;
+    g_fib_audit_stats.num_hosts_audited  = 0;
+    g_fib_audit_stats.num_route_mismatch = 0;
+    g_fib_audit_stats.num_host_mismatch  = 0;
+    g_fib_audit_stats.num_egr_mismatch   = 0;
+    g_fib_audit_stats.num_skipped        = 0;
+    g_fib_audit_stats.num_repaired       = 0;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-AUDIT", "Audit started\r\n");
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            if (FIB_GET_VRF_INFO (vrf_id, af_index) == NULL)
+                continue;
+
+            g_fib_audit.af_index = af_index;
+            fib_audit_tree (vrf_id, af_index, true);
+            fib_audit_tree (vrf_id, af_index, false);
+        }
+    }
+
+    g_fib_audit_stats.tot_mismatch += g_fib_audit_stats.num_route_mismatch +
+                                      g_fib_audit_stats.num_host_mismatch;
+    g_fib_audit_stats.tot_repaired += g_fib_audit_stats.num_repaired;
+
+    if (!g_fib_audit.to_be_stopped)
+        g_fib_audit.num_audits_completed++;
+
+    g_fib_audit.last_audit_end_time = (uint64_t) time (NULL);
+    g_fib_audit.status = FIB_AUDIT_NOT_STARTED;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-AUDIT",
+            "Audit %s. Routes: %d, Hosts: %d, Mismatches: %d/%d, Repaired: %d, "
+            "Egress mismatches: %d\r\n",
+            (g_fib_audit.to_be_stopped) ? "stopped" : "done",
+            g_fib_audit_stats.num_routes_audited, g_fib_audit_stats.num_hosts_audited,
+            g_fib_audit_stats.num_route_mismatch, g_fib_audit_stats.num_host_mismatch,
+            g_fib_audit_stats.num_repaired, g_fib_audit_stats.num_egr_mismatch);
+}
+
+static void fib_audit_thread_main (void)
+{
+    struct timespec  wake_time;
+    bool             is_requested;
+
+    for ( ; ; )
+    {
+        pthread_mutex_lock (&g_fib_audit_mutex);
+        while (!g_fib_audit_is_requested) {
+            g_fib_audit.curr_cfg = g_fib_audit.next_cfg;
+
+            if ((!g_fib_audit.enabled) || (g_fib_audit.curr_cfg.interval == 0)) {
+                pthread_cond_wait (&g_fib_audit_cond, &g_fib_audit_mutex);
+                continue;
+            }
+
+            clock_gettime (CLOCK_REALTIME, &wake_time);
+            wake_time.tv_sec += g_fib_audit.curr_cfg.interval * 60;
+            if (pthread_cond_timedwait (&g_fib_audit_cond, &g_fib_audit_mutex,
+                                        &wake_time) != 0)
+                break;
+        }
+        is_requested = g_fib_audit_is_requested;
+        g_fib_audit_is_requested = false;
+        g_fib_audit.curr_cfg = g_fib_audit.next_cfg;
+        pthread_mutex_unlock (&g_fib_audit_mutex);
+
+        g_fib_audit.last_audit_wake_up_time = (uint64_t) time (NULL);
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-AUDIT", "Audit wake up, %s\r\n",
+                     (is_requested) ? "requested" : "periodic");
+
+        fib_audit_run ();
+    }
+}
+
+t_std_error hal_rt_audit_init (void)
+{
+    memset (&g_fib_audit, 0, sizeof (g_fib_audit));
+    memset (&g_fib_audit_stats, 0, sizeof (g_fib_audit_stats));
+
+    g_fib_audit.enabled = true;
+    g_fib_audit.status  = FIB_AUDIT_NOT_STARTED;
+    g_fib_audit.curr_cfg.interval = FIB_AUDIT_DEF_INTERVAL;
+    g_fib_audit.next_cfg.interval = FIB_AUDIT_DEF_INTERVAL;
+
+    if (hal_rt_thread_create (&g_fib_audit_thr, HAL_RT_THREAD_AUDIT,
+                              (std_thread_function_t) fib_audit_thread_main,
+                              NULL) != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating audit thread");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+/*
+ * Starts an audit now. An audit in progress is completed first.
+ */
+void hal_rt_audit_start (void)
+{
+    pthread_mutex_lock (&g_fib_audit_mutex);
+    g_fib_audit_is_requested = true;
+    pthread_cond_signal (&g_fib_audit_cond);
+    pthread_mutex_unlock (&g_fib_audit_mutex);
+}
+
+/*
+ * Sets the audit interval in minutes, 0 stops the periodic audit and the
+ * audit in progress. The interval is used from the next audit.
+ */
+void hal_rt_audit_set_interval (uint32_t interval)
+{
+    pthread_mutex_lock (&g_fib_audit_mutex);
+    g_fib_audit.next_cfg.interval = interval;
+    if (interval == 0)
+        g_fib_audit.to_be_stopped = true;
+    pthread_cond_signal (&g_fib_audit_cond);
+    pthread_mutex_unlock (&g_fib_audit_mutex);
+}
+
+const t_fib_audit *hal_rt_access_fib_audit (void)
+{
+    return &g_fib_audit;
+}
+
+const t_hal_rt_audit_stats *hal_rt_access_audit_stats (void)
+{
+    return &g_fib_audit_stats;
+}
+
+void fib_start_audit (void)
+{
+    hal_rt_audit_start ();
+}
+
+void fib_dump_audit_stats (void)
+{
+    printf ("**************************************************\r\n");
+    printf ("  status                :  %s\r\n",
+            (g_fib_audit.status == FIB_AUDIT_STARTED) ? "Started" : "Not started");
+    printf ("  interval              :  %d\r\n", g_fib_audit.curr_cfg.interval);
+    printf ("  num_audits_completed  :  %d\r\n", g_fib_audit.num_audits_completed);
+    printf ("  last_audit_start_time :  %llu\r\n",
+            (unsigned long long) g_fib_audit.last_audit_start_time);
+    printf ("  last_audit_end_time   :  %llu\r\n",
+            (unsigned long long) g_fib_audit.last_audit_end_time);
+    printf ("  num_routes_audited    :  %d\r\n", g_fib_audit_stats.num_routes_audited);
+    printf ("  num_hosts_audited     :  %d\r\n", g_fib_audit_stats.num_hosts_audited);
+    printf ("  num_route_mismatch    :  %d\r\n", g_fib_audit_stats.num_route_mismatch);
+    printf ("  num_host_mismatch     :  %d\r\n", g_fib_audit_stats.num_host_mismatch);
+    printf ("  num_egr_mismatch      :  %d\r\n", g_fib_audit_stats.num_egr_mismatch);
+    printf ("  num_skipped           :  %d\r\n", g_fib_audit_stats.num_skipped);
+    printf ("  num_repaired          :  %d\r\n", g_fib_audit_stats.num_repaired);
+    printf ("  tot_mismatch          :  %d\r\n", g_fib_audit_stats.tot_mismatch);
+    printf ("  tot_repaired          :  %d\r\n", g_fib_audit_stats.tot_repaired);
+    printf ("**************************************************\r\n");
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_cam.c
+ * \brief  NPU table occupancy model
+ *
+ * The entries written to the route, host, next hop and group tables of
+ * the NPUs are counted against the table capacity. The capacity is read
+ * from NDI when it reports the table sizes, else it is learnt from the
+ * entries in use when NDI fails a write as the table is full. A table is
+ * at the high level above the high threshold until it goes below the low
+ * threshold, each level change is published as a CPS event. A new route for a full
+ * table is not written but queued for retry, it is retried as soon as the
+ * table has room.
+ *
+ * The host, next hop and group tables are shared by the AFs, the model is
+ * guarded by its own mutex. No lock is taken under it, the level changes
+ * are published after it is released.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_util.h"
+#include "hal_rt_debug.h"
+#include "hal_rt_mpath_grp.h"
+#include "hal_rt_ndi_opt.h"
+#include "nas_rt_api.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef t_std_error (*t_fib_ndi_table_size_get_fn) (npu_id_t npu_id, uint32_t table,
+                                                    uint32_t *p_size);
+
+static const char *ga_fib_cam_name [HAL_RT_CAM_MAX] = {
+    "IPv4 LPM",
+    "IPv6 LPM /64",
+    "IPv6 LPM /128",
+    "Host",
+    "Next hop",
+    "Next hop group",
+};
+
+static pthread_mutex_t     g_fib_cam_mutex = PTHREAD_MUTEX_INITIALIZER;
+static t_hal_rt_cam_usage  ga_fib_cam_usage [HAL_RT_CAM_MAX];
+
+/*
+ * The groups are counted by the ECMP group pressure, the group table of
+ * the model follows it.
+ */
+static void fib_sync_cam_nh_grp (void)
+{
+    t_fib_ecmp_grp_pressure *p_pressure = hal_rt_access_ecmp_grp_pressure ();
+    t_hal_rt_cam_usage      *p_usage = &ga_fib_cam_usage [HAL_RT_CAM_NH_GRP];
+
+    pthread_mutex_lock (&g_fib_cam_mutex);
+    p_usage->in_use = p_pressure->num_grps_in_use;
+    if (p_pressure->grp_capacity > 0)
+        p_usage->capacity = p_pressure->grp_capacity;
+    pthread_mutex_unlock (&g_fib_cam_mutex);
+}
+
+/*
+ * The table sizes are read from NDI if it has the table size API, the
+ * smallest size of the NPUs is the capacity of the table.
+ */
+t_std_error hal_rt_cam_init (void)
+{
+    t_fib_ndi_table_size_get_fn  size_get_fn;
+    uint32_t                     cam;
+    uint32_t                     size;
+    npu_id_t                     unit;
+
+    memset (ga_fib_cam_usage, 0, sizeof (ga_fib_cam_usage));
+
+    size_get_fn = ndi_route_table_size_get;
+    if (size_get_fn == NULL)
+        return STD_ERR_OK;
+
+    for (cam = 0; cam < HAL_RT_CAM_MAX; cam++) {
+        for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+            size = 0;
+            if ((size_get_fn (unit, cam, &size) != STD_ERR_OK) || (size == 0))
+                continue;
+
+            if ((ga_fib_cam_usage [cam].capacity == 0) ||
+                (size < ga_fib_cam_usage [cam].capacity))
+                ga_fib_cam_usage [cam].capacity = size;
+        }
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-CAM", "%s table capacity: %d\r\n",
+                     ga_fib_cam_name [cam], ga_fib_cam_usage [cam].capacity);
+    }
+    return STD_ERR_OK;
+}
+
+const t_hal_rt_cam_usage *hal_rt_access_cam_usage (t_hal_rt_cam cam)
+{
+    if (cam >= HAL_RT_CAM_MAX)
+        return NULL;
+
+    if (cam == HAL_RT_CAM_NH_GRP)
+        fib_sync_cam_nh_grp ();
+
+    return &ga_fib_cam_usage [cam];
+}
+
+const char *hal_rt_cam_name (t_hal_rt_cam cam)
+{
+    return ((cam < HAL_RT_CAM_MAX) ? ga_fib_cam_name [cam] : "");
+}
+
+t_hal_rt_cam hal_rt_cam_get_route_cam (uint8_t af_index, uint8_t prefix_len)
+{
+    if (af_index == HAL_RT_V4_AFINDEX)
+        return HAL_RT_CAM_IPV4_LPM;
+
+    return ((prefix_len <= HAL_RT_CAM_IPV6_LPM_64_LEN) ?
+            HAL_RT_CAM_IPV6_LPM_64 : HAL_RT_CAM_IPV6_LPM_128);
+}
+
+dn_hal_route_err hal_fib_get_cam_string (int pefix_len, uint8_t af_index, uint8_t is_host_add,
+                                         uint8_t *p_str)
+{
+    t_hal_rt_cam cam;
+
+    if (p_str == NULL)
+        return DN_HAL_ROUTE_E_PARAM;
+
+    cam = (is_host_add) ? HAL_RT_CAM_HOST :
+          hal_rt_cam_get_route_cam (af_index, (uint8_t) pefix_len);
+
+    snprintf ((char *) p_str, HAL_RT_CAM_NAME_LEN, "%s", ga_fib_cam_name [cam]);
+
+    return DN_HAL_ROUTE_E_NONE;
+}
+
+void hal_rt_cam_entry_add (t_hal_rt_cam cam)
+{
+    t_hal_rt_cam_usage *p_usage = &ga_fib_cam_usage [cam];
+
+    pthread_mutex_lock (&g_fib_cam_mutex);
+    p_usage->in_use++;
+
+    /* The table took more entries than learnt, the write failure was not for space */
+    if ((p_usage->is_learnt) && (p_usage->in_use > p_usage->capacity))
+        p_usage->capacity = p_usage->in_use;
+    pthread_mutex_unlock (&g_fib_cam_mutex);
+}
+
+void hal_rt_cam_entry_del (t_hal_rt_cam cam)
+{
+    t_hal_rt_cam_usage *p_usage = &ga_fib_cam_usage [cam];
+
+    pthread_mutex_lock (&g_fib_cam_mutex);
+    if (p_usage->in_use > 0)
+        p_usage->in_use--;
+    pthread_mutex_unlock (&g_fib_cam_mutex);
+}
+
+/*
+ * NDI failed to add an entry to the table. Unless NDI reported the size
+ * of the table, the entries in use give the capacity of the table if the
+ * table was full, any other failure is only retried.
+ */
+void hal_rt_cam_write_failed (t_hal_rt_cam cam, bool is_table_full)
+{
+    t_hal_rt_cam_usage *p_usage = &ga_fib_cam_usage [cam];
+    uint32_t            in_use;
+    uint32_t            capacity;
+
+    pthread_mutex_lock (&g_fib_cam_mutex);
+    p_usage->num_write_failed++;
+
+    if ((is_table_full) && ((p_usage->capacity == 0) || (p_usage->is_learnt)) &&
+        (p_usage->in_use > 0)) {
+        p_usage->capacity = p_usage->in_use;
+        p_usage->is_learnt = true;
+    }
+
+    in_use   = p_usage->in_use;
+    capacity = p_usage->capacity;
+    pthread_mutex_unlock (&g_fib_cam_mutex);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-CAM",
+            "%s table write failed%s. In use: %d, Capacity: %d\r\n",
+            ga_fib_cam_name [cam], (is_table_full) ? " (table full)" : "",
+            in_use, capacity);
+}
+
+bool hal_rt_cam_is_full (t_hal_rt_cam cam)
+{
+    const t_hal_rt_cam_usage *p_usage = hal_rt_access_cam_usage (cam);
+
+    return ((p_usage->capacity != 0) && (p_usage->in_use >= p_usage->capacity));
+}
+
+void hal_rt_cam_route_add (t_fib_dr *p_dr)
+{
+    hal_rt_cam_entry_add (hal_rt_cam_get_route_cam (p_dr->key.prefix.af_index,
+                                                    p_dr->prefix_len));
+}
+
+void hal_rt_cam_route_del (t_fib_dr *p_dr)
+{
+    hal_rt_cam_entry_del (hal_rt_cam_get_route_cam (p_dr->key.prefix.af_index,
+                                                    p_dr->prefix_len));
+}
+
+/*
+ * Called before a route that is not written yet is written. Returns true
+ * if the table of the route is full, the route is then queued for retry.
+ */
+bool hal_rt_cam_route_defer (t_fib_dr *p_dr)
+{
+    t_hal_rt_cam cam = hal_rt_cam_get_route_cam (p_dr->key.prefix.af_index,
+                                                 p_dr->prefix_len);
+
+    if (!hal_rt_cam_is_full (cam))
+        return false;
+
+    FIB_CNTRS_ADD (ga_fib_cam_usage [cam].num_rejected, 1);
+    hal_rt_retry_dr_add (p_dr, HAL_RT_RETRY_RSN_TABLE_FULL);
+
+    return true;
+}
+
+static uint32_t fib_get_cam_level (const t_hal_rt_cam_usage *p_usage)
+{
+    const t_fib_config *p_config = hal_rt_access_fib_config ();
+    uint64_t            used = ((uint64_t) p_usage->in_use) * 100;
+
+    if (p_usage->capacity == 0)
+        return HAL_RT_CAM_LEVEL_NORMAL;
+
+    if (p_usage->in_use >= p_usage->capacity)
+        return HAL_RT_CAM_LEVEL_FULL;
+
+    if (used >= ((uint64_t) p_usage->capacity) * p_config->cam_high_threshold)
+        return HAL_RT_CAM_LEVEL_HIGH;
+
+    /* The high level is cleared only below the low threshold */
+    if ((p_usage->level != HAL_RT_CAM_LEVEL_NORMAL) &&
+        (used >= ((uint64_t) p_usage->capacity) * p_config->cam_low_threshold))
+        return HAL_RT_CAM_LEVEL_HIGH;
+
+    return HAL_RT_CAM_LEVEL_NORMAL;
+}
+
+/*
+ * Called after the entries of the tables change, the action tells whether
+ * entries were added or deleted. The level of each table is updated and
+ * a level change is published.
+ */
+void fib_check_threshold_for_all_cams (int action)
+{
+    t_hal_rt_cam_usage *p_usage;
+    cps_api_object_t    obj;
+    uint32_t            level;
+    uint32_t            cam;
+    bool                a_is_changed [HAL_RT_CAM_MAX];
+
+    fib_sync_cam_nh_grp ();
+
+    pthread_mutex_lock (&g_fib_cam_mutex);
+    for (cam = 0; cam < HAL_RT_CAM_MAX; cam++) {
+        p_usage = &ga_fib_cam_usage [cam];
+
+        level = fib_get_cam_level (p_usage);
+        a_is_changed [cam] = (level != p_usage->level);
+        if (!a_is_changed [cam])
+            continue;
+
+        p_usage->level = level;
+        p_usage->num_events++;
+    }
+    pthread_mutex_unlock (&g_fib_cam_mutex);
+
+    for (cam = 0; cam < HAL_RT_CAM_MAX; cam++) {
+        if (!a_is_changed [cam])
+            continue;
+
+        p_usage = &ga_fib_cam_usage [cam];
+        level = p_usage->level;
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-CAM",
+                "%s table level %d. In use: %d, Capacity: %d, Action: %s\r\n",
+                ga_fib_cam_name [cam], level, p_usage->in_use, p_usage->capacity,
+                (action) ? "Add" : "Del");
+
+        obj = nas_route_cam_usage_to_cps_obj (cam);
+        if ((obj != NULL) && (nas_route_publish_object (obj) != STD_ERR_OK)) {
+            EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-CAM",
+                    "Failed to publish the %s table level\r\n", ga_fib_cam_name [cam]);
+        }
+    }
+}
+
+void fib_dump_cam_stats (void)
+{
+    const t_hal_rt_cam_usage *p_usage;
+    uint32_t                  cam;
+
+    printf ("**************************************************\r\n");
+    for (cam = 0; cam < HAL_RT_CAM_MAX; cam++) {
+        p_usage = hal_rt_access_cam_usage (cam);
+
+        printf ("  %s\r\n", ga_fib_cam_name [cam]);
+        printf ("    in_use              :  %d\r\n", p_usage->in_use);
+        printf ("    capacity            :  %d\r\n", p_usage->capacity);
+        printf ("    is_learnt           :  %d\r\n", p_usage->is_learnt);
+        printf ("    level               :  %d\r\n", p_usage->level);
+        printf ("    num_write_failed    :  %d\r\n", p_usage->num_write_failed);
+        printf ("    num_rejected        :  %d\r\n", p_usage->num_rejected);
+        printf ("    num_deferred        :  %d\r\n", hal_rt_retry_num_table_full (cam));
+        printf ("    num_events          :  %d\r\n", p_usage->num_events);
+    }
+    printf ("**************************************************\r\n");
+}
@@ -24,12 +24,14 @@
 #include "hal_rt_api.h"
 #include "hal_rt_debug.h"
 #include "hal_rt_util.h"
+#include "hal_rt_mpath_grp.h"
 
 #include "std_ip_utils.h"
 
 #include <stdio.h>
 #include <netinet/in.h>
 #include <string.h>
+#include <time.h>
 
 void fib_help (void)
 {
@@ -96,6 +98,42 @@ void fib_help (void)
 
     printf ("  fib_dump_all_cntrs ()\r\n");
 
+    printf ("  fib_dump_ecmp_grp_stats_per_vrf_per_af (uint32_t vrf_id, \r\n");
+    printf ("                        uint8_t af_index, uint32_t top_n)\r\n");
+
+    printf ("  fib_dump_all_ecmp_grp_stats (uint32_t top_n)\r\n");
+
+    printf ("  fib_dump_route_bulk_stats ()\r\n");
+
+    printf ("  fib_dump_nbr_bulk_stats ()\r\n");
+
+    printf ("  fib_dump_npu_worker_stats ()\r\n");
+
+    printf ("  fib_dump_pgm_stats ()\r\n");
+
+    printf ("  fib_dump_nbr_queue_stats ()\r\n");
+
+    printf ("  fib_dump_shadow_stats ()\r\n");
+
+    printf ("  fib_dump_nh_obj_stats ()\r\n");
+
+    printf ("  fib_dump_cam_stats ()\r\n");
+
+    printf ("  fib_dump_retry_stats ()\r\n");
+
+    printf ("  fib_dump_audit_stats ()\r\n");
+
+    printf ("  fib_start_audit ()\r\n");
+
+    printf ("  fib_dump_lock_stats ()\r\n");
+
+    printf ("  fib_set_lock_prof (int is_enabled)\r\n");
+
+    printf ("  fib_dump_thread_config ()\r\n");
+
+    printf ("  fib_set_thread_sched (uint32_t thread, uint32_t cpu_mask, \r\n");
+    printf ("                        int policy, int priority)\r\n");
+
     printf ("  fib_dump_all_db ()\r\n");
 
     printf ("  fib_dump_all_vrf_peer_routing_config ()\r\n");
@@ -121,6 +159,51 @@ void fib_dump_config (void)
     printf ("  ecmp_hash_sel                       :  %d\r\n",
             (hal_rt_access_fib_config())->ecmp_hash_sel);
 
+    printf ("  ecmp_grp_incr_update                 :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_grp_incr_update);
+
+    printf ("  ecmp_nh_fast_reroute                 :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_nh_fast_reroute);
+
+    printf ("  hierarchical_fib                     :  %d\r\n",
+            (hal_rt_access_fib_config())->hierarchical_fib);
+
+    printf ("  ecmp_native_weight                   :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_native_weight);
+
+    printf ("  ecmp_resilient_hash                  :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_resilient_hash);
+
+    printf ("  ecmp_resilient_buckets               :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_resilient_buckets);
+
+    printf ("  ecmp_grp_gc_grace_period             :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_grp_gc_grace_period);
+
+    printf ("  ecmp_grp_max                         :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_grp_max);
+
+    printf ("  ecmp_grp_share_policy                :  %d\r\n",
+            (hal_rt_access_fib_config())->ecmp_grp_share_policy);
+
+    printf ("  route_bulk_size                      :  %d\r\n",
+            (hal_rt_access_fib_config())->route_bulk_size);
+
+    printf ("  nbr_bulk_size                        :  %d\r\n",
+            (hal_rt_access_fib_config())->nbr_bulk_size);
+
+    printf ("  ndi_async_pgm                        :  %d\r\n",
+            (hal_rt_access_fib_config())->ndi_async_pgm);
+
+    printf ("  cam_high_threshold                   :  %d\r\n",
+            (hal_rt_access_fib_config())->cam_high_threshold);
+
+    printf ("  cam_low_threshold                    :  %d\r\n",
+            (hal_rt_access_fib_config())->cam_low_threshold);
+
+    printf ("  cps_num_threads                      :  %d\r\n",
+            (hal_rt_access_fib_config())->cps_num_threads);
+
     printf ("**************************************************\r\n");
 
     return;
@@ -324,6 +407,8 @@ void fib_dump_dr_node (t_fib_dr *p_dr)
 
         printf ("-------------------------------------\r\n");
         fib_dump_nh_node_key (p_nh);
+        printf ("  weight                   :  %d\r\n",
+                FIB_GET_DRNH_NODE_FROM_NH_HOLDER (nh_holder)->weight);
         printf ("-------------------------------------\r\n");
 
         count++;
@@ -346,6 +431,7 @@ void fib_dump_dr_node (t_fib_dr *p_dr)
         p_dr_fh = FIB_GET_DRFH_NODE_FROM_NH_HOLDER (nh_holder);
 
         printf ("  status                   :  %d\r\n", p_dr_fh->status);
+        printf ("  ecmp_weight_count        :  %d\r\n", p_dr_fh->ecmp_weight_count);
         printf ("-------------------------------------\r\n");
 
         count++;
@@ -414,6 +500,7 @@ void fib_dump_nh_node (t_fib_nh *p_nh)
     t_fib_nh_holder  nh_holder;
     uint32_t     count = 0;
     t_fib_tunnel_fh  *p_tunnel_fh = NULL;
+    t_fib_mp_obj     *p_mp_obj = NULL;
     char              p_buf[HAL_RT_MAX_BUFSZ];
 
     if (!p_nh)
@@ -475,6 +562,14 @@ void fib_dump_nh_node (t_fib_nh *p_nh)
     printf ("  arp_last_update_time  :  %ld\r\n", p_nh->arp_last_update_time);
     printf ("  p_hal_nh_handle         :  %p\r\n", p_nh->p_hal_nh_handle);
 
+    p_mp_obj = hal_rt_get_nh_indirect_mp_obj (p_nh, 0);
+    if (p_mp_obj != NULL)
+    {
+        printf ("  indirect_grp_id         :  %d\r\n", (int) p_mp_obj->sai_ecmp_gid);
+        printf ("  indirect_grp_count      :  %d\r\n", p_mp_obj->ecmp_count);
+        printf ("  indirect_grp_ref_count  :  %d\r\n", p_mp_obj->ref_count);
+    }
+
     printf ("**************************************************\r\n");
     printf ("  Dep_dr List:\r\n");
     printf ("**************************************************\r\n");
@@ -1227,7 +1322,9 @@ void fib_dump_all_route_summary (void)
 void fib_dump_vrf_cntrs_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
 {
     uint8_t      af_index;
-    t_fib_vrf_cntrs  *p_vrf_cntrs = NULL;
+    t_fib_vrf_cntrs       vrf_cntrs;
+    t_fib_vrf_cntrs      *p_vrf_cntrs = &vrf_cntrs;
+    t_fib_vrf_cntrs_rate  rate;
 
     af_index = (uint8_t) in_af_index;
 
@@ -1243,14 +1340,15 @@ void fib_dump_vrf_cntrs_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
         return;
     }
 
-    p_vrf_cntrs = hal_rt_access_fib_vrf_cntrs(vrf_id, af_index);
-
-    if (p_vrf_cntrs == NULL)
+    if (hal_rt_access_fib_vrf(vrf_id) == NULL)
     {
         printf (" Vrf counters NULL\r\n");
         return;
     }
 
+    hal_rt_fib_vrf_cntrs_get (vrf_id, af_index, &vrf_cntrs);
+    hal_rt_fib_vrf_cntrs_rate_get (vrf_id, af_index, &rate);
+
     printf ("***********************************************\r\n");
     printf ("  Vrf_id: %d, Af_index: %s\r\n", vrf_id, STD_IP_AFINDEX_TO_STR (af_index));
     printf ("***********************************************\r\n");
@@ -1270,6 +1368,16 @@ void fib_dump_vrf_cntrs_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
     printf ("  num_fib_route_entries :  %d\r\n", p_vrf_cntrs->num_fib_route_entries);
     printf ("  num_cam_host_entries  :  %d\r\n", p_vrf_cntrs->num_cam_host_entries);
     printf ("  num_cam_route_entries :  %d\r\n", p_vrf_cntrs->num_cam_route_entries);
+    printf ("  num_ecmp_grp_parked   :  %d\r\n", p_vrf_cntrs->num_ecmp_grp_parked);
+    printf ("  num_ecmp_grp_reused   :  %d\r\n", p_vrf_cntrs->num_ecmp_grp_reused);
+    printf ("  num_ecmp_grp_freed    :  %d\r\n", p_vrf_cntrs->num_ecmp_grp_freed);
+    printf ("  num_ecmp_grp_created  :  %d\r\n", p_vrf_cntrs->num_ecmp_grp_created);
+    printf ("  num_ecmp_grp_replaced :  %d\r\n", p_vrf_cntrs->num_ecmp_grp_replaced);
+    printf ("  num_ecmp_grp_deleted  :  %d\r\n", p_vrf_cntrs->num_ecmp_grp_deleted);
+    printf ("  route_add_rate        :  %d/sec\r\n", rate.route_add_rate);
+    printf ("  route_del_rate        :  %d/sec\r\n", rate.route_del_rate);
+    printf ("  nbr_add_rate          :  %d/sec\r\n", rate.nbr_add_rate);
+    printf ("  nbr_del_rate          :  %d/sec\r\n", rate.nbr_del_rate);
 
     printf ("**************************************************\r\n");
 
@@ -1339,6 +1447,109 @@ void fib_dump_all_cntrs (void)
     return;
 }
 
+void fib_dump_ecmp_grp_stats_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index,
+                                             uint32_t top_n)
+{
+    t_fib_ecmp_grp_stats  stats;
+    uint8_t               af_index;
+
+    af_index = (uint8_t) in_af_index;
+
+    if (!(FIB_IS_VRF_ID_VALID (vrf_id)))
+    {
+        printf (" Invalid vrf_id. Vrf_id: %d\r\n", vrf_id);
+        return;
+    }
+
+    if (af_index >= FIB_MAX_AFINDEX)
+    {
+        printf (" Invalid af_index. Af_index: %d\r\n", af_index);
+        return;
+    }
+
+    memset (&stats, 0, sizeof (stats));
+    hal_rt_fib_get_ecmp_grp_stats (vrf_id, af_index, top_n, &stats);
+
+    printf ("***********************************************\r\n");
+    printf ("  Vrf_id: %d, Af_index: %s\r\n", vrf_id, STD_IP_AFINDEX_TO_STR (af_index));
+    printf ("***********************************************\r\n");
+
+    fib_dump_ecmp_grp_stats (&stats);
+
+    printf ("**************************************************\r\n");
+
+    return;
+}
+
+/*
+ * The create/replace/delete rates are averaged over the time since
+ * the previous fib_dump_all_ecmp_grp_stats ().
+ */
+void fib_dump_all_ecmp_grp_stats (uint32_t top_n)
+{
+    static uint32_t        last_created = 0;
+    static uint32_t        last_replaced = 0;
+    static uint32_t        last_deleted = 0;
+    static time_t          last_time = 0;
+    t_fib_ecmp_grp_stats   stats;
+    t_fib_vrf_cntrs        vrf_cntrs;
+    uint32_t               vrf_id = 0;
+    uint8_t                af_index = 0;
+    uint32_t               num_created = 0;
+    uint32_t               num_replaced = 0;
+    uint32_t               num_deleted = 0;
+    time_t                 now = time (NULL);
+    double                 elapsed;
+
+    memset (&stats, 0, sizeof (stats));
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++)
+    {
+        if (hal_rt_access_fib_vrf (vrf_id) == NULL)
+            continue;
+
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++)
+        {
+            hal_rt_fib_get_ecmp_grp_stats (vrf_id, af_index, top_n, &stats);
+
+            hal_rt_fib_vrf_cntrs_get (vrf_id, af_index, &vrf_cntrs);
+            num_created  += vrf_cntrs.num_ecmp_grp_created;
+            num_replaced += vrf_cntrs.num_ecmp_grp_replaced;
+            num_deleted  += vrf_cntrs.num_ecmp_grp_deleted;
+        }
+    }
+
+    printf ("**************************************************\r\n");
+    printf ("             ECMP Group Statistics                \r\n");
+    printf ("**************************************************\r\n");
+
+    fib_dump_ecmp_grp_stats (&stats);
+
+    printf ("  num_created       :  %d\r\n", num_created);
+    printf ("  num_replaced      :  %d\r\n", num_replaced);
+    printf ("  num_deleted       :  %d\r\n", num_deleted);
+
+    if ((last_time != 0) && (now > last_time) &&
+        (num_created >= last_created) && (num_replaced >= last_replaced) &&
+        (num_deleted >= last_deleted))
+    {
+        elapsed = difftime (now, last_time);
+        printf ("  Rates over the last %.0f secs (per sec):\r\n", elapsed);
+        printf ("    created         :  %.2f\r\n", (num_created - last_created) / elapsed);
+        printf ("    replaced        :  %.2f\r\n", (num_replaced - last_replaced) / elapsed);
+        printf ("    deleted         :  %.2f\r\n", (num_deleted - last_deleted) / elapsed);
+    }
+
+    last_created  = num_created;
+    last_replaced = num_replaced;
+    last_deleted  = num_deleted;
+    last_time     = now;
+
+    printf ("**************************************************\r\n");
+
+    return;
+}
+
 void fib_dump_all_db (void)
 {
     printf ("**************************************************\r\n");
@@ -1376,7 +1587,6 @@ void fib_dump_all_db (void)
 
 void fib_dbg_clear_vrf_cntrs_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_index)
 {
-    t_fib_vrf_cntrs  *p_vrf_cntrs = NULL;
     uint8_t      af_index;
 
     af_index = (uint8_t) in_af_index;
@@ -1393,15 +1603,13 @@ void fib_dbg_clear_vrf_cntrs_per_vrf_per_af (uint32_t vrf_id, uint32_t in_af_ind
         return;
     }
 
-    p_vrf_cntrs = hal_rt_access_fib_vrf_cntrs(vrf_id, af_index);
-
-    if (p_vrf_cntrs == NULL)
+    if (hal_rt_access_fib_vrf(vrf_id) == NULL)
     {
         printf (" Vrf counters NULL\r\n");
         return;
     }
 
-    memset (p_vrf_cntrs, 0, sizeof (t_fib_vrf_cntrs));
+    hal_rt_fib_vrf_cntrs_clear (vrf_id, af_index);
 
     return;
 }
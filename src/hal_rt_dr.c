@@ -25,6 +25,7 @@
 #include "hal_rt_util.h"
 #include "hal_rt_api.h"
 #include "hal_rt_debug.h"
+#include "hal_rt_mpath_grp.h"
 #include "hal_rt_mem.h"
 
 #include "event_log.h"
@@ -37,9 +38,11 @@
 #include <string.h>
 #include <stdio.h>
 #include <pthread.h>
+#include <time.h>
 
 pthread_mutex_t fib_dr_mutex;
 pthread_cond_t  fib_dr_cond;
+static bool     g_fib_dr_is_resumed = false; /* Guarded by fib_dr_mutex */
 
 #define ROUTE_NEXT_HOP_MAX_COUNT   64
 #define ROUTE_NEXT_HOP_DEF_WEIGHT (10)
@@ -67,7 +70,6 @@ typedef struct  {
 void cps_obj_to_route(cps_api_object_t obj, db_route_t *r) {
     memset(r,0,sizeof(*r));
     cps_api_object_attr_t list[cps_api_if_ROUTE_A_MAX];
-    char buff[1000], buff1[1000];
 
     cps_api_object_attr_fill_list(obj,0,list,sizeof(list)/sizeof(*list));
 
@@ -122,9 +124,8 @@ void cps_obj_to_route(cps_api_object_t obj, db_route_t *r) {
 
                    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-DR(CPS): ",
                            "Prefix:%s NH(%d): %s, nhIndex %d \r\n",
-                           std_ip_to_string(&r->prefix,buff,sizeof(buff)), hop,
-                           std_ip_to_string(&r->nh_list[hop].nh_addr, buff1,
-                           sizeof(buff1)), hop);
+                           FIB_IP_ADDR_TO_STR (&r->prefix), hop,
+                           FIB_IP_ADDR_TO_STR (&r->nh_list[hop].nh_addr), hop);
 
                    break;
                case cps_api_if_ROUTE_A_NEXT_HOP_WEIGHT:
@@ -341,7 +342,8 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
-    nas_l3_lock();
+    hal_rt_vrf_write_lock (dr_msg_info.vrf_id, af_index);
+    nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_ROUTE_INGEST);
 
     p_dr = fib_get_dr (dr_msg_info.vrf_id, &dr_msg_info.prefix, dr_msg_info.prefix_len);
 
@@ -366,7 +368,8 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
                        FIB_IP_ADDR_TO_STR (&dr_msg_info.prefix),
                        dr_msg_info.prefix_len);
 
-            nas_l3_unlock();
+            nas_l3_unlock_af (af_index);
+            hal_rt_vrf_unlock (dr_msg_info.vrf_id, af_index);
             return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
         }
 
@@ -408,7 +411,8 @@ int fib_proc_dr_add_msg (uint8_t af_index, void *p_rtm_fib_cmd, int *p_nh_info_s
 
     fib_mark_dr_for_resolution (p_dr);
 
-    nas_l3_unlock();
+    nas_l3_unlock_af (af_index);
+    hal_rt_vrf_unlock (dr_msg_info.vrf_id, af_index);
 
     return STD_ERR_OK;
 }
@@ -456,7 +460,8 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
-    nas_l3_lock();
+    hal_rt_vrf_write_lock (dr_msg_info.vrf_id, af_index);
+    nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_ROUTE_INGEST);
 
     p_dr = fib_get_dr (dr_msg_info.vrf_id, &dr_msg_info.prefix, dr_msg_info.prefix_len);
 
@@ -469,13 +474,15 @@ int fib_proc_dr_del_msg (uint8_t af_index, void *p_rtm_fib_cmd)
                    FIB_IP_ADDR_TO_STR (&dr_msg_info.prefix),
                    dr_msg_info.prefix_len);
 
-        nas_l3_unlock();
+        nas_l3_unlock_af (af_index);
+        hal_rt_vrf_unlock (dr_msg_info.vrf_id, af_index);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
     fib_proc_dr_del (p_dr);
 
-    nas_l3_unlock();
+    nas_l3_unlock_af (af_index);
+    hal_rt_vrf_unlock (dr_msg_info.vrf_id, af_index);
 
     fib_resume_nh_walker_thread(af_index);
 
@@ -533,12 +540,13 @@ int fib_proc_dr_del (t_fib_dr *p_dr)
             if(rif_del)
                 hal_rif_index_remove(0, p_dr->vrf_id, if_index);
 
-            fib_check_threshold_for_all_cams (false);
-
             p_dr->status_flag &= ~FIB_DR_STATUS_WRITTEN;
 
             FIB_DECR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                               p_dr->key.prefix.af_index);
+            hal_rt_cam_route_del (p_dr);
+
+            fib_check_threshold_for_all_cams (false);
 
             if (p_dr->prefix_len == FIB_AFINDEX_TO_PREFIX_LEN(p_dr->key.prefix.af_index))
             {
@@ -654,6 +662,15 @@ int fib_proc_dr_nh_add (t_fib_dr *p_dr, void *p_rtm_fib_cmd, int *p_nh_info_size
         EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-DR",
                      "vrf_id: %d, ip_addr: %s, nh_loop_idx %d if_index: %d",
                       vrf_id, FIB_IP_ADDR_TO_STR (&nh_msg_info.ip_addr), i, nh_if_index);
+        p_dr_nh = fib_get_dr_nh (p_dr, p_nh);
+
+        if (p_dr_nh != NULL)
+        {
+            /* Route update with the same NH, only the weight can change */
+            p_dr_nh->weight = nh_msg_info.weight;
+            continue;
+        }
+
         p_dr_nh = fib_add_dr_nh (p_dr, p_nh, 0, 0);
 
         if (p_dr_nh == NULL)
@@ -670,6 +687,8 @@ int fib_proc_dr_nh_add (t_fib_dr *p_dr, void *p_rtm_fib_cmd, int *p_nh_info_size
 
         }
 
+        p_dr_nh->weight = nh_msg_info.weight;
+
         p_nh_dep_dr = fib_add_nh_dep_dr (p_nh, p_dr);
 
         if (p_nh_dep_dr == NULL)
@@ -773,6 +792,7 @@ int fib_form_nh_msg_info (uint8_t af_index, void *p_rtm_nh_key, t_fib_nh_msg_inf
          * implemented with Linux namespace or other vrf implementations
          */
         p_fib_nh_msg_info->vrf_id   = p_rtm_v4NHKey->vrfid;
+        p_fib_nh_msg_info->weight   = p_rtm_v4NHKey->nh_list[nh_index].nh_weight;
     }
     else if (FIB_IS_AFINDEX_V6 (af_index))
     {
@@ -791,6 +811,12 @@ int fib_form_nh_msg_info (uint8_t af_index, void *p_rtm_nh_key, t_fib_nh_msg_inf
          * implemented with Linux namespace or other vrf implementations
          */
         p_fib_nh_msg_info->vrf_id   = p_rtm_v6NHKey->vrfid;
+        p_fib_nh_msg_info->weight   = p_rtm_v6NHKey->nh_list[nh_index].nh_weight;
+    }
+
+    if (p_fib_nh_msg_info->weight == 0)
+    {
+        p_fib_nh_msg_info->weight = ROUTE_NEXT_HOP_DEF_WEIGHT;
     }
 
     if (p_fib_nh_msg_info->if_index == 0)
@@ -813,10 +839,10 @@ int fib_form_nh_msg_info (uint8_t af_index, void *p_rtm_nh_key, t_fib_nh_msg_inf
     }
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-DR",
-               "vrf_id: %d, ip_addr: %s, nh_index %d if_index: 0x%x\r\n",
+               "vrf_id: %d, ip_addr: %s, nh_index %d if_index: 0x%x weight: %d\r\n",
                 p_fib_nh_msg_info->vrf_id,
                FIB_IP_ADDR_TO_STR (&p_fib_nh_msg_info->ip_addr),
-               nh_index, p_fib_nh_msg_info->if_index);
+               nh_index, p_fib_nh_msg_info->if_index, p_fib_nh_msg_info->weight);
 
     return STD_ERR_OK;
 }
@@ -1847,6 +1873,10 @@ int fib_dr_walker_main (void)
     uint32_t             vrf_id = 0;
     int                  af_index = 0;
     int                  rc = STD_ERR_OK;
+    struct timespec      gc_time;
+    bool                 is_walk_pending = false;
+    bool                 is_nh_retry_marked = false;
+    uint32_t             wait_secs;
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-DR", "af_index: %d\r\n", af_index);
 
@@ -1872,7 +1902,37 @@ int fib_dr_walker_main (void)
     for ( ; ;)
     {
         pthread_mutex_lock( &fib_dr_mutex );
-        pthread_cond_wait( &fib_dr_cond, &fib_dr_mutex );
+        if ((g_fib_dr_is_resumed) || (is_walk_pending)) {
+            /*
+             * Resumed during the last walk, or degraded ECMP routes are
+             * marked for resolution, walk again.
+             */
+            is_walk_pending = false;
+        } else if ((hal_rt_fib_num_parked_mp_objs () > 0) ||
+                   (hal_rt_ecmp_num_degraded_routes () > 0) ||
+                   (hal_rt_retry_num_pending () > 0)) {
+            /*
+             * Wake up for the parked ECMP groups, the degraded ECMP routes
+             * and the failed writes even if no route changes.
+             */
+            wait_secs = (hal_rt_access_fib_config()->ecmp_grp_gc_grace_period > 0) ?
+                         hal_rt_access_fib_config()->ecmp_grp_gc_grace_period : 1;
+            if ((hal_rt_retry_num_pending () > 0) &&
+                (wait_secs > (HAL_RT_RETRY_MIN_BACKOFF / 1000)))
+                wait_secs = HAL_RT_RETRY_MIN_BACKOFF / 1000;
+
+            clock_gettime (CLOCK_REALTIME, &gc_time);
+            gc_time.tv_sec += wait_secs;
+            pthread_cond_timedwait( &fib_dr_cond, &fib_dr_mutex, &gc_time );
+        } else {
+            pthread_cond_wait( &fib_dr_cond, &fib_dr_mutex );
+        }
+        g_fib_dr_is_resumed = false;
+        /*
+         * The walk is resumed with the VRF locks held, the mutex is not
+         * held across the walk.
+         */
+        pthread_mutex_unlock( &fib_dr_mutex );
 
         tot_dr_processed = 0;
         num_active_vrfs  = 0;
@@ -1888,7 +1948,9 @@ int fib_dr_walker_main (void)
                     continue;
                 }
 
-                nas_l3_lock();
+                hal_rt_vrf_write_lock (vrf_id, af_index);
+                nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_DR_WALKER);
+                hal_rt_route_bulk_begin (af_index);
 
                 p_vrf_info->num_dr_processed_by_walker = 0;
 
@@ -1925,13 +1987,51 @@ int fib_dr_walker_main (void)
                  * fib_dr_walker_call_back ().
                  */
                 tot_dr_processed += p_vrf_info->num_dr_processed_by_walker;
-                nas_l3_unlock();
+
+                /* Write the queued routes before the DRs can change */
+                hal_rt_route_bulk_end (af_index);
+                nas_l3_unlock_af (af_index);
+                hal_rt_vrf_unlock (vrf_id, af_index);
             }
         }  /* End of vrf loop */
-        pthread_mutex_unlock( &fib_dr_mutex );
+
+        /*
+         * Apply the results of the last batch of each AF once it is
+         * written, the DRs of the batch can be of any VRF of the AF and
+         * are read by the CPS GETs.
+         */
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            hal_rt_route_bulk_wait (af_index);
+            hal_rt_af_write_lock (af_index);
+            nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_DR_WALKER);
+            hal_rt_route_bulk_flush (af_index);
+            nas_l3_unlock_af (af_index);
+            hal_rt_af_unlock (af_index);
+        }
 
         EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-DR", "Total DR processed %d",  tot_dr_processed);
 
+        if (num_active_vrfs == 0) {
+            /*
+             * Route walk is done, delete a batch of the parked ECMP groups
+             * whose grace period is over. The DRs and NHs of all the AFs
+             * are marked for resolution.
+             */
+            hal_rt_vrf_write_lock_all ();
+            nas_l3_lock_at (HAL_RT_LOCK_SITE_DR_WALKER);
+            hal_rt_fib_mp_obj_gc (false);
+            /* Give the freed groups to the degraded ECMP routes */
+            is_walk_pending = (hal_rt_ecmp_degraded_routes_upgrade () > 0);
+            /* Retry the failed writes that are due */
+            if (hal_rt_retry_run (&is_nh_retry_marked) > 0)
+                is_walk_pending = true;
+            nas_l3_unlock();
+            hal_rt_vrf_unlock_all ();
+
+            if (is_nh_retry_marked)
+                fib_resume_nh_walker_thread (HAL_RT_V4_AFINDEX);
+        }
+
         if(tot_dr_processed) {
             fib_resume_nh_walker_thread(af_index);
         }
@@ -2025,6 +2125,7 @@ int fib_resolve_dr (t_fib_dr *p_dr)
     t_fib_nh_holder nh_holder2;
     dn_hal_route_err   hal_err = DN_HAL_ROUTE_E_NONE;
     const           t_fib_config *p_config = NULL;
+    uint32_t        nh_weight = 0;
 
     if (!p_dr)
     {
@@ -2066,6 +2167,14 @@ int fib_resolve_dr (t_fib_dr *p_dr)
             continue;
         }
 
+        /*
+         * WECMP: the NH weight is added to each of its FHs, an FH reachable
+         * through more than one NH of the route gets the sum of the weights.
+         */
+        nh_weight = FIB_GET_DRNH_NODE_FROM_NH_HOLDER (nh_holder1)->weight;
+        if (nh_weight == 0)
+            nh_weight = 1;
+
         /* First Hop */
         if (FIB_IS_NH_FH (p_nh))
         {
@@ -2083,6 +2192,7 @@ int fib_resolve_dr (t_fib_dr *p_dr)
                            FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr),
                            p_nh->key.if_index);
 
+                p_dr_fh->ecmp_weight_count += nh_weight;
                 continue;
             }
 
@@ -2102,6 +2212,7 @@ int fib_resolve_dr (t_fib_dr *p_dr)
 
                 continue;
             }
+            p_dr_fh->ecmp_weight_count = nh_weight;
         }
         else /* Next Hop */
         {
@@ -2145,6 +2256,7 @@ int fib_resolve_dr (t_fib_dr *p_dr)
                                    FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
                                    p_fh->key.if_index);
 
+                        p_dr_fh->ecmp_weight_count += nh_weight;
                         continue;
                     }
 
@@ -2166,6 +2278,7 @@ int fib_resolve_dr (t_fib_dr *p_dr)
 
                         continue;
                     }
+                    p_dr_fh->ecmp_weight_count = nh_weight;
                 }
             }
         }
@@ -2188,18 +2301,31 @@ int fib_resolve_dr (t_fib_dr *p_dr)
         }
     }
 
+    /* A new route is not written to a full table, it is retried when entries are freed */
+    if ((!(FIB_IS_DR_WRITTEN (p_dr))) && (hal_rt_cam_route_defer (p_dr)))
+    {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-DR",
+                   "Table full, route deferred. "
+                   "vrf_id: %d, prefix: %s, prefix_len: %d\r\n", p_dr->vrf_id,
+                   FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+        return STD_ERR_OK;
+    }
+
     hal_err = hal_fib_route_add (p_dr->vrf_id, p_dr);
 
     if (hal_err == DN_HAL_ROUTE_E_NONE)
     {
+        hal_rt_retry_dr_del (p_dr);
+
         if (!(FIB_IS_DR_WRITTEN (p_dr)))
         {
-            fib_check_threshold_for_all_cams (true);
-
             p_dr->status_flag |= FIB_DR_STATUS_WRITTEN;
 
             FIB_INCR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                               p_dr->key.prefix.af_index);
+            hal_rt_cam_route_add (p_dr);
+
+            fib_check_threshold_for_all_cams (true);
         }
     }
     else
@@ -2232,7 +2358,9 @@ int fib_resolve_dr (t_fib_dr *p_dr)
 
                     FIB_DECR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                                       p_dr->key.prefix.af_index);
+                    hal_rt_cam_route_del (p_dr);
                 }
+                hal_rt_retry_dr_add (p_dr, HAL_RT_RETRY_RSN_ECMP_FAIL);
             }
         }
         else
@@ -2243,8 +2371,15 @@ int fib_resolve_dr (t_fib_dr *p_dr)
 
                 FIB_DECR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                                   p_dr->key.prefix.af_index);
+                hal_rt_cam_route_del (p_dr);
             }
+            hal_rt_cam_write_failed (hal_rt_cam_get_route_cam (p_dr->key.prefix.af_index,
+                                                               p_dr->prefix_len),
+                                     (hal_err == DN_HAL_ROUTE_E_FULL));
+            hal_rt_retry_dr_add (p_dr, (p_dr->num_fh > 1) ? HAL_RT_RETRY_RSN_ECMP_FAIL :
+                                                            HAL_RT_RETRY_RSN_NDI_FAIL);
         }
+        fib_check_threshold_for_all_cams (false);
     }
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-DR",
@@ -2386,14 +2521,17 @@ int fib_proc_dr_degeneration (t_fib_dr *p_dr)
             {
                 if (!(FIB_IS_DR_WRITTEN (p_dr)))
                 {
-                    fib_check_threshold_for_all_cams (true);
-
                     p_dr->status_flag |= FIB_DR_STATUS_WRITTEN;
 
                     FIB_INCR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                                       p_dr->key.prefix.af_index);
+                    hal_rt_cam_route_add (p_dr);
+
+                    fib_check_threshold_for_all_cams (true);
                 }
 
+                hal_rt_retry_dr_del (p_dr);
+
                 is_route_added = true;
 
                 break;
@@ -2430,14 +2568,17 @@ int fib_proc_dr_degeneration (t_fib_dr *p_dr)
 
         if (hal_err == DN_HAL_ROUTE_E_NONE)
         {
+            hal_rt_retry_dr_del (p_dr);
+
             if (!(FIB_IS_DR_WRITTEN (p_dr)))
             {
-                fib_check_threshold_for_all_cams (true);
-
                 p_dr->status_flag |= FIB_DR_STATUS_WRITTEN;
 
                 FIB_INCR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                                   p_dr->key.prefix.af_index);
+                hal_rt_cam_route_add (p_dr);
+
+                fib_check_threshold_for_all_cams (true);
             }
         }
         else
@@ -2455,7 +2596,11 @@ int fib_proc_dr_degeneration (t_fib_dr *p_dr)
 
                 FIB_DECR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id,
                                                   p_dr->key.prefix.af_index);
+                hal_rt_cam_route_del (p_dr);
+
+                fib_check_threshold_for_all_cams (false);
             }
+            hal_rt_retry_dr_add (p_dr, HAL_RT_RETRY_RSN_ECMP_FAIL);
         }
     }
 
@@ -2545,6 +2690,7 @@ int fib_resume_dr_walker_thread (uint8_t af_index)
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-DR", "af_index: %d\r\n",  af_index);
     pthread_mutex_lock( &fib_dr_mutex );
+    g_fib_dr_is_resumed = true;
     if((retval = pthread_cond_signal( &fib_dr_cond )) != 0) {
         EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-DR", "pthread cond signal failed %d", retval);
     }
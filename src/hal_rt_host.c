@@ -72,25 +72,12 @@ dn_hal_route_err hal_fib_host_add (uint32_t vrf_id, t_fib_nh *p_fh)
 
 dn_hal_route_err hal_fib_next_hop_del(t_fib_nh *p_nh)
 {
-    t_std_error rc = STD_ERR_OK;
-    npu_id_t    unit;
-
     EV_LOG_TRACE(ev_log_t_ROUTE, 1,"HAL-RT-NDI(ARP-END)",
                  "NH Del: Addr: %s, Interface: %d, nh_id %d\r\n",
                   FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index, p_nh->next_hop_id);
 
-    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
-        if(p_nh->next_hop_id) {
-            rc = ndi_route_next_hop_delete(unit, p_nh->next_hop_id);
-            if(rc != STD_ERR_OK) {
-                EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI", "%s (): Failed to delete NH. "
-                           "Unit: %d. Err: %d nh id %d\r\n",
-                           __FUNCTION__, unit, rc, p_nh->next_hop_id);
-                return DN_HAL_ROUTE_E_FAIL;
-            }
-            if(!hal_rt_rif_ref_dec(p_nh->key.if_index))
-                hal_rif_index_remove(0, p_nh->vrf_id, p_nh->key.if_index);
-        }
+    if (hal_rt_nh_obj_delete(p_nh) != STD_ERR_OK) {
+        return DN_HAL_ROUTE_E_FAIL;
     }
 
     return DN_HAL_ROUTE_E_NONE;
@@ -166,6 +153,7 @@ dn_hal_route_err _hal_fib_host_add (uint32_t vrf_id, t_fib_nh *p_fh)
     npu_id_t       unit;
     int            rc = STD_ERR_OK;
     bool           error_occured = false;
+    bool           is_table_full = false;
     ndi_neighbor_t nbr_entry;
     char           p_buf[HAL_RT_MAX_BUFSZ];
     ndi_route_action       action = NDI_ROUTE_PACKET_ACTION_FORWARD;
@@ -216,8 +204,9 @@ dn_hal_route_err _hal_fib_host_add (uint32_t vrf_id, t_fib_nh *p_fh)
         nbr_entry.rif_id = hal_rif_index_get(unit, vrf_id, p_fh->key.if_index);
         hal_dump_nbr_entry(&nbr_entry);
         if(!p_fh->a_is_written [unit]) {
-            rc = ndi_route_neighbor_add(&nbr_entry);
+            rc = hal_rt_nbr_ndi_add(&nbr_entry, vrf_id, p_fh);
             if(rc != STD_ERR_OK) {
+                is_table_full = hal_rt_ndi_rc_is_table_full(rc);
                 error_occured = true;
             } else {
                 p_fh->a_is_written [unit] = true;
@@ -227,25 +216,35 @@ dn_hal_route_err _hal_fib_host_add (uint32_t vrf_id, t_fib_nh *p_fh)
                              ((action == NDI_ROUTE_PACKET_ACTION_FORWARD) ? "Forward" :
                               ((action == NDI_ROUTE_PACKET_ACTION_DROP) ? "Drop" : "TrapToCPU")));
             }
+        } else if (hal_rt_nbr_shadow_is_same(p_fh, &nbr_entry)) {
+            EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+                         "Entry already programmed, unchanged..! action:%s\r\n",
+                         ((action == NDI_ROUTE_PACKET_ACTION_FORWARD) ? "Forward" :
+                          ((action == NDI_ROUTE_PACKET_ACTION_DROP) ? "Drop" : "TrapToCPU")));
         } else {
             EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
                          "Entry already programmed, Replacing..! action:%s\r\n",
                          ((action == NDI_ROUTE_PACKET_ACTION_FORWARD) ? "Forward" :
                           ((action == NDI_ROUTE_PACKET_ACTION_DROP) ? "Drop" : "TrapToCPU")));
+            /* The replace is not batched, write the queued neighbor before it */
+            hal_rt_nbr_bulk_sync_nh(p_fh, unit);
             rc = ndi_route_neighbor_delete(&nbr_entry);
             if(rc != STD_ERR_OK) {
                 EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI", "Nbr delete failed\r\n");
             }
             rc = ndi_route_neighbor_add(&nbr_entry);
             if(rc != STD_ERR_OK) {
+                is_table_full = hal_rt_ndi_rc_is_table_full(rc);
                 error_occured = true;
+            } else {
+                hal_rt_nbr_shadow_set(p_fh, &nbr_entry);
             }
         }
     }
     if (error_occured == true) {
         EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI", "Error occured.\r\n");
         _hal_fib_host_del (vrf_id, p_fh);
-        return DN_HAL_ROUTE_E_FAIL;
+        return ((is_table_full) ? DN_HAL_ROUTE_E_FULL : DN_HAL_ROUTE_E_FAIL);
     }
 
     return DN_HAL_ROUTE_E_NONE;
@@ -282,13 +281,7 @@ dn_hal_route_err _hal_fib_host_del (uint32_t vrf_id, t_fib_nh *p_fh)
             nbr_entry.npu_id = unit;
             nbr_entry.rif_id = hal_rif_index_get(unit, vrf_id, p_fh->key.if_index);
             hal_dump_nbr_entry(&nbr_entry);
-            rc = ndi_route_neighbor_delete(&nbr_entry);
-            if(rc != STD_ERR_OK) {
-                EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI", "%s (): Failed to delete Host. "
-                           "Vrf_id: %ld, Unit: %d. Err: %d \r\n", __FUNCTION__, vrf_id, unit, rc);
-            }
-            if(!hal_rt_rif_ref_dec(p_fh->key.if_index))
-                hal_rif_index_remove(unit, vrf_id, p_fh->key.if_index);
+            hal_rt_nbr_ndi_del(&nbr_entry, vrf_id, p_fh);
         }
         p_fh->a_is_written [unit] = false;
     }
@@ -40,9 +40,15 @@
 #include "cps_api_events.h"
 #include "cps_class_map.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 
 /**************************************************************************
  *                            GLOBALS
@@ -57,23 +63,313 @@ static t_fib_vrf        *ga_fib_vrf [FIB_MAX_VRF];
 
 static cps_api_operation_handle_t nas_rt_cps_handle;
 
-#define NUM_INT_NAS_RT_CPS_API_THREAD 1
-
-static std_mutex_lock_create_static_init_fast(nas_l3_mutex);
+/* The L3 lock of each AF */
+static pthread_mutex_t ga_nas_l3_af_mutex [FIB_MAX_AFINDEX] = {
+    [0 ... (FIB_MAX_AFINDEX - 1)] = PTHREAD_MUTEX_INITIALIZER
+};
+static std_mutex_lock_create_static_init_fast(nas_l3_intf_mutex);
 
 /***************************************************************************
  *                          Private Functions
  ***************************************************************************/
 
+/*
+ * Routing thread settings. The defaults keep the thread names and the
+ * scheduling of the process, NAS_RT_THREAD_<KIND> overrides them with a
+ * comma separated list of name=, cpus= (hex mask), policy= (other, fifo
+ * or rr) and prio=. NAS_RT_CPS_THREADS sets the CPS handler threads.
+ */
+typedef struct _t_fib_thread_kind {
+    const char  *name;
+    const char  *env;
+} t_fib_thread_kind;
+
+static const t_fib_thread_kind ga_fib_thread_kind [HAL_RT_THREAD_MAX] = {
+    { "hal-rt-main",  "NAS_RT_THREAD_MAIN"  },
+    { "hal-rt-dr",    "NAS_RT_THREAD_DR"    },
+    { "hal-rt-nh",    "NAS_RT_THREAD_NH"    },
+    { "hal-rt-cps",   "NAS_RT_THREAD_CPS"   },
+    { "hal-rt-pgm",   "NAS_RT_THREAD_PGM"   },
+    { "hal-rt-npu",   "NAS_RT_THREAD_NPU"   },
+    { "hal-rt-audit", "NAS_RT_THREAD_AUDIT" },
+    { "hal-rt-nbr-rx", "NAS_RT_THREAD_NBR_RX" },
+    { "hal-rt-nbr",   "NAS_RT_THREAD_NBR"   },
+};
+
+/* Threads started with hal_rt_thread_create, for the changes at run time */
+typedef struct _t_fib_thread_running {
+    t_hal_rt_thread  thread;
+    pid_t            tid;
+} t_fib_thread_running;
+
+typedef struct _t_fib_thread_start {
+    t_hal_rt_thread        thread;
+    std_thread_function_t  thread_function;
+    void                  *param;
+} t_fib_thread_start;
+
+static t_fib_thread_running  ga_fib_thread_running [HAL_RT_THREAD_MAX_RUNNING];
+static uint32_t              g_fib_num_thread_running = 0;
+static pthread_mutex_t       g_fib_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void fib_thread_config_parse (t_hal_rt_thread_config *p_cfg, const char *p_env)
+{
+    char  buf [HAL_RT_MAX_BUFSZ];
+    char *p_save = NULL;
+    char *p_tok;
+    char *p_val;
+
+    snprintf (buf, sizeof (buf), "%s", p_env);
+
+    for (p_tok = strtok_r (buf, ",", &p_save); p_tok != NULL;
+         p_tok = strtok_r (NULL, ",", &p_save)) {
+        if ((p_val = strchr (p_tok, '=')) == NULL)
+            continue;
+        *p_val++ = '\0';
+
+        if (strcmp (p_tok, "name") == 0) {
+            snprintf (p_cfg->name, sizeof (p_cfg->name), "%s", p_val);
+        } else if (strcmp (p_tok, "cpus") == 0) {
+            p_cfg->cpu_mask = strtoull (p_val, NULL, 16);
+        } else if (strcmp (p_tok, "policy") == 0) {
+            if (strcmp (p_val, "fifo") == 0)
+                p_cfg->policy = SCHED_FIFO;
+            else if (strcmp (p_val, "rr") == 0)
+                p_cfg->policy = SCHED_RR;
+            else
+                p_cfg->policy = SCHED_OTHER;
+            p_cfg->is_sched_set = true;
+        } else if (strcmp (p_tok, "prio") == 0) {
+            p_cfg->priority = atoi (p_val);
+            p_cfg->is_sched_set = true;
+        }
+    }
+}
+
+static void fib_thread_config_init (void)
+{
+    t_hal_rt_thread_config *p_cfg;
+    const char             *p_env;
+    uint32_t                thread;
+
+    for (thread = 0; thread < HAL_RT_THREAD_MAX; thread++) {
+        p_cfg = &g_fib_config.a_thread [thread];
+
+        snprintf (p_cfg->name, sizeof (p_cfg->name), "%s", ga_fib_thread_kind [thread].name);
+        p_cfg->cpu_mask = 0;
+        p_cfg->policy = SCHED_OTHER;
+        p_cfg->priority = 0;
+        p_cfg->is_sched_set = false;
+
+        if ((p_env = getenv (ga_fib_thread_kind [thread].env)) != NULL)
+            fib_thread_config_parse (p_cfg, p_env);
+    }
+
+    if ((p_env = getenv ("NAS_RT_CPS_THREADS")) != NULL) {
+        g_fib_config.cps_num_threads = (uint32_t) atoi (p_env);
+        if (g_fib_config.cps_num_threads == 0)
+            g_fib_config.cps_num_threads = 1;
+        else if (g_fib_config.cps_num_threads > HAL_RT_CPS_MAX_NUM_THREADS)
+            g_fib_config.cps_num_threads = HAL_RT_CPS_MAX_NUM_THREADS;
+    }
+}
+
+/*
+ * The settings are applied by the thread id, the thread need not be the
+ * caller. Only the configured settings are applied, a thread otherwise
+ * keeps the CPUs and the scheduling it inherits from the process.
+ */
+static void fib_thread_apply_sched (pid_t tid, const t_hal_rt_thread_config *p_cfg)
+{
+    struct sched_param  sp;
+    cpu_set_t           cpu_set;
+    int                 cpu;
+
+    if (p_cfg->cpu_mask != 0) {
+        CPU_ZERO (&cpu_set);
+        for (cpu = 0; cpu < 64; cpu++) {
+            if (p_cfg->cpu_mask & (1ULL << cpu))
+                CPU_SET (cpu, &cpu_set);
+        }
+        if (sched_setaffinity (tid, sizeof (cpu_set), &cpu_set) != 0) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "%s: CPU mask 0x%llx not set",
+                       p_cfg->name, (unsigned long long) p_cfg->cpu_mask);
+        }
+    }
+
+    if (!p_cfg->is_sched_set)
+        return;
+
+    memset (&sp, 0, sizeof (sp));
+    if (p_cfg->policy != SCHED_OTHER)
+        sp.sched_priority = p_cfg->priority;
+
+    if (sched_setscheduler (tid, p_cfg->policy, &sp) != 0) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "%s: Policy %d priority %d not set",
+                   p_cfg->name, p_cfg->policy, p_cfg->priority);
+        return;
+    }
+
+    if ((p_cfg->policy == SCHED_OTHER) &&
+        (setpriority (PRIO_PROCESS, tid, p_cfg->priority) != 0)) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "%s: Nice %d not set",
+                   p_cfg->name, p_cfg->priority);
+    }
+}
+
+static void *fib_thread_start (void *p_arg)
+{
+    t_fib_thread_start  start = *((t_fib_thread_start *) p_arg);
+    pid_t               tid = (pid_t) syscall (SYS_gettid);
+
+    free (p_arg);
+
+    pthread_mutex_lock (&g_fib_thread_mutex);
+    fib_thread_apply_sched (tid, &g_fib_config.a_thread [start.thread]);
+    if (g_fib_num_thread_running < HAL_RT_THREAD_MAX_RUNNING) {
+        ga_fib_thread_running [g_fib_num_thread_running].thread = start.thread;
+        ga_fib_thread_running [g_fib_num_thread_running].tid = tid;
+        g_fib_num_thread_running++;
+    }
+    pthread_mutex_unlock (&g_fib_thread_mutex);
+
+    return start.thread_function (start.param);
+}
+
+/*
+ * Creates a routing thread with the name and the scheduling configured
+ * for its kind.
+ */
+t_std_error hal_rt_thread_create (std_thread_create_param_t *p_thr, t_hal_rt_thread thread,
+                                  std_thread_function_t thread_function, void *param)
+{
+    t_fib_thread_start *p_start;
+
+    if ((p_start = malloc (sizeof (t_fib_thread_start))) == NULL)
+        return STD_ERR(ROUTE,FAIL,0);
+
+    p_start->thread = thread;
+    p_start->thread_function = thread_function;
+    p_start->param = param;
+
+    std_thread_init_struct (p_thr);
+    p_thr->name = g_fib_config.a_thread [thread].name;
+    p_thr->thread_function = (std_thread_function_t) fib_thread_start;
+    p_thr->param = p_start;
+
+    if (std_thread_create (p_thr) != STD_ERR_OK) {
+        free (p_start);
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+/* Changes the CPU mask and the scheduling of the running threads of a kind */
+t_std_error hal_rt_thread_set_sched (t_hal_rt_thread thread, uint64_t cpu_mask,
+                                     int policy, int priority)
+{
+    t_hal_rt_thread_config *p_cfg;
+    uint32_t                index;
+
+    if ((thread >= HAL_RT_THREAD_MAX) ||
+        ((policy != SCHED_OTHER) && (policy != SCHED_FIFO) && (policy != SCHED_RR)))
+        return STD_ERR(ROUTE,PARAM,0);
+
+    pthread_mutex_lock (&g_fib_thread_mutex);
+    p_cfg = &g_fib_config.a_thread [thread];
+    p_cfg->cpu_mask = cpu_mask;
+    p_cfg->policy = policy;
+    p_cfg->priority = priority;
+    p_cfg->is_sched_set = true;
+
+    for (index = 0; index < g_fib_num_thread_running; index++) {
+        if (ga_fib_thread_running [index].thread == thread)
+            fib_thread_apply_sched (ga_fib_thread_running [index].tid, p_cfg);
+    }
+    pthread_mutex_unlock (&g_fib_thread_mutex);
+
+    return STD_ERR_OK;
+}
+
+const char *hal_rt_thread_kind_name (t_hal_rt_thread thread)
+{
+    return ((thread < HAL_RT_THREAD_MAX) ? ga_fib_thread_kind [thread].name : "");
+}
+
+void fib_set_thread_sched (uint32_t thread, uint32_t cpu_mask, int policy, int priority)
+{
+    if (hal_rt_thread_set_sched ((t_hal_rt_thread) thread, cpu_mask, policy,
+                                 priority) != STD_ERR_OK)
+        printf (" Invalid thread %d or policy %d\r\n", thread, policy);
+}
+
+void fib_dump_thread_config (void)
+{
+    const t_hal_rt_thread_config *p_cfg;
+    uint32_t                      thread;
+    uint32_t                      index;
+    uint32_t                      num_running;
+
+    printf ("**************************************************\r\n");
+    printf ("  cps_num_threads       :  %d\r\n", g_fib_config.cps_num_threads);
+    pthread_mutex_lock (&g_fib_thread_mutex);
+    for (thread = 0; thread < HAL_RT_THREAD_MAX; thread++) {
+        p_cfg = &g_fib_config.a_thread [thread];
+
+        num_running = 0;
+        for (index = 0; index < g_fib_num_thread_running; index++) {
+            if (ga_fib_thread_running [index].thread == thread)
+                num_running++;
+        }
+
+        printf ("  %d: %s\r\n", thread, ga_fib_thread_kind [thread].name);
+        printf ("    name                :  %s\r\n", p_cfg->name);
+        printf ("    num_running         :  %d\r\n", num_running);
+        printf ("    cpu_mask            :  0x%llx\r\n", (unsigned long long) p_cfg->cpu_mask);
+        printf ("    policy              :  %d\r\n", p_cfg->policy);
+        printf ("    priority            :  %d\r\n", p_cfg->priority);
+    }
+    pthread_mutex_unlock (&g_fib_thread_mutex);
+    printf ("**************************************************\r\n");
+}
+
 int hal_rt_config_init (void)
 {
     /* Init the configs to default values */
     memset (&g_fib_config, 0, sizeof (g_fib_config));
     g_fib_config.max_num_npu          = nas_switch_get_max_npus();
+    if (g_fib_config.max_num_npu > HAL_RT_MAX_INSTANCE) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT", "%s (): %d NPUs, only %d are programmed",
+                   __FUNCTION__, g_fib_config.max_num_npu, HAL_RT_MAX_INSTANCE);
+        g_fib_config.max_num_npu      = HAL_RT_MAX_INSTANCE;
+    }
     g_fib_config.ecmp_max_paths       = HAL_RT_MAX_ECMP_PATH;
     g_fib_config.hw_ecmp_max_paths    = HAL_RT_MAX_ECMP_PATH;
     g_fib_config.ecmp_path_fall_back  = false;
     g_fib_config.ecmp_hash_sel        = FIB_DEFAULT_ECMP_HASH;
+    g_fib_config.ecmp_grp_incr_update = true;
+    g_fib_config.ecmp_nh_fast_reroute = true;
+    g_fib_config.hierarchical_fib     = true;
+    /*
+     * NDI does not report the weighted member capability of the NPU yet,
+     * so WECMP is done by replicating the group members by default. The
+     * native weights are enabled by the ECMP config CPS object.
+     */
+    g_fib_config.ecmp_native_weight   = false;
+    /* Resilient groups are enabled by the ECMP config CPS object */
+    g_fib_config.ecmp_resilient_hash  = false;
+    g_fib_config.ecmp_resilient_buckets = HAL_RT_MAX_ECMP_PATH;
+    g_fib_config.ecmp_grp_gc_grace_period = HAL_RT_MP_OBJ_GC_GRACE_PERIOD;
+    g_fib_config.ecmp_grp_max         = 0;
+    g_fib_config.ecmp_grp_share_policy = HAL_RT_ECMP_GRP_SHARE_SUBSET;
+    g_fib_config.route_bulk_size      = HAL_RT_ROUTE_BULK_DEFAULT_SIZE;
+    g_fib_config.nbr_bulk_size        = HAL_RT_NBR_BULK_DEFAULT_SIZE;
+    g_fib_config.ndi_async_pgm        = true;
+    g_fib_config.cam_high_threshold   = HAL_RT_CAM_DEF_HIGH_THRESHOLD;
+    g_fib_config.cam_low_threshold    = HAL_RT_CAM_DEF_LOW_THRESHOLD;
+    g_fib_config.cps_num_threads      = HAL_RT_CPS_DEF_NUM_THREADS;
+
+    fib_thread_config_init ();
 
     return STD_ERR_OK;
 }
@@ -83,14 +379,385 @@ const t_fib_config * hal_rt_access_fib_config(void)
     return(&g_fib_config);
 }
 
+/*
+ * Set the ECMP width, the number of members selected for a group. It is
+ * limited by the NPU max paths and applies to the groups programmed
+ * after the change.
+ */
+dn_hal_route_err hal_fib_set_ecmp_max_paths (uint32_t max_ecmp_paths)
+{
+    if ((max_ecmp_paths == 0) ||
+        (max_ecmp_paths > g_fib_config.hw_ecmp_max_paths)) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT", "%s (): Invalid ECMP max paths %d, "
+                   "hw_ecmp_max_paths %d", __FUNCTION__, max_ecmp_paths,
+                   g_fib_config.hw_ecmp_max_paths);
+        return DN_HAL_ROUTE_E_PARAM;
+    }
+
+    g_fib_config.ecmp_max_paths = max_ecmp_paths;
+    return DN_HAL_ROUTE_E_NONE;
+}
+
+/*
+ * Use the WECMP member weights of the NPU instead of replicating the
+ * members, for the groups programmed after the change.
+ */
+void hal_fib_set_ecmp_native_weight (bool is_native_weight)
+{
+    g_fib_config.ecmp_native_weight = is_native_weight;
+}
+
+/*
+ * Program the groups as a fixed size table of buckets. The buckets are
+ * kept by the software in plain ECMP groups, NDI has no resilient group
+ * type, so the flows stay on their bucket only if the NPU hashes over
+ * the member positions of the group.
+ */
+void hal_fib_set_ecmp_resilient_hash (bool is_resilient_hash)
+{
+    g_fib_config.ecmp_resilient_hash = is_resilient_hash;
+}
+
+dn_hal_route_err hal_fib_set_ecmp_resilient_buckets (uint32_t num_buckets)
+{
+    if ((num_buckets == 0) ||
+        (num_buckets > g_fib_config.hw_ecmp_max_paths)) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT", "%s (): Invalid resilient buckets %d, "
+                   "hw_ecmp_max_paths %d", __FUNCTION__, num_buckets,
+                   g_fib_config.hw_ecmp_max_paths);
+        return DN_HAL_ROUTE_E_PARAM;
+    }
+
+    g_fib_config.ecmp_resilient_buckets = num_buckets;
+    return DN_HAL_ROUTE_E_NONE;
+}
+
+/*
+ * L3 lock profiler. When enabled, the wait for the L3 lock of an AF, or
+ * of all the AFs, and the time it is held are counted against the call
+ * site. The hold start of a lock is kept under the lock itself, the hold
+ * of all the AFs is timed on the first AF. The stats are updated under
+ * their own mutex, only the enable flag is read without it.
+ */
+static const char *ga_fib_lock_site_name [HAL_RT_LOCK_SITE_MAX] = {
+    "Other",
+    "Route ingest",
+    "Neighbor ingest",
+    "DR walker",
+    "NH walker",
+    "Audit",
+    "CPS GET",
+    "Peer config",
+};
+
+static pthread_mutex_t      g_fib_lock_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static t_hal_rt_lock_stats  g_fib_lock_stats;
+static uint64_t             ga_fib_lock_hold_start [FIB_MAX_AFINDEX];  /* 0 if not timed */
+static t_hal_rt_lock_site   ga_fib_lock_holder [FIB_MAX_AFINDEX];
+
+static uint64_t fib_lock_get_usecs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (((uint64_t) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void fib_lock_hist_add (uint32_t a_hist [], uint64_t usecs)
+{
+    uint64_t limit = 10;
+    uint32_t bucket = 0;
+
+    while ((bucket < (HAL_RT_LOCK_HIST_BUCKETS - 1)) && (usecs >= limit)) {
+        limit *= 10;
+        bucket++;
+    }
+    a_hist [bucket]++;
+}
+
+/* Called with the lock of the AF held, start is 0 if the wait is not timed */
+static void fib_lock_prof_acquired (uint8_t af_index, t_hal_rt_lock_site site, uint64_t start)
+{
+    t_hal_rt_lock_site_stats *p_stats;
+    uint64_t                  wait;
+
+    if (start == 0) {
+        ga_fib_lock_hold_start [af_index] = 0;
+        return;
+    }
+
+    ga_fib_lock_hold_start [af_index] = fib_lock_get_usecs ();
+    ga_fib_lock_holder [af_index] = site;
+    wait = ga_fib_lock_hold_start [af_index] - start;
+
+    pthread_mutex_lock (&g_fib_lock_stats_mutex);
+    p_stats = &g_fib_lock_stats.a_site [site];
+    p_stats->num_acquired++;
+    p_stats->tot_wait_usecs += wait;
+    if (wait > p_stats->max_wait_usecs)
+        p_stats->max_wait_usecs = (uint32_t) wait;
+    fib_lock_hist_add (p_stats->a_wait_hist, wait);
+    pthread_mutex_unlock (&g_fib_lock_stats_mutex);
+}
+
+/* Called with the lock of the AF held, before it is released */
+static void fib_lock_prof_release (uint8_t af_index)
+{
+    t_hal_rt_lock_site_stats *p_stats;
+    t_hal_rt_lock_site        site = ga_fib_lock_holder [af_index];
+    uint64_t                  hold;
+
+    if (ga_fib_lock_hold_start [af_index] == 0)
+        return;
+
+    hold = fib_lock_get_usecs () - ga_fib_lock_hold_start [af_index];
+    ga_fib_lock_hold_start [af_index] = 0;
+
+    pthread_mutex_lock (&g_fib_lock_stats_mutex);
+    p_stats = &g_fib_lock_stats.a_site [site];
+    p_stats->tot_hold_usecs += hold;
+    if (hold > p_stats->max_hold_usecs) {
+        p_stats->max_hold_usecs = (uint32_t) hold;
+        if (hold > g_fib_lock_stats.a_site [g_fib_lock_stats.max_hold_site].max_hold_usecs)
+            g_fib_lock_stats.max_hold_site = site;
+    }
+    fib_lock_hist_add (p_stats->a_hold_hist, hold);
+    pthread_mutex_unlock (&g_fib_lock_stats_mutex);
+}
+
+static uint64_t fib_lock_prof_start (t_hal_rt_lock_site *p_site)
+{
+    if (!g_fib_lock_stats.is_enabled)
+        return 0;
+
+    if (*p_site >= HAL_RT_LOCK_SITE_MAX)
+        *p_site = HAL_RT_LOCK_SITE_OTHER;
+
+    return fib_lock_get_usecs ();
+}
+
+/*
+ * The L3 locks of all the AFs, in the order of af_index.
+ */
+void nas_l3_lock_at (t_hal_rt_lock_site site)
+{
+    uint64_t start = fib_lock_prof_start (&site);
+    uint8_t  af_index;
+
+    for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++)
+        pthread_mutex_lock (&ga_nas_l3_af_mutex [af_index]);
+
+    fib_lock_prof_acquired (FIB_MIN_AFINDEX, site, start);
+}
+
 void nas_l3_lock()
 {
-    std_mutex_lock(&nas_l3_mutex);
+    nas_l3_lock_at (HAL_RT_LOCK_SITE_OTHER);
 }
 
 void nas_l3_unlock()
 {
-    std_mutex_unlock(&nas_l3_mutex);
+    uint8_t af_index;
+
+    fib_lock_prof_release (FIB_MIN_AFINDEX);
+
+    for (af_index = FIB_MAX_AFINDEX; af_index > FIB_MIN_AFINDEX; af_index--)
+        pthread_mutex_unlock (&ga_nas_l3_af_mutex [af_index - 1]);
+}
+
+/*
+ * The L3 lock of the AF, the locks of all the AFs if the AF is not valid.
+ */
+void nas_l3_lock_af_at (uint8_t af_index, t_hal_rt_lock_site site)
+{
+    uint64_t start;
+
+    if ((af_index < FIB_MIN_AFINDEX) || (af_index >= FIB_MAX_AFINDEX)) {
+        nas_l3_lock_at (site);
+        return;
+    }
+
+    start = fib_lock_prof_start (&site);
+    pthread_mutex_lock (&ga_nas_l3_af_mutex [af_index]);
+    fib_lock_prof_acquired (af_index, site, start);
+}
+
+void nas_l3_unlock_af (uint8_t af_index)
+{
+    if ((af_index < FIB_MIN_AFINDEX) || (af_index >= FIB_MAX_AFINDEX)) {
+        nas_l3_unlock ();
+        return;
+    }
+
+    fib_lock_prof_release (af_index);
+    pthread_mutex_unlock (&ga_nas_l3_af_mutex [af_index]);
+}
+
+/* The stats are cleared when the profiler is enabled */
+void hal_rt_lock_prof_enable (bool is_enabled)
+{
+    pthread_mutex_lock (&g_fib_lock_stats_mutex);
+    if ((is_enabled) && (!g_fib_lock_stats.is_enabled))
+        memset (&g_fib_lock_stats, 0, sizeof (g_fib_lock_stats));
+    g_fib_lock_stats.is_enabled = is_enabled;
+    pthread_mutex_unlock (&g_fib_lock_stats_mutex);
+}
+
+const t_hal_rt_lock_stats *hal_rt_access_lock_stats (void)
+{
+    return &g_fib_lock_stats;
+}
+
+const char *hal_rt_lock_site_name (uint32_t site)
+{
+    return ((site < HAL_RT_LOCK_SITE_MAX) ? ga_fib_lock_site_name [site] : "");
+}
+
+void fib_set_lock_prof (int is_enabled)
+{
+    hal_rt_lock_prof_enable (is_enabled != 0);
+}
+
+void fib_dump_lock_stats (void)
+{
+    const t_hal_rt_lock_site_stats *p_stats;
+    uint32_t                        site;
+    uint32_t                        bucket;
+
+    printf ("**************************************************\r\n");
+    printf ("  is_enabled            :  %d\r\n", g_fib_lock_stats.is_enabled);
+    printf ("  max_hold_site         :  %s\r\n",
+            hal_rt_lock_site_name (g_fib_lock_stats.max_hold_site));
+    for (site = 0; site < HAL_RT_LOCK_SITE_MAX; site++) {
+        p_stats = &g_fib_lock_stats.a_site [site];
+        if (p_stats->num_acquired == 0)
+            continue;
+
+        printf ("  %s\r\n", ga_fib_lock_site_name [site]);
+        printf ("    num_acquired        :  %d\r\n", p_stats->num_acquired);
+        printf ("    tot_wait_usecs      :  %llu\r\n",
+                (unsigned long long) p_stats->tot_wait_usecs);
+        printf ("    max_wait_usecs      :  %d\r\n", p_stats->max_wait_usecs);
+        printf ("    tot_hold_usecs      :  %llu\r\n",
+                (unsigned long long) p_stats->tot_hold_usecs);
+        printf ("    max_hold_usecs      :  %d\r\n", p_stats->max_hold_usecs);
+        printf ("    wait_hist           : ");
+        for (bucket = 0; bucket < HAL_RT_LOCK_HIST_BUCKETS; bucket++)
+            printf (" %d", p_stats->a_wait_hist [bucket]);
+        printf ("\r\n");
+        printf ("    hold_hist           : ");
+        for (bucket = 0; bucket < HAL_RT_LOCK_HIST_BUCKETS; bucket++)
+            printf (" %d", p_stats->a_hold_hist [bucket]);
+        printf ("\r\n");
+    }
+    printf ("**************************************************\r\n");
+}
+
+/*
+ * Locking of the FIB. A lock is not taken while holding a lock below it:
+ *
+ *  1. The VRF AF locks, in the order of vrf_id and af_index. The lock of
+ *     an AF guards the DR and NH trees of the AF, the change lists of the
+ *     walkers and the route and neighbor info of the DRs and NHs. Readers
+ *     of an AF take it shared, the AFs are read and written independently.
+ *  2. The L3 locks of the AFs (nas_l3_lock_af_at), in the order of
+ *     af_index - the NPU programming state of the AF: the route and
+ *     neighbor batches, the ECMP groups and their MD5 trees, the parked
+ *     groups and the written state of the DRs and NHs of the AF. The next
+ *     hop objects and groups of a route are of the AF of the route.
+ *     nas_l3_lock takes the locks of all the AFs, for the config, the CPS
+ *     GETs across the AFs and the idle work of the DR walker.
+ *  3. hal_rt_intf_lock - the interface tree and the RIF map.
+ *  4. The mutexes of the state shared by the AFs - the next hop object
+ *     trees, the indirect group list, the ECMP group pressure, the table
+ *     model, the retry list and the lock profiler stats, and fib_dr_mutex,
+ *     fib_nh_mutex for the walker wake ups. They are held only to change
+ *     the state or to wait and signal, no lock is taken under them.
+ *
+ * A writer takes the lock of the AF, then the L3 lock of the AF, so the
+ * writers of the AFs run concurrently. Marking DRs or NHs of any AF for
+ * resolution needs the locks of all the AFs.
+ */
+static pthread_rwlock_t *hal_rt_vrf_rw_lock (uint32_t vrf_id, uint8_t af_index)
+{
+    if ((!FIB_IS_VRF_ID_VALID (vrf_id)) || (af_index >= FIB_MAX_AFINDEX) ||
+        (ga_fib_vrf [vrf_id] == NULL))
+        return NULL;
+
+    return (&ga_fib_vrf [vrf_id]->info [af_index].rw_lock);
+}
+
+void hal_rt_vrf_read_lock (uint32_t vrf_id, uint8_t af_index)
+{
+    pthread_rwlock_t *p_lock = hal_rt_vrf_rw_lock (vrf_id, af_index);
+
+    if (p_lock != NULL)
+        pthread_rwlock_rdlock (p_lock);
+}
+
+void hal_rt_vrf_write_lock (uint32_t vrf_id, uint8_t af_index)
+{
+    pthread_rwlock_t *p_lock = hal_rt_vrf_rw_lock (vrf_id, af_index);
+
+    if (p_lock != NULL)
+        pthread_rwlock_wrlock (p_lock);
+}
+
+void hal_rt_vrf_unlock (uint32_t vrf_id, uint8_t af_index)
+{
+    pthread_rwlock_t *p_lock = hal_rt_vrf_rw_lock (vrf_id, af_index);
+
+    if (p_lock != NULL)
+        pthread_rwlock_unlock (p_lock);
+}
+
+void hal_rt_vrf_write_lock_all (void)
+{
+    uint32_t vrf_id;
+    uint8_t  af_index;
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++)
+            hal_rt_vrf_write_lock (vrf_id, af_index);
+    }
+}
+
+void hal_rt_vrf_unlock_all (void)
+{
+    uint32_t vrf_id;
+    uint8_t  af_index;
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++)
+            hal_rt_vrf_unlock (vrf_id, af_index);
+    }
+}
+
+/* The locks of the AF in all the VRFs */
+void hal_rt_af_write_lock (uint8_t af_index)
+{
+    uint32_t vrf_id;
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++)
+        hal_rt_vrf_write_lock (vrf_id, af_index);
+}
+
+void hal_rt_af_unlock (uint8_t af_index)
+{
+    uint32_t vrf_id;
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++)
+        hal_rt_vrf_unlock (vrf_id, af_index);
+}
+
+void hal_rt_intf_lock (void)
+{
+    std_mutex_lock(&nas_l3_intf_mutex);
+}
+
+void hal_rt_intf_unlock (void)
+{
+    std_mutex_unlock(&nas_l3_intf_mutex);
 }
 
 t_fib_vrf * hal_rt_access_fib_vrf(uint32_t vrf_id)
@@ -103,9 +770,126 @@ t_fib_vrf_info * hal_rt_access_fib_vrf_info(uint32_t vrf_id, uint8_t af_index)
     return(&(ga_fib_vrf[vrf_id]->info[af_index]));
 }
 
+/*
+ * Each thread is given a counter shard on its first update, the shard is
+ * the same for all the VRFs and AFs.
+ */
+static uint32_t          g_fib_cntrs_num_shards = 0;
+static __thread int      g_fib_cntrs_shard = -1;
+
 t_fib_vrf_cntrs * hal_rt_access_fib_vrf_cntrs(uint32_t vrf_id, uint8_t af_index)
 {
-    return(&(ga_fib_vrf[vrf_id]->cntrs[af_index]));
+    uint32_t shard;
+
+    if (g_fib_cntrs_shard < 0) {
+        shard = __atomic_fetch_add (&g_fib_cntrs_num_shards, 1, __ATOMIC_RELAXED);
+        g_fib_cntrs_shard = (shard < HAL_RT_CNTRS_MAX_SHARDS) ?
+                            (int) shard : (HAL_RT_CNTRS_MAX_SHARDS - 1);
+    }
+    return(&(ga_fib_vrf[vrf_id]->a_cntrs_shard[g_fib_cntrs_shard].cntrs[af_index]));
+}
+
+uint32_t hal_rt_fib_vrf_cntr_get(uint32_t vrf_id, uint8_t af_index, size_t offset)
+{
+    t_fib_vrf_cntrs *p_cntrs;
+    uint32_t         value = 0;
+    uint32_t        *p_cntr;
+    int              shard;
+
+    for (shard = 0; shard < HAL_RT_CNTRS_MAX_SHARDS; shard++) {
+        p_cntrs = &ga_fib_vrf[vrf_id]->a_cntrs_shard[shard].cntrs[af_index];
+        p_cntr = (uint32_t *) (((uint8_t *) p_cntrs) + offset);
+        /* The gauges can be decremented in another shard, the sum wraps back */
+        value += __atomic_load_n (p_cntr, __ATOMIC_RELAXED);
+    }
+    return value;
+}
+
+void hal_rt_fib_vrf_cntrs_get(uint32_t vrf_id, uint8_t af_index, t_fib_vrf_cntrs *p_cntrs)
+{
+    size_t offset;
+
+    for (offset = 0; offset < sizeof (t_fib_vrf_cntrs); offset += sizeof (uint32_t))
+        *((uint32_t *) (((uint8_t *) p_cntrs) + offset)) =
+            hal_rt_fib_vrf_cntr_get (vrf_id, af_index, offset);
+}
+
+/*
+ * Rates of the route and neighbor counters. They are computed when read,
+ * over the interval since the last read, reads within
+ * HAL_RT_CNTRS_RATE_INTERVAL of it return the last rates.
+ */
+typedef struct _t_fib_vrf_cntrs_sample {
+    uint64_t              usecs;
+    uint32_t              num_route_add;
+    uint32_t              num_route_del;
+    uint32_t              num_nbr_add;
+    uint32_t              num_nbr_del;
+    t_fib_vrf_cntrs_rate  rate;
+} t_fib_vrf_cntrs_sample;
+
+static t_fib_vrf_cntrs_sample  ga_fib_cntrs_sample [FIB_MAX_VRF][FIB_MAX_AFINDEX];
+static pthread_mutex_t         g_fib_cntrs_sample_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t fib_get_cntr_rate (uint32_t cur, uint32_t last, uint64_t usecs)
+{
+    return ((uint32_t) ((((uint64_t) (cur - last)) * 1000000) / usecs));
+}
+
+void hal_rt_fib_vrf_cntrs_rate_get(uint32_t vrf_id, uint8_t af_index,
+                                   t_fib_vrf_cntrs_rate *p_rate)
+{
+    t_fib_vrf_cntrs_sample *p_sample = &ga_fib_cntrs_sample [vrf_id][af_index];
+    t_fib_vrf_cntrs         cntrs;
+    uint64_t                now = fib_lock_get_usecs ();
+    uint64_t                elapsed;
+
+    hal_rt_fib_vrf_cntrs_get (vrf_id, af_index, &cntrs);
+
+    pthread_mutex_lock (&g_fib_cntrs_sample_mutex);
+    elapsed = now - p_sample->usecs;
+    if (elapsed >= (HAL_RT_CNTRS_RATE_INTERVAL * 1000)) {
+        if (p_sample->usecs != 0) {
+            p_sample->rate.route_add_rate =
+                fib_get_cntr_rate (cntrs.num_route_add, p_sample->num_route_add, elapsed);
+            p_sample->rate.route_del_rate =
+                fib_get_cntr_rate (cntrs.num_route_del, p_sample->num_route_del, elapsed);
+            p_sample->rate.nbr_add_rate =
+                fib_get_cntr_rate (cntrs.num_nbr_add, p_sample->num_nbr_add, elapsed);
+            p_sample->rate.nbr_del_rate =
+                fib_get_cntr_rate (cntrs.num_nbr_del, p_sample->num_nbr_del, elapsed);
+        }
+        p_sample->usecs = now;
+        p_sample->num_route_add = cntrs.num_route_add;
+        p_sample->num_route_del = cntrs.num_route_del;
+        p_sample->num_nbr_add = cntrs.num_nbr_add;
+        p_sample->num_nbr_del = cntrs.num_nbr_del;
+    }
+    *p_rate = p_sample->rate;
+    pthread_mutex_unlock (&g_fib_cntrs_sample_mutex);
+}
+
+/*
+ * The shards are updated by their threads, they are cleared with atomic
+ * stores. An update racing with the clear can be lost, as with the clear
+ * of a single copy.
+ */
+void hal_rt_fib_vrf_cntrs_clear(uint32_t vrf_id, uint8_t af_index)
+{
+    t_fib_vrf_cntrs *p_cntrs;
+    size_t           offset;
+    int              shard;
+
+    for (shard = 0; shard < HAL_RT_CNTRS_MAX_SHARDS; shard++) {
+        p_cntrs = &ga_fib_vrf[vrf_id]->a_cntrs_shard[shard].cntrs[af_index];
+        for (offset = 0; offset < sizeof (t_fib_vrf_cntrs); offset += sizeof (uint32_t))
+            __atomic_store_n ((uint32_t *) (((uint8_t *) p_cntrs) + offset), 0,
+                              __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_lock (&g_fib_cntrs_sample_mutex);
+    memset (&ga_fib_cntrs_sample [vrf_id][af_index], 0, sizeof (t_fib_vrf_cntrs_sample));
+    pthread_mutex_unlock (&g_fib_cntrs_sample_mutex);
 }
 
 std_rt_table * hal_rt_access_fib_vrf_dr_tree(uint32_t vrf_id, uint8_t af_index)
@@ -132,6 +916,7 @@ int hal_rt_vrf_init (void)
     ndi_vr_entry_t  vr_entry;
     hal_mac_addr_t  ndi_mac;
     ndi_vrf_id_t    ndi_vr_id = 0;
+    pthread_rwlockattr_t rw_lock_attr;
     t_std_error     rc = STD_ERR_OK;
 
    /* Create a virtual router entry and get vr_id (maps to fib vrf id) */
@@ -152,6 +937,11 @@ int hal_rt_vrf_init (void)
     memcpy(vr_entry.src_mac, &ndi_mac, HAL_MAC_ADDR_LEN);
     vr_entry.flags |= NDI_VR_ATTR_SRC_MAC_ADDRESS;
 
+    /* The walkers must not starve behind the readers of an AF */
+    pthread_rwlockattr_init (&rw_lock_attr);
+    pthread_rwlockattr_setkind_np (&rw_lock_attr,
+                                   PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+
     for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id ++) {
 
         /* Create default VRF and other vrfs as per FIB_MAX_VRF */
@@ -176,6 +966,7 @@ int hal_rt_vrf_init (void)
 
             p_vrf_info->vrf_id = vrf_id;
             p_vrf_info->af_index = af_index;
+            pthread_rwlock_init (&p_vrf_info->rw_lock, &rw_lock_attr);
 
             /* Create the DR Tree */
             fib_create_dr_tree (p_vrf_info);
@@ -194,6 +985,7 @@ int hal_rt_vrf_init (void)
             p_vrf_info->is_catch_all_disabled = false;
         }
     }
+    pthread_rwlockattr_destroy (&rw_lock_attr);
     return STD_ERR_OK;
 }
 
@@ -235,6 +1027,8 @@ int hal_rt_vrf_de_init (void)
 
             /* Destroy the MP MD5 Tree */
             fib_destroy_mp_md5_tree (p_vrf_info);
+
+            pthread_rwlock_destroy (&p_vrf_info->rw_lock);
         }
         ndi_vr_id = p_vrf->vrf_obj_id;
 
@@ -424,6 +1218,16 @@ t_std_error hal_rt_task_init (void)
 
     fib_create_intf_tree ();
 
+    if ((rc = hal_rt_nh_obj_init ()) != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT", "%s (): nh_obj_init failed", __FUNCTION__);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+    }
+
+    if ((rc = hal_rt_cam_init ()) != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT", "%s (): cam_init failed", __FUNCTION__);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+    }
+
     if ((rc = hal_rt_vrf_init ()) != STD_ERR_OK) {
         EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT", "%s (): vrf_init failed", __FUNCTION__);
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
@@ -477,10 +1281,6 @@ static bool hal_rt_process_msg(cps_api_object_t obj, void *param)
             fib_proc_dr_download(obj);
             break;
 
-        case cps_api_route_obj_NEIBH:
-            fib_proc_nbr_download(obj);
-            break;
-
         default:
             EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT", "msg sub_class unknown %d",
                     cps_api_key_get_subcat(cps_api_object_key(obj)));
@@ -495,13 +1295,12 @@ t_std_error hal_rt_main(void)
     cps_api_event_reg_t reg;
 
     memset(&reg,0,sizeof(reg));
-    const uint_t NUM_KEYS=2;
+    const uint_t NUM_KEYS=1;
     cps_api_key_t key[NUM_KEYS];
 
+    /* The neighbor events are received by the neighbor pipeline */
     cps_api_key_init(&key[0],cps_api_qualifier_TARGET,
             cps_api_obj_cat_ROUTE,cps_api_route_obj_ROUTE,0);
-    cps_api_key_init(&key[1],cps_api_qualifier_TARGET,
-            cps_api_obj_cat_ROUTE,cps_api_route_obj_NEIBH,0);
 
     reg.number_of_objects = NUM_KEYS;
     reg.objects = key;
@@ -531,9 +1330,9 @@ t_std_error hal_rt_cps_thread(void)
     reg.number_of_objects = NUM_EVENTS;
     reg.objects = keys;
 
-    //Create a handle for CPS objects
+    //Create a handle for CPS objects, the handler threads take the settings of this thread
     if (cps_api_operation_subsystem_init(&nas_rt_cps_handle,
-            NUM_INT_NAS_RT_CPS_API_THREAD)!=cps_api_ret_code_OK) {
+            g_fib_config.cps_num_threads)!=cps_api_ret_code_OK) {
         return STD_ERR(CPSNAS,FAIL,0);
     }
 
@@ -557,39 +1356,47 @@ t_std_error hal_rt_init(void)
         hal_rt_task_exit ();
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
-    std_thread_init_struct(&hal_rt_main_thr);
-    hal_rt_main_thr.name = "hal-rt-main";
-    hal_rt_main_thr.thread_function = (std_thread_function_t)hal_rt_main;
+    if (hal_rt_npu_worker_init () != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating npu worker threads");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    if (hal_rt_pgm_init () != STD_ERR_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    if (hal_rt_nbr_queue_init () != STD_ERR_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
 
-    if (std_thread_create(&hal_rt_main_thr)!=STD_ERR_OK) {
+    if (hal_rt_thread_create(&hal_rt_main_thr, HAL_RT_THREAD_MAIN,
+                             (std_thread_function_t)hal_rt_main, NULL)!=STD_ERR_OK) {
         EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating thread");
         return STD_ERR(ROUTE,FAIL,0);
     }
 
-    std_thread_init_struct(&hal_rt_dr_thr);
-    hal_rt_dr_thr.name = "hal-rt-dr";
-    hal_rt_dr_thr.thread_function = (std_thread_function_t)fib_dr_walker_main;
-    if (std_thread_create(&hal_rt_dr_thr)!=STD_ERR_OK) {
+    if (hal_rt_thread_create(&hal_rt_dr_thr, HAL_RT_THREAD_DR,
+                             (std_thread_function_t)fib_dr_walker_main, NULL)!=STD_ERR_OK) {
         EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating dr thread");
         return STD_ERR(ROUTE,FAIL,0);
     }
 
-    std_thread_init_struct(&hal_rt_nh_thr);
-    hal_rt_nh_thr.name = "hal-rt-nh";
-    hal_rt_nh_thr.thread_function = (std_thread_function_t)fib_nh_walker_main;
-    if (std_thread_create(&hal_rt_nh_thr)!=STD_ERR_OK) {
+    if (hal_rt_thread_create(&hal_rt_nh_thr, HAL_RT_THREAD_NH,
+                             (std_thread_function_t)fib_nh_walker_main, NULL)!=STD_ERR_OK) {
         EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating nh thread");
         return STD_ERR(ROUTE,FAIL,0);
     }
     /*
      * New North Bound CPS Routing Thread
      */
-    std_thread_init_struct(&hal_rt_cps_thr);
-    hal_rt_cps_thr.name = "hal-rt-cps";
-    hal_rt_cps_thr.thread_function = (std_thread_function_t)hal_rt_cps_thread;
-    if (std_thread_create(&hal_rt_cps_thr)!=STD_ERR_OK) {
+    if (hal_rt_thread_create(&hal_rt_cps_thr, HAL_RT_THREAD_CPS,
+                             (std_thread_function_t)hal_rt_cps_thread, NULL)!=STD_ERR_OK) {
         EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating cps thread");
         return STD_ERR(ROUTE,FAIL,0);
     }
+
+    if (hal_rt_audit_init () != STD_ERR_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
     return STD_ERR_OK;
 }
@@ -22,6 +22,8 @@
 #include "hal_rt_main.h"
 #include "hal_rt_mem.h"
 #include "hal_rt_route.h"
+#include "hal_rt_api.h"
+#include "hal_rt_util.h"
 #include "hal_rt_debug.h"
 #include "hal_rt_mpath_grp.h"
 
@@ -34,6 +36,7 @@ t_fib_dr *fib_alloc_dr_node (void)
     t_fib_dr          *p_dr;
     t_fib_hal_dr_info *p_hal_dr_info;
     void              *p_buf = NULL;
+    size_t             size;
 
     p_dr = (t_fib_dr *) FIB_DR_MEM_MALLOC ();
 
@@ -43,13 +46,15 @@ t_fib_dr *fib_alloc_dr_node (void)
 
     memset (p_dr, 0, sizeof (t_fib_dr));
 
-       p_buf = malloc(sizeof (t_fib_hal_dr_info));
+       size = sizeof (t_fib_hal_dr_info) +
+              (hal_rt_access_fib_config()->max_num_npu * sizeof (t_fib_route_shadow));
+       p_buf = malloc(size);
        if (p_buf != NULL) {
-           memset (p_buf, 0, sizeof (t_fib_hal_dr_info));
+           memset (p_buf, 0, size);
 
            p_hal_dr_info = (t_fib_hal_dr_info *) p_buf;
            int unit;
-           for (unit = 0; unit <= hal_rt_access_fib_config()->max_num_npu; unit++) {
+           for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
                p_hal_dr_info->a_obj_status [unit] = HAL_RT_STATUS_ECMP_INVALID;
            }
        }
@@ -60,6 +65,17 @@ t_fib_dr *fib_alloc_dr_node (void)
 
 void fib_free_dr_node (t_fib_dr *p_dr)
 {
+    npu_id_t unit;
+
+    /* The route batch must not refer to a freed DR */
+    hal_rt_route_bulk_sync_dr (p_dr);
+    hal_rt_ecmp_degraded_route_del (p_dr);
+    hal_rt_retry_dr_del (p_dr);
+
+    /* Release the references on the next hop objects, if still written */
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++)
+        hal_rt_route_shadow_clear (p_dr, unit);
+
     if (p_dr->p_hal_dr_handle != NULL) {
         free ((void *) p_dr->p_hal_dr_handle);
         p_dr->p_hal_dr_handle = NULL;
@@ -78,14 +94,20 @@ t_fib_nh *fib_alloc_nh_node (void)
         return NULL;
     }
 
-    memset (p_nh, 0, sizeof (t_fib_nh));
+    memset (p_nh, 0, FIB_NH_MEM_SIZE ());
 
     return p_nh;
 }
 
 void fib_free_nh_node (t_fib_nh *p_nh)
 {
+    /* The neighbor batch of the AF must not refer to a freed NH */
+    hal_rt_nbr_bulk_flush (p_nh->key.ip_addr.af_index);
+    hal_rt_retry_nh_del (p_nh);
+
     if (p_nh->p_hal_nh_handle != NULL) {
+        hal_rt_nh_obj_free (p_nh);
+        hal_rt_nh_indirect_mp_obj_detach (p_nh);
         free(p_nh->p_hal_nh_handle);
         p_nh->p_hal_nh_handle = NULL;
     }
@@ -93,11 +115,12 @@ void fib_free_nh_node (t_fib_nh *p_nh)
     FIB_NH_MEM_FREE (p_nh);
 }
 
+/* The tunnel FHs of the AFs are allocated and freed concurrently */
 static int num_tunnel_fh_nodes = 0;
 
 int fib_num_tunnel_fh_nodes (void)
 {
-    return num_tunnel_fh_nodes;
+    return __atomic_load_n (&num_tunnel_fh_nodes, __ATOMIC_RELAXED);
 }
 
 t_fib_tunnel_fh *fib_alloc_tunnel_fh_node (void)
@@ -112,7 +135,7 @@ t_fib_tunnel_fh *fib_alloc_tunnel_fh_node (void)
 
     memset (p_tunnel_fh, 0, sizeof (t_fib_tunnel_fh));
 
-    num_tunnel_fh_nodes++;
+    __atomic_fetch_add (&num_tunnel_fh_nodes, 1, __ATOMIC_RELAXED);
 
     return p_tunnel_fh;
 }
@@ -125,8 +148,8 @@ void fib_free_tunnel_fh_node (t_fib_tunnel_fh *p_tunnel_fh)
 
     FIB_TUNNEL_FH_MEM_FREE (p_tunnel_fh);
 
-    if (num_tunnel_fh_nodes > 0) {
-        num_tunnel_fh_nodes--;
+    if (__atomic_load_n (&num_tunnel_fh_nodes, __ATOMIC_RELAXED) > 0) {
+        __atomic_fetch_sub (&num_tunnel_fh_nodes, 1, __ATOMIC_RELAXED);
     }
 }
 
@@ -172,20 +195,51 @@ void hal_rt_fib_free_mp_md5_node (t_fib_mp_md5_node *p_mp_md5_node)
     free ((void *) p_mp_md5_node);
 }
 
-t_fib_mp_obj *hal_rt_fib_calloc_mp_obj_node (void)
+static int fib_get_mp_obj_size_class (int ecmp_count)
 {
-    void *p_buf = NULL;
+    static const int a_size_class [] = HAL_RT_MP_OBJ_SIZE_CLASSES;
+    size_t           index;
 
-    p_buf = malloc(sizeof (t_fib_mp_obj));
-    if (p_buf != NULL) {
-        memset (p_buf, 0, sizeof (t_fib_mp_obj));
+    for (index = 0; index < (sizeof (a_size_class) / sizeof (a_size_class [0])); index++) {
+        if (ecmp_count <= a_size_class [index])
+            return a_size_class [index];
     }
+    return HAL_RT_MAX_ECMP_PATH;
+}
+
+t_fib_mp_obj *hal_rt_fib_calloc_mp_obj_node (npu_id_t unit, int ecmp_count)
+{
+    void   *p_buf = NULL;
+    int     max_ecmp_count;
+    size_t  size;
+    t_fib_mp_obj *p_mp_obj;
+
+    max_ecmp_count = fib_get_mp_obj_size_class (ecmp_count);
+    size = sizeof (t_fib_mp_obj) +
+           (max_ecmp_count * (sizeof (t_fib_mp_obj_link) + sizeof (next_hop_id_t) +
+                              sizeof (uint32_t)));
+
+    p_buf = malloc(size);
+    if (p_buf == NULL) {
+        return NULL;
+    }
+    memset (p_buf, 0, size);
+    hal_rt_ecmp_grp_pressure_grp_add (unit);
+
+    p_mp_obj = (t_fib_mp_obj *) p_buf;
+    p_mp_obj->unit = unit;
+    p_mp_obj->max_ecmp_count = max_ecmp_count;
+    p_mp_obj->a_link = (t_fib_mp_obj_link *) (p_mp_obj + 1);
+    p_mp_obj->a_nh_obj_id = (next_hop_id_t *) (p_mp_obj->a_link + max_ecmp_count);
+    p_mp_obj->a_nh_weight = (uint32_t *) (p_mp_obj->a_nh_obj_id + max_ecmp_count);
 
-    return ((t_fib_mp_obj *) p_buf);
+    return p_mp_obj;
 }
 
 void hal_rt_fib_free_mp_obj_node (t_fib_mp_obj *p_mp_obj)
 {
+    hal_rt_fib_unlink_mp_obj_members (p_mp_obj);
+    hal_rt_ecmp_grp_pressure_grp_del (p_mp_obj->unit);
     free ((void *) p_mp_obj);
 }
 
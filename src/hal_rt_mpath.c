@@ -108,9 +108,9 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
     next_hop_id_t nh_group_handle = 0;
     npu_id_t npu_id;
     bool error_occured = false, is_ecmp_table_full = false;
+    bool is_table_full = false;
     bool ecmp_handle_created = false;
     int valid_ecmp_count;
-    ndi_rif_id_t rif_id = 0;
     t_fib_nh *p_fh;
     t_fib_dr_fh *p_dr_fh;
     t_fib_nh_holder nh_holder;
@@ -120,7 +120,9 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
     t_fib_tunnel_fh *p_tunnel_fh = NULL;
     t_fib_tunnel_dr_fh *p_tunnel_dr_fh = NULL;
     t_std_error rc;
-    ndi_neighbor_t nbr_entry;
+    t_fib_nh *ap_new_fh[HAL_RT_MAX_ECMP_PATH];
+    uint32_t num_new_fh;
+    uint32_t num_valid_fh;
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                 "MP NH Group: VRF %d. " "Prefix: %s/%d, num_fh: %d\r\n", vrf_id,
@@ -146,6 +148,23 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
         route_entry.vrf_id = hal_vrf_obj_get(npu_id, p_dr->vrf_id);
         nh_group_entry.vrf_id = route_entry.vrf_id;
 
+        /*
+         * The next hop objects missing for the group are created at once,
+         * only for the members that fit in the ECMP width.
+         */
+        num_new_fh = 0;
+        num_valid_fh = 0;
+        FIB_FOR_EACH_FH_FROM_DR (p_dr, p_fh, nh_holder)
+        {
+            if ((FIB_IS_FH_IP_TUNNEL(p_fh)) || (!FIB_IS_FH_VALID_ECMP(p_fh, num_valid_fh)))
+                continue;
+
+            num_valid_fh++;
+            if (hal_rt_nh_obj_id_get(p_fh, npu_id) == 0)
+                ap_new_fh[num_new_fh++] = p_fh;
+        }
+        hal_rt_nh_obj_create_bulk(ap_new_fh, num_new_fh, npu_id);
+
         FIB_FOR_EACH_FH_FROM_DR (p_dr, p_fh, nh_holder)
         {
             p_dr_fh = FIB_GET_DRFH_NODE_FROM_NH_HOLDER(nh_holder);
@@ -184,54 +203,19 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
                     continue;
                 }
 
+                if (hal_rt_nh_obj_get(p_fh, npu_id, &nh_handle) != STD_ERR_OK) {
+                    return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
+                }
+
                 p_dr_fh->status = FIB_DRFH_STATUS_WRITTEN;
                 EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                         "NH Group Add VRF %d, FH: %d, nh_count: %d, " "NH handle: %d\r\n",
                         p_fh->vrf_id, p_fh->key.if_index, valid_ecmp_count,
-                        p_fh->next_hop_id);
-                nh_handle = p_fh->next_hop_id;
-
-                if (nh_handle == 0) {
-                    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
-                            "NH Group: FH nh_handle is NULL. " "Vrf_id: %d.\r\n",
-                            vrf_id);
-                    /*
-                     * If fh has no nh_handle, create one
-                     */
-                    if (nh_handle == 0) {
-                        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
-                                "NH Group: FH nh_handle is NULL. Creating!" "if_index %d Vrf_id: %d.\r\n",
-                                p_fh->key.if_index, vrf_id);
-
-                        rif_id = hal_rif_index_get(npu_id, vrf_id, p_fh->key.if_index);
-                        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
-                                "NH Group: RIF ID %d!" "Vrf_id: %d.\r\n",
-                                rif_id, vrf_id);
-
-                        memset(&nbr_entry, 0, sizeof(nbr_entry));
-                        if (hal_form_nbr_entry(&nbr_entry, p_fh) == STD_ERR_OK) {
-                            nbr_entry.rif_id = rif_id;
-                            /*
-                             * NDI Nexthop add API & Neighbor API uses the same ndi_neighbor_t
-                             * data structure. A next-hop id is created for the route next-hop
-                             * and passed as an index to NDI/SAI.
-                             */
-                            if (ndi_route_next_hop_add(&nbr_entry,&nh_handle) != STD_ERR_OK) {
-                                return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
-                            }
-                            p_fh->next_hop_id = nh_handle;
-                            hal_rt_rif_ref_inc(p_fh->key.if_index);
-                        }
-                    }
-
-                }
+                        nh_handle);
 
                 nh_group_entry.nh_list[valid_ecmp_count].id = nh_handle;
-                nh_group_entry.nh_list[valid_ecmp_count].weight = 1;
-                /*
-                 * @@TODO: verify wecmp
-                 *
-                 */
+                nh_group_entry.nh_list[valid_ecmp_count].weight =
+                    p_dr_fh->ecmp_weight_count;
 
                 EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                         "NH Group Add to NHLIST: VRF %d. Prefix: %s/%d, "
@@ -255,6 +239,8 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
          */
         nh_group_entry.npu_id = npu_id;
         nh_group_entry.nhop_count = valid_ecmp_count;
+        /* WECMP: native member weights or replicated members */
+        valid_ecmp_count = hal_rt_fib_apply_nh_weights(&nh_group_entry);
         p_dr->nh_count = valid_ecmp_count;
         hal_dump_ecmp_route_entry(&nh_group_entry);
 
@@ -356,12 +342,13 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
         if (!p_dr->a_is_written[npu_id]) {
 
             hal_dump_route_entry(&route_entry);
-            rc = ndi_route_add(&route_entry);
+            rc = hal_rt_route_ndi_add(&route_entry, p_dr, false, 0);
             if (rc != STD_ERR_OK) { /* failure */
                 EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                         "" "MP: ECMP Route Add: Failed. VRF %d, " "Prefix: %s/%d, Unit: %d, Err: %d",
                         vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                         p_dr->prefix_len, npu_id, rc);
+                is_table_full = hal_rt_ndi_rc_is_table_full(rc);
                 error_occured = true;
                 break;
             } else { /* success */
@@ -377,11 +364,14 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
                         p_dr->prefix_len, p_dr->num_fh, p_dr->nh_handle);
                 p_dr->nh_handle = route_entry.nh_handle;
             }
-        } else if (p_dr->nh_handle != nh_group_handle) { /* Update route NH */
+        } else if (!hal_rt_route_shadow_is_same(p_dr, &route_entry)) { /* Update route NH */
 
             hal_dump_route_entry(&route_entry);
+            hal_rt_route_bulk_sync_dr(p_dr);
             rc = ndi_route_set_attribute(&route_entry);
-            if (rc != STD_ERR_OK) {
+            if (rc == STD_ERR_OK) {
+                hal_rt_route_shadow_set(p_dr, &route_entry);
+            } else {
                 EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                         "MP: ECMP Route Update: Failed. Attribute Group Nexthop ID set failed."
                         "Prefix: %s/%d Unit: %d, Err: %d, old gid %d, new gid to set %d\r\n",
@@ -396,7 +386,7 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
                     "old gid %d, new gid %d %s\r\n",
                     vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                     p_dr->prefix_len, p_dr->nh_handle, nh_group_handle,
-                    (ecmp_handle_created && p_dr->ofh_list.nh_count <= 1) ?
+                    (ecmp_handle_created && p_dr->ofh_count <= 1) ?
                             "(Changed non-ECMP to ECMP)" : "");
             /*
              * Change to new group handle
@@ -417,6 +407,8 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
                     p_dr->nh_handle, nh_group_handle);
         }
 
+        /* Route is not pointing to an indirect group anymore */
+        hal_rt_set_dr_indirect_mp_obj(p_dr, npu_id, NULL);
     }
 
     if (error_occured == false) {
@@ -429,23 +421,308 @@ dn_hal_route_err hal_fib_ecmp_route_add(uint32_t vrf_id, t_fib_dr *p_dr)
         hal_rt_fib_check_and_delete_old_groupid(p_dr, route_entry.npu_id);
 
         /*
-         * Update old list in pdr->ofh_list with new nh list values to save a  copy of old NH
+         * Save the old FH count, the members are kept in the mp_obj
+         */
+        p_dr->ofh_count = valid_ecmp_count;
+    } else {
+        /*
+         * The route is deleted from all the NPUs as in the non-ECMP case,
+         * the caller queues it for retry.
          */
-        size_t i;
+        hal_fib_route_del(vrf_id, p_dr);
+        return ((is_table_full) ? DN_HAL_ROUTE_E_FULL : DN_HAL_ROUTE_E_FAIL);
+    }
+
+    return (DN_HAL_ROUTE_E_NONE);
+}
+
+/*
+ * Hierarchical FIB: program the first hops of the recursive NH p_nh as an
+ * indirect group. The group is created when the NH gets its first valid
+ * first hop and its members are updated in place afterwards, so the routes
+ * pointing to the group are not re-programmed on an underlay change.
+ */
+t_std_error hal_fib_nh_indirect_grp_update(t_fib_nh *p_nh)
+{
+    t_fib_hal_nh_info *p_hal_nh_info;
+    t_fib_mp_obj *p_mp_obj;
+    t_fib_nh *p_fh;
+    t_fib_nh_holder nh_holder;
+    ndi_nh_group_t nh_group_entry;
+    t_fib_nh *ap_new_fh[HAL_RT_MAX_ECMP_PATH];
+    uint32_t num_new_fh;
+    uint32_t num_valid_fh;
+    next_hop_id_t a_nh_obj_id[HAL_RT_MAX_ECMP_PATH];
+    next_hop_id_t nh_handle, tmp;
+    npu_id_t npu_id;
+    int valid_ecmp_count, i, j;
+    t_std_error rc = STD_ERR_OK;
+
+    if ((!(hal_rt_access_fib_config()->hierarchical_fib)) ||
+        (FIB_IS_NH_FH(p_nh))) {
+        hal_rt_nh_indirect_mp_obj_detach(p_nh);
+        return STD_ERR_OK;
+    }
+
+    if (p_nh->p_hal_nh_handle == NULL) {
+        p_nh->p_hal_nh_handle = hal_rt_fib_calloc_hal_nh_info_node();
+        if (p_nh->p_hal_nh_handle == NULL) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                    "%s (): Failed to allocate NH info. VRF %d, NH: %s\r\n",
+                    __FUNCTION__, p_nh->vrf_id,
+                    FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr));
+            return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
+        }
+    }
+    p_hal_nh_info = (t_fib_hal_nh_info *) p_nh->p_hal_nh_handle;
+
+    for (npu_id = 0; npu_id < hal_rt_access_fib_config()->max_num_npu;
+            npu_id++) {
+        memset(&nh_group_entry, 0, sizeof(nh_group_entry));
+        memset(a_nh_obj_id, 0, sizeof(a_nh_obj_id));
+        memcpy(&nh_group_entry.prefix, &p_nh->key.ip_addr, sizeof(nh_group_entry.prefix));
+        nh_group_entry.mask_len = FIB_AFINDEX_TO_PREFIX_LEN(p_nh->key.ip_addr.af_index);
+        nh_group_entry.group_type = NDI_ROUTE_NH_GROUP_TYPE_ECMP;
+        nh_group_entry.npu_id = npu_id;
+        nh_group_entry.vrf_id = hal_vrf_obj_get(npu_id, p_nh->vrf_id);
+        valid_ecmp_count = 0;
+
+        num_new_fh = 0;
+        num_valid_fh = 0;
+        FIB_FOR_EACH_FH_FROM_NH (p_nh, p_fh, nh_holder)
+        {
+            if ((FIB_IS_FH_IP_TUNNEL(p_fh)) || (!FIB_IS_FH_VALID_ECMP(p_fh, num_valid_fh)))
+                continue;
+
+            num_valid_fh++;
+            if (hal_rt_nh_obj_id_get(p_fh, npu_id) == 0)
+                ap_new_fh[num_new_fh++] = p_fh;
+        }
+        hal_rt_nh_obj_create_bulk(ap_new_fh, num_new_fh, npu_id);
+
+        FIB_FOR_EACH_FH_FROM_NH (p_nh, p_fh, nh_holder)
+        {
+            if ((FIB_IS_FH_IP_TUNNEL(p_fh)) ||
+                (!FIB_IS_FH_VALID_ECMP(p_fh, valid_ecmp_count))) {
+                continue;
+            }
+
+            if (hal_rt_nh_obj_get(p_fh, npu_id, &nh_handle) != STD_ERR_OK) {
+                continue;
+            }
+
+            nh_group_entry.nh_list[valid_ecmp_count].id = nh_handle;
+            nh_group_entry.nh_list[valid_ecmp_count].weight = 1;
+            a_nh_obj_id[valid_ecmp_count] = nh_handle;
+            valid_ecmp_count++;
+        }
+        nh_group_entry.nhop_count = valid_ecmp_count;
+
         for (i = 0; i < valid_ecmp_count; i++) {
-            p_dr->ofh_list.nh_list[i].id = nh_group_entry.nh_list[i].id;
-            p_dr->ofh_list.nh_list[i].weight = nh_group_entry.nh_list[i].weight;
-            p_dr->ofh_list.nh_count = valid_ecmp_count;
+            for (j = i + 1; j < valid_ecmp_count; j++) {
+                if (a_nh_obj_id[i] > a_nh_obj_id[j]) {
+                    tmp = a_nh_obj_id[j];
+                    a_nh_obj_id[j] = a_nh_obj_id[i];
+                    a_nh_obj_id[i] = tmp;
+                }
+            }
         }
-    } else {
+
+        p_mp_obj = p_hal_nh_info->ap_mp_obj[npu_id];
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "Indirect NH Group: VRF %d, NH: %s, valid_ecmp_count %d, "
+                "GID %d, Unit: %d\r\n", p_nh->vrf_id,
+                FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), valid_ecmp_count,
+                (p_mp_obj != NULL) ? p_mp_obj->sai_ecmp_gid : 0, npu_id);
+
+        if (valid_ecmp_count == 0) {
+            /*
+             * No usable first hop, the routes fall back to the
+             * flattened first hops of the NH.
+             */
+            p_hal_nh_info->ap_mp_obj[npu_id] = NULL;
+            hal_rt_fib_release_indirect_mp_obj(p_mp_obj);
+            continue;
+        }
+
+        if ((p_mp_obj != NULL) &&
+            (hal_rt_fib_update_indirect_mp_obj(&nh_group_entry, p_mp_obj,
+                    valid_ecmp_count, a_nh_obj_id) == STD_ERR_OK)) {
+            continue;
+        }
+
         /*
-         * @@TODO either delete route hal_fib_route_del or take appropriate action
-         * to return  DN_HAL_ROUTE_E_FAIL
+         * New indirect group or the in-place update failed, the routes
+         * pointing to the old group are moved to the new group by the
+         * DR walker.
          */
+        p_hal_nh_info->ap_mp_obj[npu_id] = NULL;
+        hal_rt_fib_release_indirect_mp_obj(p_mp_obj);
 
+        p_mp_obj = hal_rt_fib_create_indirect_mp_obj(&nh_group_entry,
+                valid_ecmp_count, a_nh_obj_id);
+        if (p_mp_obj == NULL) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                    "Indirect NH Group: Create failed. VRF %d, NH: %s, Unit: %d\r\n",
+                    p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), npu_id);
+            rc = STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
+            continue;
+        }
+        p_mp_obj->vrf_id = p_nh->vrf_id;
+        p_mp_obj->af_index = p_nh->key.ip_addr.af_index;
+        p_hal_nh_info->ap_mp_obj[npu_id] = p_mp_obj;
     }
 
-    return (DN_HAL_ROUTE_E_NONE);
+    return rc;
+}
+
+/*
+ * Returns the recursive NH if the route has to be programmed to point to
+ * the indirect group of the NH, else NULL.
+ */
+t_fib_nh *hal_fib_get_indirect_nh(t_fib_dr *p_dr)
+{
+    t_fib_nh *p_nh;
+    t_fib_nh_holder nh_holder;
+    npu_id_t npu_id;
+
+    if ((!(hal_rt_access_fib_config()->hierarchical_fib)) ||
+        (p_dr->status_flag & FIB_DR_STATUS_DEGENERATED) ||
+        (p_dr->num_nh != 1)) {
+        return NULL;
+    }
+
+    p_nh = FIB_GET_FIRST_NH_FROM_DR(p_dr, nh_holder);
+    if ((p_nh == NULL) || (FIB_IS_NH_FH(p_nh))) {
+        return NULL;
+    }
+
+    for (npu_id = 0; npu_id < hal_rt_access_fib_config()->max_num_npu;
+            npu_id++) {
+        if (hal_rt_get_nh_indirect_mp_obj(p_nh, npu_id) == NULL) {
+            return NULL;
+        }
+    }
+
+    return p_nh;
+}
+
+dn_hal_route_err hal_fib_indirect_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
+        t_fib_nh *p_nh)
+{
+    next_hop_id_t old_nh_handle;
+    npu_id_t npu_id;
+    bool error_occured = false;
+    bool is_table_full = false;
+    t_fib_mp_obj *p_mp_obj = NULL;
+    t_fib_mp_obj *p_old_mp_obj;
+    t_fib_nh *p_fh;
+    t_fib_dr_fh *p_dr_fh;
+    t_fib_nh_holder nh_holder;
+    ndi_route_t route_entry;
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "Indirect Route: VRF %d. Prefix: %s/%d, NH: %s\r\n", vrf_id,
+            FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+            FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr));
+
+    memset(&route_entry, 0, sizeof(route_entry));
+    hal_form_route_entry(&route_entry, p_dr, false);
+
+    for (npu_id = 0; npu_id < hal_rt_access_fib_config()->max_num_npu;
+            npu_id++) {
+        p_mp_obj = hal_rt_get_nh_indirect_mp_obj(p_nh, npu_id);
+
+        /* Group of its own the route was pointing to on this unit */
+        p_old_mp_obj = (p_dr->ecmp_handle_created) ? hal_rt_get_dr_mp_obj(p_dr, npu_id) : NULL;
+        old_nh_handle = (p_old_mp_obj != NULL) ? p_old_mp_obj->sai_ecmp_gid : 0;
+
+        route_entry.npu_id = npu_id;
+        route_entry.vrf_id = hal_vrf_obj_get(npu_id, p_dr->vrf_id);
+        route_entry.flags = NDI_ROUTE_L3_ECMP;
+        route_entry.nh_handle = p_mp_obj->sai_ecmp_gid;
+        route_entry.action = NDI_ROUTE_PACKET_ACTION_FORWARD;
+
+        if (!p_dr->a_is_written[npu_id]) {
+            hal_dump_route_entry(&route_entry);
+            rc = hal_rt_route_ndi_add(&route_entry, p_dr, false, 0);
+            if (rc != STD_ERR_OK) {
+                EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                        "Indirect Route Add: Failed. VRF %d, Prefix: %s/%d, "
+                        "GID %d, Unit: %d, Err: %d", vrf_id,
+                        FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                        p_dr->prefix_len, route_entry.nh_handle, npu_id, rc);
+                is_table_full = hal_rt_ndi_rc_is_table_full(rc);
+                error_occured = true;
+                break;
+            }
+            p_dr->a_is_written[npu_id] = true;
+        } else if (!hal_rt_route_shadow_is_same(p_dr, &route_entry)) {
+            hal_dump_route_entry(&route_entry);
+            hal_rt_route_bulk_sync_dr(p_dr);
+            rc = ndi_route_set_attribute(&route_entry);
+            if (rc == STD_ERR_OK) {
+                hal_rt_route_shadow_set(p_dr, &route_entry);
+            } else {
+                EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                        "Indirect Route Update: Failed. VRF %d, Prefix: %s/%d, "
+                        "old hdl %d, new GID %d, Unit: %d, Err: %d", vrf_id,
+                        FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+                        p_dr->nh_handle, route_entry.nh_handle, npu_id, rc);
+                error_occured = true;
+                break;
+            }
+        } else {
+            EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                    "Indirect Route already programmed! Prefix: %s/%d, GID %d\r\n",
+                    FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+                    route_entry.nh_handle);
+        }
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-NDI(RT-END)",
+                "Indirect Route Add: Successful. VRF %d. Prefix: %s/%d: "
+                "old hdl %d, GID %d", vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                p_dr->prefix_len, p_dr->nh_handle, route_entry.nh_handle);
+
+        p_dr->nh_handle = route_entry.nh_handle;
+        hal_rt_set_dr_indirect_mp_obj(p_dr, npu_id, p_mp_obj);
+
+        /*
+         * The route was pointing to a group of its own (ECMP to indirect case)
+         */
+        if (old_nh_handle != 0) {
+            rc = hal_rt_delete_ecmp_group(p_dr, &route_entry, old_nh_handle, true);
+            if (rc != STD_ERR_OK) {
+                EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                        "ECMP:Failed to delete route from NH group :%d Prefix: %s/%d ,"
+                        "Vrf_id: %d, Unit: %d Err: %d \r\n",
+                        old_nh_handle, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                        p_dr->prefix_len, vrf_id, npu_id, rc);
+            }
+        }
+    }
+
+    if (error_occured == true) {
+        hal_fib_route_del(vrf_id, p_dr);
+        return ((is_table_full) ? DN_HAL_ROUTE_E_FULL : DN_HAL_ROUTE_E_FAIL);
+    }
+
+    /* The groups of its own have been released on all the units */
+    p_dr->ecmp_handle_created = false;
+
+    FIB_FOR_EACH_FH_FROM_DR (p_dr, p_fh, nh_holder)
+    {
+        p_dr_fh = FIB_GET_DRFH_NODE_FROM_NH_HOLDER(nh_holder);
+        p_dr_fh->status = (FIB_IS_FH_VALID_ECMP(p_fh, 0)) ?
+                FIB_DRFH_STATUS_WRITTEN : FIB_DRFH_STATUS_UNWRITTEN;
+    }
+
+    p_dr->nh_count = (p_mp_obj != NULL) ? p_mp_obj->ecmp_count : 0;
+    p_dr->ofh_count = 0;
+
+    return DN_HAL_ROUTE_E_NONE;
 }
 
 dn_hal_route_err hal_fib_ecmp_route_del(uint32_t vrf_id, t_fib_dr *p_dr) {
@@ -505,13 +782,15 @@ dn_hal_route_err hal_fib_ecmp_route_del(uint32_t vrf_id, t_fib_dr *p_dr) {
                          p_dr->nh_handle, vrf_id, npu_id, rc);
             error_occured = true;
         }
+        hal_rt_set_dr_indirect_mp_obj(p_dr, npu_id, NULL);
 
         p_dr->a_is_written[npu_id] = false;
+        hal_rt_route_shadow_clear(p_dr, npu_id);
         p_dr->nh_handle = 0;
         p_dr->ecmp_handle_created = false;
         p_dr->num_fh = 0;
         p_dr->nh_count = 0;
-        memset(&(p_dr->ofh_list), 0, sizeof(t_fib_nh_list));
+        p_dr->ofh_count = 0;
     }
     if (error_occured == true) {
         return DN_HAL_ROUTE_E_FAIL;
@@ -79,6 +79,7 @@ static void fib_update_mp_obj_info (t_fib_dr *p_dr, npu_id_t unit, t_fib_hal_dr_
                 /* Old Route is ECMP and new Route is non-ECMP */
 
                 p_hal_dr_info->ap_mp_obj [unit] = NULL;
+                hal_rt_ecmp_degraded_route_del (p_dr);
 
                 if (p_old_mp_obj != NULL && (p_old_mp_obj->ref_count > 0))
                 {
@@ -152,13 +153,17 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
     npu_id_t            unit;
     int                 is_mp_obj_created;
     int                 is_mp_obj_replaced;
+    int                 is_mp_obj_updated;
+    int                 is_mp_obj_shared;
     int                 error_occured = false;
     int                 ecmp_count;
+    bool                is_resilient;
     t_fib_hal_dr_info   *p_hal_dr_info;
     t_fib_mp_obj        *p_mp_obj = NULL;
     t_fib_mp_obj        *p_old_mp_obj = NULL;
     uint8_t             aui1_md5_digest [HAL_RT_MD5_DIGEST_LEN];
     next_hop_id_t       a_nh_obj_id [HAL_RT_MAX_ECMP_PATH];
+    uint32_t            a_nh_weight [HAL_RT_MAX_ECMP_PATH];
 
     p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
     unit = entry->npu_id;
@@ -166,6 +171,8 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
     *p_out_is_mp_table_full   = false;
     is_mp_obj_created  = false;
     is_mp_obj_replaced = false;
+    is_mp_obj_updated  = false;
+    is_mp_obj_shared   = false;
     if (p_dr->nh_count > HAL_RT_MAX_ECMP_PATH) {
         ecmp_count         = HAL_RT_MAX_ECMP_PATH;
     }else {
@@ -175,6 +182,7 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
 
         memset (aui1_md5_digest, 0, sizeof (aui1_md5_digest));
         memset (a_nh_obj_id, 0, sizeof (a_nh_obj_id));
+        memset (a_nh_weight, 0, sizeof (a_nh_weight));
 
         if ((p_hal_dr_info->a_obj_status [unit] == HAL_RT_STATUS_ECMP) &&
             (p_hal_dr_info->ap_mp_obj [unit] != NULL))
@@ -189,31 +197,54 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
         size_t i;
         for (i=0; i<ecmp_count; i++) {
             a_nh_obj_id[i] = entry->nh_list[i].id;
+            a_nh_weight[i] = entry->nh_list[i].weight;
 
         }
 
+        is_resilient = hal_rt_access_fib_config()->ecmp_resilient_hash;
+        if (is_resilient) {
+            /*
+             * Resilient group: the members are the bucket table, in bucket
+             * order. Start from the buckets of the group the route is using
+             * so that only the buckets of the changed members move.
+             */
+            entry->nhop_count = ecmp_count;
+            ecmp_count = hal_rt_fib_form_resilient_group (entry,
+                              ((p_hal_dr_info->a_obj_status [unit] == HAL_RT_STATUS_ECMP) ?
+                               p_hal_dr_info->ap_mp_obj [unit] : NULL),
+                              a_nh_obj_id, a_nh_weight);
+        }
+
 
         /*
-         * Sort the NH list in ascending order
+         * Sort the NH list in ascending order of NH id and weight
          * @@TODO: make it a nlog(n) function
          */
         size_t j;
         next_hop_id_t tmp;
-        for (i=0; i<ecmp_count; i++) {
+        uint32_t tmp_weight;
+        for (i=0; (!is_resilient) && (i<ecmp_count); i++) {
             for (j=i+1; j<ecmp_count; j++) {
-                if (a_nh_obj_id[i]  > a_nh_obj_id[j]) {
+                if ((a_nh_obj_id[i]  > a_nh_obj_id[j]) ||
+                    ((a_nh_obj_id[i] == a_nh_obj_id[j]) &&
+                     (a_nh_weight[i] > a_nh_weight[j]))) {
                     tmp = a_nh_obj_id[j];
                     a_nh_obj_id[j] = a_nh_obj_id[i];
                     a_nh_obj_id[i] = tmp;
+                    tmp_weight = a_nh_weight[j];
+                    a_nh_weight[j] = a_nh_weight[i];
+                    a_nh_weight[i] = tmp_weight;
                 }
             }
 
         }
 
         hal_dump_ecmp_nh_list(a_nh_obj_id, ecmp_count);
-        hal_rt_fib_form_md5_key(aui1_md5_digest, a_nh_obj_id, HAL_RT_MAX_ECMP_PATH, 1);
+        hal_rt_fib_form_md5_key(aui1_md5_digest, a_nh_obj_id, a_nh_weight,
+                                ecmp_count, 1);
 
-        p_mp_obj = hal_rt_fib_get_mp_obj (p_dr, entry, aui1_md5_digest, ecmp_count, a_nh_obj_id);
+        p_mp_obj = hal_rt_fib_get_mp_obj (p_dr, entry, aui1_md5_digest, ecmp_count,
+                                          a_nh_obj_id, a_nh_weight);
         EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                 "hal_rt_find_or_create_ecmp_group: Get Multipath mp_obj Node  =%p (ref_cnt=%d) "
                                "Unit: %d.\n",p_mp_obj, p_mp_obj? p_mp_obj->ref_count :-1, unit);
@@ -229,10 +260,24 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
              */
 
             if ((p_old_mp_obj != NULL) &&
+                (p_old_mp_obj->ref_count == 1) &&
+                (hal_rt_access_fib_config()->ecmp_grp_incr_update) &&
+                (hal_rt_fib_update_mp_obj (p_dr, entry, p_old_mp_obj, aui1_md5_digest,
+                                           ecmp_count, a_nh_obj_id,
+                                           a_nh_weight) == STD_ERR_OK))
+            {
+                /*
+                 * Members of the existing group are updated in place,
+                 * the route keeps pointing to the same group id.
+                 */
+                p_mp_obj = p_old_mp_obj;
+                is_mp_obj_updated = true;
+            }
+            else if ((p_old_mp_obj != NULL) &&
                 (p_old_mp_obj->ref_count == 1))
             {
                 p_mp_obj = hal_rt_fib_create_mp_obj (p_dr, entry, aui1_md5_digest, ecmp_count,
-                                         a_nh_obj_id, true,
+                                         a_nh_obj_id, a_nh_weight, true,
                                          p_old_mp_obj->sai_ecmp_gid,
                                          p_out_is_mp_table_full);
 
@@ -254,9 +299,32 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
                   */
 
                 p_mp_obj = hal_rt_fib_create_mp_obj (p_dr, entry, aui1_md5_digest, ecmp_count,
-                                         a_nh_obj_id, false,
+                                         a_nh_obj_id, a_nh_weight, false,
                                          0, p_out_is_mp_table_full);
 
+                if ((p_mp_obj == NULL) && (*p_out_is_mp_table_full == true) &&
+                    (hal_rt_fib_mp_obj_gc_af (p_dr->key.prefix.af_index, true) > 0))
+                {
+                    /* Parked groups of the AF were holding the table, try again */
+                    p_mp_obj = hal_rt_fib_create_mp_obj (p_dr, entry, aui1_md5_digest,
+                                             ecmp_count, a_nh_obj_id, a_nh_weight,
+                                             false, 0, p_out_is_mp_table_full);
+                }
+
+                if ((p_mp_obj == NULL) && (*p_out_is_mp_table_full == true))
+                {
+                    hal_rt_ecmp_grp_pressure_table_full (unit);
+
+                    p_mp_obj = hal_rt_fib_get_shared_mp_obj (p_dr, unit, ecmp_count,
+                                                             a_nh_obj_id);
+                    if (p_mp_obj != NULL)
+                    {
+                        *p_out_is_mp_table_full = false;
+                        is_mp_obj_shared = true;
+                        hal_rt_ecmp_grp_pressure_grp_shared ();
+                    }
+                }
+
                 if (p_mp_obj == NULL)
                 {
                     EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
@@ -267,11 +335,11 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
                     error_occured = true;
                 }
 
-                is_mp_obj_created = true;
+                is_mp_obj_created = (is_mp_obj_shared == false);
             }
         }
 
-        if (p_old_mp_obj == p_mp_obj)
+        if ((p_old_mp_obj == p_mp_obj) && (is_mp_obj_updated == false))
         {
             /* Nothing has changed. So do nothing */
             EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI", "Duplicate ECMP route add. "
@@ -285,6 +353,15 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
              */
             *handle = p_mp_obj->sai_ecmp_gid;
 
+            if ((is_mp_obj_created == true) || (is_mp_obj_replaced == true))
+                p_mp_obj->is_resilient = is_resilient;
+
+            /* A shared group does not have all the paths of the route */
+            if (is_mp_obj_shared == true)
+                hal_rt_ecmp_degraded_route_add (p_dr);
+            else
+                hal_rt_ecmp_degraded_route_del (p_dr);
+
             fib_update_mp_obj_info (p_dr, unit, p_hal_dr_info, true, (void *) p_mp_obj);
         } else  {
             if (is_mp_obj_created == true)
@@ -297,9 +374,10 @@ t_std_error hal_rt_find_or_create_ecmp_group(t_fib_dr *p_dr, ndi_nh_group_t *ent
 
             if (*p_out_is_mp_table_full == true) {
                 /*
-                 *  @@TODO Do appropriate action when SAI ECMP groups are full
-                 *
+                 * Route is programmed single path by the caller, it is
+                 * upgraded when the groups are freed.
                  */
+                hal_rt_ecmp_degraded_route_add (p_dr);
                 return (STD_ERR(ROUTE, FAIL, 0));
             }
 
@@ -353,3 +431,108 @@ t_std_error hal_rt_delete_ecmp_group(t_fib_dr *p_dr, ndi_route_t  *entry,
 
     return STD_ERR_OK;
 }
+
+/*
+ * Group of its own the route is pointing to on the unit, NULL if none.
+ */
+t_fib_mp_obj *hal_rt_get_dr_mp_obj (t_fib_dr *p_dr, npu_id_t unit)
+{
+    t_fib_hal_dr_info  *p_hal_dr_info;
+
+    p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+
+    if (p_hal_dr_info == NULL)
+        return NULL;
+
+    return p_hal_dr_info->ap_mp_obj [unit];
+}
+
+/*
+ * Hierarchical FIB: indirect group of a recursive NH
+ */
+t_fib_mp_obj *hal_rt_get_nh_indirect_mp_obj (t_fib_nh *p_nh, npu_id_t unit)
+{
+    t_fib_hal_nh_info  *p_hal_nh_info;
+
+    p_hal_nh_info = (t_fib_hal_nh_info *) p_nh->p_hal_nh_handle;
+
+    if (p_hal_nh_info == NULL)
+        return NULL;
+
+    return p_hal_nh_info->ap_mp_obj [unit];
+}
+
+/*
+ * Update the indirect group the route is pointing to, NULL if the
+ * route is not pointing to an indirect group anymore. The reference on
+ * the old group is released only after the route is moved away from it.
+ */
+void hal_rt_set_dr_indirect_mp_obj (t_fib_dr *p_dr, npu_id_t unit, t_fib_mp_obj *p_mp_obj)
+{
+    t_fib_hal_dr_info  *p_hal_dr_info;
+    t_fib_mp_obj       *p_old_mp_obj;
+
+    p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+
+    if (p_hal_dr_info == NULL)
+        return;
+
+    p_old_mp_obj = p_hal_dr_info->ap_indirect_mp_obj [unit];
+
+    if (p_old_mp_obj == p_mp_obj)
+        return;
+
+    if (p_mp_obj != NULL)
+        p_mp_obj->ref_count++;
+
+    p_hal_dr_info->ap_indirect_mp_obj [unit] = p_mp_obj;
+
+    hal_rt_fib_release_indirect_mp_obj (p_old_mp_obj);
+}
+
+/*
+ * Returns true if the single NH route p_dr has to be re-programmed
+ * because the indirect group of its NH has been created or removed.
+ * A change in the members of the indirect group does not need it.
+ */
+bool hal_rt_is_dr_indirect_mp_obj_stale (t_fib_dr *p_dr, t_fib_nh *p_nh)
+{
+    t_fib_hal_dr_info  *p_hal_dr_info;
+    npu_id_t            unit;
+
+    p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+
+    if ((p_hal_dr_info == NULL) ||
+        (!(hal_rt_access_fib_config()->hierarchical_fib)))
+        return false;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        if (p_hal_dr_info->ap_indirect_mp_obj [unit] !=
+            hal_rt_get_nh_indirect_mp_obj (p_nh, unit))
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Drop the NH's reference on its indirect groups. The groups stay
+ * in hardware till the routes pointing to them are moved away.
+ */
+void hal_rt_nh_indirect_mp_obj_detach (t_fib_nh *p_nh)
+{
+    t_fib_hal_nh_info  *p_hal_nh_info;
+    t_fib_mp_obj       *p_mp_obj;
+    npu_id_t            unit;
+
+    p_hal_nh_info = (t_fib_hal_nh_info *) p_nh->p_hal_nh_handle;
+
+    if (p_hal_nh_info == NULL)
+        return;
+
+    for (unit = 0; unit < HAL_RT_MAX_INSTANCE; unit++) {
+        p_mp_obj = p_hal_nh_info->ap_mp_obj [unit];
+        p_hal_nh_info->ap_mp_obj [unit] = NULL;
+
+        hal_rt_fib_release_indirect_mp_obj (p_mp_obj);
+    }
+}
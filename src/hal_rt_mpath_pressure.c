@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_mpath_pressure.c
+ * \brief  ECMP group table pressure management
+ *
+ * The groups in use on each unit are counted against the group table
+ * capacity of the unit. The capacity comes from the config (ecmp_grp_max)
+ * or is learnt from NDI when a group create fails as the table is full. A route that could not get
+ * its own group is programmed through a shared group or single path and
+ * is kept in the degraded route list. When groups are freed, the DR walker
+ * re-resolves the degraded routes so that they get back their full ECMP.
+ *
+ * The groups of all the AFs share the group tables, the counts and the
+ * degraded route list are guarded by their own mutex. No lock is taken
+ * under it.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_mpath_grp.h"
+#include "hal_rt_util.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _t_fib_ecmp_degraded_route {
+    std_dll        glue;
+    t_fib_dr       *p_dr;
+} t_fib_ecmp_degraded_route;
+
+static pthread_mutex_t         g_fib_ecmp_grp_pressure_mutex = PTHREAD_MUTEX_INITIALIZER;
+static t_fib_ecmp_grp_pressure g_fib_ecmp_grp_pressure;
+static std_dll_head            g_fib_ecmp_degraded_route_list;
+static bool                    g_fib_ecmp_degraded_route_list_init = false;
+
+static std_dll_head *fib_get_ecmp_degraded_route_list (void)
+{
+    if (g_fib_ecmp_degraded_route_list_init == false) {
+        std_dll_init (&g_fib_ecmp_degraded_route_list);
+        g_fib_ecmp_degraded_route_list_init = true;
+    }
+    return &g_fib_ecmp_degraded_route_list;
+}
+
+/*
+ * A route takes a group on every unit, the table pressure is the one of
+ * the unit with the least free groups. A unit whose capacity is not known
+ * yet has no limit.
+ */
+static void fib_sync_ecmp_grp_pressure (void)
+{
+    t_fib_ecmp_grp_pressure *p_pressure = &g_fib_ecmp_grp_pressure;
+    uint32_t                 capacity;
+    uint32_t                 num_free;
+    uint32_t                 min_free = 0;
+    npu_id_t                 unit;
+
+    p_pressure->num_grps_in_use = 0;
+    p_pressure->grp_capacity = 0;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        if (hal_rt_access_fib_config()->ecmp_grp_max > 0)
+            p_pressure->a_grp_capacity [unit] = hal_rt_access_fib_config()->ecmp_grp_max;
+
+        capacity = p_pressure->a_grp_capacity [unit];
+        if (capacity == 0) {
+            if ((p_pressure->grp_capacity == 0) &&
+                (p_pressure->a_num_grps_in_use [unit] > p_pressure->num_grps_in_use))
+                p_pressure->num_grps_in_use = p_pressure->a_num_grps_in_use [unit];
+            continue;
+        }
+
+        num_free = (capacity > p_pressure->a_num_grps_in_use [unit]) ?
+                   (capacity - p_pressure->a_num_grps_in_use [unit]) : 0;
+        if ((p_pressure->grp_capacity == 0) || (num_free < min_free)) {
+            min_free = num_free;
+            p_pressure->grp_capacity = capacity;
+            p_pressure->num_grps_in_use = p_pressure->a_num_grps_in_use [unit];
+        }
+    }
+}
+
+t_fib_ecmp_grp_pressure *hal_rt_access_ecmp_grp_pressure (void)
+{
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    fib_sync_ecmp_grp_pressure ();
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+
+    return &g_fib_ecmp_grp_pressure;
+}
+
+void hal_rt_ecmp_grp_pressure_grp_add (npu_id_t unit)
+{
+    if (unit >= HAL_RT_MAX_INSTANCE)
+        return;
+
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    g_fib_ecmp_grp_pressure.a_num_grps_in_use [unit]++;
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+}
+
+void hal_rt_ecmp_grp_pressure_grp_del (npu_id_t unit)
+{
+    if (unit >= HAL_RT_MAX_INSTANCE)
+        return;
+
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    if (g_fib_ecmp_grp_pressure.a_num_grps_in_use [unit] > 0)
+        g_fib_ecmp_grp_pressure.a_num_grps_in_use [unit]--;
+
+    g_fib_ecmp_grp_pressure.is_grp_freed = true;
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+}
+
+/*
+ * NDI failed to create a group on the unit as its group table is full.
+ * Unless the capacity is configured, the groups in use on the unit give
+ * the capacity of its table.
+ */
+void hal_rt_ecmp_grp_pressure_table_full (npu_id_t unit)
+{
+    t_fib_ecmp_grp_pressure *p_pressure = &g_fib_ecmp_grp_pressure;
+    uint32_t                 num_grps_in_use;
+    uint32_t                 grp_capacity;
+
+    if (unit >= HAL_RT_MAX_INSTANCE)
+        return;
+
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    p_pressure->num_table_full++;
+    p_pressure->is_grp_freed = false;
+
+    if (hal_rt_access_fib_config()->ecmp_grp_max == 0)
+        p_pressure->a_grp_capacity [unit] = p_pressure->a_num_grps_in_use [unit];
+
+    num_grps_in_use = p_pressure->a_num_grps_in_use [unit];
+    grp_capacity    = p_pressure->a_grp_capacity [unit];
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-MP",
+            "ECMP group table full. Groups in use: %d, Capacity: %d, Unit: %d\r\n",
+            num_grps_in_use, grp_capacity, unit);
+}
+
+void hal_rt_ecmp_grp_pressure_grp_shared (void)
+{
+    FIB_CNTRS_ADD (g_fib_ecmp_grp_pressure.num_shared, 1);
+}
+
+/*
+ * The route is not programmed with its own group. The route keeps its
+ * entry of the list, it is removed from the list before it is freed.
+ */
+void hal_rt_ecmp_degraded_route_add (t_fib_dr *p_dr)
+{
+    t_fib_ecmp_degraded_route *p_route;
+
+    if (p_dr->p_ecmp_degraded != NULL)
+        return;
+
+    p_route = (t_fib_ecmp_degraded_route *) malloc (sizeof (t_fib_ecmp_degraded_route));
+    if (p_route == NULL) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-MP",
+                "Failed to allocate degraded route node. Prefix: %s/%d\r\n",
+                FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+        return;
+    }
+    memset (p_route, 0, sizeof (t_fib_ecmp_degraded_route));
+
+    p_route->p_dr = p_dr;
+    p_dr->p_ecmp_degraded = p_route;
+
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    std_dll_insertatback (fib_get_ecmp_degraded_route_list (), &p_route->glue);
+    g_fib_ecmp_grp_pressure.num_degraded_routes++;
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-MP",
+            "ECMP degraded route: VRF %d, Prefix: %s/%d, Degraded routes: %d\r\n",
+            p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+            g_fib_ecmp_grp_pressure.num_degraded_routes);
+}
+
+static void fib_free_ecmp_degraded_route (t_fib_ecmp_degraded_route *p_route)
+{
+    p_route->p_dr->p_ecmp_degraded = NULL;
+
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    std_dll_remove (fib_get_ecmp_degraded_route_list (), &p_route->glue);
+
+    if (g_fib_ecmp_grp_pressure.num_degraded_routes > 0)
+        g_fib_ecmp_grp_pressure.num_degraded_routes--;
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+
+    free (p_route);
+}
+
+/*
+ * The route got its own group, is not ECMP anymore or is freed.
+ */
+void hal_rt_ecmp_degraded_route_del (t_fib_dr *p_dr)
+{
+    if (p_dr->p_ecmp_degraded == NULL)
+        return;
+
+    fib_free_ecmp_degraded_route ((t_fib_ecmp_degraded_route *) p_dr->p_ecmp_degraded);
+}
+
+uint32_t hal_rt_ecmp_num_degraded_routes (void)
+{
+    return g_fib_ecmp_grp_pressure.num_degraded_routes;
+}
+
+/*
+ * Called by the DR walker when it is idle. If groups are available, mark
+ * the degraded routes for resolution, as many as the free groups (a batch
+ * if a group was freed since the table got full and the capacity is not
+ * known). Returns the number of routes marked. The walker holds the L3
+ * locks of all the AFs, no route is added to or removed from the list by
+ * another thread meanwhile, the mutex is taken only to change it.
+ */
+int hal_rt_ecmp_degraded_routes_upgrade (void)
+{
+    t_fib_ecmp_degraded_route *p_route;
+    t_fib_ecmp_degraded_route *p_next_route;
+    t_fib_ecmp_grp_pressure   *p_pressure = hal_rt_access_ecmp_grp_pressure ();
+    uint32_t                   num_free;
+    int                        num_marked = 0;
+
+    if (p_pressure->num_degraded_routes == 0)
+        return 0;
+
+    if (p_pressure->grp_capacity > p_pressure->num_grps_in_use) {
+        num_free = p_pressure->grp_capacity - p_pressure->num_grps_in_use;
+    } else if ((p_pressure->grp_capacity == 0) && (p_pressure->is_grp_freed)) {
+        num_free = HAL_RT_MP_OBJ_GC_BATCH;
+    } else {
+        return 0;
+    }
+
+    p_route = (t_fib_ecmp_degraded_route *)
+        std_dll_getfirst (fib_get_ecmp_degraded_route_list ());
+
+    while ((p_route != NULL) && ((uint32_t) num_marked < num_free))
+    {
+        p_next_route = (t_fib_ecmp_degraded_route *)
+            std_dll_getnext (fib_get_ecmp_degraded_route_list (), &p_route->glue);
+
+        /* Re-added to the list if the route cannot get a group still */
+        fib_mark_dr_for_resolution (p_route->p_dr);
+        FIB_CNTRS_ADD (p_pressure->num_upgraded, 1);
+        num_marked++;
+        fib_free_ecmp_degraded_route (p_route);
+
+        p_route = p_next_route;
+    }
+
+    pthread_mutex_lock (&g_fib_ecmp_grp_pressure_mutex);
+    p_pressure->is_grp_freed = false;
+    pthread_mutex_unlock (&g_fib_ecmp_grp_pressure_mutex);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-MP",
+            "ECMP degraded routes: %d marked for upgrade, %d remaining\r\n",
+            num_marked, p_pressure->num_degraded_routes);
+
+    return num_marked;
+}
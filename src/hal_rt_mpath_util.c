@@ -27,20 +27,28 @@
 #include "std_ip_utils.h"
 #include "std_error_codes.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <openssl/md5.h>
 
 
 void hal_rt_fib_form_md5_key (uint8_t t_md5_digest [], next_hop_id_t a_nh_obj_id [],
-                    uint32_t ecmp_count, uint32_t debug)
+                    uint32_t a_nh_weight [], uint32_t ecmp_count, uint32_t debug)
 {
     MD5_CTX      md5_context;
 
 
+    /*
+     * The member weights are part of the group identity, groups with the
+     * same members but different weights are not shared.
+     */
     MD5_Init(&md5_context);
     MD5_Update(&md5_context,(uint8_t *) a_nh_obj_id,
                sizeof (next_hop_id_t) * ecmp_count);
+    MD5_Update(&md5_context,(uint8_t *) a_nh_weight,
+               sizeof (uint32_t) * ecmp_count);
     MD5_Final(t_md5_digest, &md5_context);
 
     if (debug)
@@ -65,7 +73,81 @@ void hal_rt_fib_form_md5_key (uint8_t t_md5_digest [], next_hop_id_t a_nh_obj_id
 
 }
 
-static t_std_error fib_add_mp_obj_in_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj *p_mp_obj,
+/*
+ * Drop the back references of the members from their next hop objects,
+ * the object of a freed FH is deleted with its last reference.
+ */
+void hal_rt_fib_unlink_mp_obj_members (t_fib_mp_obj *p_mp_obj)
+{
+    t_fib_mp_obj_link *p_link;
+    int                index;
+
+    for (index = 0; index < p_mp_obj->max_ecmp_count; index++) {
+        p_link = &p_mp_obj->a_link [index];
+        if (p_link->p_list != NULL) {
+            std_dll_remove (p_link->p_list, &p_link->glue);
+            p_link->p_list = NULL;
+            hal_rt_nh_obj_mp_obj_unlinked (p_mp_obj->unit, p_mp_obj->a_nh_obj_id [index]);
+        }
+    }
+}
+
+/*
+ * Link the multipath object to the next hop object of each distinct member,
+ * the replicas of a WECMP member and the buckets of a resilient group are
+ * linked once.
+ */
+static void fib_link_mp_obj_members (t_fib_mp_obj *p_mp_obj)
+{
+    t_fib_mp_obj_link *p_link;
+    std_dll_head      *p_list;
+    int                index, prev;
+
+    for (index = 0; index < p_mp_obj->ecmp_count; index++) {
+        for (prev = 0; prev < index; prev++) {
+            if (p_mp_obj->a_nh_obj_id [prev] == p_mp_obj->a_nh_obj_id [index])
+                break;
+        }
+        if (prev < index)
+            continue;
+
+        p_list = hal_rt_nh_obj_mp_obj_list (p_mp_obj->unit, p_mp_obj->a_nh_obj_id [index]);
+        if (p_list == NULL)
+            continue;
+
+        p_link = &p_mp_obj->a_link [index];
+        p_link->p_mp_obj = p_mp_obj;
+        p_link->p_list = p_list;
+        std_dll_insertatback (p_list, &p_link->glue);
+    }
+}
+
+/*
+ * Copy the members to the size class storage of the multipath object,
+ * the caller makes sure that ecmp_count fits in max_ecmp_count.
+ */
+static void fib_set_mp_obj_members (t_fib_mp_obj *p_mp_obj, int ecmp_count,
+                                    next_hop_id_t a_nh_obj_id [], uint32_t a_nh_weight [])
+{
+    hal_rt_fib_unlink_mp_obj_members (p_mp_obj);
+
+    p_mp_obj->ecmp_count = ecmp_count;
+    memcpy (p_mp_obj->a_nh_obj_id, a_nh_obj_id, sizeof (next_hop_id_t) * ecmp_count);
+    memcpy (p_mp_obj->a_nh_weight, a_nh_weight, sizeof (uint32_t) * ecmp_count);
+
+    fib_link_mp_obj_members (p_mp_obj);
+}
+
+static bool fib_is_mp_obj_members_same (t_fib_mp_obj *p_mp_obj, int ecmp_count,
+                                        next_hop_id_t a_nh_obj_id [], uint32_t a_nh_weight [])
+{
+    return ((p_mp_obj->ecmp_count == ecmp_count) &&
+            (!memcmp (p_mp_obj->a_nh_obj_id, a_nh_obj_id, sizeof (next_hop_id_t) * ecmp_count)) &&
+            (!memcmp (p_mp_obj->a_nh_weight, a_nh_weight, sizeof (uint32_t) * ecmp_count)));
+}
+
+static t_std_error fib_add_mp_obj_in_mp_md5_tree (uint32_t vrf_id, uint8_t af_index,
+                                                   t_fib_mp_obj *p_mp_obj,
                                                    uint8_t *pu1_md5_digest)
 {
     t_fib_mp_md5_node_key  key;
@@ -77,8 +159,7 @@ static t_std_error fib_add_mp_obj_in_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj *
     memcpy (key.md5_digest, pu1_md5_digest, sizeof (key.md5_digest));
 
     p_mp_md5_node = (t_fib_mp_md5_node *)
-        std_radix_getexact (hal_rt_access_fib_vrf_mp_md5_tree(p_dr->vrf_id,
-                            p_dr->key.prefix.af_index),
+        std_radix_getexact (hal_rt_access_fib_vrf_mp_md5_tree(vrf_id, af_index),
                             (uint8_t *) &key, HAL_RT_MP_MD5_NODE_TREE_KEY_SIZE);
 
     if (p_mp_md5_node == NULL)
@@ -104,8 +185,7 @@ static t_std_error fib_add_mp_obj_in_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj *
 
         p_mp_md5_node->rt_head.rth_addr = (uint8_t *) &p_mp_md5_node->key;
 
-        p_rt_head = std_radix_insert (hal_rt_access_fib_vrf_mp_md5_tree(p_dr->vrf_id,
-                                        p_dr->key.prefix.af_index),
+        p_rt_head = std_radix_insert (hal_rt_access_fib_vrf_mp_md5_tree(vrf_id, af_index),
                                         &p_mp_md5_node->rt_head,
                                         HAL_RT_MP_MD5_NODE_TREE_KEY_SIZE);
 
@@ -125,12 +205,15 @@ static t_std_error fib_add_mp_obj_in_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj *
     p_mp_md5_node->num_nodes++;
 
     p_mp_obj->p_md5_node = p_mp_md5_node;
+    p_mp_obj->vrf_id     = vrf_id;
+    p_mp_obj->af_index   = af_index;
 
     return STD_ERR_OK;
 }
 
 
-static t_std_error fib_del_mp_obj_from_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj *p_mp_obj)
+static t_std_error fib_del_mp_obj_from_mp_md5_tree (uint32_t vrf_id, uint8_t af_index,
+                                                    t_fib_mp_obj *p_mp_obj)
 {
     t_fib_mp_md5_node *p_mp_md5_node;
 
@@ -159,8 +242,8 @@ static t_std_error fib_del_mp_obj_from_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj
 
         if ( p_mp_md5_node->num_nodes == 0)
         {
-            std_radix_remove (hal_rt_access_fib_vrf_mp_md5_tree(p_dr->vrf_id,
-                              p_dr->key.prefix.af_index), &p_mp_md5_node->rt_head);
+            std_radix_remove (hal_rt_access_fib_vrf_mp_md5_tree(vrf_id, af_index),
+                              &p_mp_md5_node->rt_head);
 
         }
 
@@ -178,7 +261,7 @@ static t_std_error fib_del_mp_obj_from_mp_md5_tree (t_fib_dr *p_dr, t_fib_mp_obj
 
 t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
                                  uint8_t *pu1_md5_digest, int ecmp_count,
-                                 next_hop_id_t a_nh_obj_id [],
+                                 next_hop_id_t a_nh_obj_id [], uint32_t a_nh_weight [],
                                  bool is_with_id, uint32_t sai_ecmp_gid,
                                  bool *p_out_is_mp_table_full)
 {
@@ -199,7 +282,9 @@ t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
      *  list and find the difference in NHs to add and delete for the existing
      *  nexthop_group or else the easy way is to add a new group id for the new NH
      *  list and then delete old group id.
-     *  Currently optimizing by creating a new group id and later deleting the old group id
+     *  The in-place member update is done by hal_rt_fib_update_mp_obj(), this
+     *  function is the fall back that creates a new group id and later deletes
+     *  the old group id.
      *
      */
 
@@ -209,7 +294,7 @@ t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
      */
     rc = ndi_route_next_hop_group_create (entry, &nh_group_handle);
 
-    if (is_with_id == true) {
+    if ((is_with_id == true) && (rc == STD_ERR_OK)) {
 
             /*
              * If the earlier nh_handle is ecmp group id, mark it for deletion
@@ -236,9 +321,9 @@ t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
                 FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                 p_dr->prefix_len, entry->npu_id, rc);
         /*
-         * set  group table as full
+         * set  group table as full, any other failure is retried
          */
-        *p_out_is_mp_table_full = true;
+        *p_out_is_mp_table_full = hal_rt_ndi_rc_is_table_full (rc);
 
         return NULL;
     } else {
@@ -252,7 +337,7 @@ t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
         /*
          * Create new mp_obj and add group_id to it.
          */
-        p_mp_obj = hal_rt_fib_calloc_mp_obj_node ();
+        p_mp_obj = hal_rt_fib_calloc_mp_obj_node (entry->npu_id, ecmp_count);
         EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL_RT-MPATH", "In Create MP Object: "
                     "Unit %d.\n", entry->npu_id);
 
@@ -266,10 +351,10 @@ t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
         }
 
         p_mp_obj->unit      = entry->npu_id;
-        p_mp_obj->ecmp_count = ecmp_count;
-        memcpy (p_mp_obj->a_nh_obj_id, a_nh_obj_id, sizeof (p_mp_obj->a_nh_obj_id));
+        fib_set_mp_obj_members (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight);
 
-        rc = fib_add_mp_obj_in_mp_md5_tree (p_dr, p_mp_obj, pu1_md5_digest);
+        rc = fib_add_mp_obj_in_mp_md5_tree (p_dr->vrf_id, p_dr->key.prefix.af_index,
+                                            p_mp_obj, pu1_md5_digest);
 
         if (STD_IS_ERR(rc))
         {
@@ -287,13 +372,522 @@ t_fib_mp_obj *hal_rt_fib_create_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
         p_mp_obj->sai_ecmp_gid = nh_group_handle;
         p_dr->onh_handle = p_dr->nh_handle;
         p_dr->ecmp_handle_created = true;
+
+        if (is_with_id == true)
+            FIB_INCR_CNTRS_ECMP_GRP_REPLACED (p_mp_obj->vrf_id, p_mp_obj->af_index);
+        else
+            FIB_INCR_CNTRS_ECMP_GRP_CREATED (p_mp_obj->vrf_id, p_mp_obj->af_index);
     }
 
     return p_mp_obj;
 }
 
+static uint32_t fib_get_nh_weight_from_group_entry (ndi_nh_group_t *entry, next_hop_id_t nh_id)
+{
+    size_t i;
+
+    for (i = 0; i < entry->nhop_count; i++) {
+        if (entry->nh_list[i].id == nh_id)
+            return entry->nh_list[i].weight;
+    }
+    return 1;
+}
+
+static void fib_get_nh_weights_from_group_entry (ndi_nh_group_t *entry, int ecmp_count,
+                                                 next_hop_id_t a_nh_obj_id [],
+                                                 uint32_t a_nh_weight [])
+{
+    int index;
+
+    for (index = 0; index < ecmp_count; index++) {
+        a_nh_weight [index] = fib_get_nh_weight_from_group_entry (entry, a_nh_obj_id [index]);
+    }
+}
+
+static uint32_t fib_get_gcd (uint32_t a, uint32_t b)
+{
+    uint32_t tmp;
+
+    while (b != 0) {
+        tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+    return a;
+}
+
+/*
+ * WECMP: convert the first hop weights in entry->nh_list to the members
+ * programmed in the group. The weights are reduced by their GCD, so equal
+ * weights give a plain ECMP group. If the NPU supports weighted members
+ * the reduced weight is given to NDI, else each member is replicated as
+ * many times as its weight, scaled down to fit in the configured ECMP width.
+ * Returns the new member count of entry->nh_list.
+ */
+int hal_rt_fib_apply_nh_weights (ndi_nh_group_t *entry)
+{
+    next_hop_id_t   a_nh_obj_id [HAL_RT_MAX_ECMP_PATH];
+    uint32_t        a_nh_weight [HAL_RT_MAX_ECMP_PATH];
+    uint32_t        gcd = 0, sum = 0, weight, rep;
+    uint32_t        max_paths = HAL_RT_ECMP_MAX_PATHS ();
+    int             count, index, nhop_count = 0;
+
+    count = entry->nhop_count;
+    if (count > max_paths)
+        count = max_paths;
+
+    for (index = 0; index < count; index++) {
+        if (entry->nh_list[index].weight == 0)
+            entry->nh_list[index].weight = 1;
+        gcd = fib_get_gcd (gcd, entry->nh_list[index].weight);
+    }
+
+    for (index = 0; index < count; index++) {
+        entry->nh_list[index].weight /= gcd;
+        sum += entry->nh_list[index].weight;
+    }
+
+    if ((hal_rt_access_fib_config()->ecmp_native_weight) || (sum == count))
+        return count;
+
+    for (index = 0; index < count; index++) {
+        a_nh_obj_id [index] = entry->nh_list[index].id;
+        a_nh_weight [index] = entry->nh_list[index].weight;
+    }
+
+    for (index = 0; index < count; index++) {
+        weight = a_nh_weight [index];
+        if (sum > max_paths) {
+            /* Every member keeps atleast one slot */
+            weight = 1 + (uint32_t) (((uint64_t) (weight - 1) *
+                                      (max_paths - count)) / (sum - count));
+        }
+        for (rep = 0; rep < weight; rep++) {
+            entry->nh_list[nhop_count].id = a_nh_obj_id [index];
+            entry->nh_list[nhop_count].weight = 1;
+            nhop_count++;
+        }
+    }
+    entry->nhop_count = nhop_count;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-MP",
+            "WECMP: %d first hops replicated to %d members, Unit: %d\r\n",
+            count, nhop_count, entry->npu_id);
+
+    return nhop_count;
+}
+
+/*
+ * Resilient (consistent hash) ECMP: the group is a table of num_buckets
+ * buckets and the flows hash onto the buckets, not onto the members. Each
+ * member owns a share of the buckets in proportion to its weight. When the
+ * membership changes, a bucket stays with its old member as long as the
+ * member is present and within its share, so only the buckets of a
+ * departing member are reassigned and a returning member takes back just
+ * its share from the members that are over theirs.
+ * a_member_id[] must be sorted so that the layout of a new group is
+ * deterministic and the routes with the same members share the group.
+ */
+void hal_rt_fib_form_resilient_buckets (next_hop_id_t a_old_bucket [], int old_num_buckets,
+                                        next_hop_id_t a_member_id [], uint32_t a_member_weight [],
+                                        int num_members, next_hop_id_t a_bucket [],
+                                        int num_buckets)
+{
+    int       a_share [HAL_RT_MAX_ECMP_PATH];
+    int       a_used [HAL_RT_MAX_ECMP_PATH];
+    bool      a_is_free [HAL_RT_MAX_ECMP_PATH];
+    uint64_t  sum = 0;
+    int       index, member, assigned = 0;
+
+    if ((num_members <= 0) || (num_buckets <= 0))
+        return;
+
+    for (member = 0; member < num_members; member++) {
+        sum += (a_member_weight [member] ? a_member_weight [member] : 1);
+    }
+    for (member = 0; member < num_members; member++) {
+        a_share [member] = (int) (((uint64_t) num_buckets *
+                                   (a_member_weight [member] ? a_member_weight [member] : 1)) / sum);
+        a_used [member] = 0;
+        assigned += a_share [member];
+    }
+    /* Hand out the remainder round robin */
+    for (member = 0; assigned < num_buckets; member = (member + 1) % num_members) {
+        a_share [member]++;
+        assigned++;
+    }
+
+    for (index = 0; index < num_buckets; index++) {
+        a_is_free [index] = true;
+        if ((a_old_bucket == NULL) || (index >= old_num_buckets))
+            continue;
+
+        for (member = 0; member < num_members; member++) {
+            if (a_member_id [member] == a_old_bucket [index])
+                break;
+        }
+        if ((member < num_members) && (a_used [member] < a_share [member])) {
+            a_bucket [index] = a_old_bucket [index];
+            a_used [member]++;
+            a_is_free [index] = false;
+        }
+    }
+
+    member = 0;
+    for (index = 0; index < num_buckets; index++) {
+        if (!a_is_free [index])
+            continue;
+
+        while (a_used [member] >= a_share [member])
+            member = (member + 1) % num_members;
+
+        a_bucket [index] = a_member_id [member];
+        a_used [member]++;
+        member = (member + 1) % num_members;
+    }
+}
+
+/*
+ * Rewrite the members of entry to the bucket table of a resilient group.
+ * The replicas of a member (WECMP) add up to its weight. The buckets of
+ * p_old_mp_obj, the group the route is currently using, are preserved
+ * where possible. Returns the number of buckets.
+ */
+int hal_rt_fib_form_resilient_group (ndi_nh_group_t *entry, t_fib_mp_obj *p_old_mp_obj,
+                                     next_hop_id_t a_nh_obj_id [], uint32_t a_nh_weight [])
+{
+    next_hop_id_t   a_member_id [HAL_RT_MAX_ECMP_PATH];
+    uint32_t        a_member_weight [HAL_RT_MAX_ECMP_PATH];
+    next_hop_id_t  *a_old_bucket = NULL;
+    int             old_num_buckets = 0;
+    int             num_buckets, num_members = 0;
+    int             index, member, pos;
+
+    num_buckets = hal_rt_access_fib_config()->ecmp_resilient_buckets;
+    if ((num_buckets <= 0) || (num_buckets > HAL_RT_MAX_ECMP_PATH))
+        num_buckets = HAL_RT_MAX_ECMP_PATH;
+
+    /* Collect the distinct members in sorted order */
+    for (index = 0; index < entry->nhop_count; index++) {
+        for (member = 0; member < num_members; member++) {
+            if (a_member_id [member] >= entry->nh_list[index].id)
+                break;
+        }
+        if ((member < num_members) && (a_member_id [member] == entry->nh_list[index].id)) {
+            a_member_weight [member] += (entry->nh_list[index].weight ?
+                                         entry->nh_list[index].weight : 1);
+            continue;
+        }
+        for (pos = num_members; pos > member; pos--) {
+            a_member_id [pos] = a_member_id [pos - 1];
+            a_member_weight [pos] = a_member_weight [pos - 1];
+        }
+        a_member_id [member] = entry->nh_list[index].id;
+        a_member_weight [member] = (entry->nh_list[index].weight ?
+                                    entry->nh_list[index].weight : 1);
+        num_members++;
+    }
+
+    if (num_members == 0)
+        return 0;
+
+    if ((p_old_mp_obj != NULL) && (p_old_mp_obj->is_resilient)) {
+        a_old_bucket = p_old_mp_obj->a_nh_obj_id;
+        old_num_buckets = p_old_mp_obj->ecmp_count;
+    }
+
+    hal_rt_fib_form_resilient_buckets (a_old_bucket, old_num_buckets, a_member_id,
+                                       a_member_weight, num_members, a_nh_obj_id, num_buckets);
+
+    for (index = 0; index < num_buckets; index++) {
+        a_nh_weight [index] = 1;
+        entry->nh_list[index].id = a_nh_obj_id [index];
+        entry->nh_list[index].weight = 1;
+    }
+    entry->nhop_count = num_buckets;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-MP",
+            "Resilient: %d members in %d buckets, Old buckets: %d, Unit: %d\r\n",
+            num_members, num_buckets, old_num_buckets, entry->npu_id);
+
+    return num_buckets;
+}
+
+/*
+ * Add/remove group members so that the group p_mp_obj has the members in
+ * a_nh_obj_id[] with the weights in a_nh_weight[]. Both the old list in
+ * p_mp_obj and the new list are sorted, so the members to be added and
+ * removed are found in a single merge pass. A member is repeated in the
+ * group as many times as it is replicated (WECMP without native weights),
+ * the copies of a member are matched one to one and only the difference
+ * in the copies is added or removed. New members are added before the
+ * stale ones are removed so that the group never becomes empty while a
+ * route is pointing to it. If the remove fails the added members are
+ * removed again and the caller replaces the group. A weight change of a
+ * native weighted member, or a resilient group whose members are kept in
+ * bucket order, is also handled by the caller replacing the group.
+ */
+static t_std_error fib_update_mp_obj_members (ndi_nh_group_t *entry, t_fib_mp_obj *p_mp_obj,
+                                              int ecmp_count, next_hop_id_t a_nh_obj_id [],
+                                              uint32_t a_nh_weight [])
+{
+    ndi_nh_group_t  add_entry;
+    ndi_nh_group_t  del_entry;
+    int             old_ix = 0, new_ix = 0;
+    t_std_error     rc;
+
+    if ((p_mp_obj->is_resilient) ||
+        (hal_rt_access_fib_config()->ecmp_resilient_hash)) {
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    memcpy (&add_entry, entry, sizeof (add_entry));
+    memcpy (&del_entry, entry, sizeof (del_entry));
+    add_entry.nhop_count = 0;
+    del_entry.nhop_count = 0;
+    add_entry.nh_group_handle = p_mp_obj->sai_ecmp_gid;
+    del_entry.nh_group_handle = p_mp_obj->sai_ecmp_gid;
+
+    while ((old_ix < p_mp_obj->ecmp_count) || (new_ix < ecmp_count)) {
+        if ((new_ix >= ecmp_count) ||
+            ((old_ix < p_mp_obj->ecmp_count) &&
+             (p_mp_obj->a_nh_obj_id[old_ix] < a_nh_obj_id[new_ix]))) {
+            del_entry.nh_list[del_entry.nhop_count].id = p_mp_obj->a_nh_obj_id[old_ix];
+            del_entry.nh_list[del_entry.nhop_count].weight = p_mp_obj->a_nh_weight[old_ix];
+            del_entry.nhop_count++;
+            old_ix++;
+        } else if ((old_ix >= p_mp_obj->ecmp_count) ||
+                   (a_nh_obj_id[new_ix] < p_mp_obj->a_nh_obj_id[old_ix])) {
+            add_entry.nh_list[add_entry.nhop_count].id = a_nh_obj_id[new_ix];
+            add_entry.nh_list[add_entry.nhop_count].weight = a_nh_weight[new_ix];
+            add_entry.nhop_count++;
+            new_ix++;
+        } else if (p_mp_obj->a_nh_weight[old_ix] != a_nh_weight[new_ix]) {
+            return (STD_ERR(ROUTE, FAIL, 0));
+        } else {
+            /* One copy of the member is kept */
+            old_ix++;
+            new_ix++;
+        }
+    }
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "NH Group: In-place update of GID %d, Unit: %d, add %d remove %d\r\n",
+            p_mp_obj->sai_ecmp_gid, entry->npu_id, add_entry.nhop_count,
+            del_entry.nhop_count);
+
+    if (add_entry.nhop_count) {
+        rc = ndi_route_add_next_hop_to_group (&add_entry, p_mp_obj->sai_ecmp_gid);
+        if (rc != STD_ERR_OK) {
+            EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                    "NH Group: Member add to GID %d failed. Unit: %d, Err: %d\r\n",
+                    p_mp_obj->sai_ecmp_gid, entry->npu_id, rc);
+            return (STD_ERR(ROUTE, FAIL, 0));
+        }
+    }
+
+    if (del_entry.nhop_count) {
+        rc = ndi_route_delete_next_hop_from_group (&del_entry, p_mp_obj->sai_ecmp_gid);
+        if (rc != STD_ERR_OK) {
+            EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                    "NH Group: Member remove from GID %d failed. Unit: %d, Err: %d\r\n",
+                    p_mp_obj->sai_ecmp_gid, entry->npu_id, rc);
+
+            /*
+             * Take the added members out again. The group is replaced by
+             * the caller, so a group left with extra members is deleted
+             * once the route points to the new group.
+             */
+            if ((add_entry.nhop_count) &&
+                (ndi_route_delete_next_hop_from_group (&add_entry,
+                                                       p_mp_obj->sai_ecmp_gid) != STD_ERR_OK)) {
+                EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                        "NH Group: Rollback of the added members of GID %d failed. "
+                        "Unit: %d\r\n", p_mp_obj->sai_ecmp_gid, entry->npu_id);
+            }
+            return (STD_ERR(ROUTE, FAIL, 0));
+        }
+    }
+
+    return STD_ERR_OK;
+}
+
+/*
+ * Update the members of an existing (non-shared) group in place.
+ * On failure, the caller falls back to replacing the group.
+ */
+t_std_error hal_rt_fib_update_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry,
+                                      t_fib_mp_obj *p_mp_obj, uint8_t *pu1_md5_digest,
+                                      int ecmp_count, next_hop_id_t a_nh_obj_id [],
+                                      uint32_t a_nh_weight [])
+{
+    t_std_error     rc;
+
+    if ((p_mp_obj == NULL) || (p_mp_obj->ref_count != 1) || (ecmp_count == 0) ||
+        (ecmp_count > p_mp_obj->max_ecmp_count)) {
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "NH Group: In-place update of GID %d VRF %d. Prefix: %s/%d\r\n",
+            p_mp_obj->sai_ecmp_gid, p_dr->vrf_id,
+            FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len);
+
+    if (fib_update_mp_obj_members (entry, p_mp_obj, ecmp_count,
+                                   a_nh_obj_id, a_nh_weight) != STD_ERR_OK) {
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    /*
+     * Re-key the multipath object with the new member list
+     */
+    fib_del_mp_obj_from_mp_md5_tree (p_dr->vrf_id, p_dr->key.prefix.af_index, p_mp_obj);
+
+    fib_set_mp_obj_members (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight);
+
+    rc = fib_add_mp_obj_in_mp_md5_tree (p_dr->vrf_id, p_dr->key.prefix.af_index,
+                                            p_mp_obj, pu1_md5_digest);
+    if (STD_IS_ERR(rc)) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "NH Group: Failed to re-insert GID %d in MD5 tree. Unit: %d\r\n",
+                p_mp_obj->sai_ecmp_gid, entry->npu_id);
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    return STD_ERR_OK;
+}
+
+/*
+ * Hierarchical FIB: indirect multipath objects.
+ * An indirect object is the group of first hops of one recursive NH. It is
+ * owned by the NH (t_fib_hal_nh_info) and shared by all the routes resolved
+ * through that NH, so it is not part of the MD5 tree. ref_count counts the
+ * owner NH plus the routes pointing to the group id; the group is deleted
+ * in hardware when the last reference goes away. The list is shared by the
+ * AFs, it is guarded by its own mutex.
+ */
+static pthread_mutex_t g_fib_indirect_mp_obj_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std_dll_head    g_fib_indirect_mp_obj_list;
+static bool            g_fib_indirect_mp_obj_list_init = false;
+
+static void fib_add_indirect_mp_obj (t_fib_mp_obj *p_mp_obj)
+{
+    pthread_mutex_lock (&g_fib_indirect_mp_obj_mutex);
+    if (g_fib_indirect_mp_obj_list_init == false) {
+        std_dll_init (&g_fib_indirect_mp_obj_list);
+        g_fib_indirect_mp_obj_list_init = true;
+    }
+    std_dll_insertatback (&g_fib_indirect_mp_obj_list, &p_mp_obj->glue);
+    pthread_mutex_unlock (&g_fib_indirect_mp_obj_mutex);
+}
+
+static void fib_del_indirect_mp_obj (t_fib_mp_obj *p_mp_obj)
+{
+    pthread_mutex_lock (&g_fib_indirect_mp_obj_mutex);
+    std_dll_remove (&g_fib_indirect_mp_obj_list, &p_mp_obj->glue);
+    pthread_mutex_unlock (&g_fib_indirect_mp_obj_mutex);
+}
+
+t_fib_mp_obj *hal_rt_fib_create_indirect_mp_obj (ndi_nh_group_t *entry, int ecmp_count,
+                                                 next_hop_id_t a_nh_obj_id [])
+{
+    t_fib_mp_obj   *p_mp_obj;
+    uint32_t        a_nh_weight [HAL_RT_MAX_ECMP_PATH];
+    next_hop_id_t   nh_group_handle = 0;
+    t_std_error     rc;
+
+    rc = ndi_route_next_hop_group_create (entry, &nh_group_handle);
+    if (rc != STD_ERR_OK) {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "NH Group: Indirect Group ID create failed. Unit: %d, Err: %d\r\n",
+                entry->npu_id, rc);
+        return NULL;
+    }
+
+    p_mp_obj = hal_rt_fib_calloc_mp_obj_node (entry->npu_id, ecmp_count);
+    if (p_mp_obj == NULL) {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL_RT-MPATH", "Create Indirect MP Object: "
+                   "Failed to allocate Multipath Object node. Unit %d.\n", entry->npu_id);
+        ndi_route_next_hop_group_delete (entry->npu_id, nh_group_handle);
+        return NULL;
+    }
+
+    p_mp_obj->unit         = entry->npu_id;
+    p_mp_obj->sai_ecmp_gid = nh_group_handle;
+    p_mp_obj->ref_count    = 1;
+    fib_get_nh_weights_from_group_entry (entry, ecmp_count, a_nh_obj_id, a_nh_weight);
+    fib_set_mp_obj_members (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight);
+
+    fib_add_indirect_mp_obj (p_mp_obj);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "NH Group: Created Indirect Group ID: %d, ecmp_count %d, Unit: %d\r\n",
+            nh_group_handle, ecmp_count, entry->npu_id);
+
+    return p_mp_obj;
+}
+
+t_std_error hal_rt_fib_update_indirect_mp_obj (ndi_nh_group_t *entry, t_fib_mp_obj *p_mp_obj,
+                                               int ecmp_count, next_hop_id_t a_nh_obj_id [])
+{
+    uint32_t a_nh_weight [HAL_RT_MAX_ECMP_PATH];
+
+    if ((p_mp_obj == NULL) || (ecmp_count == 0)) {
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    fib_get_nh_weights_from_group_entry (entry, ecmp_count, a_nh_obj_id, a_nh_weight);
+
+    if (fib_is_mp_obj_members_same (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight)) {
+        return STD_ERR_OK;
+    }
+
+    /* The group outgrows its size class, the caller replaces the group */
+    if (ecmp_count > p_mp_obj->max_ecmp_count) {
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    if (fib_update_mp_obj_members (entry, p_mp_obj, ecmp_count,
+                                   a_nh_obj_id, a_nh_weight) != STD_ERR_OK) {
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    fib_set_mp_obj_members (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight);
+
+    return STD_ERR_OK;
+}
+
+void hal_rt_fib_release_indirect_mp_obj (t_fib_mp_obj *p_mp_obj)
+{
+    t_std_error rc;
+
+    if (p_mp_obj == NULL)
+        return;
+
+    if (p_mp_obj->ref_count > 0)
+        p_mp_obj->ref_count--;
+
+    if (p_mp_obj->ref_count != 0)
+        return;
+
+    rc = ndi_route_next_hop_group_delete (p_mp_obj->unit, p_mp_obj->sai_ecmp_gid);
+    if (rc != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "NH Group: Indirect Group ID %d delete failed. Unit: %d, Err: %d\r\n",
+                p_mp_obj->sai_ecmp_gid, p_mp_obj->unit, rc);
+    } else {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "NH Group: Deleted Indirect Group ID %d, Unit: %d\r\n",
+                p_mp_obj->sai_ecmp_gid, p_mp_obj->unit);
+    }
+
+    fib_del_indirect_mp_obj (p_mp_obj);
+    hal_rt_fib_free_mp_obj_node (p_mp_obj);
+}
+
 static t_fib_mp_obj *fib_find_mp_obj_in_md5_digest_list (t_fib_mp_md5_node *p_mp_md5_node,
-                                      int  ecmp_count,  next_hop_id_t a_nh_obj_id[])
+                                      int  ecmp_count,  next_hop_id_t a_nh_obj_id[],
+                                      uint32_t a_nh_weight[])
 {
     t_fib_mp_obj *p_mp_obj;
 
@@ -301,9 +895,7 @@ static t_fib_mp_obj *fib_find_mp_obj_in_md5_digest_list (t_fib_mp_md5_node *p_mp
 
     while (p_mp_obj != NULL)
     {
-        if ((ecmp_count == p_mp_obj->ecmp_count) &&
-                !memcmp (p_mp_obj->a_nh_obj_id, a_nh_obj_id,
-                        sizeof (p_mp_obj->a_nh_obj_id)))
+        if (fib_is_mp_obj_members_same (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight))
         {
             return p_mp_obj;
         }
@@ -315,8 +907,152 @@ static t_fib_mp_obj *fib_find_mp_obj_in_md5_digest_list (t_fib_mp_md5_node *p_mp
     return NULL;
 }
 
+/*
+ * Groups with no route referring to them, oldest first. The groups are
+ * parked per AF, the list of an AF is guarded by the L3 lock of the AF.
+ */
+#define FIB_GET_MP_OBJ_FROM_GC_GLUE(_p_glue)                               \
+        ((t_fib_mp_obj *) ((uint8_t *) (_p_glue) - offsetof (t_fib_mp_obj, gc_glue)))
+
+static std_dll_head ga_fib_parked_mp_obj_list [FIB_MAX_AFINDEX];
+static bool         ga_fib_parked_mp_obj_list_init [FIB_MAX_AFINDEX];
+static uint32_t     ga_fib_num_parked_mp_objs [FIB_MAX_AFINDEX];
+
+static std_dll_head *fib_get_parked_mp_obj_list (uint8_t af_index)
+{
+    if (ga_fib_parked_mp_obj_list_init [af_index] == false) {
+        std_dll_init (&ga_fib_parked_mp_obj_list [af_index]);
+        ga_fib_parked_mp_obj_list_init [af_index] = true;
+    }
+    return &ga_fib_parked_mp_obj_list [af_index];
+}
+
+static void fib_park_mp_obj (t_fib_mp_obj *p_mp_obj)
+{
+    p_mp_obj->is_parked = true;
+    p_mp_obj->park_time = time (NULL);
+    std_dll_insertatback (fib_get_parked_mp_obj_list (p_mp_obj->af_index),
+                          &p_mp_obj->gc_glue);
+    FIB_CNTRS_ADD (ga_fib_num_parked_mp_objs [p_mp_obj->af_index], 1);
+}
+
+static void fib_unpark_mp_obj (t_fib_mp_obj *p_mp_obj)
+{
+    std_dll_remove (fib_get_parked_mp_obj_list (p_mp_obj->af_index), &p_mp_obj->gc_glue);
+    p_mp_obj->is_parked = false;
+    if (ga_fib_num_parked_mp_objs [p_mp_obj->af_index] > 0)
+        FIB_CNTRS_ADD (ga_fib_num_parked_mp_objs [p_mp_obj->af_index], -1);
+}
+
+/* Read without the L3 locks by the DR walker to decide to wake up */
+uint32_t hal_rt_fib_num_parked_mp_objs (void)
+{
+    uint32_t num_parked = 0;
+    uint8_t  af_index;
+
+    for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++)
+        num_parked += __atomic_load_n (&ga_fib_num_parked_mp_objs [af_index],
+                                       __ATOMIC_RELAXED);
+    return num_parked;
+}
+
+static t_std_error fib_free_parked_mp_obj (t_fib_mp_obj *p_mp_obj)
+{
+    t_std_error rc;
+
+    rc = ndi_route_next_hop_group_delete (p_mp_obj->unit, p_mp_obj->sai_ecmp_gid);
+    if (rc != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-MP",
+                "Parked ECMP group delete failed. gid %d, Vrf_id: %d, Unit: %d, "
+                "Err: %d\r\n", (int) p_mp_obj->sai_ecmp_gid, p_mp_obj->vrf_id,
+                p_mp_obj->unit, rc);
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    FIB_INCR_CNTRS_ECMP_GRP_FREED (p_mp_obj->vrf_id, p_mp_obj->af_index);
+    FIB_INCR_CNTRS_ECMP_GRP_DELETED (p_mp_obj->vrf_id, p_mp_obj->af_index);
+
+    fib_unpark_mp_obj (p_mp_obj);
+    fib_del_mp_obj_from_mp_md5_tree (p_mp_obj->vrf_id, p_mp_obj->af_index, p_mp_obj);
+    hal_rt_fib_free_mp_obj_node (p_mp_obj);
+
+    return STD_ERR_OK;
+}
+
+static int fib_mp_obj_gc (uint8_t af_index, bool is_force, int max_freed)
+{
+    std_dll      *p_glue;
+    std_dll      *p_next_glue;
+    t_fib_mp_obj *p_mp_obj;
+    time_t        now = time (NULL);
+    uint32_t      grace_period = hal_rt_access_fib_config()->ecmp_grp_gc_grace_period;
+    int           num_freed = 0;
+    uint32_t      num_to_visit = ga_fib_num_parked_mp_objs [af_index];
+
+    p_glue = std_dll_getfirst (fib_get_parked_mp_obj_list (af_index));
+
+    while ((p_glue != NULL) && (num_freed < max_freed) && (num_to_visit > 0))
+    {
+        p_next_glue = std_dll_getnext (fib_get_parked_mp_obj_list (af_index), p_glue);
+        p_mp_obj = FIB_GET_MP_OBJ_FROM_GC_GLUE (p_glue);
+        num_to_visit--;
+
+        /* The list is in park order, the rest are parked later */
+        if ((!is_force) && ((now - p_mp_obj->park_time) < grace_period))
+            break;
+
+        if (fib_free_parked_mp_obj (p_mp_obj) == STD_ERR_OK) {
+            num_freed++;
+        } else {
+            /*
+             * Retry after another grace period, the groups behind it
+             * are still deleted.
+             */
+            fib_unpark_mp_obj (p_mp_obj);
+            fib_park_mp_obj (p_mp_obj);
+        }
+        p_glue = p_next_glue;
+    }
+
+    if (num_freed) {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-MP",
+                "ECMP group GC: %d groups deleted, %d parked. AF: %d\r\n",
+                num_freed, ga_fib_num_parked_mp_objs [af_index], af_index);
+    }
+    return num_freed;
+}
+
+/*
+ * Delete the parked groups of the AF whose grace period is over (all of
+ * them if is_force), atmost HAL_RT_MP_OBJ_GC_BATCH groups per call. The
+ * caller holds the L3 lock of the AF. Returns the number of groups deleted.
+ */
+int hal_rt_fib_mp_obj_gc_af (uint8_t af_index, bool is_force)
+{
+    if (af_index >= FIB_MAX_AFINDEX)
+        return 0;
+
+    return fib_mp_obj_gc (af_index, is_force, HAL_RT_MP_OBJ_GC_BATCH);
+}
+
+/*
+ * Same as hal_rt_fib_mp_obj_gc_af () for all the AFs, the caller holds the
+ * L3 locks of all the AFs.
+ */
+int hal_rt_fib_mp_obj_gc (bool is_force)
+{
+    int     num_freed = 0;
+    uint8_t af_index;
+
+    for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++)
+        num_freed += fib_mp_obj_gc (af_index, is_force, HAL_RT_MP_OBJ_GC_BATCH - num_freed);
+
+    return num_freed;
+}
+
 t_fib_mp_obj *hal_rt_fib_get_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry, uint8_t *pu1_md5_digest,
-                        int ecmp_count, next_hop_id_t a_nh_obj_id[])
+                        int ecmp_count, next_hop_id_t a_nh_obj_id[],
+                        uint32_t a_nh_weight[])
 {
     t_fib_mp_md5_node_key  key;
     t_fib_mp_md5_node    *p_mp_md5_node;
@@ -355,7 +1091,112 @@ t_fib_mp_obj *hal_rt_fib_get_mp_obj (t_fib_dr *p_dr, ndi_nh_group_t *entry, uint
     else
     {
         p_mp_obj = fib_find_mp_obj_in_md5_digest_list (p_mp_md5_node, ecmp_count,
-                                                       a_nh_obj_id);
+                                                       a_nh_obj_id, a_nh_weight);
+    }
+
+    if ((p_mp_obj != NULL) && (p_mp_obj->is_parked))
+    {
+        /* Same member set is back, reuse the parked group */
+        fib_unpark_mp_obj (p_mp_obj);
+        FIB_INCR_CNTRS_ECMP_GRP_REUSED (p_mp_obj->vrf_id, p_mp_obj->af_index);
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-MP",
+                "Parked ECMP group reused. gid %d, Vrf_id: %d, Unit: %d\r\n",
+                (int) p_mp_obj->sai_ecmp_gid, p_mp_obj->vrf_id, p_mp_obj->unit);
+    }
+    return p_mp_obj;
+}
+
+/* true if every member of the list a is in the list b */
+static bool fib_is_nh_list_subset (int count_a, next_hop_id_t a_nh_obj_id_a [],
+                                   int count_b, next_hop_id_t a_nh_obj_id_b [])
+{
+    int ix_a, ix_b;
+
+    for (ix_a = 0; ix_a < count_a; ix_a++) {
+        for (ix_b = 0; ix_b < count_b; ix_b++) {
+            if (a_nh_obj_id_a [ix_a] == a_nh_obj_id_b [ix_b])
+                break;
+        }
+        if (ix_b == count_b)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * ECMP group table is full: find a group in the route's VRF that the route
+ * can share. The largest group made of a subset of the route's paths keeps
+ * the traffic on the route's paths. With the superset policy, when there is
+ * no such group, the smallest group having all the route's paths is used,
+ * the route's traffic is then spread over the extra paths of the group too.
+ */
+t_fib_mp_obj *hal_rt_fib_get_shared_mp_obj (t_fib_dr *p_dr, npu_id_t unit, int ecmp_count,
+                                            next_hop_id_t a_nh_obj_id [])
+{
+    std_rt_table          *p_md5_tree;
+    t_fib_mp_md5_node     *p_mp_md5_node;
+    t_fib_mp_md5_node_key  key;
+    t_fib_mp_obj          *p_mp_obj;
+    t_fib_mp_obj          *p_subset_mp_obj = NULL;
+    t_fib_mp_obj          *p_superset_mp_obj = NULL;
+    uint32_t               policy = hal_rt_access_fib_config()->ecmp_grp_share_policy;
+
+    if (policy == HAL_RT_ECMP_GRP_SHARE_NONE)
+        return NULL;
+
+    p_md5_tree = hal_rt_access_fib_vrf_mp_md5_tree (p_dr->vrf_id, p_dr->key.prefix.af_index);
+    if (p_md5_tree == NULL)
+        return NULL;
+
+    p_mp_md5_node = (t_fib_mp_md5_node *) std_radix_getfirst (p_md5_tree);
+
+    while (p_mp_md5_node != NULL)
+    {
+        p_mp_obj = (t_fib_mp_obj *) std_dll_getfirst (&p_mp_md5_node->mp_node_list);
+
+        while ((p_mp_obj != NULL) && (p_mp_md5_node->key.unit == unit))
+        {
+            if (p_mp_obj->is_resilient) {
+                /* The bucket layout belongs to the routes of the group */
+            } else if (fib_is_nh_list_subset (p_mp_obj->ecmp_count, p_mp_obj->a_nh_obj_id,
+                                              ecmp_count, a_nh_obj_id)) {
+                if ((p_subset_mp_obj == NULL) ||
+                    (p_mp_obj->ecmp_count > p_subset_mp_obj->ecmp_count))
+                    p_subset_mp_obj = p_mp_obj;
+            } else if ((policy == HAL_RT_ECMP_GRP_SHARE_SUPERSET) &&
+                       (fib_is_nh_list_subset (ecmp_count, a_nh_obj_id,
+                                               p_mp_obj->ecmp_count, p_mp_obj->a_nh_obj_id))) {
+                if ((p_superset_mp_obj == NULL) ||
+                    (p_mp_obj->ecmp_count < p_superset_mp_obj->ecmp_count))
+                    p_superset_mp_obj = p_mp_obj;
+            }
+            p_mp_obj = (t_fib_mp_obj *) std_dll_getnext (&p_mp_md5_node->mp_node_list,
+                                                         &p_mp_obj->glue);
+        }
+
+        memcpy (&key, &p_mp_md5_node->key, sizeof (key));
+        p_mp_md5_node = (t_fib_mp_md5_node *)
+            std_radix_getnext (p_md5_tree, (uint8_t *) &key,
+                               HAL_RT_MP_MD5_NODE_TREE_KEY_SIZE);
+    }
+
+    p_mp_obj = (p_subset_mp_obj != NULL) ? p_subset_mp_obj : p_superset_mp_obj;
+
+    if ((p_mp_obj != NULL) && (p_mp_obj->is_parked))
+    {
+        fib_unpark_mp_obj (p_mp_obj);
+        FIB_INCR_CNTRS_ECMP_GRP_REUSED (p_mp_obj->vrf_id, p_mp_obj->af_index);
+    }
+
+    if (p_mp_obj != NULL) {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-MP",
+                "ECMP group table full, sharing %s group gid %d (%d members) for "
+                "Prefix: %s/%d (%d members), Unit: %d\r\n",
+                (p_mp_obj == p_subset_mp_obj) ? "subset" : "superset",
+                (int) p_mp_obj->sai_ecmp_gid, p_mp_obj->ecmp_count,
+                FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+                ecmp_count, unit);
     }
     return p_mp_obj;
 }
@@ -399,6 +1240,31 @@ t_std_error hal_rt_fib_check_and_delete_mp_obj (t_fib_dr *p_dr, t_fib_mp_obj *p_
 
     if (p_mp_obj && (p_mp_obj->ref_count == 0))
     {
+        if ((is_sai_del == true) && (p_mp_obj->p_md5_node != NULL) &&
+            (hal_rt_access_fib_config()->ecmp_grp_gc_grace_period > 0))
+        {
+            /*
+             * Park the group instead of deleting it in the route programming
+             * path. It stays in the MD5 tree to be reused by a route with the
+             * same members, else it is deleted by hal_rt_fib_mp_obj_gc().
+             */
+            if (!p_mp_obj->is_parked) {
+                fib_park_mp_obj (p_mp_obj);
+                FIB_INCR_CNTRS_ECMP_GRP_PARKED (p_mp_obj->vrf_id, p_mp_obj->af_index);
+            }
+
+            /*
+             * The GC owns the delete of a parked group, do not let the
+             * replace path delete the gid that a route can still reuse.
+             */
+            if ((p_dr->remove_old_handle) &&
+                (p_dr->onh_handle == p_mp_obj->sai_ecmp_gid)) {
+                p_dr->remove_old_handle = false;
+                p_dr->onh_handle = 0;
+            }
+            return STD_ERR_OK;
+        }
+
         if (is_sai_del == true)
         {
 
@@ -420,7 +1286,8 @@ t_std_error hal_rt_fib_check_and_delete_mp_obj (t_fib_dr *p_dr, t_fib_mp_obj *p_
 
         }
 
-        fib_del_mp_obj_from_mp_md5_tree (p_dr, p_mp_obj);
+        FIB_INCR_CNTRS_ECMP_GRP_DELETED (p_dr->vrf_id, p_dr->key.prefix.af_index);
+        fib_del_mp_obj_from_mp_md5_tree (p_dr->vrf_id, p_dr->key.prefix.af_index, p_mp_obj);
         hal_rt_fib_free_mp_obj_node (p_mp_obj);
         return STD_ERR_OK;
     }
@@ -428,6 +1295,227 @@ t_std_error hal_rt_fib_check_and_delete_mp_obj (t_fib_dr *p_dr, t_fib_mp_obj *p_
     return STD_ERR_OK;
 }
 
+/*
+ * Remove the member nh_id from one multipath object in hardware and
+ * re-key the object with the remaining members.
+ */
+static t_std_error fib_remove_nh_from_mp_obj (uint32_t vrf_id, uint8_t af_index,
+                                              t_fib_mp_obj *p_mp_obj, next_hop_id_t nh_id)
+{
+    ndi_nh_group_t  del_entry;
+    next_hop_id_t   a_nh_obj_id [HAL_RT_MAX_ECMP_PATH];
+    uint32_t        a_nh_weight [HAL_RT_MAX_ECMP_PATH];
+    uint8_t         aui1_md5_digest [HAL_RT_MD5_DIGEST_LEN];
+    int             index, ecmp_count = 0;
+    t_std_error     rc;
+
+    memset (&del_entry, 0, sizeof (del_entry));
+    del_entry.npu_id = p_mp_obj->unit;
+    del_entry.vrf_id = hal_vrf_obj_get (p_mp_obj->unit, vrf_id);
+    del_entry.group_type = NDI_ROUTE_NH_GROUP_TYPE_ECMP;
+    del_entry.nh_group_handle = p_mp_obj->sai_ecmp_gid;
+
+    /* All the replicas of a WECMP member are removed */
+    memset (a_nh_obj_id, 0, sizeof (a_nh_obj_id));
+    memset (a_nh_weight, 0, sizeof (a_nh_weight));
+    for (index = 0; index < p_mp_obj->ecmp_count; index++) {
+        if (p_mp_obj->a_nh_obj_id [index] != nh_id) {
+            a_nh_obj_id [ecmp_count] = p_mp_obj->a_nh_obj_id [index];
+            a_nh_weight [ecmp_count] = p_mp_obj->a_nh_weight [index];
+            ecmp_count++;
+        } else {
+            del_entry.nh_list[del_entry.nhop_count].id = nh_id;
+            del_entry.nh_list[del_entry.nhop_count].weight = p_mp_obj->a_nh_weight [index];
+            del_entry.nhop_count++;
+        }
+    }
+
+    /* Keep atleast one member, the route walk handles the last path */
+    if ((ecmp_count == 0) || (del_entry.nhop_count == 0))
+        return (STD_ERR(ROUTE, FAIL, 0));
+
+    rc = ndi_route_delete_next_hop_from_group (&del_entry, p_mp_obj->sai_ecmp_gid);
+    if (rc != STD_ERR_OK) {
+        EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "NH Group: Fast reroute member %d remove from GID %d failed. "
+                "Unit: %d, Err: %d\r\n", nh_id, p_mp_obj->sai_ecmp_gid,
+                p_mp_obj->unit, rc);
+        return (STD_ERR(ROUTE, FAIL, 0));
+    }
+
+    if (p_mp_obj->p_md5_node == NULL) {
+        /* Indirect multipath object, not part of the MD5 tree */
+        fib_set_mp_obj_members (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight);
+        return STD_ERR_OK;
+    }
+
+    hal_rt_fib_form_md5_key (aui1_md5_digest, a_nh_obj_id, a_nh_weight, ecmp_count, 0);
+
+    fib_del_mp_obj_from_mp_md5_tree (vrf_id, af_index, p_mp_obj);
+
+    fib_set_mp_obj_members (p_mp_obj, ecmp_count, a_nh_obj_id, a_nh_weight);
+
+    return (fib_add_mp_obj_in_mp_md5_tree (vrf_id, af_index, p_mp_obj, aui1_md5_digest));
+}
+
+/*
+ * Next-hop failure fast reroute: remove the failed next-hop from every
+ * multipath object (group) that contains it, once per group. The groups
+ * are found from the back references of the next hop object, so the cost
+ * is O(groups of the next hop). The routes sharing a group keep pointing
+ * to the same group id, so the hardware convergence is O(groups) instead
+ * of O(routes). The dependent routes are still re-resolved by the DR
+ * walker, they find the shrunk group by its new MD5 key and no further
+ * route write is needed.
+ * Returns the number of groups updated.
+ */
+int hal_rt_fib_shrink_mp_objs_for_nh (npu_id_t unit, next_hop_id_t nh_id)
+{
+    std_dll_head          *p_list;
+    t_fib_mp_obj_link     *p_link;
+    t_fib_mp_obj_link     *p_next_link;
+    t_fib_mp_obj          *p_mp_obj;
+    int                    num_grps = 0;
+
+    p_list = hal_rt_nh_obj_mp_obj_list (unit, nh_id);
+    if (p_list == NULL)
+        return 0;
+
+    p_link = (t_fib_mp_obj_link *) std_dll_getfirst (p_list);
+
+    while (p_link != NULL)
+    {
+        /*
+         * The link of the group is removed from the list when the member
+         * is removed, the links of the other groups are not touched.
+         */
+        p_next_link = (t_fib_mp_obj_link *) std_dll_getnext (p_list, &p_link->glue);
+        p_mp_obj = p_link->p_mp_obj;
+
+        /*
+         * Keep atleast one member, the route walk handles the last path.
+         * Removing the member from a resilient group would shift all the
+         * buckets, the route walk reassigns just the buckets of the member.
+         */
+        if ((p_mp_obj->ecmp_count > 1) && (!p_mp_obj->is_resilient) &&
+            (!p_mp_obj->is_parked) &&
+            (fib_remove_nh_from_mp_obj (p_mp_obj->vrf_id, p_mp_obj->af_index,
+                                        p_mp_obj, nh_id) == STD_ERR_OK))
+        {
+            num_grps++;
+        }
+        p_link = p_next_link;
+    }
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-MP",
+            "NH fast reroute: nh_id %d removed from %d groups. "
+            "Unit: %d\r\n", nh_id, num_grps, unit);
+
+    return num_grps;
+}
+
+uint32_t hal_rt_fib_ecmp_grp_hist_bucket (uint32_t value)
+{
+    uint32_t bucket = 0;
+    uint32_t limit = 1;
+
+    if (value == 0)
+        return 0;
+
+    for (bucket = 1; bucket < (HAL_RT_ECMP_GRP_HIST_BUCKETS - 1); bucket++) {
+        if (value <= limit)
+            break;
+        limit <<= 1;
+    }
+    return bucket;
+}
+
+/* Keep the top_n groups with the most routes, in descending ref_count */
+static void fib_add_ecmp_grp_top (t_fib_ecmp_grp_stats *p_stats, uint32_t top_n,
+                                  t_fib_mp_obj *p_mp_obj)
+{
+    uint32_t index;
+
+    if (top_n > HAL_RT_ECMP_GRP_STATS_MAX_TOP_N)
+        top_n = HAL_RT_ECMP_GRP_STATS_MAX_TOP_N;
+
+    index = p_stats->num_top;
+    if (index == top_n) {
+        if ((top_n == 0) ||
+            (p_stats->a_top [top_n - 1].ref_count >= p_mp_obj->ref_count))
+            return;
+        index--;
+    } else {
+        p_stats->num_top++;
+    }
+
+    while ((index > 0) && (p_stats->a_top [index - 1].ref_count < p_mp_obj->ref_count)) {
+        p_stats->a_top [index] = p_stats->a_top [index - 1];
+        index--;
+    }
+
+    p_stats->a_top [index].vrf_id       = p_mp_obj->vrf_id;
+    p_stats->a_top [index].af_index     = p_mp_obj->af_index;
+    p_stats->a_top [index].unit         = p_mp_obj->unit;
+    p_stats->a_top [index].sai_ecmp_gid = p_mp_obj->sai_ecmp_gid;
+    p_stats->a_top [index].ecmp_count   = p_mp_obj->ecmp_count;
+    p_stats->a_top [index].ref_count    = p_mp_obj->ref_count;
+}
+
+/*
+ * Walk the MD5 tree of the VRF/AF and add its groups to the statistics,
+ * so that the caller can sum up the VRFs in one p_stats.
+ */
+void hal_rt_fib_get_ecmp_grp_stats (uint32_t vrf_id, uint8_t af_index, uint32_t top_n,
+                                    t_fib_ecmp_grp_stats *p_stats)
+{
+    std_rt_table       *p_md5_tree;
+    t_fib_mp_md5_node  *p_mp_md5_node;
+    t_fib_mp_obj       *p_mp_obj;
+
+    if (!FIB_IS_VRF_ID_VALID (vrf_id))
+        return;
+
+    p_md5_tree = hal_rt_access_fib_vrf_mp_md5_tree (vrf_id, af_index);
+    if (p_md5_tree == NULL)
+        return;
+
+    p_mp_md5_node = (t_fib_mp_md5_node *) std_radix_getfirst (p_md5_tree);
+
+    while (p_mp_md5_node != NULL)
+    {
+        p_stats->num_md5_nodes++;
+        if (p_mp_md5_node->num_nodes > 1) {
+            p_stats->num_collisions++;
+            p_stats->num_collided_grps += p_mp_md5_node->num_nodes;
+        }
+
+        p_mp_obj = (t_fib_mp_obj *) std_dll_getfirst (&p_mp_md5_node->mp_node_list);
+
+        while (p_mp_obj != NULL)
+        {
+            p_stats->num_grps++;
+            if ((p_mp_obj->unit >= 0) && (p_mp_obj->unit < HAL_RT_MAX_INSTANCE))
+                p_stats->a_num_grps [p_mp_obj->unit]++;
+            if (p_mp_obj->is_parked)
+                p_stats->num_parked++;
+            if (p_mp_obj->is_resilient)
+                p_stats->num_resilient++;
+
+            p_stats->a_width_hist [hal_rt_fib_ecmp_grp_hist_bucket (p_mp_obj->ecmp_count)]++;
+            p_stats->a_share_hist [hal_rt_fib_ecmp_grp_hist_bucket (p_mp_obj->ref_count)]++;
+            fib_add_ecmp_grp_top (p_stats, top_n, p_mp_obj);
+
+            p_mp_obj = (t_fib_mp_obj *)
+                std_dll_getnext (&p_mp_md5_node->mp_node_list, &p_mp_obj->glue);
+        }
+
+        p_mp_md5_node = (t_fib_mp_md5_node *)
+            std_radix_getnext (p_md5_tree, p_mp_md5_node->rt_head.rth_addr,
+                               HAL_RT_MP_MD5_NODE_TREE_KEY_SIZE);
+    }
+}
+
 int fib_create_mp_md5_tree (t_fib_vrf_info *p_vrf_info)
 {
     char tree_name_str [FIB_RDX_MAX_NAME_LEN];
@@ -478,6 +1566,29 @@ int fib_create_mp_md5_tree (t_fib_vrf_info *p_vrf_info)
     return STD_ERR_OK;
 }
 
+static void fib_free_parked_mp_objs_in_vrf (uint32_t vrf_id, uint8_t af_index)
+{
+    std_dll      *p_glue;
+    std_dll      *p_next_glue;
+    t_fib_mp_obj *p_mp_obj;
+
+    if (af_index >= FIB_MAX_AFINDEX)
+        return;
+
+    p_glue = std_dll_getfirst (fib_get_parked_mp_obj_list (af_index));
+
+    while (p_glue != NULL)
+    {
+        p_next_glue = std_dll_getnext (fib_get_parked_mp_obj_list (af_index), p_glue);
+        p_mp_obj = FIB_GET_MP_OBJ_FROM_GC_GLUE (p_glue);
+
+        if (p_mp_obj->vrf_id == vrf_id)
+            fib_free_parked_mp_obj (p_mp_obj);
+
+        p_glue = p_next_glue;
+    }
+}
+
 int fib_destroy_mp_md5_tree (t_fib_vrf_info *p_vrf_info)
 {
     if (!p_vrf_info)
@@ -499,6 +1610,8 @@ int fib_destroy_mp_md5_tree (t_fib_vrf_info *p_vrf_info)
         return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
     }
 
+    fib_free_parked_mp_objs_in_vrf (p_vrf_info->vrf_id, p_vrf_info->af_index);
+
     std_radix_destroy (p_vrf_info->mp_md5_tree);
     p_vrf_info->mp_md5_tree = NULL;
 
@@ -517,18 +1630,21 @@ void fib_dump_mp_obj_node (t_fib_mp_obj *p_mp_obj, int add_indendation)
     printf ("%sp_mp_obj      : %p\n", p_indent_str, p_mp_obj);
     printf ("%sunit        : %d\n", p_indent_str, p_mp_obj->unit);
     printf ("%secmp_count   : %d\n", p_indent_str, p_mp_obj->ecmp_count);
+    printf ("%smax_ecmp_count : %d\n", p_indent_str, p_mp_obj->max_ecmp_count);
     printf ("%shw_mp_index   : %d\n", p_indent_str, (int) p_mp_obj->sai_ecmp_gid);
     printf ("%sref_count    : %d\n", p_indent_str, p_mp_obj->ref_count);
+    printf ("%sis_parked    : %d\n", p_indent_str, p_mp_obj->is_parked);
     printf ("%sp_mdp_md5_node : %p\n", p_indent_str, p_mp_obj->p_md5_node);
 
     printf ("%snh_obj_list  : ", p_indent_str);
 
     for (index = 0; index < p_mp_obj->ecmp_count; index++)
     {
-        printf ("%s (%d)%s%s",
+        printf ("%s (%d w%d)%s%s",
                 (index == 0) ? "" :
                 (((index % 4) == 0) ? p_nh_obj_indent_str : ""),
                 (int) p_mp_obj->a_nh_obj_id [index],
+                (int) p_mp_obj->a_nh_weight [index],
                 (index == (p_mp_obj->ecmp_count - 1)) ? "" : ", ",
                 ((index % 4) == 3) ? "\n" : "");
     }
@@ -573,3 +1689,60 @@ void fib_dump_mp_md5_node (t_fib_mp_md5_node *p_md5_node, int dump_mp_obj)
             std_dll_getnext (&p_md5_node->mp_node_list, &p_mp_obj->glue);
     }
 }
+
+static void fib_dump_ecmp_grp_hist (const char *p_name, uint32_t a_hist [])
+{
+    uint32_t bucket;
+    uint32_t low = 0;
+    uint32_t high = 0;
+
+    printf ("  %s histogram:\r\n", p_name);
+
+    for (bucket = 0; bucket < HAL_RT_ECMP_GRP_HIST_BUCKETS; bucket++)
+    {
+        if (bucket > 0) {
+            low  = high + 1;
+            high = (bucket == 1) ? 1 : (high << 1);
+        }
+        if (a_hist [bucket] == 0)
+            continue;
+
+        if (bucket == (HAL_RT_ECMP_GRP_HIST_BUCKETS - 1))
+            printf ("    %5d+       :  %d\r\n", low, a_hist [bucket]);
+        else if (low == high)
+            printf ("    %5d        :  %d\r\n", low, a_hist [bucket]);
+        else
+            printf ("    %5d - %-5d:  %d\r\n", low, high, a_hist [bucket]);
+    }
+}
+
+void fib_dump_ecmp_grp_stats (t_fib_ecmp_grp_stats *p_stats)
+{
+    uint32_t index;
+
+    printf ("  num_grps          :  %d\r\n", p_stats->num_grps);
+    for (index = 0; index < HAL_RT_MAX_INSTANCE; index++) {
+        if (p_stats->a_num_grps [index])
+            printf ("  num_grps unit %-3d :  %d\r\n", index, p_stats->a_num_grps [index]);
+    }
+    printf ("  num_parked        :  %d\r\n", p_stats->num_parked);
+    printf ("  num_resilient     :  %d\r\n", p_stats->num_resilient);
+    printf ("  num_md5_nodes     :  %d\r\n", p_stats->num_md5_nodes);
+    printf ("  num_collisions    :  %d\r\n", p_stats->num_collisions);
+    printf ("  num_collided_grps :  %d\r\n", p_stats->num_collided_grps);
+
+    fib_dump_ecmp_grp_hist ("Width", p_stats->a_width_hist);
+    fib_dump_ecmp_grp_hist ("Sharing (routes per group)", p_stats->a_share_hist);
+
+    if (p_stats->num_top)
+        printf ("  Top %d groups by routes:\r\n", p_stats->num_top);
+
+    for (index = 0; index < p_stats->num_top; index++)
+    {
+        printf ("    Vrf_id: %d, Af: %s, Unit: %d, gid: %d, ecmp_count: %d, "
+                "ref_count: %d\r\n", p_stats->a_top [index].vrf_id,
+                STD_IP_AFINDEX_TO_STR (p_stats->a_top [index].af_index),
+                p_stats->a_top [index].unit, (int) p_stats->a_top [index].sai_ecmp_gid,
+                p_stats->a_top [index].ecmp_count, p_stats->a_top [index].ref_count);
+    }
+}
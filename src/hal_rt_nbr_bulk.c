@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_nbr_bulk.c
+ * \brief  Bulk neighbor programming from the NH walker
+ *
+ * While the NH walker has a batch open, the neighbor create and remove
+ * operations are queued instead of being written to the NPU one by one.
+ * A queued create updates the NH as if the write is successful, a queued
+ * remove releases the RIF only after the neighbor is removed from the NPU.
+ * The batch is written with one bulk NDI call when it is full, when the
+ * operation changes and before the walker releases the L3 lock. The NHs
+ * that failed to be created are removed from the NPU and marked as not
+ * written, as on a failed per neighbor call. The neighbors a failed bulk
+ * call did not get to, and the whole batch if NDI does not have the bulk
+ * neighbor APIs, are written with per neighbor calls. The batch
+ * is kept per NPU and the NPUs are written in parallel by the NPU workers.
+ *
+ * As for the routes, the batch is written by the programming thread after
+ * the walker releases the L3 lock, and its results are applied at the next
+ * walk or when a NH of it is written directly or freed. The batches are
+ * kept per AF and are guarded by the L3 lock of the AF.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_api.h"
+#include "hal_rt_util.h"
+#include "hal_rt_ndi_opt.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef t_std_error (*t_fib_ndi_nbr_bulk_fn) (ndi_neighbor_t *p_nbr_entry, size_t count,
+                                              t_std_error *p_status);
+
+typedef enum {
+    FIB_NBR_BULK_OP_NONE = 0,
+    FIB_NBR_BULK_OP_ADD,
+    FIB_NBR_BULK_OP_DEL,
+} t_fib_nbr_bulk_op;
+
+typedef struct _t_fib_nbr_bulk_entry {
+    t_fib_nh       *p_fh;     /* Only to order the operations of a NH on a remove */
+    uint32_t        vrf_id;
+    hal_ifindex_t   if_index;
+} t_fib_nbr_bulk_entry;
+
+typedef struct _t_fib_nbr_bulk_stats {
+    uint32_t  num_batches;
+    uint32_t  num_nbrs;
+    uint32_t  num_failed;
+    uint32_t  num_sync;
+    /* Updated by the NPU workers */
+    uint32_t  a_num_bulk_calls [HAL_RT_MAX_INSTANCE];
+    uint32_t  a_num_per_nbr_calls [HAL_RT_MAX_INSTANCE];
+} t_fib_nbr_bulk_stats;
+
+typedef struct _t_fib_nbr_batch {
+    t_fib_nbr_bulk_stats *p_stats;
+    t_fib_nbr_bulk_op     op;
+    uint32_t              num_nbrs;
+    uint32_t              a_count [HAL_RT_MAX_INSTANCE];
+    ndi_neighbor_t        a_ndi [HAL_RT_MAX_INSTANCE][HAL_RT_NBR_BULK_MAX_SIZE];
+    t_std_error           a_status [HAL_RT_MAX_INSTANCE][HAL_RT_NBR_BULK_MAX_SIZE];
+    t_fib_nbr_bulk_entry  a_entry [HAL_RT_MAX_INSTANCE][HAL_RT_NBR_BULK_MAX_SIZE];
+    t_hal_rt_pgm_job      job;
+} t_fib_nbr_batch;
+
+/* The bulk state of an AF, allocated at the first walk of the AF */
+typedef struct _t_fib_nbr_bulk {
+    t_fib_nbr_batch       a_batch [2];
+    t_fib_nbr_batch      *p_batch;             /* Being filled */
+    t_fib_nbr_batch      *p_batch_in_flight;
+    bool                  is_open;
+    bool                  is_flushing;
+    t_fib_nbr_bulk_stats  stats;
+} t_fib_nbr_bulk;
+
+static t_fib_nbr_bulk        *gap_fib_nbr_bulk [FIB_MAX_AFINDEX];
+
+static bool                   g_fib_ndi_nbr_bulk_resolved = false;
+static t_fib_ndi_nbr_bulk_fn  g_fib_ndi_nbr_bulk_add = NULL;
+static t_fib_ndi_nbr_bulk_fn  g_fib_ndi_nbr_bulk_del = NULL;
+
+/*
+ * The bulk neighbor APIs are optional NDI APIs, they are not there in the
+ * older NDI versions.
+ */
+static void fib_resolve_ndi_nbr_bulk_fn (void)
+{
+    if (g_fib_ndi_nbr_bulk_resolved)
+        return;
+
+    g_fib_ndi_nbr_bulk_add = ndi_route_neighbor_bulk_add;
+    g_fib_ndi_nbr_bulk_del = ndi_route_neighbor_bulk_delete;
+    g_fib_ndi_nbr_bulk_resolved = true;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+            "NDI bulk neighbor add: %s, delete: %s\r\n",
+            (g_fib_ndi_nbr_bulk_add != NULL) ? "available" : "not available",
+            (g_fib_ndi_nbr_bulk_del != NULL) ? "available" : "not available");
+}
+
+static uint32_t fib_get_nbr_bulk_size (void)
+{
+    uint32_t size = hal_rt_access_fib_config()->nbr_bulk_size;
+
+    return ((size < HAL_RT_NBR_BULK_MAX_SIZE) ? size : HAL_RT_NBR_BULK_MAX_SIZE);
+}
+
+static bool fib_is_nh_in_nbr_batch (t_fib_nbr_batch *p_batch, t_fib_nh *p_fh,
+                                    npu_id_t npu_id)
+{
+    uint32_t index;
+
+    if (p_batch == NULL)
+        return false;
+
+    for (index = 0; index < p_batch->a_count [npu_id]; index++) {
+        if (p_batch->a_entry [npu_id][index].p_fh == p_fh)
+            return true;
+    }
+    return false;
+}
+
+static t_fib_nbr_bulk *fib_get_nbr_bulk (uint8_t af_index)
+{
+    return ((af_index < FIB_MAX_AFINDEX) ? gap_fib_nbr_bulk [af_index] : NULL);
+}
+
+static t_fib_nbr_bulk *fib_alloc_nbr_bulk (uint8_t af_index)
+{
+    t_fib_nbr_bulk *p_bulk;
+
+    if (af_index >= FIB_MAX_AFINDEX)
+        return NULL;
+
+    if (gap_fib_nbr_bulk [af_index] != NULL)
+        return gap_fib_nbr_bulk [af_index];
+
+    p_bulk = (t_fib_nbr_bulk *) calloc (1, sizeof (t_fib_nbr_bulk));
+    if (p_bulk == NULL) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "Failed to allocate the neighbor batches, neighbors are written one by one. "
+                "AF: %d\r\n", af_index);
+        return NULL;
+    }
+
+    p_bulk->a_batch [0].p_stats = &p_bulk->stats;
+    p_bulk->a_batch [1].p_stats = &p_bulk->stats;
+    p_bulk->p_batch = &p_bulk->a_batch [0];
+    gap_fib_nbr_bulk [af_index] = p_bulk;
+
+    return p_bulk;
+}
+
+static bool fib_is_nh_in_nbr_bulk (t_fib_nbr_bulk *p_bulk, t_fib_nh *p_fh, npu_id_t npu_id)
+{
+    return ((fib_is_nh_in_nbr_batch (p_bulk->p_batch, p_fh, npu_id)) ||
+            (fib_is_nh_in_nbr_batch (p_bulk->p_batch_in_flight, p_fh, npu_id)));
+}
+
+/*
+ * The RIF is released once the neighbor on it is removed from the NPU.
+ */
+static void fib_nbr_rif_release (npu_id_t unit, uint32_t vrf_id, hal_ifindex_t if_index)
+{
+    if(!hal_rt_rif_ref_dec(if_index))
+        hal_rif_index_remove(unit, vrf_id, if_index);
+}
+
+/*
+ * Same handling as a failed per neighbor call in the host add and the NH
+ * walker, the host is removed from all the NPUs and the NH is marked as not
+ * written, the routes through it are resolved again.
+ */
+static void fib_nbr_bulk_add_failed (t_fib_nbr_batch *p_batch, npu_id_t unit, uint32_t index)
+{
+    t_fib_nbr_bulk_entry *p_entry = &p_batch->a_entry [unit][index];
+    t_fib_nh             *p_fh = p_entry->p_fh;
+
+    EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "Bulk Host Add: Failed. VRF %d. Addr: %s, Interface: %d, "
+            "Unit: %d, Err: %d\r\n", p_entry->vrf_id, FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
+            p_entry->if_index, unit, p_batch->a_status [unit][index]);
+
+    p_batch->p_stats->num_failed++;
+
+    /* Not written already if an earlier entry of this NH failed */
+    if (p_fh->a_is_written [unit]) {
+        p_fh->a_is_written [unit] = false;
+        hal_rt_rif_ref_dec (p_entry->if_index);
+    }
+    hal_rt_nbr_shadow_clear (p_fh, unit);
+
+    _hal_fib_host_del (p_entry->vrf_id, p_fh);
+
+    if (FIB_IS_NH_WRITTEN (p_fh))
+    {
+        p_fh->status_flag &= ~FIB_NH_STATUS_WRITTEN;
+
+        if ((p_fh->is_cam_host_count_incremented == true))
+        {
+            p_fh->is_cam_host_count_incremented = false;
+
+            FIB_DECR_CNTRS_CAM_HOST_ENTRIES (p_fh->vrf_id, p_fh->key.ip_addr.af_index);
+            hal_rt_cam_entry_del (HAL_RT_CAM_HOST);
+        }
+        hal_rt_cam_write_failed (HAL_RT_CAM_HOST,
+                                 hal_rt_ndi_rc_is_table_full (p_batch->a_status [unit][index]));
+        hal_rt_retry_nh_add (p_fh, HAL_RT_RETRY_RSN_NDI_FAIL);
+        fib_check_threshold_for_all_cams (false);
+
+        fib_mark_nh_dep_dr_for_resolution (p_fh);
+    }
+}
+
+static void fib_nbr_bulk_del_done (t_fib_nbr_batch *p_batch, npu_id_t unit, uint32_t index)
+{
+    t_fib_nbr_bulk_entry *p_entry = &p_batch->a_entry [unit][index];
+
+    if (p_batch->a_status [unit][index] != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI", "%s (): Failed to delete Host. "
+                   "Vrf_id: %d, Unit: %d. Err: %d \r\n", __FUNCTION__, p_entry->vrf_id,
+                   unit, p_batch->a_status [unit][index]);
+
+        p_batch->p_stats->num_failed++;
+    }
+
+    fib_nbr_rif_release (unit, p_entry->vrf_id, p_entry->if_index);
+}
+
+static t_std_error fib_nbr_batch_write_entry (t_fib_nbr_batch *p_batch, npu_id_t unit,
+                                              uint32_t index)
+{
+    return ((p_batch->op == FIB_NBR_BULK_OP_ADD) ?
+            ndi_route_neighbor_add (&p_batch->a_ndi [unit][index]) :
+            ndi_route_neighbor_delete (&p_batch->a_ndi [unit][index]));
+}
+
+/*
+ * Run by the NPU workers, the batch of the unit is written to the unit.
+ */
+static void fib_nbr_batch_write_unit (npu_id_t unit, void *p_arg)
+{
+    t_fib_nbr_batch        *p_batch = (t_fib_nbr_batch *) p_arg;
+    t_fib_ndi_nbr_bulk_fn   bulk_fn;
+    uint32_t                count = p_batch->a_count [unit];
+    uint32_t                index;
+    t_std_error             rc = STD_ERR_OK;
+
+    if (count == 0)
+        return;
+
+    bulk_fn = (p_batch->op == FIB_NBR_BULK_OP_ADD) ?
+              g_fib_ndi_nbr_bulk_add : g_fib_ndi_nbr_bulk_del;
+
+    if (bulk_fn != NULL) {
+        for (index = 0; index < count; index++)
+            p_batch->a_status [unit][index] = HAL_RT_NDI_BULK_STATUS_NOT_DONE;
+
+        rc = bulk_fn (p_batch->a_ndi [unit], count, p_batch->a_status [unit]);
+        p_batch->p_stats->a_num_bulk_calls [unit]++;
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+                "Bulk Host %s: %d neighbors, Unit: %d, Err: %d\r\n",
+                (p_batch->op == FIB_NBR_BULK_OP_ADD) ? "Add" : "Del", count, unit, rc);
+
+        /* The neighbors not done by a failed bulk call are written one by one */
+        for (index = 0; index < count; index++) {
+            if (p_batch->a_status [unit][index] != HAL_RT_NDI_BULK_STATUS_NOT_DONE)
+                continue;
+
+            if (rc == STD_ERR_OK) {
+                p_batch->a_status [unit][index] = STD_ERR_OK;
+                continue;
+            }
+            p_batch->a_status [unit][index] = fib_nbr_batch_write_entry (p_batch, unit, index);
+            p_batch->p_stats->a_num_per_nbr_calls [unit]++;
+        }
+    } else {
+        for (index = 0; index < count; index++)
+            p_batch->a_status [unit][index] = fib_nbr_batch_write_entry (p_batch, unit, index);
+        p_batch->p_stats->a_num_per_nbr_calls [unit] += count;
+    }
+}
+
+/*
+ * Applies the results of the batch in flight, if it is written or the
+ * caller waits for it.
+ */
+static void fib_nbr_bulk_complete (t_fib_nbr_bulk *p_bulk, bool wait)
+{
+    t_fib_nbr_batch *p_batch = p_bulk->p_batch_in_flight;
+    npu_id_t         unit;
+    uint32_t         index;
+
+    if (p_batch == NULL)
+        return;
+
+    if ((!wait) && (hal_rt_pgm_is_pending (&p_batch->job)))
+        return;
+
+    hal_rt_pgm_wait (&p_batch->job);
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        for (index = 0; index < p_batch->a_count [unit]; index++) {
+            if (p_batch->op == FIB_NBR_BULK_OP_DEL)
+                fib_nbr_bulk_del_done (p_batch, unit, index);
+            else if (p_batch->a_status [unit][index] != STD_ERR_OK)
+                fib_nbr_bulk_add_failed (p_batch, unit, index);
+        }
+        p_batch->a_count [unit] = 0;
+    }
+
+    p_batch->num_nbrs = 0;
+    p_batch->op = FIB_NBR_BULK_OP_NONE;
+    p_bulk->p_batch_in_flight = NULL;
+}
+
+/*
+ * The batch being filled is handed to the programming thread, after the
+ * batch in flight is complete.
+ */
+static void fib_nbr_bulk_dispatch (t_fib_nbr_bulk *p_bulk)
+{
+    t_fib_nbr_batch *p_batch = p_bulk->p_batch;
+
+    if (p_batch->num_nbrs == 0)
+        return;
+
+    fib_nbr_bulk_complete (p_bulk, true);
+    fib_resolve_ndi_nbr_bulk_fn ();
+
+    p_bulk->stats.num_batches++;
+    p_bulk->stats.num_nbrs += p_batch->num_nbrs;
+
+    p_bulk->p_batch_in_flight = p_batch;
+    p_bulk->p_batch = (p_batch == &p_bulk->a_batch [0]) ?
+                      &p_bulk->a_batch [1] : &p_bulk->a_batch [0];
+
+    p_batch->job.job_fn = fib_nbr_batch_write_unit;
+    p_batch->job.p_arg  = p_batch;
+    hal_rt_pgm_submit (&p_batch->job);
+}
+
+static void fib_nbr_bulk_flush (t_fib_nbr_bulk *p_bulk)
+{
+    if (p_bulk->is_flushing)
+        return;
+
+    if ((p_bulk->p_batch->num_nbrs == 0) && (p_bulk->p_batch_in_flight == NULL))
+        return;
+
+    p_bulk->is_flushing = true;
+
+    fib_nbr_bulk_dispatch (p_bulk);
+    fib_nbr_bulk_complete (p_bulk, true);
+
+    p_bulk->is_flushing = false;
+}
+
+/*
+ * Writes the queued neighbors of the AF and applies the results before
+ * returning.
+ */
+void hal_rt_nbr_bulk_flush (uint8_t af_index)
+{
+    t_fib_nbr_bulk *p_bulk = fib_get_nbr_bulk (af_index);
+
+    if (p_bulk != NULL)
+        fib_nbr_bulk_flush (p_bulk);
+}
+
+/*
+ * Called before the host is written directly, the queued writes of the
+ * NH are done first.
+ */
+void hal_rt_nbr_bulk_sync_nh (t_fib_nh *p_fh, npu_id_t unit)
+{
+    t_fib_nbr_bulk *p_bulk = fib_get_nbr_bulk (p_fh->key.ip_addr.af_index);
+
+    if ((p_bulk != NULL) && (unit < HAL_RT_MAX_INSTANCE) &&
+        (fib_is_nh_in_nbr_bulk (p_bulk, p_fh, unit))) {
+        p_bulk->stats.num_sync++;
+        fib_nbr_bulk_flush (p_bulk);
+    }
+}
+
+/*
+ * Returns true if the neighbor operation is queued.
+ */
+static bool fib_nbr_bulk_queue (t_fib_nbr_bulk_op op, ndi_neighbor_t *p_nbr_entry,
+                                t_fib_nh *p_fh, uint32_t vrf_id)
+{
+    t_fib_nbr_bulk  *p_bulk = fib_get_nbr_bulk (p_fh->key.ip_addr.af_index);
+    t_fib_nbr_batch *p_batch;
+    uint32_t         bulk_size = fib_get_nbr_bulk_size ();
+    npu_id_t         unit = p_nbr_entry->npu_id;
+    uint32_t         index;
+
+    if ((p_bulk == NULL) || (!p_bulk->is_open) || (p_bulk->is_flushing) || (bulk_size <= 1) ||
+        (unit >= HAL_RT_MAX_INSTANCE))
+        return false;
+
+    /*
+     * Keep the order of the operations and of the updates of a NH. A full
+     * batch is written before the next neighbor, not in the middle of the
+     * host add that filled it, as the caller marks the NH written after it.
+     */
+    if ((p_bulk->p_batch->num_nbrs != 0) &&
+        ((p_bulk->p_batch->op != op) || (p_bulk->p_batch->a_count [unit] >= bulk_size)))
+        fib_nbr_bulk_flush (p_bulk);
+    else if (fib_is_nh_in_nbr_bulk (p_bulk, p_fh, unit))
+        fib_nbr_bulk_flush (p_bulk);
+
+    p_batch = p_bulk->p_batch;
+    index   = p_batch->a_count [unit];
+
+    memcpy (&p_batch->a_ndi [unit][index], p_nbr_entry, sizeof (ndi_neighbor_t));
+    p_batch->a_entry [unit][index].p_fh     = p_fh;
+    p_batch->a_entry [unit][index].vrf_id   = vrf_id;
+    p_batch->a_entry [unit][index].if_index = p_fh->key.if_index;
+    p_batch->a_count [unit]++;
+    p_batch->num_nbrs++;
+    p_batch->op = op;
+
+    return true;
+}
+
+/*
+ * The caller marks the host written on the unit and takes the RIF
+ * reference on success, queued or not.
+ */
+t_std_error hal_rt_nbr_ndi_add (ndi_neighbor_t *p_nbr_entry, uint32_t vrf_id, t_fib_nh *p_fh)
+{
+    t_std_error rc = STD_ERR_OK;
+
+    if (!fib_nbr_bulk_queue (FIB_NBR_BULK_OP_ADD, p_nbr_entry, p_fh, vrf_id)) {
+        hal_rt_nbr_bulk_sync_nh (p_fh, p_nbr_entry->npu_id);
+        rc = ndi_route_neighbor_add (p_nbr_entry);
+    }
+
+    if (rc == STD_ERR_OK)
+        hal_rt_nbr_shadow_set (p_fh, p_nbr_entry);
+
+    return rc;
+}
+
+/*
+ * Removes the host from the unit and releases the RIF, now or when the
+ * batch is written. A failure is only logged.
+ */
+void hal_rt_nbr_ndi_del (ndi_neighbor_t *p_nbr_entry, uint32_t vrf_id, t_fib_nh *p_fh)
+{
+    t_std_error rc;
+
+    hal_rt_nbr_shadow_clear (p_fh, p_nbr_entry->npu_id);
+
+    if (fib_nbr_bulk_queue (FIB_NBR_BULK_OP_DEL, p_nbr_entry, p_fh, vrf_id))
+        return;
+
+    hal_rt_nbr_bulk_sync_nh (p_fh, p_nbr_entry->npu_id);
+    rc = ndi_route_neighbor_delete (p_nbr_entry);
+    if(rc != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI", "%s (): Failed to delete Host. "
+                   "Vrf_id: %d, Unit: %d. Err: %d \r\n", __FUNCTION__, vrf_id,
+                   p_nbr_entry->npu_id, rc);
+    }
+    fib_nbr_rif_release (p_nbr_entry->npu_id, vrf_id, p_fh->key.if_index);
+}
+
+/*
+ * The results of the batch written since the last walk are applied first.
+ * The neighbors are written one by one if the batches of the AF could not
+ * be allocated.
+ */
+void hal_rt_nbr_bulk_begin (uint8_t af_index)
+{
+    t_fib_nbr_bulk *p_bulk = fib_alloc_nbr_bulk (af_index);
+
+    if (p_bulk == NULL)
+        return;
+
+    p_bulk->is_flushing = true;
+    fib_nbr_bulk_complete (p_bulk, false);
+    p_bulk->is_flushing = false;
+
+    p_bulk->is_open = true;
+}
+
+/*
+ * The queued neighbors are handed to the programming thread, the walker
+ * does not wait for them to be written.
+ */
+void hal_rt_nbr_bulk_end (uint8_t af_index)
+{
+    t_fib_nbr_bulk *p_bulk = fib_get_nbr_bulk (af_index);
+
+    if (p_bulk == NULL)
+        return;
+
+    p_bulk->is_flushing = true;
+    fib_nbr_bulk_dispatch (p_bulk);
+    p_bulk->is_flushing = false;
+
+    p_bulk->is_open = false;
+}
+
+/*
+ * Called by the walker without the L3 lock of the AF when it is done with
+ * all the VRFs, the walker then flushes under the lock to apply the results.
+ */
+void hal_rt_nbr_bulk_wait (uint8_t af_index)
+{
+    t_fib_nbr_bulk  *p_bulk = fib_get_nbr_bulk (af_index);
+    t_fib_nbr_batch *p_batch = (p_bulk != NULL) ? p_bulk->p_batch_in_flight : NULL;
+
+    if (p_batch != NULL)
+        hal_rt_pgm_wait (&p_batch->job);
+}
+
+void fib_dump_nbr_bulk_stats (void)
+{
+    t_fib_nbr_bulk *p_bulk;
+    uint32_t        num_bulk_calls;
+    uint32_t        num_per_nbr_calls;
+    npu_id_t        unit;
+    uint8_t         af_index;
+
+    fib_resolve_ndi_nbr_bulk_fn ();
+
+    printf ("**************************************************\r\n");
+    printf ("  nbr_bulk_size         :  %d\r\n", fib_get_nbr_bulk_size ());
+    printf ("  ndi_bulk_add          :  %d\r\n", (g_fib_ndi_nbr_bulk_add != NULL));
+    printf ("  ndi_bulk_del          :  %d\r\n", (g_fib_ndi_nbr_bulk_del != NULL));
+
+    for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+        if ((p_bulk = fib_get_nbr_bulk (af_index)) == NULL)
+            continue;
+
+        num_bulk_calls = 0;
+        num_per_nbr_calls = 0;
+        for (unit = 0; unit < HAL_RT_MAX_INSTANCE; unit++) {
+            num_bulk_calls    += p_bulk->stats.a_num_bulk_calls [unit];
+            num_per_nbr_calls += p_bulk->stats.a_num_per_nbr_calls [unit];
+        }
+
+        printf ("  AF %d\r\n", af_index);
+        printf ("    num_batches         :  %d\r\n", p_bulk->stats.num_batches);
+        printf ("    num_nbrs            :  %d\r\n", p_bulk->stats.num_nbrs);
+        printf ("    num_bulk_calls      :  %d\r\n", num_bulk_calls);
+        printf ("    num_per_nbr_calls   :  %d\r\n", num_per_nbr_calls);
+        printf ("    num_failed          :  %d\r\n", p_bulk->stats.num_failed);
+        printf ("    num_sync            :  %d\r\n", p_bulk->stats.num_sync);
+        printf ("    is_in_flight        :  %d\r\n", (p_bulk->p_batch_in_flight != NULL));
+    }
+    printf ("**************************************************\r\n");
+}
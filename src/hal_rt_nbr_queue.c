@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_nbr_queue.c
+ * \brief  Neighbor event pipeline
+ *
+ * The neighbor events are received on their own CPS event handle, apart
+ * from the route events, and applied by their own thread so that a route
+ * burst does not delay the neighbor resolution. The receive thread queues
+ * the events of the neighbors that are next hops of routes (rtm_ref_count
+ * is not 0) to the high queue and the others to the normal queue, the
+ * apply thread drains the high queue first. An event is parsed once, by
+ * the receive thread, and queued as the parsed neighbor message.
+ *
+ * The events of a neighbor must be applied in the order they are received.
+ * The neighbors are hashed to buckets and a bucket counts its events in the
+ * normal queue, a high event for a bucket with normal events pending is
+ * queued to the normal queue behind them. A bucket shared by two neighbors
+ * only costs priority. The receive thread waits when a queue is full, no
+ * event is dropped.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+#include "std_thread_tools.h"
+
+#include "cps_api_events.h"
+#include "cps_api_object.h"
+#include "cps_api_object_category.h"
+#include "cps_api_route.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HAL_RT_NBR_QUEUE_SIZE      4096
+#define HAL_RT_NBR_HASH_SIZE       1024
+#define HAL_RT_NBR_RX_RETRY_DELAY  10000  /* usecs */
+
+typedef enum {
+    HAL_RT_NBR_PRIO_HIGH = 0,
+    HAL_RT_NBR_PRIO_NORMAL,
+    HAL_RT_NBR_PRIO_MAX,
+} t_hal_rt_nbr_prio;
+
+typedef struct _t_hal_rt_nbr_msg {
+    db_neighbour_entry_t  arp_msg;
+    uint32_t              hash;
+} t_hal_rt_nbr_msg;
+
+typedef struct _t_hal_rt_nbr_queue {
+    t_hal_rt_nbr_msg  a_msg [HAL_RT_NBR_QUEUE_SIZE];
+    uint32_t          head;
+    uint32_t          num_msgs;
+    uint32_t          high_water;
+    uint32_t          num_queued;
+} t_hal_rt_nbr_queue;
+
+static std_thread_create_param_t      g_fib_nbr_rx_thr;
+static std_thread_create_param_t      g_fib_nbr_thr;
+static cps_api_event_service_handle_t g_fib_nbr_handle;
+
+static pthread_mutex_t     g_fib_nbr_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t      g_fib_nbr_msg_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t      g_fib_nbr_space_cond = PTHREAD_COND_INITIALIZER;
+static t_hal_rt_nbr_queue  ga_fib_nbr_queue [HAL_RT_NBR_PRIO_MAX];
+static uint16_t            ga_fib_nbr_num_pending [HAL_RT_NBR_HASH_SIZE];
+
+static uint32_t            g_fib_nbr_num_held = 0;
+static uint32_t            g_fib_nbr_num_full_waits = 0;
+static uint32_t            g_fib_nbr_num_rx_failed = 0;
+static uint32_t            g_fib_nbr_num_applied = 0;
+
+static void fib_nbr_enqueue (const db_neighbour_entry_t *p_arp_msg, uint32_t hash,
+                             bool is_route_nh)
+{
+    t_hal_rt_nbr_queue *p_queue;
+    t_hal_rt_nbr_msg   *p_msg;
+    uint32_t            bucket = hash % HAL_RT_NBR_HASH_SIZE;
+
+    pthread_mutex_lock (&g_fib_nbr_mutex);
+
+    /* Keep the event behind the events of the neighbor in the normal queue */
+    if ((is_route_nh) && (ga_fib_nbr_num_pending [bucket] > 0)) {
+        g_fib_nbr_num_held++;
+        is_route_nh = false;
+    }
+
+    p_queue = &ga_fib_nbr_queue [(is_route_nh) ? HAL_RT_NBR_PRIO_HIGH : HAL_RT_NBR_PRIO_NORMAL];
+
+    if (p_queue->num_msgs >= HAL_RT_NBR_QUEUE_SIZE)
+        g_fib_nbr_num_full_waits++;
+
+    while (p_queue->num_msgs >= HAL_RT_NBR_QUEUE_SIZE)
+        pthread_cond_wait (&g_fib_nbr_space_cond, &g_fib_nbr_mutex);
+
+    p_msg = &p_queue->a_msg [(p_queue->head + p_queue->num_msgs) % HAL_RT_NBR_QUEUE_SIZE];
+    p_msg->arp_msg = *p_arp_msg;
+    p_msg->hash = hash;
+    p_queue->num_msgs++;
+    p_queue->num_queued++;
+    if (p_queue->num_msgs > p_queue->high_water)
+        p_queue->high_water = p_queue->num_msgs;
+
+    if (!is_route_nh)
+        ga_fib_nbr_num_pending [bucket]++;
+
+    pthread_cond_signal (&g_fib_nbr_msg_cond);
+    pthread_mutex_unlock (&g_fib_nbr_mutex);
+}
+
+static void fib_nbr_dequeue (db_neighbour_entry_t *p_arp_msg)
+{
+    t_hal_rt_nbr_queue *p_queue;
+
+    pthread_mutex_lock (&g_fib_nbr_mutex);
+    while ((ga_fib_nbr_queue [HAL_RT_NBR_PRIO_HIGH].num_msgs == 0) &&
+           (ga_fib_nbr_queue [HAL_RT_NBR_PRIO_NORMAL].num_msgs == 0))
+        pthread_cond_wait (&g_fib_nbr_msg_cond, &g_fib_nbr_mutex);
+
+    p_queue = &ga_fib_nbr_queue [HAL_RT_NBR_PRIO_HIGH];
+    if (p_queue->num_msgs == 0) {
+        p_queue = &ga_fib_nbr_queue [HAL_RT_NBR_PRIO_NORMAL];
+        ga_fib_nbr_num_pending [p_queue->a_msg [p_queue->head].hash % HAL_RT_NBR_HASH_SIZE]--;
+    }
+
+    *p_arp_msg = p_queue->a_msg [p_queue->head].arp_msg;
+    p_queue->head = (p_queue->head + 1) % HAL_RT_NBR_QUEUE_SIZE;
+    p_queue->num_msgs--;
+
+    pthread_cond_signal (&g_fib_nbr_space_cond);
+    pthread_mutex_unlock (&g_fib_nbr_mutex);
+}
+
+static void *fib_nbr_rx_thread_main (void *p_arg)
+{
+    cps_api_object_t      obj;
+    db_neighbour_entry_t  arp_msg;
+    uint32_t              hash;
+    bool                  is_route_nh;
+
+    for ( ; ; )
+    {
+        obj = cps_api_object_create ();
+        if (obj == NULL) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NBR", "Failed to allocate the event object");
+            usleep (HAL_RT_NBR_RX_RETRY_DELAY);
+            continue;
+        }
+
+        if (cps_api_wait_for_event (g_fib_nbr_handle, obj) != cps_api_ret_code_OK) {
+            g_fib_nbr_num_rx_failed++;
+            cps_api_object_delete (obj);
+            continue;
+        }
+
+        hash = 0;
+        is_route_nh = fib_nbr_msg_is_route_nh (obj, &arp_msg, &hash);
+        cps_api_object_delete (obj);
+
+        fib_nbr_enqueue (&arp_msg, hash, is_route_nh);
+    }
+    return NULL;
+}
+
+static void *fib_nbr_thread_main (void *p_arg)
+{
+    db_neighbour_entry_t arp_msg;
+
+    for ( ; ; )
+    {
+        fib_nbr_dequeue (&arp_msg);
+
+        fib_proc_nbr_msg (&arp_msg);
+        g_fib_nbr_num_applied++;
+    }
+    return NULL;
+}
+
+t_std_error hal_rt_nbr_queue_init (void)
+{
+    cps_api_event_reg_t reg;
+    cps_api_key_t       key;
+
+    if (cps_api_event_service_init () != cps_api_ret_code_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NBR", "Failed to init cps event service");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    if (cps_api_event_client_connect (&g_fib_nbr_handle) != cps_api_ret_code_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NBR", "Failed to connect to cps event service");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    memset (&reg, 0, sizeof (reg));
+    cps_api_key_init (&key, cps_api_qualifier_TARGET,
+                      cps_api_obj_cat_ROUTE, cps_api_route_obj_NEIBH, 0);
+    reg.number_of_objects = 1;
+    reg.objects = &key;
+
+    if (cps_api_event_client_register (g_fib_nbr_handle, &reg) != cps_api_ret_code_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NBR", "Failed to register the neighbor events");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    if (hal_rt_thread_create (&g_fib_nbr_thr, HAL_RT_THREAD_NBR,
+                              (std_thread_function_t) fib_nbr_thread_main,
+                              NULL) != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating nbr thread");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    if (hal_rt_thread_create (&g_fib_nbr_rx_thr, HAL_RT_THREAD_NBR_RX,
+                              (std_thread_function_t) fib_nbr_rx_thread_main,
+                              NULL) != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating nbr rx thread");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    return STD_ERR_OK;
+}
+
+void fib_dump_nbr_queue_stats (void)
+{
+    t_hal_rt_nbr_queue *p_high = &ga_fib_nbr_queue [HAL_RT_NBR_PRIO_HIGH];
+    t_hal_rt_nbr_queue *p_normal = &ga_fib_nbr_queue [HAL_RT_NBR_PRIO_NORMAL];
+
+    printf ("**************************************************\r\n");
+    printf ("  high_num_msgs         :  %d\r\n", p_high->num_msgs);
+    printf ("  high_num_queued       :  %d\r\n", p_high->num_queued);
+    printf ("  high_high_water       :  %d\r\n", p_high->high_water);
+    printf ("  normal_num_msgs       :  %d\r\n", p_normal->num_msgs);
+    printf ("  normal_num_queued     :  %d\r\n", p_normal->num_queued);
+    printf ("  normal_high_water     :  %d\r\n", p_normal->high_water);
+    printf ("  num_held              :  %d\r\n", g_fib_nbr_num_held);
+    printf ("  num_full_waits        :  %d\r\n", g_fib_nbr_num_full_waits);
+    printf ("  num_rx_failed         :  %d\r\n", g_fib_nbr_num_rx_failed);
+    printf ("  num_applied           :  %d\r\n", g_fib_nbr_num_applied);
+    printf ("**************************************************\r\n");
+}
@@ -25,6 +25,7 @@
 #include "hal_rt_api.h"
 #include "hal_rt_util.h"
 #include "hal_rt_debug.h"
+#include "hal_rt_mpath_grp.h"
 
 #include "event_log.h"
 #include "std_ip_utils.h"
@@ -38,6 +39,7 @@
  **************************************************************************/
 pthread_mutex_t fib_nh_mutex;
 pthread_cond_t  fib_nh_cond;
+static bool     g_fib_nh_is_resumed = false; /* Guarded by fib_nh_mutex */
 std_rt_table   *rt_intf_tree = NULL;
 
 std_rt_table * hal_rt_access_intf_tree(void)
@@ -1890,8 +1892,11 @@ t_fib_intf *fib_add_intf (uint32_t if_index, uint32_t vrf_id, uint8_t af_index)
 
     p_intf->rt_head.rth_addr = (uint8_t *) (&(p_intf->key));
 
+    /* The interface tree is shared by the AFs */
+    hal_rt_intf_lock ();
     p_radix_head = std_radix_insert (rt_intf_tree, (std_rt_head *)(&p_intf->rt_head),
                                      FIB_RDX_INTF_KEY_LEN);
+    hal_rt_intf_unlock ();
 
     if (p_radix_head == NULL)
     {
@@ -1936,8 +1941,10 @@ t_fib_intf *fib_get_intf (uint32_t if_index, uint32_t vrf_id, uint8_t af_index)
     key.vrf_id   = vrf_id;
     key.af_index = af_index;
 
+    hal_rt_intf_lock ();
     p_intf = (t_fib_intf *)
               std_radix_getexact (rt_intf_tree, (uint8_t *)&key, FIB_RDX_INTF_KEY_LEN);
+    hal_rt_intf_unlock ();
 
     return p_intf;
 }
@@ -1958,7 +1965,9 @@ int fib_del_intf (t_fib_intf *p_intf)
                p_intf->key.if_index, p_intf->key.vrf_id,
                p_intf->key.af_index);
 
+    hal_rt_intf_lock ();
     std_radix_remove (rt_intf_tree, (std_rt_head *)(&p_intf->rt_head));
+    hal_rt_intf_unlock ();
 
     memset (p_intf, 0, sizeof (t_fib_intf));
 
@@ -2332,7 +2341,15 @@ int fib_nh_walker_main (void)
         tot_nh_processed = 0;
         num_active_vrfs  = 0;
         pthread_mutex_lock( &fib_nh_mutex );
-        pthread_cond_wait( &fib_nh_cond, &fib_nh_mutex );
+        /* Walk again if resumed during the last walk */
+        if (!g_fib_nh_is_resumed)
+            pthread_cond_wait( &fib_nh_cond, &fib_nh_mutex );
+        g_fib_nh_is_resumed = false;
+        /*
+         * The walk is resumed with the VRF locks held, the mutex is not
+         * held across the walk.
+         */
+        pthread_mutex_unlock( &fib_nh_mutex );
 
         for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
             for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
@@ -2351,7 +2368,9 @@ int fib_nh_walker_main (void)
                     continue;
                 }
 
-                nas_l3_lock();
+                hal_rt_vrf_write_lock (vrf_id, af_index);
+                nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_NH_WALKER);
+                hal_rt_nbr_bulk_begin (af_index);
 
                 p_vrf_info->num_nh_processed_by_walker = 0;
                 if (p_vrf_info->nh_clear_on == true) {
@@ -2385,11 +2404,25 @@ int fib_nh_walker_main (void)
                  * fib_nh_walker_call_back ().
                  */
                 tot_nh_processed += p_vrf_info->num_nh_processed_by_walker;
-                nas_l3_unlock();
+                hal_rt_nbr_bulk_end (af_index);
+                nas_l3_unlock_af (af_index);
+                hal_rt_vrf_unlock (vrf_id, af_index);
             }
         }  /* End of vrf loop */
 
-        pthread_mutex_unlock( &fib_nh_mutex );
+        /*
+         * Apply the results of the last batch of each AF once it is
+         * written, the NHs of the batch can be of any VRF of the AF and
+         * are read by the CPS GETs.
+         */
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            hal_rt_nbr_bulk_wait (af_index);
+            hal_rt_af_write_lock (af_index);
+            nas_l3_lock_af_at (af_index, HAL_RT_LOCK_SITE_NH_WALKER);
+            hal_rt_nbr_bulk_flush (af_index);
+            nas_l3_unlock_af (af_index);
+            hal_rt_af_unlock (af_index);
+        }
 
         EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NH", "Total NH processed %d",  tot_nh_processed);
 
@@ -2401,6 +2434,44 @@ int fib_nh_walker_main (void)
     return STD_ERR_OK;
 }
 
+/*
+ * Hierarchical FIB: update the indirect group of the recursive NH with
+ * its new first hops. When the best fit DR is yet to be resolved, the NH
+ * is resolved again after it, so the group is left as is.
+ */
+static void fib_nh_indirect_grp_update (t_fib_nh *p_nh)
+{
+    if ((p_nh->p_best_fit_dr != NULL) &&
+        (FIB_IS_DR_REQ_RESOLVE (p_nh->p_best_fit_dr)))
+    {
+        return;
+    }
+
+    hal_fib_nh_indirect_grp_update (p_nh);
+}
+
+/*
+ * Remove the failed FH from all the ECMP groups that are using it,
+ * before the dependent DRs are re-walked. Called only when the FH goes
+ * from resolved to unresolved, is_fh_resolved tracks the state the
+ * groups were last written with.
+ */
+static void fib_nh_fast_reroute (t_fib_nh *p_fh)
+{
+    npu_id_t unit;
+
+    if (!(hal_rt_access_fib_config()->ecmp_nh_fast_reroute))
+    {
+        return;
+    }
+
+    /* The next hop object handles are per NPU */
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++)
+    {
+        hal_rt_fib_shrink_mp_objs_for_nh (unit, hal_rt_nh_obj_id_get (p_fh, unit));
+    }
+}
+
 int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
 {
     t_fib_vrf_info   *p_vrf_info = NULL;
@@ -2481,8 +2552,23 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
 
                 hal_err = hal_fib_host_add (p_nh->vrf_id, p_nh);
 
+                if (p_nh->p_arp_info->state != FIB_ARP_RESOLVED)
+                {
+                    if (p_nh->is_fh_resolved)
+                    {
+                        fib_nh_fast_reroute (p_nh);
+                    }
+                    p_nh->is_fh_resolved = false;
+                }
+                else
+                {
+                    p_nh->is_fh_resolved = true;
+                }
+
                 if (hal_err == DN_HAL_ROUTE_E_NONE)
                 {
+                    hal_rt_retry_nh_del (p_nh);
+
                     if ((FIB_IS_NH_OWNER_ARP (p_nh)))
                     {
                         p_nh->status_flag |= FIB_NH_STATUS_WRITTEN;
@@ -2491,6 +2577,7 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
                             p_nh->is_cam_host_count_incremented = true;
 
                             FIB_INCR_CNTRS_CAM_HOST_ENTRIES (p_nh->vrf_id, p_nh->key.ip_addr.af_index);
+                            hal_rt_cam_entry_add (HAL_RT_CAM_HOST);
                         }
                         fib_check_threshold_for_all_cams (true);
                     }
@@ -2503,6 +2590,7 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
                             p_nh->is_cam_host_count_incremented = false;
 
                             FIB_DECR_CNTRS_CAM_HOST_ENTRIES (p_nh->vrf_id, p_nh->key.ip_addr.af_index);
+                            hal_rt_cam_entry_del (HAL_RT_CAM_HOST);
                         }
                         fib_check_threshold_for_all_cams (false);
                     }
@@ -2523,7 +2611,12 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
                         p_nh->status_flag &= ~FIB_NH_STATUS_WRITTEN;
 
                         FIB_DECR_CNTRS_CAM_HOST_ENTRIES (p_nh->vrf_id, p_nh->key.ip_addr.af_index);
+                        hal_rt_cam_entry_del (HAL_RT_CAM_HOST);
                     }
+                    hal_rt_cam_write_failed (HAL_RT_CAM_HOST,
+                                             (hal_err == DN_HAL_ROUTE_E_FULL));
+                    hal_rt_retry_nh_add (p_nh, HAL_RT_RETRY_RSN_NDI_FAIL);
+                    fib_check_threshold_for_all_cams (false);
                 }
             }
         }
@@ -2532,6 +2625,8 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
             if (FIB_IS_NH_OWNER_RTM (p_nh))
             {
                 fib_resolve_nh (p_nh);
+
+                fib_nh_indirect_grp_update (p_nh);
             }
         }
 
@@ -2558,17 +2653,24 @@ int fib_nh_walker_call_back (std_radical_head_t *p_rt_head, va_list ap)
                        FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr),
                        p_nh->key.if_index);
 
+            if (p_nh->is_fh_resolved)
+            {
+                fib_nh_fast_reroute (p_nh);
+                p_nh->is_fh_resolved = false;
+            }
+
             if (FIB_IS_NH_WRITTEN (p_nh))
             {
                 hal_err = hal_fib_host_del (p_nh->vrf_id, p_nh);
 
                 if (hal_err == DN_HAL_ROUTE_E_NONE)
                 {
-                    fib_check_threshold_for_all_cams (false);
-
                     p_nh->status_flag &= ~FIB_NH_STATUS_WRITTEN;
 
                     FIB_DECR_CNTRS_CAM_HOST_ENTRIES (p_nh->vrf_id, p_nh->key.ip_addr.af_index);
+                    hal_rt_cam_entry_del (HAL_RT_CAM_HOST);
+
+                    fib_check_threshold_for_all_cams (false);
 
                     p_dr = fib_get_dr (p_nh->vrf_id, &p_nh->key.ip_addr, FIB_AFINDEX_TO_PREFIX_LEN(p_nh->key.ip_addr.af_index));
 
@@ -2851,9 +2953,13 @@ int fib_mark_nh_dep_dr_for_resolution (t_fib_nh *p_nh)
                    p_nh_dep_dr->prefix_len);
 
         /*
-         * Mark DR for resolution only for ECMP case
+         * Mark DR for resolution only for ECMP case, or when the indirect
+         * group of the NH is added/removed for a route using it. The change
+         * of members in the indirect group does not need the route to be
+         * re-programmed.
          */
-        if(p_nh_dep_dr->p_dr->num_nh > 1)
+        if((p_nh_dep_dr->p_dr->num_nh > 1) ||
+           (hal_rt_is_dr_indirect_mp_obj_stale (p_nh_dep_dr->p_dr, p_nh)))
             fib_mark_dr_for_resolution (p_nh_dep_dr->p_dr);
 
         p_nh_dep_dr =
@@ -2871,6 +2977,7 @@ int fib_resume_nh_walker_thread (uint8_t af_index)
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NH", "af_index: %d\r\n",  af_index);
     pthread_mutex_lock( &fib_nh_mutex );
+    g_fib_nh_is_resumed = true;
     if((retval = pthread_cond_signal( &fib_nh_cond)) != 0) {
         EV_LOG_TRACE(ev_log_t_ROUTE, 1, "HAL-RT-NH", "pthread cond signal failed %d", retval);
     }
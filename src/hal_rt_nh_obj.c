@@ -0,0 +1,518 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_nh_obj.c
+ * \brief  Next hop objects of the FHs
+ *
+ * A next hop object is created once per FH and NPU, the FH node being
+ * unique per VRF, address and interface, and is kept in the HAL info of the
+ * FH. The object holds a reference on the RIF of the FH for its lifetime.
+ * The routes written to point to the object take a reference on it, the
+ * object is deleted with the FH only when no route refers to it. An
+ * object still referred to when its FH is freed is kept until the last
+ * route reference goes. The objects are also kept per NPU in a tree by
+ * handle to find them from the routes. The objects missing for an ECMP
+ * group are created in one bulk NDI call when NDI has the bulk next hop
+ * API.
+ *
+ * The trees are shared by the AFs and are guarded by their own mutex, an
+ * object is only used by the routes and groups of the AF of its FH, under
+ * the L3 lock of that AF.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_api.h"
+#include "hal_rt_util.h"
+#include "hal_rt_mpath_grp.h"
+#include "nas_ndi_route.h"
+#include "hal_rt_ndi_opt.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HAL_RT_NH_OBJ_TREE_KEY_SIZE   (sizeof (next_hop_id_t) * 8)
+
+typedef t_std_error (*t_fib_ndi_nh_bulk_add_fn) (ndi_neighbor_t *p_nbr_entry, size_t count,
+                                                 next_hop_id_t *p_nh_handle,
+                                                 t_std_error *p_status);
+
+typedef struct _t_fib_nh_obj_stats {
+    uint32_t  num_objs [HAL_RT_MAX_INSTANCE];
+    uint32_t  num_created;
+    uint32_t  num_deleted;
+    uint32_t  num_create_failed;
+    uint32_t  num_delete_busy;
+    uint32_t  num_bulk_calls;
+    uint32_t  num_bulk_created;
+} t_fib_nh_obj_stats;
+
+static pthread_mutex_t            g_fib_nh_obj_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std_rt_table              *gp_fib_nh_obj_tree [HAL_RT_MAX_INSTANCE];
+static t_fib_nh_obj_stats         g_fib_nh_obj_stats;
+static t_fib_ndi_nh_bulk_add_fn   g_fib_ndi_nh_bulk_add = NULL;
+
+t_std_error hal_rt_nh_obj_init (void)
+{
+    char      tree_name_str [FIB_RDX_MAX_NAME_LEN];
+    npu_id_t  unit;
+
+    for (unit = 0; unit < HAL_RT_MAX_INSTANCE; unit++) {
+        memset (tree_name_str, 0, FIB_RDX_MAX_NAME_LEN);
+        snprintf (tree_name_str, FIB_RDX_MAX_NAME_LEN, "Fib_nh_obj_tree_unit%d", unit);
+
+        gp_fib_nh_obj_tree [unit] = std_radix_create (tree_name_str,
+                                                      HAL_RT_NH_OBJ_TREE_KEY_SIZE,
+                                                      NULL, NULL, 0);
+        if (gp_fib_nh_obj_tree [unit] == NULL) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NH",
+                       "%s (): std_radix_create failed. Unit: %d\r\n", __FUNCTION__, unit);
+            return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+        }
+        std_radix_disable_radical (gp_fib_nh_obj_tree [unit]);
+    }
+
+    /* Optional NDI API, NULL in the older NDI versions */
+    g_fib_ndi_nh_bulk_add = ndi_route_next_hop_bulk_add;
+    return STD_ERR_OK;
+}
+
+static t_fib_nh_obj *fib_get_nh_obj (t_fib_nh *p_fh, npu_id_t unit)
+{
+    t_fib_hal_nh_info *p_hal_nh_info = (t_fib_hal_nh_info *) p_fh->p_hal_nh_handle;
+
+    if ((p_hal_nh_info == NULL) || (unit >= HAL_RT_MAX_INSTANCE))
+        return NULL;
+
+    return p_hal_nh_info->ap_nh_obj [unit];
+}
+
+static t_fib_nh_obj *fib_get_nh_obj_by_id (npu_id_t unit, next_hop_id_t nh_handle)
+{
+    t_fib_nh_obj *p_nh_obj;
+
+    if ((nh_handle == 0) || (unit >= HAL_RT_MAX_INSTANCE) ||
+        (gp_fib_nh_obj_tree [unit] == NULL))
+        return NULL;
+
+    pthread_mutex_lock (&g_fib_nh_obj_mutex);
+    p_nh_obj = (t_fib_nh_obj *) std_radix_getexact (gp_fib_nh_obj_tree [unit],
+                                                    (uint8_t *) &nh_handle,
+                                                    HAL_RT_NH_OBJ_TREE_KEY_SIZE);
+    pthread_mutex_unlock (&g_fib_nh_obj_mutex);
+
+    return p_nh_obj;
+}
+
+/*
+ * Returns the handle of the next hop object of the FH on the unit,
+ * 0 if there is none.
+ */
+next_hop_id_t hal_rt_nh_obj_id_get (t_fib_nh *p_fh, npu_id_t unit)
+{
+    t_fib_nh_obj *p_nh_obj = fib_get_nh_obj (p_fh, unit);
+
+    return ((p_nh_obj != NULL) ? p_nh_obj->sai_nh_id : 0);
+}
+
+/*
+ * Returns the list of the multipath objects using the handle on the
+ * unit, NULL if the handle is not a next hop object.
+ */
+std_dll_head *hal_rt_nh_obj_mp_obj_list (npu_id_t unit, next_hop_id_t nh_handle)
+{
+    t_fib_nh_obj *p_nh_obj = fib_get_nh_obj_by_id (unit, nh_handle);
+
+    return ((p_nh_obj != NULL) ? &p_nh_obj->mp_obj_list : NULL);
+}
+
+static t_std_error fib_form_nh_obj_entry (t_fib_nh *p_fh, npu_id_t unit,
+                                          ndi_neighbor_t *p_nbr_entry)
+{
+    memset (p_nbr_entry, 0, sizeof (ndi_neighbor_t));
+
+    if (hal_form_nbr_entry (p_nbr_entry, p_fh) != STD_ERR_OK)
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+
+    p_nbr_entry->npu_id = unit;
+    p_nbr_entry->vrf_id = hal_vrf_obj_get (unit, p_fh->vrf_id);
+    p_nbr_entry->rif_id = hal_rif_index_get (unit, p_fh->vrf_id, p_fh->key.if_index);
+
+    return STD_ERR_OK;
+}
+
+/*
+ * Saves the object created in NDI for the FH, the RIF reference is taken
+ * here and only here.
+ */
+static t_std_error fib_add_nh_obj (t_fib_nh *p_fh, npu_id_t unit, next_hop_id_t nh_handle)
+{
+    t_fib_hal_nh_info *p_hal_nh_info;
+    t_fib_nh_obj      *p_nh_obj;
+
+    if (p_fh->p_hal_nh_handle == NULL) {
+        p_fh->p_hal_nh_handle = hal_rt_fib_calloc_hal_nh_info_node ();
+        if (p_fh->p_hal_nh_handle == NULL)
+            return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+    }
+    p_hal_nh_info = (t_fib_hal_nh_info *) p_fh->p_hal_nh_handle;
+
+    p_nh_obj = (t_fib_nh_obj *) malloc (sizeof (t_fib_nh_obj));
+    if (p_nh_obj == NULL)
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+
+    memset (p_nh_obj, 0, sizeof (t_fib_nh_obj));
+    p_nh_obj->key       = nh_handle;
+    p_nh_obj->sai_nh_id = nh_handle;
+    p_nh_obj->vrf_id    = p_fh->vrf_id;
+    p_nh_obj->if_index  = p_fh->key.if_index;
+    p_nh_obj->rt_head.rth_addr = (uint8_t *) &p_nh_obj->key;
+    std_dll_init (&p_nh_obj->mp_obj_list);
+
+    pthread_mutex_lock (&g_fib_nh_obj_mutex);
+    if (std_radix_insert (gp_fib_nh_obj_tree [unit], &p_nh_obj->rt_head,
+                          HAL_RT_NH_OBJ_TREE_KEY_SIZE) == NULL) {
+        pthread_mutex_unlock (&g_fib_nh_obj_mutex);
+        free (p_nh_obj);
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+    }
+    pthread_mutex_unlock (&g_fib_nh_obj_mutex);
+
+    p_hal_nh_info->ap_nh_obj [unit] = p_nh_obj;
+    hal_rt_rif_ref_inc (p_fh->key.if_index);
+
+    /* The handle of the first NPU is kept in the FH for the common code */
+    if (unit == 0) {
+        p_fh->next_hop_id = nh_handle;
+        hal_rt_cam_entry_add (HAL_RT_CAM_NH);
+    }
+
+    FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_objs [unit], 1);
+    FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_created, 1);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+                 "Created nh handle %d. VRF %d, Addr: %s, Interface: %d, Unit: %d\r\n",
+                 nh_handle, p_fh->vrf_id, FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
+                 p_fh->key.if_index, unit);
+    return STD_ERR_OK;
+}
+
+/*
+ * Returns the next hop object of the FH on the unit, it is created if the
+ * FH has none yet.
+ */
+t_std_error hal_rt_nh_obj_get (t_fib_nh *p_fh, npu_id_t unit, next_hop_id_t *p_nh_handle)
+{
+    ndi_neighbor_t  nbr_entry;
+    next_hop_id_t   nh_handle = 0;
+    t_std_error     rc;
+
+    *p_nh_handle = hal_rt_nh_obj_id_get (p_fh, unit);
+    if (*p_nh_handle != 0)
+        return STD_ERR_OK;
+
+    if ((unit >= HAL_RT_MAX_INSTANCE) ||
+        (fib_form_nh_obj_entry (p_fh, unit, &nbr_entry) != STD_ERR_OK))
+        return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+
+    /*
+     * NDI Nexthop add API & Neighbor API uses the same ndi_neighbor_t
+     * data structure. A next-hop id is created for the route next-hop
+     * and passed as an index to NDI/SAI.
+     */
+    if ((rc = ndi_route_next_hop_add (&nbr_entry, &nh_handle)) != STD_ERR_OK) {
+        FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_create_failed, 1);
+        hal_rt_cam_write_failed (HAL_RT_CAM_NH, hal_rt_ndi_rc_is_table_full (rc));
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                   "NH create failed. VRF %d, Addr: %s, Interface: %d, Unit: %d, Err: %d\r\n",
+                   p_fh->vrf_id, FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr),
+                   p_fh->key.if_index, unit, rc);
+        return rc;
+    }
+
+    if ((rc = fib_add_nh_obj (p_fh, unit, nh_handle)) != STD_ERR_OK) {
+        ndi_route_next_hop_delete (unit, nh_handle);
+        return rc;
+    }
+
+    *p_nh_handle = nh_handle;
+    return STD_ERR_OK;
+}
+
+/*
+ * Creates the next hop objects of the FHs on the unit in one NDI call,
+ * the FHs that have an object already are skipped. A FH whose object
+ * failed to be created is left without one.
+ */
+void hal_rt_nh_obj_create_bulk (t_fib_nh *ap_fh [], uint32_t count, npu_id_t unit)
+{
+    ndi_neighbor_t  a_nbr_entry [HAL_RT_MAX_ECMP_PATH];
+    next_hop_id_t   a_nh_handle [HAL_RT_MAX_ECMP_PATH];
+    t_std_error     a_status [HAL_RT_MAX_ECMP_PATH];
+    t_fib_nh       *ap_new_fh [HAL_RT_MAX_ECMP_PATH];
+    uint32_t        num_new = 0;
+    uint32_t        index;
+    next_hop_id_t   nh_handle;
+
+    if (g_fib_ndi_nh_bulk_add == NULL) {
+        for (index = 0; index < count; index++)
+            hal_rt_nh_obj_get (ap_fh [index], unit, &nh_handle);
+        return;
+    }
+
+    for (index = 0; (index < count) && (num_new < HAL_RT_MAX_ECMP_PATH); index++) {
+        if ((hal_rt_nh_obj_id_get (ap_fh [index], unit) != 0) ||
+            (fib_form_nh_obj_entry (ap_fh [index], unit, &a_nbr_entry [num_new]) != STD_ERR_OK))
+            continue;
+
+        ap_new_fh [num_new] = ap_fh [index];
+        a_nh_handle [num_new] = 0;
+        a_status [num_new] = STD_ERR_OK;
+        num_new++;
+    }
+
+    if (num_new == 0)
+        return;
+
+    FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_bulk_calls, 1);
+
+    if (g_fib_ndi_nh_bulk_add (a_nbr_entry, num_new, a_nh_handle, a_status) != STD_ERR_OK) {
+        /* The entries not done by the bulk call are created one by one */
+        for (index = 0; index < num_new; index++) {
+            if ((a_status [index] == STD_ERR_OK) && (a_nh_handle [index] != 0))
+                continue;
+            a_nh_handle [index] = 0;
+            a_status [index] = ndi_route_next_hop_add (&a_nbr_entry [index],
+                                                       &a_nh_handle [index]);
+        }
+    }
+
+    for (index = 0; index < num_new; index++) {
+        if ((a_status [index] != STD_ERR_OK) || (a_nh_handle [index] == 0)) {
+            FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_create_failed, 1);
+            hal_rt_cam_write_failed (HAL_RT_CAM_NH, hal_rt_ndi_rc_is_table_full (a_status [index]));
+            continue;
+        }
+        if (fib_add_nh_obj (ap_new_fh [index], unit, a_nh_handle [index]) != STD_ERR_OK) {
+            ndi_route_next_hop_delete (unit, a_nh_handle [index]);
+            continue;
+        }
+        FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_bulk_created, 1);
+    }
+}
+
+static void fib_destroy_nh_obj (npu_id_t unit, t_fib_nh_obj *p_nh_obj)
+{
+    t_fib_mp_obj_link *p_link;
+
+    /* The groups still using the object drop their back reference */
+    while ((p_link = (t_fib_mp_obj_link *) std_dll_getfirst (&p_nh_obj->mp_obj_list)) != NULL) {
+        std_dll_remove (&p_nh_obj->mp_obj_list, &p_link->glue);
+        p_link->p_list = NULL;
+    }
+
+    pthread_mutex_lock (&g_fib_nh_obj_mutex);
+    std_radix_remove (gp_fib_nh_obj_tree [unit], &p_nh_obj->rt_head);
+    pthread_mutex_unlock (&g_fib_nh_obj_mutex);
+    free (p_nh_obj);
+
+    FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_objs [unit], -1);
+}
+
+/*
+ * Deletes the object from the NPU and releases its RIF reference, the
+ * object node is kept.
+ */
+static t_std_error fib_ndi_del_nh_obj (npu_id_t unit, t_fib_nh_obj *p_nh_obj)
+{
+    t_std_error rc;
+
+    rc = ndi_route_next_hop_delete (unit, p_nh_obj->sai_nh_id);
+    if (rc != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI", "%s (): Failed to delete NH. "
+                   "Unit: %d. Err: %d nh id %d\r\n",
+                   __FUNCTION__, unit, rc, p_nh_obj->sai_nh_id);
+        return rc;
+    }
+
+    if (unit == 0)
+        hal_rt_cam_entry_del (HAL_RT_CAM_NH);
+
+    FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_deleted, 1);
+
+    if (!hal_rt_rif_ref_dec (p_nh_obj->if_index))
+        hal_rif_index_remove (unit, p_nh_obj->vrf_id, p_nh_obj->if_index);
+
+    return STD_ERR_OK;
+}
+
+static void fib_detach_nh_obj (t_fib_nh *p_fh, npu_id_t unit)
+{
+    t_fib_hal_nh_info *p_hal_nh_info = (t_fib_hal_nh_info *) p_fh->p_hal_nh_handle;
+
+    p_hal_nh_info->ap_nh_obj [unit] = NULL;
+
+    if (unit == 0)
+        p_fh->next_hop_id = 0;
+}
+
+/*
+ * A route written to point to the handle takes a reference on the object,
+ * a handle that is not a next hop object (a group) is ignored.
+ */
+void hal_rt_nh_obj_ref (npu_id_t unit, next_hop_id_t nh_handle)
+{
+    t_fib_nh_obj *p_nh_obj = fib_get_nh_obj_by_id (unit, nh_handle);
+
+    if (p_nh_obj != NULL)
+        p_nh_obj->ref_count++;
+}
+
+static bool fib_is_nh_obj_in_use (t_fib_nh_obj *p_nh_obj)
+{
+    return ((p_nh_obj->ref_count != 0) ||
+            (std_dll_getfirst (&p_nh_obj->mp_obj_list) != NULL));
+}
+
+/* The last route or group reference on the object of a freed FH */
+static void fib_check_and_delete_orphan_nh_obj (npu_id_t unit, t_fib_nh_obj *p_nh_obj)
+{
+    if ((p_nh_obj->flags & FIB_NH_OBJ_FLAG_ORPHAN) && (!fib_is_nh_obj_in_use (p_nh_obj))) {
+        fib_ndi_del_nh_obj (unit, p_nh_obj);
+        fib_destroy_nh_obj (unit, p_nh_obj);
+    }
+}
+
+void hal_rt_nh_obj_unref (npu_id_t unit, next_hop_id_t nh_handle)
+{
+    t_fib_nh_obj *p_nh_obj = fib_get_nh_obj_by_id (unit, nh_handle);
+
+    if ((p_nh_obj == NULL) || (p_nh_obj->ref_count == 0))
+        return;
+
+    p_nh_obj->ref_count--;
+
+    fib_check_and_delete_orphan_nh_obj (unit, p_nh_obj);
+}
+
+/*
+ * Called after a multipath object is removed from the list of the object.
+ */
+void hal_rt_nh_obj_mp_obj_unlinked (npu_id_t unit, next_hop_id_t nh_handle)
+{
+    t_fib_nh_obj *p_nh_obj = fib_get_nh_obj_by_id (unit, nh_handle);
+
+    if (p_nh_obj != NULL)
+        fib_check_and_delete_orphan_nh_obj (unit, p_nh_obj);
+}
+
+/*
+ * Deletes the next hop objects of the FH from all the NPUs. Fails without
+ * any NDI call if a route still points to one of them. A unit whose NDI
+ * delete fails keeps its object, the others are deleted, so the delete is
+ * retried for the failed units only.
+ */
+t_std_error hal_rt_nh_obj_delete (t_fib_nh *p_fh)
+{
+    t_fib_nh_obj *p_nh_obj;
+    npu_id_t      unit;
+    t_std_error   rc;
+    t_std_error   ret_rc = STD_ERR_OK;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        p_nh_obj = fib_get_nh_obj (p_fh, unit);
+        if ((p_nh_obj != NULL) && (p_nh_obj->ref_count != 0)) {
+            FIB_CNTRS_ADD (g_fib_nh_obj_stats.num_delete_busy, 1);
+            EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+                         "NH in use, not deleted. nh id %d, Unit: %d, ref_count: %d\r\n",
+                         p_nh_obj->sai_nh_id, unit, p_nh_obj->ref_count);
+            return (STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0));
+        }
+    }
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        p_nh_obj = fib_get_nh_obj (p_fh, unit);
+        if (p_nh_obj == NULL)
+            continue;
+
+        if ((rc = fib_ndi_del_nh_obj (unit, p_nh_obj)) != STD_ERR_OK) {
+            if (ret_rc == STD_ERR_OK)
+                ret_rc = rc;
+            continue;
+        }
+
+        fib_detach_nh_obj (p_fh, unit);
+        fib_destroy_nh_obj (unit, p_nh_obj);
+    }
+    return ret_rc;
+}
+
+/*
+ * Called when the FH node is freed. The objects no route or group refers
+ * to are deleted from the NPUs, the others are left to the last reference.
+ */
+void hal_rt_nh_obj_free (t_fib_nh *p_fh)
+{
+    t_fib_nh_obj *p_nh_obj;
+    npu_id_t      unit;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        p_nh_obj = fib_get_nh_obj (p_fh, unit);
+        if (p_nh_obj == NULL)
+            continue;
+
+        fib_detach_nh_obj (p_fh, unit);
+
+        if (fib_is_nh_obj_in_use (p_nh_obj)) {
+            EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+                         "NH freed with its object in use. nh id %d, Unit: %d, ref_count: %d\r\n",
+                         p_nh_obj->sai_nh_id, unit, p_nh_obj->ref_count);
+            p_nh_obj->flags |= FIB_NH_OBJ_FLAG_ORPHAN;
+            continue;
+        }
+
+        if (fib_ndi_del_nh_obj (unit, p_nh_obj) != STD_ERR_OK)
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                       "NH freed with its object not deleted. nh id %d, Unit: %d\r\n",
+                       p_nh_obj->sai_nh_id, unit);
+        fib_destroy_nh_obj (unit, p_nh_obj);
+    }
+}
+
+void fib_dump_nh_obj_stats (void)
+{
+    npu_id_t unit;
+
+    printf ("**************************************************\r\n");
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        printf ("  num_objs [%d]          :  %d\r\n", unit,
+                g_fib_nh_obj_stats.num_objs [unit]);
+    }
+    printf ("  num_created           :  %d\r\n", g_fib_nh_obj_stats.num_created);
+    printf ("  num_deleted           :  %d\r\n", g_fib_nh_obj_stats.num_deleted);
+    printf ("  num_create_failed     :  %d\r\n", g_fib_nh_obj_stats.num_create_failed);
+    printf ("  num_delete_busy       :  %d\r\n", g_fib_nh_obj_stats.num_delete_busy);
+    printf ("  bulk_create_api       :  %s\r\n",
+            (g_fib_ndi_nh_bulk_add != NULL) ? "Yes" : "No");
+    printf ("  num_bulk_calls        :  %d\r\n", g_fib_nh_obj_stats.num_bulk_calls);
+    printf ("  num_bulk_created      :  %d\r\n", g_fib_nh_obj_stats.num_bulk_created);
+    printf ("**************************************************\r\n");
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_npu_worker.c
+ * \brief  Per NPU workers to program the NPUs in parallel
+ *
+ * There is one worker thread per NPU other than the first one. A job is
+ * run for all the NPUs at the same time, the calling thread runs it for
+ * the first NPU and waits for the workers to complete it for the others.
+ * A job only writes to its NPU and to the per NPU data of the caller, the
+ * results are applied by the caller after all the NPUs are done.
+ */
+
+#include "hal_rt_main.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+#include "std_thread_tools.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+static std_thread_create_param_t g_fib_npu_worker_thr [HAL_RT_MAX_INSTANCE];
+static npu_id_t                  g_fib_npu_worker_unit [HAL_RT_MAX_INSTANCE];
+static uint32_t                  g_fib_npu_num_workers = 0;
+
+/* One job at a time, from any thread */
+static pthread_mutex_t           g_fib_npu_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t           g_fib_npu_worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t            g_fib_npu_worker_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t            g_fib_npu_done_cond = PTHREAD_COND_INITIALIZER;
+static t_hal_rt_npu_job_fn       g_fib_npu_job_fn = NULL;
+static void                     *g_fib_npu_job_arg = NULL;
+static uint32_t                  g_fib_npu_job_seq = 0;
+static uint32_t                  g_fib_npu_num_pending = 0;
+static uint32_t                  g_fib_npu_num_parallel_jobs = 0;
+
+static void *fib_npu_worker_main (void *p_arg)
+{
+    npu_id_t             unit = *((npu_id_t *) p_arg);
+    uint32_t             job_seq = 0;
+    t_hal_rt_npu_job_fn  job_fn;
+    void                *p_job_arg;
+
+    for ( ; ; )
+    {
+        pthread_mutex_lock (&g_fib_npu_worker_mutex);
+        while (job_seq == g_fib_npu_job_seq)
+            pthread_cond_wait (&g_fib_npu_worker_cond, &g_fib_npu_worker_mutex);
+
+        job_seq   = g_fib_npu_job_seq;
+        job_fn    = g_fib_npu_job_fn;
+        p_job_arg = g_fib_npu_job_arg;
+        pthread_mutex_unlock (&g_fib_npu_worker_mutex);
+
+        job_fn (unit, p_job_arg);
+
+        pthread_mutex_lock (&g_fib_npu_worker_mutex);
+        if (--g_fib_npu_num_pending == 0)
+            pthread_cond_signal (&g_fib_npu_done_cond);
+        pthread_mutex_unlock (&g_fib_npu_worker_mutex);
+    }
+    return NULL;
+}
+
+/*
+ * Workers are created for the NPUs after the first one, none on a single
+ * NPU system. A NPU without a worker is programmed by the calling thread.
+ */
+t_std_error hal_rt_npu_worker_init (void)
+{
+    npu_id_t unit;
+
+    for (unit = 1; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        g_fib_npu_worker_unit [unit] = unit;
+
+        if (hal_rt_thread_create (&g_fib_npu_worker_thr [unit], HAL_RT_THREAD_NPU,
+                                  (std_thread_function_t) fib_npu_worker_main,
+                                  &g_fib_npu_worker_unit [unit]) != STD_ERR_OK) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD",
+                       "Error creating npu worker thread. Unit: %d", unit);
+            break;
+        }
+        g_fib_npu_num_workers++;
+    }
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-THREAD", "NPU workers: %d\r\n",
+                 g_fib_npu_num_workers);
+
+    return STD_ERR_OK;
+}
+
+/*
+ * Runs the job for all the NPUs and returns when it is done for all.
+ */
+void hal_rt_npu_run_all (t_hal_rt_npu_job_fn job_fn, void *p_arg)
+{
+    uint32_t  num_npu = hal_rt_access_fib_config()->max_num_npu;
+    npu_id_t  unit;
+
+    if ((num_npu <= 1) || (g_fib_npu_num_workers != (num_npu - 1))) {
+        for (unit = 0; unit < num_npu; unit++)
+            job_fn (unit, p_arg);
+        return;
+    }
+
+    pthread_mutex_lock (&g_fib_npu_job_mutex);
+
+    pthread_mutex_lock (&g_fib_npu_worker_mutex);
+    g_fib_npu_job_fn      = job_fn;
+    g_fib_npu_job_arg     = p_arg;
+    g_fib_npu_num_pending = g_fib_npu_num_workers;
+    g_fib_npu_job_seq++;
+    g_fib_npu_num_parallel_jobs++;
+    pthread_cond_broadcast (&g_fib_npu_worker_cond);
+    pthread_mutex_unlock (&g_fib_npu_worker_mutex);
+
+    job_fn (0, p_arg);
+
+    pthread_mutex_lock (&g_fib_npu_worker_mutex);
+    while (g_fib_npu_num_pending != 0)
+        pthread_cond_wait (&g_fib_npu_done_cond, &g_fib_npu_worker_mutex);
+    pthread_mutex_unlock (&g_fib_npu_worker_mutex);
+
+    pthread_mutex_unlock (&g_fib_npu_job_mutex);
+}
+
+void fib_dump_npu_worker_stats (void)
+{
+    printf ("**************************************************\r\n");
+    printf ("  max_num_npu           :  %d\r\n", hal_rt_access_fib_config()->max_num_npu);
+    printf ("  num_workers           :  %d\r\n", g_fib_npu_num_workers);
+    printf ("  num_parallel_jobs     :  %d\r\n", g_fib_npu_num_parallel_jobs);
+    printf ("**************************************************\r\n");
+}
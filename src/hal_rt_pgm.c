@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_pgm.c
+ * \brief  Asynchronous NDI programming stage
+ *
+ * The walkers hand their batches to the programming thread and release the
+ * L3 lock while the batch is written to the NPUs. The programming thread
+ * runs the jobs in the order they are submitted and does not take the L3
+ * lock, a job only reads its batch and writes the per entry results. The
+ * submitter applies the results under the L3 lock once the job is done.
+ */
+
+#include "hal_rt_main.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+#include "std_thread_tools.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#define HAL_RT_PGM_MAX_JOBS    8
+
+static std_thread_create_param_t  g_fib_pgm_thr;
+static bool                       g_fib_pgm_is_started = false;
+
+static pthread_mutex_t            g_fib_pgm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t             g_fib_pgm_job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t             g_fib_pgm_done_cond = PTHREAD_COND_INITIALIZER;
+static t_hal_rt_pgm_job          *gp_fib_pgm_jobs [HAL_RT_PGM_MAX_JOBS];
+static uint32_t                   g_fib_pgm_head = 0;
+static uint32_t                   g_fib_pgm_num_jobs = 0;
+
+static uint32_t                   g_fib_pgm_num_submitted = 0;
+static uint32_t                   g_fib_pgm_num_inline = 0;
+static uint32_t                   g_fib_pgm_num_waits = 0;
+
+static void *fib_pgm_thread_main (void *p_arg)
+{
+    t_hal_rt_pgm_job *p_job;
+
+    for ( ; ; )
+    {
+        pthread_mutex_lock (&g_fib_pgm_mutex);
+        while (g_fib_pgm_num_jobs == 0)
+            pthread_cond_wait (&g_fib_pgm_job_cond, &g_fib_pgm_mutex);
+
+        p_job = gp_fib_pgm_jobs [g_fib_pgm_head];
+        g_fib_pgm_head = (g_fib_pgm_head + 1) % HAL_RT_PGM_MAX_JOBS;
+        g_fib_pgm_num_jobs--;
+        pthread_mutex_unlock (&g_fib_pgm_mutex);
+
+        hal_rt_npu_run_all (p_job->job_fn, p_job->p_arg);
+
+        pthread_mutex_lock (&g_fib_pgm_mutex);
+        p_job->is_pending = false;
+        pthread_cond_broadcast (&g_fib_pgm_done_cond);
+        pthread_mutex_unlock (&g_fib_pgm_mutex);
+    }
+    return NULL;
+}
+
+t_std_error hal_rt_pgm_init (void)
+{
+    if (hal_rt_thread_create (&g_fib_pgm_thr, HAL_RT_THREAD_PGM,
+                              (std_thread_function_t) fib_pgm_thread_main,
+                              NULL) != STD_ERR_OK) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-THREAD", "Error creating pgm thread");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    g_fib_pgm_is_started = true;
+
+    return STD_ERR_OK;
+}
+
+/*
+ * The job is run now if the programming is not asynchronous or the queue
+ * is full, else queued to the programming thread.
+ */
+void hal_rt_pgm_submit (t_hal_rt_pgm_job *p_job)
+{
+    pthread_mutex_lock (&g_fib_pgm_mutex);
+
+    if ((!g_fib_pgm_is_started) || (!hal_rt_access_fib_config()->ndi_async_pgm) ||
+        (g_fib_pgm_num_jobs >= HAL_RT_PGM_MAX_JOBS)) {
+        g_fib_pgm_num_inline++;
+        pthread_mutex_unlock (&g_fib_pgm_mutex);
+
+        hal_rt_npu_run_all (p_job->job_fn, p_job->p_arg);
+        p_job->is_pending = false;
+        return;
+    }
+
+    p_job->is_pending = true;
+    gp_fib_pgm_jobs [(g_fib_pgm_head + g_fib_pgm_num_jobs) % HAL_RT_PGM_MAX_JOBS] = p_job;
+    g_fib_pgm_num_jobs++;
+    g_fib_pgm_num_submitted++;
+    pthread_cond_signal (&g_fib_pgm_job_cond);
+
+    pthread_mutex_unlock (&g_fib_pgm_mutex);
+}
+
+bool hal_rt_pgm_is_pending (t_hal_rt_pgm_job *p_job)
+{
+    bool is_pending;
+
+    pthread_mutex_lock (&g_fib_pgm_mutex);
+    is_pending = p_job->is_pending;
+    pthread_mutex_unlock (&g_fib_pgm_mutex);
+
+    return is_pending;
+}
+
+void hal_rt_pgm_wait (t_hal_rt_pgm_job *p_job)
+{
+    pthread_mutex_lock (&g_fib_pgm_mutex);
+    if (p_job->is_pending)
+        g_fib_pgm_num_waits++;
+
+    while (p_job->is_pending)
+        pthread_cond_wait (&g_fib_pgm_done_cond, &g_fib_pgm_mutex);
+    pthread_mutex_unlock (&g_fib_pgm_mutex);
+}
+
+void fib_dump_pgm_stats (void)
+{
+    printf ("**************************************************\r\n");
+    printf ("  ndi_async_pgm         :  %d\r\n", hal_rt_access_fib_config()->ndi_async_pgm);
+    printf ("  is_started            :  %d\r\n", g_fib_pgm_is_started);
+    printf ("  num_jobs              :  %d\r\n", g_fib_pgm_num_jobs);
+    printf ("  num_submitted         :  %d\r\n", g_fib_pgm_num_submitted);
+    printf ("  num_inline            :  %d\r\n", g_fib_pgm_num_inline);
+    printf ("  num_waits             :  %d\r\n", g_fib_pgm_num_waits);
+    printf ("**************************************************\r\n");
+}
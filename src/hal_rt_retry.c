@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_retry.c
+ * \brief  Retry of the failed route and neighbor writes
+ *
+ * A DR or NH whose write to the NPUs failed is queued with the reason of
+ * the failure and is removed once it is written or freed. The DR walker
+ * marks the queued entries for resolution when their backoff expires, the
+ * backoff doubles with each retry up to HAL_RT_RETRY_MAX_BACKOFF. An entry
+ * that failed for a full table is retried as soon as the table has room,
+ * no more entries than the free table entries. The entries retried
+ * HAL_RT_RETRY_STUCK_ATTEMPTS times and still pending are counted stuck.
+ *
+ * The list is shared by the AFs, the writers of the AFs queue and remove
+ * their entries under its own mutex. The DR walker runs the retries with
+ * the L3 locks of all the AFs, the list does not change meanwhile.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_util.h"
+#include "hal_rt_debug.h"
+#include "event_log.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct _t_fib_retry_entry {
+    std_dll        glue;
+    bool           is_dr;
+    void          *p_node;       /* t_fib_dr or t_fib_nh */
+    t_hal_rt_cam   cam;
+    uint32_t       reason;       /* HAL_RT_RETRY_RSN_XXX */
+    uint32_t       num_attempts;
+    uint32_t       backoff;      /* msecs */
+    uint64_t       retry_time;   /* msecs */
+} t_fib_retry_entry;
+
+static const char *ga_fib_retry_reason_name [HAL_RT_RETRY_RSN_MAX] = {
+    "NDI failure",
+    "Table full",
+    "ECMP failure",
+};
+
+static pthread_mutex_t       g_fib_retry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static t_hal_rt_retry_stats  g_fib_retry_stats;
+static std_dll_head          g_fib_retry_list;
+static bool                  g_fib_retry_list_init = false;
+
+static std_dll_head *fib_get_retry_list (void)
+{
+    if (g_fib_retry_list_init == false) {
+        std_dll_init (&g_fib_retry_list);
+        g_fib_retry_list_init = true;
+    }
+    return &g_fib_retry_list;
+}
+
+static uint64_t fib_retry_get_msecs (void)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (((uint64_t) now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+}
+
+static void fib_retry_count (t_fib_retry_entry *p_entry, bool is_add)
+{
+    uint32_t *p_cnt = &g_fib_retry_stats.a_num_pending [p_entry->reason];
+
+    *p_cnt = (is_add) ? (*p_cnt + 1) : ((*p_cnt > 0) ? (*p_cnt - 1) : 0);
+
+    if (p_entry->reason == HAL_RT_RETRY_RSN_TABLE_FULL) {
+        p_cnt = &g_fib_retry_stats.a_num_table_full [p_entry->cam];
+        *p_cnt = (is_add) ? (*p_cnt + 1) : ((*p_cnt > 0) ? (*p_cnt - 1) : 0);
+    }
+}
+
+/*
+ * Queues the entry or, if queued already, updates its reason. A write
+ * that failed while the table of the entry is full is retried for room.
+ */
+static void fib_retry_entry_add (void **pp_retry, bool is_dr, void *p_node,
+                                 t_hal_rt_cam cam, t_hal_rt_retry_reason reason)
+{
+    t_fib_retry_entry *p_entry = (t_fib_retry_entry *) *pp_retry;
+    bool               is_new = (p_entry == NULL);
+
+    if ((reason == HAL_RT_RETRY_RSN_NDI_FAIL) && (hal_rt_cam_is_full (cam)))
+        reason = HAL_RT_RETRY_RSN_TABLE_FULL;
+
+    if (is_new) {
+        p_entry = (t_fib_retry_entry *) malloc (sizeof (t_fib_retry_entry));
+        if (p_entry == NULL) {
+            EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-RETRY",
+                    "Failed to allocate retry node. Table: %s\r\n", hal_rt_cam_name (cam));
+            return;
+        }
+        memset (p_entry, 0, sizeof (t_fib_retry_entry));
+
+        p_entry->is_dr   = is_dr;
+        p_entry->p_node  = p_node;
+        p_entry->cam     = cam;
+        p_entry->backoff = HAL_RT_RETRY_MIN_BACKOFF;
+        p_entry->retry_time = fib_retry_get_msecs () + p_entry->backoff;
+    }
+
+    pthread_mutex_lock (&g_fib_retry_mutex);
+    if (is_new) {
+        std_dll_insertatback (fib_get_retry_list (), &p_entry->glue);
+        g_fib_retry_stats.num_pending++;
+        *pp_retry = p_entry;
+    } else {
+        fib_retry_count (p_entry, false);
+    }
+
+    p_entry->reason = reason;
+    fib_retry_count (p_entry, true);
+    g_fib_retry_stats.num_failed++;
+    pthread_mutex_unlock (&g_fib_retry_mutex);
+}
+
+static void fib_retry_entry_del (void **pp_retry)
+{
+    t_fib_retry_entry *p_entry = (t_fib_retry_entry *) *pp_retry;
+
+    if (p_entry == NULL)
+        return;
+
+    pthread_mutex_lock (&g_fib_retry_mutex);
+    if (p_entry->num_attempts > 0)
+        g_fib_retry_stats.num_recovered++;
+
+    fib_retry_count (p_entry, false);
+    std_dll_remove (fib_get_retry_list (), &p_entry->glue);
+
+    if (g_fib_retry_stats.num_pending > 0)
+        g_fib_retry_stats.num_pending--;
+    pthread_mutex_unlock (&g_fib_retry_mutex);
+
+    free (p_entry);
+    *pp_retry = NULL;
+}
+
+void hal_rt_retry_dr_add (t_fib_dr *p_dr, t_hal_rt_retry_reason reason)
+{
+    fib_retry_entry_add (&p_dr->p_retry, true, p_dr,
+                         hal_rt_cam_get_route_cam (p_dr->key.prefix.af_index, p_dr->prefix_len),
+                         reason);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-RETRY",
+            "Route queued for retry: VRF %d, Prefix: %s/%d, Reason: %s\r\n",
+            p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+            ga_fib_retry_reason_name [reason]);
+}
+
+void hal_rt_retry_dr_del (t_fib_dr *p_dr)
+{
+    fib_retry_entry_del (&p_dr->p_retry);
+}
+
+void hal_rt_retry_nh_add (t_fib_nh *p_nh, t_hal_rt_retry_reason reason)
+{
+    fib_retry_entry_add (&p_nh->p_retry, false, p_nh, HAL_RT_CAM_HOST, reason);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-RETRY",
+            "Host queued for retry: VRF %d, Addr: %s, Interface: %d, Reason: %s\r\n",
+            p_nh->vrf_id, FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
+            ga_fib_retry_reason_name [reason]);
+}
+
+void hal_rt_retry_nh_del (t_fib_nh *p_nh)
+{
+    fib_retry_entry_del (&p_nh->p_retry);
+}
+
+uint32_t hal_rt_retry_num_pending (void)
+{
+    return g_fib_retry_stats.num_pending;
+}
+
+uint32_t hal_rt_retry_num_table_full (t_hal_rt_cam cam)
+{
+    return ((cam < HAL_RT_CAM_MAX) ? g_fib_retry_stats.a_num_table_full [cam] : 0);
+}
+
+const t_hal_rt_retry_stats *hal_rt_access_retry_stats (void)
+{
+    return &g_fib_retry_stats;
+}
+
+/*
+ * Called by the DR walker when it is idle. Marks a batch of the entries
+ * that are due for resolution. Returns the number of DRs marked, the NH
+ * walker is to be resumed by the caller if NHs were marked.
+ */
+int hal_rt_retry_run (bool *p_is_nh_marked)
+{
+    const t_hal_rt_cam_usage *p_usage;
+    t_fib_retry_entry        *p_entry;
+    t_fib_retry_entry        *p_next_entry;
+    uint32_t                  a_room [HAL_RT_CAM_MAX];
+    uint32_t                  cam;
+    uint32_t                  num_marked = 0;
+    uint32_t                  num_stuck = 0;
+    int                       num_dr_marked = 0;
+    uint64_t                  now;
+    bool                      is_due;
+
+    *p_is_nh_marked = false;
+
+    if (g_fib_retry_stats.num_pending == 0)
+        return 0;
+
+    for (cam = 0; cam < HAL_RT_CAM_MAX; cam++) {
+        p_usage = hal_rt_access_cam_usage (cam);
+        a_room [cam] = (p_usage->capacity > p_usage->in_use) ?
+                       (p_usage->capacity - p_usage->in_use) : 0;
+    }
+
+    now = fib_retry_get_msecs ();
+
+    p_entry = (t_fib_retry_entry *) std_dll_getfirst (fib_get_retry_list ());
+
+    while (p_entry != NULL)
+    {
+        p_next_entry = (t_fib_retry_entry *)
+            std_dll_getnext (fib_get_retry_list (), &p_entry->glue);
+
+        if (p_entry->reason == HAL_RT_RETRY_RSN_TABLE_FULL) {
+            is_due = (a_room [p_entry->cam] > 0);
+        } else {
+            is_due = (now >= p_entry->retry_time);
+        }
+
+        if ((is_due) && (num_marked < HAL_RT_RETRY_BATCH)) {
+            if (p_entry->reason == HAL_RT_RETRY_RSN_TABLE_FULL)
+                a_room [p_entry->cam]--;
+
+            /* Backed off again in case the retry does not write the entry */
+            p_entry->num_attempts++;
+            p_entry->backoff = ((p_entry->backoff * 2) < HAL_RT_RETRY_MAX_BACKOFF) ?
+                               (p_entry->backoff * 2) : HAL_RT_RETRY_MAX_BACKOFF;
+            p_entry->retry_time = now + p_entry->backoff;
+
+            if (p_entry->num_attempts > g_fib_retry_stats.max_attempts)
+                g_fib_retry_stats.max_attempts = p_entry->num_attempts;
+
+            if (p_entry->is_dr) {
+                fib_mark_dr_for_resolution ((t_fib_dr *) p_entry->p_node);
+                num_dr_marked++;
+            } else {
+                fib_mark_nh_for_resolution ((t_fib_nh *) p_entry->p_node);
+                *p_is_nh_marked = true;
+            }
+            g_fib_retry_stats.num_retried++;
+            num_marked++;
+        }
+
+        if (p_entry->num_attempts >= HAL_RT_RETRY_STUCK_ATTEMPTS)
+            num_stuck++;
+
+        p_entry = p_next_entry;
+    }
+
+    g_fib_retry_stats.num_stuck = num_stuck;
+
+    if (num_marked > 0)
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-RETRY",
+                "Retry: %d marked, %d pending, %d stuck\r\n",
+                num_marked, g_fib_retry_stats.num_pending, num_stuck);
+
+    return num_dr_marked;
+}
+
+void fib_dump_retry_stats (void)
+{
+    t_fib_retry_entry *p_entry;
+    uint32_t           index;
+
+    printf ("**************************************************\r\n");
+    printf ("  num_pending           :  %d\r\n", g_fib_retry_stats.num_pending);
+    for (index = 0; index < HAL_RT_RETRY_RSN_MAX; index++) {
+        printf ("    %-19s :  %d\r\n", ga_fib_retry_reason_name [index],
+                g_fib_retry_stats.a_num_pending [index]);
+    }
+    for (index = 0; index < HAL_RT_CAM_MAX; index++) {
+        printf ("    %-19s :  %d\r\n", hal_rt_cam_name (index),
+                g_fib_retry_stats.a_num_table_full [index]);
+    }
+    printf ("  num_stuck             :  %d\r\n", g_fib_retry_stats.num_stuck);
+    printf ("  num_failed            :  %d\r\n", g_fib_retry_stats.num_failed);
+    printf ("  num_retried           :  %d\r\n", g_fib_retry_stats.num_retried);
+    printf ("  num_recovered         :  %d\r\n", g_fib_retry_stats.num_recovered);
+    printf ("  max_attempts          :  %d\r\n", g_fib_retry_stats.max_attempts);
+    printf ("**************************************************\r\n");
+
+    p_entry = (t_fib_retry_entry *) std_dll_getfirst (fib_get_retry_list ());
+
+    while (p_entry != NULL)
+    {
+        if (p_entry->num_attempts >= HAL_RT_RETRY_STUCK_ATTEMPTS) {
+            if (p_entry->is_dr) {
+                t_fib_dr *p_dr = (t_fib_dr *) p_entry->p_node;
+
+                printf ("  Stuck route: VRF %d, Prefix: %s/%d, Reason: %s, Attempts: %d\r\n",
+                        p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
+                        p_dr->prefix_len, ga_fib_retry_reason_name [p_entry->reason],
+                        p_entry->num_attempts);
+            } else {
+                t_fib_nh *p_nh = (t_fib_nh *) p_entry->p_node;
+
+                printf ("  Stuck host: VRF %d, Addr: %s, Interface: %d, Reason: %s, "
+                        "Attempts: %d\r\n", p_nh->vrf_id,
+                        FIB_IP_ADDR_TO_STR (&p_nh->key.ip_addr), p_nh->key.if_index,
+                        ga_fib_retry_reason_name [p_entry->reason], p_entry->num_attempts);
+            }
+        }
+        p_entry = (t_fib_retry_entry *) std_dll_getnext (fib_get_retry_list (), &p_entry->glue);
+    }
+}
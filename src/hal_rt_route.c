@@ -45,6 +45,7 @@ dn_hal_route_err hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr) {
     t_fib_tunnel_fh *p_tunnel_fh = NULL;
     t_fib_nh_holder nh_holder1;
     t_fib_tunnel_dr_fh *p_tunnel_dr_fh = NULL;
+    t_fib_nh *p_indirect_nh = NULL;
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
             "VRF %d. Prefix: %s/%d, num_fh: %d%s\r\n", vrf_id,
@@ -58,6 +59,15 @@ dn_hal_route_err hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr) {
         return DN_HAL_ROUTE_E_PARAM;
     }
 
+    /*
+     * Hierarchical FIB: route resolved through a single recursive NH
+     * points to the indirect group of the NH.
+     */
+    p_indirect_nh = hal_fib_get_indirect_nh(p_dr);
+    if (p_indirect_nh != NULL) {
+        return hal_fib_indirect_route_add(vrf_id, p_dr, p_indirect_nh);
+    }
+
     /*
      * ECMP case
      */
@@ -138,6 +148,9 @@ dn_hal_route_err hal_fib_route_del(uint32_t vrf_id, t_fib_dr *p_dr) {
         return DN_HAL_ROUTE_E_PARAM;
     }
 
+    /* The route may have a queued write in a route batch */
+    hal_rt_route_bulk_sync_dr(p_dr);
+
     hal_fib_set_all_dr_fh_to_un_written(p_dr);
 
     if (p_dr->ecmp_handle_created == false) {
@@ -188,11 +201,12 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
     t_fib_tunnel_dr_fh *p_tunnel_dr_fh = NULL;
     npu_id_t npu_id = 0;
     ndi_route_t route_entry;
-    ndi_neighbor_t nbr_entry;
     t_std_error rc;
     bool error_occured = false;
+    bool is_table_full = false;
     bool rif_update = false;
-    hal_ifindex_t  if_index;
+    bool is_fh_nh_obj = false;
+    hal_ifindex_t  if_index = 0;
 
     if (p_dr_fh != NULL) {
         p_fh = FIB_GET_FH_FROM_DRFH(p_dr_fh);
@@ -216,34 +230,9 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
                     return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
                 }
             }
-        } else {
-            nh_handle = p_fh->next_hop_id;
-
-            if (nh_handle == 0) {
-                EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
-                        "nh_handle is NULL. Creating..!!" "if_index %d Vrf_id: %d.\r\n",
-                        p_fh->key.if_index, vrf_id);
-                //@Todo, Handle multi-npu case
-                rif_id = hal_rif_index_get(npu_id, vrf_id, p_fh->key.if_index);
-                EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
-                        "RIF ID %d!" "Vrf_id: %d.\r\n", rif_id, vrf_id);
-
-                memset(&nbr_entry, 0, sizeof(nbr_entry));
-                if (hal_form_nbr_entry(&nbr_entry, p_fh) == STD_ERR_OK) {
-                    nbr_entry.rif_id = rif_id;
-                    /*
-                     * NDI Nexthop add API & Neighbor API uses the same ndi_neighbor_t
-                     * data structure. A next-hop id is created for the route next-hop
-                     * and passed as an index to NDI/SAI.
-                     */
-                    if (ndi_route_next_hop_add(&nbr_entry, &nh_handle) != STD_ERR_OK) {
-                        return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
-                    }
-                    p_fh->next_hop_id = nh_handle;
-                }
-                rif_update = true;
-                if_index = p_fh->key.if_index;
-            }
+        } else if (!FIB_IS_NH_ZERO(p_fh)) {
+            /* The next hop object of the FH is got per NPU below */
+            is_fh_nh_obj = true;
         }
 
         *p_status = FIB_DRFH_STATUS_UNWRITTEN;
@@ -280,31 +269,27 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
             EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                     "RIF ID %d, Vrf_id: %d.\r\n", rif_id, vrf_id);
 
-            memset(&nbr_entry, 0, sizeof(nbr_entry));
-            if (hal_form_nbr_entry(&nbr_entry, p_nh) == STD_ERR_OK) {
-                nbr_entry.rif_id = rif_id;
-                if (p_nh->next_hop_id == 0) {
-                    if (ndi_route_next_hop_add(&nbr_entry, &nh_handle) != STD_ERR_OK) {
-                        return STD_ERR_MK(e_std_err_ROUTE, e_std_err_code_FAIL, 0);
-                    }
-                    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
-                                 "Created nh handle %d..!!" "Vrf_id: %d.\r\n", nh_handle, vrf_id);
-                    p_nh->next_hop_id = nh_handle;
-                } else {
-                    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
-                                 "nh handle already exists %d..!!" "Vrf_id: %d.\r\n",
-                                 p_nh->next_hop_id, vrf_id);
-                    nh_handle = p_nh->next_hop_id;
+            if (!FIB_IS_NH_ZERO(p_nh)) {
+                if (hal_rt_nh_obj_get(p_nh, npu_id, &nh_handle) != STD_ERR_OK) {
+                    error_occured = true;
+                    break;
                 }
                 route_entry.action = NDI_ROUTE_PACKET_ACTION_FORWARD;
             } else {
                 EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
                              "NH IP Zero, Vrf_id: %d.\r\n", vrf_id);
+                /* The RIF reference of the route is taken for the trap only */
                 route_entry.action = NDI_ROUTE_PACKET_ACTION_TRAPCPU;
+                rif_update = true;
+                if_index = p_nh->key.if_index;
             }
-            rif_update = true;
-            if_index = p_nh->key.if_index;
         } else {
+            if ((is_fh_nh_obj) &&
+                (hal_rt_nh_obj_get(p_fh, npu_id, &nh_handle) != STD_ERR_OK)) {
+                error_occured = true;
+                break;
+            }
+
             if (STD_IP_IS_ADDR_LINK_LOCAL(&(p_fh->key.ip_addr))) {
                 //@TODO Handle IPv6 case
             } else if (FIB_IS_FH_IP_TUNNEL(p_fh)) {
@@ -326,13 +311,14 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
         route_entry.nh_handle = nh_handle;
         hal_dump_route_entry(&route_entry);
         if (!p_dr->a_is_written[npu_id]) {
-            rc = ndi_route_add(&route_entry);
+            rc = hal_rt_route_ndi_add(&route_entry, p_dr, rif_update, if_index);
             if (rc != STD_ERR_OK) {
                 EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                         "Route Add: Failed. VRF %d. Prefix: %s/%d: " "NH Handle %d\r\n",
                         vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                         p_dr->prefix_len, route_entry.nh_handle);
 
+                is_table_full = hal_rt_ndi_rc_is_table_full(rc);
                 error_occured = true;
                 break;
             } else {
@@ -349,9 +335,28 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
                         vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix),
                         p_dr->prefix_len, route_entry.nh_handle, rif_id);
             }
-        } else if (p_dr->nh_handle != nh_handle) {
+        } else if (hal_rt_route_shadow_is_same(p_dr, &route_entry)) {
+            /*
+             * This case is hit when ARP is re-resolved and DR thread walks
+             * over the existing routes. If there is no change in the route
+             * entry or nh handle, just return success..
+             */
+            EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI(RT-END)",
+                    "Route already programmed!\r\n");
+        } else if (hal_rt_route_shadow_is_nh_same(p_dr, &route_entry)) {
+            /* Only the action of the route changed */
+            route_entry.flags = NDI_ROUTE_L3_PACKET_ACTION;
+            rc = hal_rt_route_ndi_set(&route_entry, p_dr, false, 0);
+            if (rc != STD_ERR_OK) {
+                EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                        "Route Attribute action set failed.Unit: %d, " "Err: %d\r\n",
+                        npu_id, rc);
+                error_occured = true;
+                break;
+            }
+        } else {
             route_entry.flags = NDI_ROUTE_L3_NEXT_HOP_ID;
-            rc = ndi_route_set_attribute(&route_entry);
+            rc = hal_rt_route_ndi_set(&route_entry, p_dr, rif_update, if_index);
             if (rc != STD_ERR_OK) {
                 EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
                         "Route Attribute Nexthop ID set failed.Unit: %d, " "Err: %d\r\n",
@@ -366,16 +371,11 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
             p_dr->nh_handle = nh_handle;
             if(rif_update)
                 hal_rt_rif_ref_inc(if_index);
-        } else {
-            /*
-             * This case is hit when ARP is re-resolved and DR thread walks
-             * over the existing routes. If there is no change in the route
-             * entry or nh handle, just return success..
-             */
-            EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI(RT-END)",
-                    "Route already programmed!\r\n");
         }
 
+        /* Route is not pointing to an indirect group anymore */
+        hal_rt_set_dr_indirect_mp_obj(p_dr, npu_id, NULL);
+
         /*
          * After successful programming the non-ECMP route, check for
          * whether the route was previously an ECMP route and then remove it from
@@ -411,7 +411,7 @@ dn_hal_route_err _hal_fib_route_add(uint32_t vrf_id, t_fib_dr *p_dr,
 
     if (error_occured == true) {
         hal_fib_route_del(vrf_id, p_dr);
-        return DN_HAL_ROUTE_E_FAIL;
+        return ((is_table_full) ? DN_HAL_ROUTE_E_FULL : DN_HAL_ROUTE_E_FAIL);
     }
 
     if (p_dr_fh != NULL) {
@@ -456,6 +456,8 @@ dn_hal_route_err _hal_fib_route_del(uint32_t vrf_id, t_fib_dr *p_dr) {
         }
 
         p_dr->a_is_written[npu_id] = false;
+        hal_rt_route_shadow_clear(p_dr, npu_id);
+        hal_rt_set_dr_indirect_mp_obj(p_dr, npu_id, NULL);
     }
 
     return DN_HAL_ROUTE_E_NONE;
@@ -0,0 +1,561 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_route_bulk.c
+ * \brief  Bulk route programming from the DR walker
+ *
+ * While the DR walker has a batch open, the route create and next hop set
+ * operations are queued instead of being written to the NPU one by one.
+ * The route is updated as if the write is successful, and the batch is
+ * written with one bulk NDI call per operation when it is full, when the
+ * operation changes and before the walker releases the L3 lock. The routes
+ * that failed in the bulk call are deleted from the NPU and marked as not
+ * written, as on a failed per route call. The routes a failed bulk call
+ * did not get to, and the whole batch if NDI does not have the bulk route
+ * APIs, are written with per route calls. The batch is kept
+ * per NPU and the NPUs are written in parallel by the NPU workers.
+ *
+ * At the end of a walk the batch is handed to the programming thread and
+ * the walker releases the L3 lock while it is written. The next batch is
+ * filled meanwhile, one batch is in flight at a time. The results of the
+ * batch in flight are applied by the walker at its next walk, and right
+ * away by any caller that deletes, frees or directly writes a route of it.
+ *
+ * The batches are kept per AF and are guarded by the L3 lock of the AF,
+ * the routes of the AFs are queued and written independently.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_api.h"
+#include "hal_rt_util.h"
+#include "hal_rt_mpath_grp.h"
+#include "hal_rt_ndi_opt.h"
+#include "event_log.h"
+#include "std_error_codes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef t_std_error (*t_fib_ndi_route_bulk_fn) (ndi_route_t *p_route_entry, size_t count,
+                                                t_std_error *p_status);
+
+typedef enum {
+    FIB_ROUTE_BULK_OP_NONE = 0,
+    FIB_ROUTE_BULK_OP_ADD,
+    FIB_ROUTE_BULK_OP_SET,
+} t_fib_route_bulk_op;
+
+typedef struct _t_fib_route_bulk_entry {
+    t_fib_dr       *p_dr;
+    bool            is_rif_update;
+    hal_ifindex_t   if_index;
+} t_fib_route_bulk_entry;
+
+typedef struct _t_fib_route_bulk_stats {
+    uint32_t  num_batches;
+    uint32_t  num_routes;
+    uint32_t  num_failed;
+    uint32_t  num_sync;
+    /* Updated by the NPU workers */
+    uint32_t  a_num_bulk_calls [HAL_RT_MAX_INSTANCE];
+    uint32_t  a_num_per_route_calls [HAL_RT_MAX_INSTANCE];
+} t_fib_route_bulk_stats;
+
+typedef struct _t_fib_route_batch {
+    t_fib_route_bulk_stats *p_stats;
+    t_fib_route_bulk_op     op;
+    uint32_t                num_routes;
+    uint32_t                a_count [HAL_RT_MAX_INSTANCE];
+    ndi_route_t             a_ndi [HAL_RT_MAX_INSTANCE][HAL_RT_ROUTE_BULK_MAX_SIZE];
+    t_std_error             a_status [HAL_RT_MAX_INSTANCE][HAL_RT_ROUTE_BULK_MAX_SIZE];
+    t_fib_route_bulk_entry  a_entry [HAL_RT_MAX_INSTANCE][HAL_RT_ROUTE_BULK_MAX_SIZE];
+    t_hal_rt_pgm_job        job;
+} t_fib_route_batch;
+
+/* The bulk state of an AF, allocated at the first walk of the AF */
+typedef struct _t_fib_route_bulk {
+    t_fib_route_batch       a_batch [2];
+    t_fib_route_batch      *p_batch;             /* Being filled */
+    t_fib_route_batch      *p_batch_in_flight;
+    bool                    is_open;
+    bool                    is_flushing;
+    t_fib_route_bulk_stats  stats;
+} t_fib_route_bulk;
+
+static t_fib_route_bulk       *gap_fib_route_bulk [FIB_MAX_AFINDEX];
+
+static bool                    g_fib_ndi_route_bulk_resolved = false;
+static t_fib_ndi_route_bulk_fn g_fib_ndi_route_bulk_add = NULL;
+static t_fib_ndi_route_bulk_fn g_fib_ndi_route_bulk_set = NULL;
+
+/*
+ * The bulk route APIs are optional NDI APIs, they are not there in the
+ * older NDI versions.
+ */
+static void fib_resolve_ndi_route_bulk_fn (void)
+{
+    if (g_fib_ndi_route_bulk_resolved)
+        return;
+
+    g_fib_ndi_route_bulk_add = ndi_route_bulk_add;
+    g_fib_ndi_route_bulk_set = ndi_route_bulk_set_attribute;
+    g_fib_ndi_route_bulk_resolved = true;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+            "NDI bulk route add: %s, set: %s\r\n",
+            (g_fib_ndi_route_bulk_add != NULL) ? "available" : "not available",
+            (g_fib_ndi_route_bulk_set != NULL) ? "available" : "not available");
+}
+
+static uint32_t fib_get_route_bulk_size (void)
+{
+    uint32_t size = hal_rt_access_fib_config()->route_bulk_size;
+
+    return ((size < HAL_RT_ROUTE_BULK_MAX_SIZE) ? size : HAL_RT_ROUTE_BULK_MAX_SIZE);
+}
+
+static bool fib_is_dr_in_route_batch (t_fib_route_batch *p_batch, t_fib_dr *p_dr,
+                                      npu_id_t npu_id)
+{
+    uint32_t index;
+
+    if (p_batch == NULL)
+        return false;
+
+    for (index = 0; index < p_batch->a_count [npu_id]; index++) {
+        if (p_batch->a_entry [npu_id][index].p_dr == p_dr)
+            return true;
+    }
+    return false;
+}
+
+static t_fib_route_bulk *fib_get_route_bulk (uint8_t af_index)
+{
+    return ((af_index < FIB_MAX_AFINDEX) ? gap_fib_route_bulk [af_index] : NULL);
+}
+
+static t_fib_route_bulk *fib_alloc_route_bulk (uint8_t af_index)
+{
+    t_fib_route_bulk *p_bulk;
+
+    if (af_index >= FIB_MAX_AFINDEX)
+        return NULL;
+
+    if (gap_fib_route_bulk [af_index] != NULL)
+        return gap_fib_route_bulk [af_index];
+
+    p_bulk = (t_fib_route_bulk *) calloc (1, sizeof (t_fib_route_bulk));
+    if (p_bulk == NULL) {
+        EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+                "Failed to allocate the route batches, routes are written one by one. "
+                "AF: %d\r\n", af_index);
+        return NULL;
+    }
+
+    p_bulk->a_batch [0].p_stats = &p_bulk->stats;
+    p_bulk->a_batch [1].p_stats = &p_bulk->stats;
+    p_bulk->p_batch = &p_bulk->a_batch [0];
+    gap_fib_route_bulk [af_index] = p_bulk;
+
+    return p_bulk;
+}
+
+static bool fib_is_dr_in_route_bulk (t_fib_route_bulk *p_bulk, t_fib_dr *p_dr,
+                                     npu_id_t npu_id)
+{
+    return ((fib_is_dr_in_route_batch (p_bulk->p_batch, p_dr, npu_id)) ||
+            (fib_is_dr_in_route_batch (p_bulk->p_batch_in_flight, p_dr, npu_id)));
+}
+
+/*
+ * Same handling as a failed per route call in the route add functions,
+ * the route is deleted from all the NPUs and marked as not written.
+ */
+static void fib_route_bulk_entry_failed (t_fib_route_batch *p_batch, npu_id_t unit,
+                                         uint32_t index)
+{
+    t_fib_route_bulk_entry *p_entry = &p_batch->a_entry [unit][index];
+    ndi_route_t            *p_route_entry = &p_batch->a_ndi [unit][index];
+    t_fib_dr               *p_dr = p_entry->p_dr;
+
+    EV_LOG_ERR(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "Bulk Route %s: Failed. VRF %d. Prefix: %s/%d, NH Handle %d, "
+            "Unit: %d, Err: %d\r\n", (p_batch->op == FIB_ROUTE_BULK_OP_ADD) ? "Add" : "Update",
+            p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+            p_route_entry->nh_handle, unit, p_batch->a_status [unit][index]);
+
+    p_batch->p_stats->num_failed++;
+
+    if (p_batch->op == FIB_ROUTE_BULK_OP_ADD)
+        p_dr->a_is_written [unit] = false;
+    hal_rt_route_shadow_clear (p_dr, unit);
+
+    if (p_entry->is_rif_update)
+        hal_rt_rif_ref_dec (p_entry->if_index);
+
+    hal_fib_route_del (p_dr->vrf_id, p_dr);
+
+    if (FIB_IS_DR_WRITTEN (p_dr))
+    {
+        p_dr->status_flag &= ~FIB_DR_STATUS_WRITTEN;
+
+        FIB_DECR_CNTRS_CAM_ROUTE_ENTRIES (p_dr->vrf_id, p_dr->key.prefix.af_index);
+        hal_rt_cam_route_del (p_dr);
+    }
+
+    /* Written again when table entries are freed */
+    if (p_batch->op == FIB_ROUTE_BULK_OP_ADD)
+        hal_rt_cam_write_failed (hal_rt_cam_get_route_cam (p_dr->key.prefix.af_index,
+                                                           p_dr->prefix_len),
+                                 hal_rt_ndi_rc_is_table_full (p_batch->a_status [unit][index]));
+    hal_rt_retry_dr_add (p_dr, HAL_RT_RETRY_RSN_NDI_FAIL);
+    fib_check_threshold_for_all_cams (false);
+}
+
+static t_std_error fib_route_batch_write_entry (t_fib_route_batch *p_batch, npu_id_t unit,
+                                                uint32_t index)
+{
+    return ((p_batch->op == FIB_ROUTE_BULK_OP_ADD) ?
+            ndi_route_add (&p_batch->a_ndi [unit][index]) :
+            ndi_route_set_attribute (&p_batch->a_ndi [unit][index]));
+}
+
+/*
+ * Run by the NPU workers, the batch of the unit is written to the unit.
+ */
+static void fib_route_batch_write_unit (npu_id_t unit, void *p_arg)
+{
+    t_fib_route_batch       *p_batch = (t_fib_route_batch *) p_arg;
+    t_fib_ndi_route_bulk_fn  bulk_fn;
+    uint32_t                 count = p_batch->a_count [unit];
+    uint32_t                 index;
+    t_std_error              rc = STD_ERR_OK;
+
+    if (count == 0)
+        return;
+
+    bulk_fn = (p_batch->op == FIB_ROUTE_BULK_OP_ADD) ?
+              g_fib_ndi_route_bulk_add : g_fib_ndi_route_bulk_set;
+
+    if (bulk_fn != NULL) {
+        for (index = 0; index < count; index++)
+            p_batch->a_status [unit][index] = HAL_RT_NDI_BULK_STATUS_NOT_DONE;
+
+        rc = bulk_fn (p_batch->a_ndi [unit], count, p_batch->a_status [unit]);
+        p_batch->p_stats->a_num_bulk_calls [unit]++;
+
+        EV_LOG_TRACE(ev_log_t_ROUTE, 2, "HAL-RT-NDI",
+                "Bulk Route %s: %d routes, Unit: %d, Err: %d\r\n",
+                (p_batch->op == FIB_ROUTE_BULK_OP_ADD) ? "Add" : "Update", count, unit, rc);
+
+        /* The routes not done by a failed bulk call are written one by one */
+        for (index = 0; index < count; index++) {
+            if (p_batch->a_status [unit][index] != HAL_RT_NDI_BULK_STATUS_NOT_DONE)
+                continue;
+
+            if (rc == STD_ERR_OK) {
+                p_batch->a_status [unit][index] = STD_ERR_OK;
+                continue;
+            }
+            p_batch->a_status [unit][index] = fib_route_batch_write_entry (p_batch, unit, index);
+            p_batch->p_stats->a_num_per_route_calls [unit]++;
+        }
+    } else {
+        for (index = 0; index < count; index++)
+            p_batch->a_status [unit][index] = fib_route_batch_write_entry (p_batch, unit, index);
+        p_batch->p_stats->a_num_per_route_calls [unit] += count;
+    }
+}
+
+/*
+ * Applies the results of the batch in flight, if it is written or the
+ * caller waits for it.
+ */
+static void fib_route_bulk_complete (t_fib_route_bulk *p_bulk, bool wait)
+{
+    t_fib_route_batch *p_batch = p_bulk->p_batch_in_flight;
+    npu_id_t           unit;
+    uint32_t           index;
+
+    if (p_batch == NULL)
+        return;
+
+    if ((!wait) && (hal_rt_pgm_is_pending (&p_batch->job)))
+        return;
+
+    hal_rt_pgm_wait (&p_batch->job);
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        for (index = 0; index < p_batch->a_count [unit]; index++) {
+            if (p_batch->a_status [unit][index] != STD_ERR_OK)
+                fib_route_bulk_entry_failed (p_batch, unit, index);
+        }
+        p_batch->a_count [unit] = 0;
+    }
+
+    p_batch->num_routes = 0;
+    p_batch->op = FIB_ROUTE_BULK_OP_NONE;
+    p_bulk->p_batch_in_flight = NULL;
+}
+
+/*
+ * The batch being filled is handed to the programming thread, after the
+ * batch in flight is complete.
+ */
+static void fib_route_bulk_dispatch (t_fib_route_bulk *p_bulk)
+{
+    t_fib_route_batch *p_batch = p_bulk->p_batch;
+
+    if (p_batch->num_routes == 0)
+        return;
+
+    fib_route_bulk_complete (p_bulk, true);
+    fib_resolve_ndi_route_bulk_fn ();
+
+    p_bulk->stats.num_batches++;
+    p_bulk->stats.num_routes += p_batch->num_routes;
+
+    p_bulk->p_batch_in_flight = p_batch;
+    p_bulk->p_batch = (p_batch == &p_bulk->a_batch [0]) ?
+                      &p_bulk->a_batch [1] : &p_bulk->a_batch [0];
+
+    p_batch->job.job_fn = fib_route_batch_write_unit;
+    p_batch->job.p_arg  = p_batch;
+    hal_rt_pgm_submit (&p_batch->job);
+}
+
+static void fib_route_bulk_flush (t_fib_route_bulk *p_bulk)
+{
+    if (p_bulk->is_flushing)
+        return;
+
+    if ((p_bulk->p_batch->num_routes == 0) && (p_bulk->p_batch_in_flight == NULL))
+        return;
+
+    p_bulk->is_flushing = true;
+
+    fib_route_bulk_dispatch (p_bulk);
+    fib_route_bulk_complete (p_bulk, true);
+
+    p_bulk->is_flushing = false;
+}
+
+/*
+ * Writes the queued routes of the AF and applies the results before
+ * returning.
+ */
+void hal_rt_route_bulk_flush (uint8_t af_index)
+{
+    t_fib_route_bulk *p_bulk = fib_get_route_bulk (af_index);
+
+    if (p_bulk != NULL)
+        fib_route_bulk_flush (p_bulk);
+}
+
+/*
+ * Called before the route is written directly or read back from the NPU,
+ * the queued writes of the route are done first.
+ */
+void hal_rt_route_bulk_sync_dr (t_fib_dr *p_dr)
+{
+    t_fib_route_bulk *p_bulk = fib_get_route_bulk (p_dr->key.prefix.af_index);
+    npu_id_t          unit;
+
+    if (p_bulk == NULL)
+        return;
+
+    for (unit = 0; unit < hal_rt_access_fib_config()->max_num_npu; unit++) {
+        if (fib_is_dr_in_route_bulk (p_bulk, p_dr, unit)) {
+            p_bulk->stats.num_sync++;
+            fib_route_bulk_flush (p_bulk);
+            return;
+        }
+    }
+}
+
+/*
+ * Returns true if the route operation is queued. The caller then updates
+ * the route as on a successful write.
+ */
+static bool fib_route_bulk_queue (t_fib_route_bulk_op op, ndi_route_t *p_route_entry,
+                                  t_fib_dr *p_dr, bool is_rif_update, hal_ifindex_t if_index)
+{
+    t_fib_route_bulk  *p_bulk = fib_get_route_bulk (p_dr->key.prefix.af_index);
+    t_fib_route_batch *p_batch;
+    uint32_t           bulk_size = fib_get_route_bulk_size ();
+    npu_id_t           unit = p_route_entry->npu_id;
+    uint32_t           index;
+
+    if ((p_bulk == NULL) || (!p_bulk->is_open) || (p_bulk->is_flushing) || (bulk_size <= 1) ||
+        (unit >= HAL_RT_MAX_INSTANCE))
+        return false;
+
+    /*
+     * Keep the order of the operations and of the updates of a route. A full
+     * batch is written before the next route, not in the middle of the route
+     * add that filled it, as the caller marks the route written after it.
+     */
+    if ((p_bulk->p_batch->num_routes != 0) &&
+        ((p_bulk->p_batch->op != op) || (p_bulk->p_batch->a_count [unit] >= bulk_size)))
+        fib_route_bulk_flush (p_bulk);
+    else if (fib_is_dr_in_route_bulk (p_bulk, p_dr, unit))
+        fib_route_bulk_flush (p_bulk);
+
+    p_batch = p_bulk->p_batch;
+    index   = p_batch->a_count [unit];
+
+    memcpy (&p_batch->a_ndi [unit][index], p_route_entry, sizeof (ndi_route_t));
+    p_batch->a_entry [unit][index].p_dr          = p_dr;
+    p_batch->a_entry [unit][index].is_rif_update = is_rif_update;
+    p_batch->a_entry [unit][index].if_index      = if_index;
+    p_batch->a_count [unit]++;
+    p_batch->num_routes++;
+    p_batch->op = op;
+
+    return true;
+}
+
+t_std_error hal_rt_route_ndi_add (ndi_route_t *p_route_entry, t_fib_dr *p_dr,
+                                  bool is_rif_update, hal_ifindex_t if_index)
+{
+    t_std_error rc = STD_ERR_OK;
+
+    if (!fib_route_bulk_queue (FIB_ROUTE_BULK_OP_ADD, p_route_entry, p_dr,
+                               is_rif_update, if_index)) {
+        hal_rt_route_bulk_sync_dr (p_dr);
+        rc = ndi_route_add (p_route_entry);
+    }
+
+    if (rc == STD_ERR_OK)
+        hal_rt_route_shadow_set (p_dr, p_route_entry);
+
+    return rc;
+}
+
+/*
+ * The next hop of a route is updated in bulk only if the old next hop is
+ * not a group, a group is deleted right after the route moves away from it.
+ */
+t_std_error hal_rt_route_ndi_set (ndi_route_t *p_route_entry, t_fib_dr *p_dr,
+                                  bool is_rif_update, hal_ifindex_t if_index)
+{
+    t_fib_hal_dr_info *p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+    t_std_error        rc = STD_ERR_OK;
+
+    if ((p_dr->ecmp_handle_created) || (p_hal_dr_info == NULL) ||
+        (p_hal_dr_info->ap_indirect_mp_obj [p_route_entry->npu_id] != NULL) ||
+        (!fib_route_bulk_queue (FIB_ROUTE_BULK_OP_SET, p_route_entry, p_dr,
+                                is_rif_update, if_index))) {
+        hal_rt_route_bulk_sync_dr (p_dr);
+        rc = ndi_route_set_attribute (p_route_entry);
+    }
+
+    if (rc == STD_ERR_OK)
+        hal_rt_route_shadow_set (p_dr, p_route_entry);
+
+    return rc;
+}
+
+/*
+ * The results of the batch written since the last walk are applied first.
+ * The routes are written one by one if the batches of the AF could not be
+ * allocated.
+ */
+void hal_rt_route_bulk_begin (uint8_t af_index)
+{
+    t_fib_route_bulk *p_bulk = fib_alloc_route_bulk (af_index);
+
+    if (p_bulk == NULL)
+        return;
+
+    p_bulk->is_flushing = true;
+    fib_route_bulk_complete (p_bulk, false);
+    p_bulk->is_flushing = false;
+
+    p_bulk->is_open = true;
+}
+
+/*
+ * The queued routes are handed to the programming thread, the walker does
+ * not wait for them to be written.
+ */
+void hal_rt_route_bulk_end (uint8_t af_index)
+{
+    t_fib_route_bulk *p_bulk = fib_get_route_bulk (af_index);
+
+    if (p_bulk == NULL)
+        return;
+
+    p_bulk->is_flushing = true;
+    fib_route_bulk_dispatch (p_bulk);
+    p_bulk->is_flushing = false;
+
+    p_bulk->is_open = false;
+}
+
+/*
+ * Called by the walker without the L3 lock of the AF when it is done with
+ * all the VRFs, the walker then flushes under the lock to apply the results.
+ */
+void hal_rt_route_bulk_wait (uint8_t af_index)
+{
+    t_fib_route_bulk  *p_bulk = fib_get_route_bulk (af_index);
+    t_fib_route_batch *p_batch = (p_bulk != NULL) ? p_bulk->p_batch_in_flight : NULL;
+
+    if (p_batch != NULL)
+        hal_rt_pgm_wait (&p_batch->job);
+}
+
+void fib_dump_route_bulk_stats (void)
+{
+    t_fib_route_bulk *p_bulk;
+    uint32_t          num_bulk_calls;
+    uint32_t          num_per_route_calls;
+    npu_id_t          unit;
+    uint8_t           af_index;
+
+    fib_resolve_ndi_route_bulk_fn ();
+
+    printf ("**************************************************\r\n");
+    printf ("  route_bulk_size       :  %d\r\n", fib_get_route_bulk_size ());
+    printf ("  ndi_bulk_add          :  %d\r\n", (g_fib_ndi_route_bulk_add != NULL));
+    printf ("  ndi_bulk_set          :  %d\r\n", (g_fib_ndi_route_bulk_set != NULL));
+
+    for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+        if ((p_bulk = fib_get_route_bulk (af_index)) == NULL)
+            continue;
+
+        num_bulk_calls = 0;
+        num_per_route_calls = 0;
+        for (unit = 0; unit < HAL_RT_MAX_INSTANCE; unit++) {
+            num_bulk_calls      += p_bulk->stats.a_num_bulk_calls [unit];
+            num_per_route_calls += p_bulk->stats.a_num_per_route_calls [unit];
+        }
+
+        printf ("  AF %d\r\n", af_index);
+        printf ("    num_batches         :  %d\r\n", p_bulk->stats.num_batches);
+        printf ("    num_routes          :  %d\r\n", p_bulk->stats.num_routes);
+        printf ("    num_bulk_calls      :  %d\r\n", num_bulk_calls);
+        printf ("    num_per_route_calls :  %d\r\n", num_per_route_calls);
+        printf ("    num_failed          :  %d\r\n", p_bulk->stats.num_failed);
+        printf ("    num_sync            :  %d\r\n", p_bulk->stats.num_sync);
+        printf ("    is_in_flight        :  %d\r\n", (p_bulk->p_batch_in_flight != NULL));
+    }
+    printf ("**************************************************\r\n");
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * \file   hal_rt_shadow.c
+ * \brief  Shadow of the routes and neighbors written to the NPUs
+ *
+ * The action and next hop of a route and the action, RIF and egress of a
+ * neighbor are saved per NPU when they are written, queued writes included,
+ * and cleared when they are deleted. A route or neighbor that is resolved
+ * again to the same state is not written again. A write that fails deletes
+ * the entry, so the shadow is never more recent than the NPU. The route
+ * shadow holds the reference of the route on its next hop object.
+ */
+
+#include "hal_rt_main.h"
+#include "hal_rt_route.h"
+#include "hal_rt_api.h"
+#include "hal_rt_mpath_grp.h"
+#include "event_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct _t_fib_shadow_stats {
+    uint32_t  num_route_writes;
+    uint32_t  num_route_writes_suppressed;
+    uint32_t  num_nbr_writes;
+    uint32_t  num_nbr_writes_suppressed;
+} t_fib_shadow_stats;
+
+/* Counted by the writers of all the AFs */
+static t_fib_shadow_stats g_fib_shadow_stats;
+
+static t_fib_route_shadow *fib_get_route_shadow (t_fib_dr *p_dr, npu_id_t unit)
+{
+    t_fib_hal_dr_info *p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+
+    if ((p_hal_dr_info == NULL) || (unit >= hal_rt_access_fib_config()->max_num_npu))
+        return NULL;
+
+    return &p_hal_dr_info->a_shadow [unit];
+}
+
+const t_fib_route_shadow *hal_rt_route_shadow_get (t_fib_dr *p_dr, npu_id_t unit)
+{
+    return fib_get_route_shadow (p_dr, unit);
+}
+
+/*
+ * Returns true if the route is written to the unit as in the route entry,
+ * the write is then suppressed by the caller.
+ */
+bool hal_rt_route_shadow_is_same (t_fib_dr *p_dr, ndi_route_t *p_route_entry)
+{
+    t_fib_route_shadow *p_shadow = fib_get_route_shadow (p_dr, p_route_entry->npu_id);
+
+    if ((p_shadow == NULL) || (!p_shadow->is_valid) ||
+        (!p_dr->a_is_written [p_route_entry->npu_id]) ||
+        (p_shadow->action != (uint32_t) p_route_entry->action) ||
+        (p_shadow->nh_handle != p_route_entry->nh_handle))
+        return false;
+
+    FIB_CNTRS_ADD (g_fib_shadow_stats.num_route_writes_suppressed, 1);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "Route write suppressed. VRF %d. Prefix: %s/%d, NH Handle %d, Unit: %d\r\n",
+            p_dr->vrf_id, FIB_IP_ADDR_TO_STR (&p_dr->key.prefix), p_dr->prefix_len,
+            p_route_entry->nh_handle, p_route_entry->npu_id);
+    return true;
+}
+
+/*
+ * Returns true if the route is written to the unit with the next hop of
+ * the route entry, only its action may differ.
+ */
+bool hal_rt_route_shadow_is_nh_same (t_fib_dr *p_dr, ndi_route_t *p_route_entry)
+{
+    t_fib_route_shadow *p_shadow = fib_get_route_shadow (p_dr, p_route_entry->npu_id);
+
+    return ((p_shadow != NULL) && (p_shadow->is_valid) &&
+            (p_dr->a_is_written [p_route_entry->npu_id]) &&
+            (p_shadow->nh_handle == p_route_entry->nh_handle));
+}
+
+void hal_rt_route_shadow_set (t_fib_dr *p_dr, ndi_route_t *p_route_entry)
+{
+    t_fib_route_shadow *p_shadow = fib_get_route_shadow (p_dr, p_route_entry->npu_id);
+
+    if (p_shadow == NULL)
+        return;
+
+    /* The route holds a reference on the next hop object it points to */
+    if ((!p_shadow->is_valid) || (p_shadow->nh_handle != p_route_entry->nh_handle)) {
+        if (p_shadow->is_valid)
+            hal_rt_nh_obj_unref (p_route_entry->npu_id, p_shadow->nh_handle);
+        hal_rt_nh_obj_ref (p_route_entry->npu_id, p_route_entry->nh_handle);
+    }
+
+    p_shadow->is_valid  = true;
+    p_shadow->action    = (uint32_t) p_route_entry->action;
+    p_shadow->nh_handle = p_route_entry->nh_handle;
+
+    FIB_CNTRS_ADD (g_fib_shadow_stats.num_route_writes, 1);
+}
+
+void hal_rt_route_shadow_clear (t_fib_dr *p_dr, npu_id_t unit)
+{
+    t_fib_route_shadow *p_shadow = fib_get_route_shadow (p_dr, unit);
+
+    if (p_shadow == NULL)
+        return;
+
+    if (p_shadow->is_valid)
+        hal_rt_nh_obj_unref (unit, p_shadow->nh_handle);
+
+    memset (p_shadow, 0, sizeof (t_fib_route_shadow));
+}
+
+/*
+ * Returns true if the host is written to the unit as in the neighbor
+ * entry, the delete and add of the host are then suppressed by the caller.
+ */
+bool hal_rt_nbr_shadow_is_same (t_fib_nh *p_fh, ndi_neighbor_t *p_nbr_entry)
+{
+    t_fib_nbr_shadow *p_shadow;
+
+    if (p_nbr_entry->npu_id >= hal_rt_access_fib_config()->max_num_npu)
+        return false;
+
+    p_shadow = &p_fh->a_nbr_shadow [p_nbr_entry->npu_id];
+
+    if ((!p_shadow->is_valid) || (!p_fh->a_is_written [p_nbr_entry->npu_id]) ||
+        (p_shadow->action != (uint32_t) p_nbr_entry->action) ||
+        (p_shadow->rif_id != p_nbr_entry->rif_id) ||
+        (p_shadow->vlan_id != (uint32_t) p_nbr_entry->egress_data.vlan_id) ||
+        (p_shadow->port_tgid != (uint32_t) p_nbr_entry->egress_data.port_tgid) ||
+        (memcmp (p_shadow->mac_addr, &p_nbr_entry->egress_data.neighbor_mac,
+                 HAL_RT_MAC_ADDR_LEN)))
+        return false;
+
+    FIB_CNTRS_ADD (g_fib_shadow_stats.num_nbr_writes_suppressed, 1);
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "HAL-RT-NDI",
+            "Host write suppressed. VRF %d. Addr: %s, Interface: %d, Unit: %d\r\n",
+            p_fh->vrf_id, FIB_IP_ADDR_TO_STR (&p_fh->key.ip_addr), p_fh->key.if_index,
+            p_nbr_entry->npu_id);
+    return true;
+}
+
+void hal_rt_nbr_shadow_set (t_fib_nh *p_fh, ndi_neighbor_t *p_nbr_entry)
+{
+    t_fib_nbr_shadow *p_shadow;
+
+    if (p_nbr_entry->npu_id >= hal_rt_access_fib_config()->max_num_npu)
+        return;
+
+    p_shadow = &p_fh->a_nbr_shadow [p_nbr_entry->npu_id];
+
+    p_shadow->is_valid  = true;
+    p_shadow->action    = (uint32_t) p_nbr_entry->action;
+    p_shadow->rif_id    = p_nbr_entry->rif_id;
+    p_shadow->vlan_id   = (uint32_t) p_nbr_entry->egress_data.vlan_id;
+    p_shadow->port_tgid = (uint32_t) p_nbr_entry->egress_data.port_tgid;
+    memcpy (p_shadow->mac_addr, &p_nbr_entry->egress_data.neighbor_mac, HAL_RT_MAC_ADDR_LEN);
+
+    FIB_CNTRS_ADD (g_fib_shadow_stats.num_nbr_writes, 1);
+}
+
+void hal_rt_nbr_shadow_clear (t_fib_nh *p_fh, npu_id_t unit)
+{
+    if (unit < hal_rt_access_fib_config()->max_num_npu)
+        memset (&p_fh->a_nbr_shadow [unit], 0, sizeof (t_fib_nbr_shadow));
+}
+
+void fib_dump_shadow_stats (void)
+{
+    printf ("**************************************************\r\n");
+    printf ("  num_route_writes              :  %d\r\n",
+            g_fib_shadow_stats.num_route_writes);
+    printf ("  num_route_writes_suppressed   :  %d\r\n",
+            g_fib_shadow_stats.num_route_writes_suppressed);
+    printf ("  num_nbr_writes                :  %d\r\n",
+            g_fib_shadow_stats.num_nbr_writes);
+    printf ("  num_nbr_writes_suppressed     :  %d\r\n",
+            g_fib_shadow_stats.num_nbr_writes_suppressed);
+    printf ("**************************************************\r\n");
+}
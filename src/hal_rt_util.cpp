@@ -49,6 +49,13 @@ typedef struct _nas_rif_info_t {
 typedef std::unordered_map<hal_ifindex_t, nas_rif_info_t> nas_rt_rif_map_t;
 static nas_rt_rif_map_t g_rif_entry_table;
 
+/* The RIF map is shared by the AFs, it is guarded by the interface lock */
+class nas_rt_rif_lock_t {
+  public:
+    nas_rt_rif_lock_t () { hal_rt_intf_lock (); }
+    ~nas_rt_rif_lock_t () { hal_rt_intf_unlock (); }
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -65,8 +72,12 @@ extern "C" {
           { DN_HAL_ROUTE_E_END,            ""                   },   \
         }
 
-static uint8_t   ga_fib_scratch_buf [FIB_NUM_SCRATCH_BUF][FIB_MAX_SCRATCH_BUFSZ];
-static uint32_t  g_fib_scratch_buf_index = 0;
+/*
+ * The scratch buffers are per thread, the CPS, event and walker threads
+ * format addresses at the same time and must not reuse each other's buffer.
+ */
+static thread_local uint8_t   ga_fib_scratch_buf [FIB_NUM_SCRATCH_BUF][FIB_MAX_SCRATCH_BUFSZ];
+static thread_local uint32_t  g_fib_scratch_buf_index = 0;
 
 uint8_t  *fib_get_scratch_buf ()
 {
@@ -79,6 +90,102 @@ uint8_t  *fib_get_scratch_buf ()
     return ga_fib_scratch_buf [g_fib_scratch_buf_index];
 }
 
+static char *fib_fmt_dec_octet (char *p_str, uint8_t octet)
+{
+    if (octet >= 100) {
+        *p_str++ = (char) ('0' + (octet / 100));
+        octet %= 100;
+        *p_str++ = (char) ('0' + (octet / 10));
+    } else if (octet >= 10) {
+        *p_str++ = (char) ('0' + (octet / 10));
+    }
+    *p_str++ = (char) ('0' + (octet % 10));
+
+    return p_str;
+}
+
+static char *fib_fmt_ipv4 (char *p_str, const uint8_t *p_addr)
+{
+    int index;
+
+    for (index = 0; index < HAL_INET4_LEN; index++) {
+        if (index != 0)
+            *p_str++ = '.';
+        p_str = fib_fmt_dec_octet (p_str, p_addr [index]);
+    }
+    *p_str = '\0';
+
+    return p_str;
+}
+
+char *fib_ipv4_addr_to_str (const void *p_addr, char *p_buf)
+{
+    fib_fmt_ipv4 (p_buf, (const uint8_t *) p_addr);
+
+    return p_buf;
+}
+
+/*
+ * Formats the address as inet_ntop does: lower case hex without leading
+ * zeros, the longest run of two or more zero words is compressed to "::"
+ * and the IPv4 mapped and compatible addresses end in dotted decimal.
+ */
+char *fib_ipv6_addr_to_str (const void *p_addr, char *p_buf)
+{
+    static const char  a_hex [] = "0123456789abcdef";
+    const uint8_t     *p_byte = (const uint8_t *) p_addr;
+    char              *p_str = p_buf;
+    uint16_t           a_word [HAL_INET6_LEN / 2];
+    int                best_base = -1, best_len = 0;
+    int                cur_base = -1, cur_len = 0;
+    int                index, shift;
+
+    for (index = 0; index < (HAL_INET6_LEN / 2); index++) {
+        a_word [index] = (uint16_t) ((p_byte [2 * index] << 8) | p_byte [(2 * index) + 1]);
+
+        if (a_word [index] == 0) {
+            if (cur_base == -1)
+                cur_base = index;
+            cur_len++;
+            if (cur_len > best_len) {
+                best_base = cur_base;
+                best_len = cur_len;
+            }
+        } else {
+            cur_base = -1;
+            cur_len = 0;
+        }
+    }
+    if (best_len < 2)
+        best_base = -1;
+
+    for (index = 0; index < (HAL_INET6_LEN / 2); index++) {
+        if ((best_base != -1) && (index >= best_base) && (index < (best_base + best_len))) {
+            if (index == best_base)
+                *p_str++ = ':';
+            continue;
+        }
+        if (index != 0)
+            *p_str++ = ':';
+
+        if ((index == 6) && (best_base == 0) &&
+            ((best_len == 6) || ((best_len == 5) && (a_word [5] == 0xffff)))) {
+            fib_fmt_ipv4 (p_str, p_byte + 12);
+            return p_buf;
+        }
+
+        for (shift = 12; (shift > 0) && (((a_word [index] >> shift) & 0xf) == 0); shift -= 4)
+            ;
+        for (; shift >= 0; shift -= 4)
+            *p_str++ = a_hex [(a_word [index] >> shift) & 0xf];
+    }
+    if ((best_base != -1) && ((best_base + best_len) == (HAL_INET6_LEN / 2)))
+        *p_str++ = ':';
+    *p_str = '\0';
+
+    return p_buf;
+}
+
 t_std_error hal_rt_validate_intf(int if_index)
 {
     interface_ctrl_t intf_ctrl;
@@ -105,6 +212,12 @@ uint8_t *hal_rt_get_hal_err_str(dn_hal_route_err _hal_err)
     return p_str;
 }
 
+bool hal_rt_ndi_rc_is_table_full (t_std_error rc)
+{
+    return ((rc == STD_ERR (ROUTE, FAIL, HAL_RT_NDI_SAI_STATUS_TABLE_FULL)) ||
+            (rc == STD_ERR (ROUTE, FAIL, HAL_RT_NDI_SAI_STATUS_INSUFFICIENT_RESOURCES)));
+}
+
 char *hal_rt_mac_to_str (hal_mac_addr_t *mac_addr, char *p_buf, size_t len)
 {
     snprintf (p_buf, len, "%02x:%02x:%02x:%02x:%02x:%02x",
@@ -153,6 +266,7 @@ t_std_error hal_rt_lag_obj_id_get (hal_ifindex_t if_index, ndi_obj_id_t& obj_id)
 
 uint32_t hal_rt_rif_ref_inc(hal_ifindex_t if_index)
 {
+    nas_rt_rif_lock_t rif_lock;
     auto it = g_rif_entry_table.find(if_index);
     uint32_t ref_cnt = 0;
 
@@ -170,6 +284,7 @@ uint32_t hal_rt_rif_ref_inc(hal_ifindex_t if_index)
 
 uint32_t hal_rt_rif_ref_dec(hal_ifindex_t if_index)
 {
+    nas_rt_rif_lock_t rif_lock;
     auto it = g_rif_entry_table.find(if_index);
     uint32_t ref_cnt = 0;
 
@@ -200,6 +315,7 @@ ndi_rif_id_t hal_rif_index_get (npu_id_t npu_id, hal_vrf_id_t vrf_id, hal_ifinde
     ndi_rif_entry_t     rif_entry;
     interface_ctrl_t    intf_ctrl;
     char                buf[HAL_RT_MAX_BUFSZ];
+    nas_rt_rif_lock_t   rif_lock;
 
     auto it = g_rif_entry_table.find(if_index);
 
@@ -269,6 +385,7 @@ ndi_rif_id_t hal_rif_index_get (npu_id_t npu_id, hal_vrf_id_t vrf_id, hal_ifinde
 t_std_error hal_rif_index_remove (npu_id_t npu_id, hal_vrf_id_t vrf_id, hal_ifindex_t if_index)
 {
     ndi_rif_id_t        rif_id = 0;
+    nas_rt_rif_lock_t   rif_lock;
 
     auto it = g_rif_entry_table.find(if_index);
 
@@ -281,6 +398,16 @@ t_std_error hal_rif_index_remove (npu_id_t npu_id, hal_vrf_id_t vrf_id, hal_ifin
 
     rif_id = (it->second).rif_id;
 
+    /*
+     * The writers of the AFs run concurrently, a writer of another AF may
+     * have taken a reference after the caller released the last one.
+     */
+    if ((it->second).ref_count != 0) {
+        EV_LOG_TRACE (ev_log_t_ROUTE, 3, "HAL-RT", "RIF id %d for if_index %d in use, "
+                      "refcnt %d", rif_id, if_index, (it->second).ref_count);
+        return STD_ERR_OK;
+    }
+
     if (ndi_rif_delete(npu_id, rif_id) != STD_ERR_OK) {
         EV_LOG_ERR(ev_log_t_ROUTE, 3, "NAS-ROUTE", "%s ():RIF id Deletion "
                 " failed for if_index = %d", __FUNCTION__, if_index);
@@ -305,11 +432,6 @@ ndi_vrf_id_t hal_vrf_obj_get (npu_id_t npu_id, hal_vrf_id_t vrf_id)
 /*
  * Stub Routines - @TODO
  */
-void fib_check_threshold_for_all_cams (int action)
-{
-    return;
-}
-
 unsigned long fib_tick_get( void )
 {
     return (0);
@@ -23,17 +23,20 @@
 #include "nas_rt_api.h"
 #include "nas_os_l3.h"
 #include "hal_rt_util.h"
+#include "hal_rt_mpath_grp.h"
 #include "event_log_types.h"
 #include "event_log.h"
 #include "std_mutex_lock.h"
 
 #include "cps_class_map.h"
+#include "cps_api_object_category.h"
 #include "cps_api_object_key.h"
 #include "cps_api_operation.h"
 #include "cps_api_events.h"
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 BASE_ROUTE_OBJ_t nas_route_check_route_key_attr(cps_api_object_t obj) {
 
@@ -303,7 +306,7 @@ cps_api_return_code_t nas_route_process_cps_nbr(cps_api_transaction_params_t * p
 static cps_api_object_t nas_route_info_to_cps_object(t_fib_dr *entry){
     t_fib_nh       *p_nh = NULL;
     t_fib_nh_holder nh_holder1;
-    int weight = 0;
+    uint32_t weight = 0;
     int addr_len = 0, nh_itr = 0, is_arp_resolved = false;
 
     if(entry == NULL){
@@ -355,6 +358,7 @@ static cps_api_object_t nas_route_info_to_cps_object(t_fib_dr *entry){
         cps_api_object_e_add(obj, parent_list, 3,
                              cps_api_object_ATTR_T_U32, &p_nh->key.if_index, sizeof(p_nh->key.if_index));
 
+        weight = FIB_GET_DRNH_NODE_FROM_NH_HOLDER (nh_holder1)->weight;
         parent_list[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT;
         cps_api_object_e_add(obj, parent_list, 3,
                              cps_api_object_ATTR_T_U32, &weight, sizeof(weight));
@@ -378,6 +382,9 @@ t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vr
                                          hal_ip_addr_t prefix, uint32_t pref_len, bool is_specific_prefix_get) {
 
     t_fib_dr *p_dr = NULL;
+    t_fib_ip_addr key_prefix;
+    uint8_t key_prefix_len;
+    uint32_t count = 0;
 
     if (af >= FIB_MAX_AFINDEX)
     {
@@ -385,6 +392,8 @@ t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vr
         return STD_ERR(ROUTE,FAIL,0);
     }
 
+    hal_rt_vrf_read_lock (vrf_id, af);
+
     if (is_specific_prefix_get) {
         p_dr = fib_get_dr (vrf_id, &prefix, pref_len);
     } else {
@@ -396,6 +405,7 @@ t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vr
             if (!cps_api_object_list_append(list,obj)) {
                 cps_api_object_delete(obj);
                 EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+                hal_rt_vrf_unlock (vrf_id, af);
                 return STD_ERR(ROUTE,FAIL,0);
             }
         }
@@ -403,8 +413,594 @@ t_std_error nas_route_get_all_route_info(cps_api_object_list_t list, uint32_t vr
         if (is_specific_prefix_get)
             break;
 
-        p_dr = fib_get_next_dr (vrf_id, &p_dr->key.prefix, p_dr->prefix_len);
+        memcpy (&key_prefix, &p_dr->key.prefix, sizeof (t_fib_ip_addr));
+        key_prefix_len = p_dr->prefix_len;
+
+        /*
+         * The writers of the AF get the lock after each chunk, no DR is held
+         * across the unlock. The walk resumes from the key of the last DR.
+         */
+        if (++count >= HAL_RT_GET_CHUNK) {
+            hal_rt_vrf_unlock (vrf_id, af);
+            count = 0;
+            hal_rt_vrf_read_lock (vrf_id, af);
+        }
+
+        p_dr = fib_get_next_dr (vrf_id, &key_prefix, key_prefix_len);
+    }
+
+    hal_rt_vrf_unlock (vrf_id, af);
+    return STD_ERR_OK;
+}
+
+
+t_std_error nas_route_get_ecmp_grp_pressure(cps_api_object_list_t list) {
+
+    t_fib_ecmp_grp_pressure *p_pressure = hal_rt_access_ecmp_grp_pressure();
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_GRP_PRESSURE_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_PRESSURE_GRPS_IN_USE,
+                                p_pressure->num_grps_in_use);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_PRESSURE_CAPACITY,
+                                p_pressure->grp_capacity);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_PRESSURE_DEGRADED_ROUTES,
+                                p_pressure->num_degraded_routes);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_PRESSURE_TABLE_FULL,
+                                p_pressure->num_table_full);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_PRESSURE_SHARED,
+                                p_pressure->num_shared);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_PRESSURE_UPGRADED,
+                                p_pressure->num_upgraded);
+
+    if (!cps_api_object_list_append(list,obj)) {
+        cps_api_object_delete(obj);
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+static void nas_route_ecmp_grp_stats_add_list(cps_api_object_t obj, cps_api_attr_id_t id,
+                                              uint32_t a_value[], uint32_t count) {
+    cps_api_attr_id_t parent_list[2];
+    uint32_t          index;
+
+    for (index = 0; index < count; index++) {
+        if (a_value[index] == 0)
+            continue;
+        parent_list[0] = id;
+        parent_list[1] = index;
+        cps_api_object_e_add(obj, parent_list, 2,
+                             cps_api_object_ATTR_T_U32, &a_value[index], sizeof(a_value[index]));
+    }
+}
+
+static cps_api_object_t nas_route_ecmp_grp_stats_to_cps_object(uint32_t vrf_id, uint8_t af_index,
+                                                                uint32_t top_n) {
+    t_fib_ecmp_grp_stats  stats;
+    t_fib_vrf_cntrs       vrf_cntrs;
+    t_fib_vrf_cntrs      *p_vrf_cntrs = &vrf_cntrs;
+    cps_api_attr_id_t     parent_list[3];
+    uint32_t              index;
+    uint64_t              gid;
+    uint32_t              width, npu_id;
+
+    memset(&stats, 0, sizeof(stats));
+    hal_rt_fib_get_ecmp_grp_stats(vrf_id, af_index, top_n, &stats);
+    hal_rt_fib_vrf_cntrs_get(vrf_id, af_index, &vrf_cntrs);
+
+    if ((stats.num_grps == 0) && (p_vrf_cntrs->num_ecmp_grp_created == 0))
+        return NULL;
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return NULL;
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_GRP_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_VRF_ID, vrf_id);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_AF, af_index);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_NUM_GRPS, stats.num_grps);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_PARKED, stats.num_parked);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_COLLISIONS, stats.num_collisions);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_COLLIDED_GRPS,
+                                stats.num_collided_grps);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_CREATED,
+                                p_vrf_cntrs->num_ecmp_grp_created);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_REPLACED,
+                                p_vrf_cntrs->num_ecmp_grp_replaced);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_DELETED,
+                                p_vrf_cntrs->num_ecmp_grp_deleted);
+
+    nas_route_ecmp_grp_stats_add_list(obj, NAS_RT_ECMP_GRP_STATS_NPU_GRPS,
+                                      stats.a_num_grps,
+                                      hal_rt_access_fib_config()->max_num_npu);
+    nas_route_ecmp_grp_stats_add_list(obj, NAS_RT_ECMP_GRP_STATS_WIDTH_HIST,
+                                      stats.a_width_hist, HAL_RT_ECMP_GRP_HIST_BUCKETS);
+    nas_route_ecmp_grp_stats_add_list(obj, NAS_RT_ECMP_GRP_STATS_SHARE_HIST,
+                                      stats.a_share_hist, HAL_RT_ECMP_GRP_HIST_BUCKETS);
+
+    for (index = 0; index < stats.num_top; index++) {
+        parent_list[0] = NAS_RT_ECMP_GRP_STATS_TOP;
+        parent_list[1] = index;
+
+        gid = stats.a_top[index].sai_ecmp_gid;
+        parent_list[2] = NAS_RT_ECMP_GRP_STATS_TOP_GID;
+        cps_api_object_e_add(obj, parent_list, 3,
+                             cps_api_object_ATTR_T_U64, &gid, sizeof(gid));
+
+        width = stats.a_top[index].ecmp_count;
+        parent_list[2] = NAS_RT_ECMP_GRP_STATS_TOP_WIDTH;
+        cps_api_object_e_add(obj, parent_list, 3,
+                             cps_api_object_ATTR_T_U32, &width, sizeof(width));
+
+        parent_list[2] = NAS_RT_ECMP_GRP_STATS_TOP_REF_COUNT;
+        cps_api_object_e_add(obj, parent_list, 3, cps_api_object_ATTR_T_U32,
+                             &stats.a_top[index].ref_count,
+                             sizeof(stats.a_top[index].ref_count));
+
+        npu_id = stats.a_top[index].unit;
+        parent_list[2] = NAS_RT_ECMP_GRP_STATS_TOP_NPU_ID;
+        cps_api_object_e_add(obj, parent_list, 3,
+                             cps_api_object_ATTR_T_U32, &npu_id, sizeof(npu_id));
+    }
+    return obj;
+}
+
+t_std_error nas_route_get_ecmp_grp_stats(cps_api_object_list_t list, uint32_t top_n) {
+
+    uint32_t vrf_id;
+    uint8_t  af_index;
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
+        if (hal_rt_access_fib_vrf(vrf_id) == NULL)
+            continue;
+
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            cps_api_object_t obj = nas_route_ecmp_grp_stats_to_cps_object(vrf_id, af_index,
+                                                                          top_n);
+            if (obj == NULL)
+                continue;
+
+            if (!cps_api_object_list_append(list,obj)) {
+                cps_api_object_delete(obj);
+                EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+                return STD_ERR(ROUTE,FAIL,0);
+            }
+        }
+    }
+    return STD_ERR_OK;
+}
+
+static cps_api_object_t nas_route_vrf_cntrs_to_cps_object(uint32_t vrf_id, uint8_t af_index) {
+
+    t_fib_vrf_cntrs       cntrs;
+    t_fib_vrf_cntrs_rate  rate;
+
+    hal_rt_fib_vrf_cntrs_get(vrf_id, af_index, &cntrs);
+    hal_rt_fib_vrf_cntrs_rate_get(vrf_id, af_index, &rate);
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return NULL;
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_VRF_CNTRS_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_VRF_ID, vrf_id);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_AF, af_index);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ROUTE_ADD, cntrs.num_route_add);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ROUTE_DEL, cntrs.num_route_del);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_VRF_ADD, cntrs.num_vrf_add);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_VRF_DEL, cntrs.num_vrf_del);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ROUTE_CLEAR, cntrs.num_route_clear);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_UNKNOWN_MSG, cntrs.num_unknown_msg);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_ADD, cntrs.num_nbr_add);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_DEL, cntrs.num_nbr_del);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_RESOLVING, cntrs.num_nbr_resolving);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_UNRSLVD, cntrs.num_nbr_un_rslvd);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_CLEAR, cntrs.num_nbr_clear);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_FIB_HOST_ENTRIES,
+                                cntrs.num_fib_host_entries);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_FIB_ROUTE_ENTRIES,
+                                cntrs.num_fib_route_entries);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_CAM_HOST_ENTRIES,
+                                cntrs.num_cam_host_entries);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_CAM_ROUTE_ENTRIES,
+                                cntrs.num_cam_route_entries);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ECMP_GRP_PARKED,
+                                cntrs.num_ecmp_grp_parked);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ECMP_GRP_REUSED,
+                                cntrs.num_ecmp_grp_reused);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ECMP_GRP_FREED,
+                                cntrs.num_ecmp_grp_freed);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ECMP_GRP_CREATED,
+                                cntrs.num_ecmp_grp_created);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ECMP_GRP_REPLACED,
+                                cntrs.num_ecmp_grp_replaced);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ECMP_GRP_DELETED,
+                                cntrs.num_ecmp_grp_deleted);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ROUTE_ADD_RATE, rate.route_add_rate);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_ROUTE_DEL_RATE, rate.route_del_rate);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_ADD_RATE, rate.nbr_add_rate);
+    cps_api_object_attr_add_u32(obj, NAS_RT_VRF_CNTRS_NBR_DEL_RATE, rate.nbr_del_rate);
+
+    return obj;
+}
+
+/*
+ * The counters are read without the FIB locks, vrf_id/af of
+ * FIB_MAX_VRF/FIB_MAX_AFINDEX select all the VRFs/AFs.
+ */
+t_std_error nas_route_get_vrf_cntrs(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af) {
+
+    uint32_t cur_vrf_id;
+    uint8_t  af_index;
+
+    for (cur_vrf_id = FIB_MIN_VRF; cur_vrf_id < FIB_MAX_VRF; cur_vrf_id++) {
+        if ((vrf_id != FIB_MAX_VRF) && (cur_vrf_id != vrf_id))
+            continue;
+        if (hal_rt_access_fib_vrf(cur_vrf_id) == NULL)
+            continue;
+
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            if ((af != FIB_MAX_AFINDEX) && (af_index != af))
+                continue;
+            if (((af_index != HAL_RT_V4_AFINDEX) && (af_index != HAL_RT_V6_AFINDEX)) ||
+                (!FIB_IS_VRF_CREATED(cur_vrf_id, af_index)))
+                continue;
+
+            cps_api_object_t obj = nas_route_vrf_cntrs_to_cps_object(cur_vrf_id, af_index);
+            if (obj == NULL)
+                return STD_ERR(ROUTE,FAIL,0);
+
+            if (!cps_api_object_list_append(list,obj)) {
+                cps_api_object_delete(obj);
+                EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+                return STD_ERR(ROUTE,FAIL,0);
+            }
+        }
     }
     return STD_ERR_OK;
 }
 
+static uint32_t nas_route_grp_fh_count(t_fib_mp_obj *p_mp_obj, next_hop_id_t nh_id,
+                                       uint32_t *p_weight) {
+    uint32_t count = 0;
+    int      index;
+
+    for (index = 0; index < p_mp_obj->ecmp_count; index++) {
+        if (p_mp_obj->a_nh_obj_id[index] != nh_id)
+            continue;
+        if (count == 0)
+            *p_weight = p_mp_obj->a_nh_weight[index];
+        count++;
+    }
+    return count;
+}
+
+static cps_api_object_t nas_route_grp_to_cps_object(t_fib_dr *p_dr) {
+
+    t_fib_hal_dr_info *p_hal_dr_info = (t_fib_hal_dr_info *) p_dr->p_hal_dr_handle;
+    t_fib_mp_obj      *p_mp_obj = NULL;
+    t_fib_nh          *p_fh;
+    t_fib_nh_holder    nh_holder;
+    cps_api_attr_id_t  parent_list[3];
+    uint64_t           gid = 0;
+    uint32_t           is_indirect = false, is_resilient = false;
+    uint32_t           num_members = 0, weight, count, fh_itr = 0;
+    int                addr_len;
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return NULL;
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ROUTE_GRP_OBJ,0);
+
+    addr_len = ((p_dr->key.prefix.af_index == HAL_INET4_FAMILY) ? HAL_INET4_LEN : HAL_INET6_LEN);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_VRF_ID, p_dr->vrf_id);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_AF, p_dr->key.prefix.af_index);
+    cps_api_object_attr_add(obj, NAS_RT_ROUTE_GRP_PREFIX, &p_dr->key.prefix.u, addr_len);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_PREFIX_LEN, p_dr->prefix_len);
+
+    if (p_hal_dr_info != NULL) {
+        if (p_hal_dr_info->ap_indirect_mp_obj[0] != NULL) {
+            p_mp_obj = p_hal_dr_info->ap_indirect_mp_obj[0];
+            is_indirect = true;
+        } else if ((p_hal_dr_info->a_obj_status[0] == HAL_RT_STATUS_ECMP) &&
+                   (p_hal_dr_info->ap_mp_obj[0] != NULL)) {
+            p_mp_obj = p_hal_dr_info->ap_mp_obj[0];
+        }
+    }
+    if (p_mp_obj != NULL) {
+        gid = p_mp_obj->sai_ecmp_gid;
+        is_resilient = p_mp_obj->is_resilient;
+        num_members = p_mp_obj->ecmp_count;
+    }
+
+    cps_api_object_attr_add_u64(obj, NAS_RT_ROUTE_GRP_GID, gid);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_IS_INDIRECT, is_indirect);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_IS_RESILIENT, is_resilient);
+
+    FIB_FOR_EACH_FH_FROM_DR (p_dr, p_fh, nh_holder)
+    {
+        weight = 1;
+        if (p_mp_obj != NULL) {
+            count = nas_route_grp_fh_count(p_mp_obj, hal_rt_nh_obj_id_get(p_fh, 0), &weight);
+        } else {
+            /* The route points to the FH itself */
+            count = 1;
+            num_members = 1;
+        }
+
+        parent_list[0] = NAS_RT_ROUTE_GRP_FH;
+        parent_list[1] = fh_itr;
+
+        parent_list[2] = NAS_RT_ROUTE_GRP_FH_ADDR;
+        cps_api_object_e_add(obj, parent_list, 3, cps_api_object_ATTR_T_BIN,
+                             &p_fh->key.ip_addr.u, addr_len);
+
+        parent_list[2] = NAS_RT_ROUTE_GRP_FH_IF_INDEX;
+        cps_api_object_e_add(obj, parent_list, 3, cps_api_object_ATTR_T_U32,
+                             &p_fh->key.if_index, sizeof(p_fh->key.if_index));
+
+        parent_list[2] = NAS_RT_ROUTE_GRP_FH_WEIGHT;
+        cps_api_object_e_add(obj, parent_list, 3, cps_api_object_ATTR_T_U32,
+                             &weight, sizeof(weight));
+
+        parent_list[2] = NAS_RT_ROUTE_GRP_FH_COUNT;
+        cps_api_object_e_add(obj, parent_list, 3, cps_api_object_ATTR_T_U32,
+                             &count, sizeof(count));
+        fh_itr++;
+    }
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_NUM_MEMBERS, num_members);
+
+    return obj;
+}
+
+/*
+ * The groups of the AF are changed under the L3 lock of the AF, it is
+ * taken inside the VRF AF read lock as in the lock order.
+ */
+t_std_error nas_route_get_route_grp(cps_api_object_list_t list, uint32_t vrf_id, uint32_t af,
+                                    hal_ip_addr_t *p_prefix, uint32_t pref_len) {
+
+    t_fib_dr         *p_dr;
+    cps_api_object_t  obj = NULL;
+
+    if ((!FIB_IS_VRF_ID_VALID (vrf_id)) || (af >= FIB_MAX_AFINDEX))
+        return STD_ERR(ROUTE,FAIL,0);
+
+    hal_rt_vrf_read_lock (vrf_id, af);
+    nas_l3_lock_af_at (af, HAL_RT_LOCK_SITE_CPS_GET);
+
+    p_dr = fib_get_dr (vrf_id, p_prefix, pref_len);
+    if (p_dr != NULL)
+        obj = nas_route_grp_to_cps_object(p_dr);
+
+    nas_l3_unlock_af (af);
+    hal_rt_vrf_unlock (vrf_id, af);
+
+    if (obj == NULL)
+        return ((p_dr == NULL) ? STD_ERR_OK : STD_ERR(ROUTE,FAIL,0));
+
+    if (!cps_api_object_list_append(list,obj)) {
+        cps_api_object_delete(obj);
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+t_std_error nas_route_get_ecmp_config(cps_api_object_list_t list) {
+
+    const t_fib_config *p_config = hal_rt_access_fib_config();
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_CONFIG_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_CONFIG_NATIVE_WEIGHT,
+                                p_config->ecmp_native_weight);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_CONFIG_MAX_PATHS, p_config->ecmp_max_paths);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_CONFIG_HW_MAX_PATHS,
+                                p_config->hw_ecmp_max_paths);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_CONFIG_RESILIENT_HASH,
+                                p_config->ecmp_resilient_hash);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_CONFIG_RESILIENT_BUCKETS,
+                                p_config->ecmp_resilient_buckets);
+
+    if (!cps_api_object_list_append(list,obj)) {
+        cps_api_object_delete(obj);
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+cps_api_object_t nas_route_cam_usage_to_cps_obj(uint32_t cam) {
+
+    const t_hal_rt_cam_usage *p_usage = hal_rt_access_cam_usage((t_hal_rt_cam) cam);
+
+    if (p_usage == NULL)
+        return NULL;
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return NULL;
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_CAM_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_TABLE, cam);
+    cps_api_object_attr_add(obj, NAS_RT_CAM_NAME, hal_rt_cam_name((t_hal_rt_cam) cam),
+                            strlen(hal_rt_cam_name((t_hal_rt_cam) cam)) + 1);
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_IN_USE, p_usage->in_use);
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_CAPACITY, p_usage->capacity);
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_LEVEL, p_usage->level);
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_WRITE_FAILED, p_usage->num_write_failed);
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_REJECTED, p_usage->num_rejected);
+    cps_api_object_attr_add_u32(obj, NAS_RT_CAM_DEFERRED,
+                                hal_rt_retry_num_table_full((t_hal_rt_cam) cam));
+
+    return obj;
+}
+
+t_std_error nas_route_get_cam_usage(cps_api_object_list_t list) {
+
+    uint32_t cam;
+
+    for (cam = 0; cam < HAL_RT_CAM_MAX; cam++) {
+        cps_api_object_t obj = nas_route_cam_usage_to_cps_obj(cam);
+        if (obj == NULL)
+            return STD_ERR(ROUTE,FAIL,0);
+
+        if (!cps_api_object_list_append(list,obj)) {
+            cps_api_object_delete(obj);
+            EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+            return STD_ERR(ROUTE,FAIL,0);
+        }
+    }
+    return STD_ERR_OK;
+}
+
+t_std_error nas_route_get_retry_stats(cps_api_object_list_t list) {
+
+    const t_hal_rt_retry_stats *p_stats = hal_rt_access_retry_stats();
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_RETRY_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_PENDING, p_stats->num_pending);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_NDI_FAIL,
+                                p_stats->a_num_pending[HAL_RT_RETRY_RSN_NDI_FAIL]);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_TABLE_FULL,
+                                p_stats->a_num_pending[HAL_RT_RETRY_RSN_TABLE_FULL]);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_ECMP_FAIL,
+                                p_stats->a_num_pending[HAL_RT_RETRY_RSN_ECMP_FAIL]);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_STUCK, p_stats->num_stuck);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_RETRIED, p_stats->num_retried);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_RECOVERED, p_stats->num_recovered);
+    cps_api_object_attr_add_u32(obj, NAS_RT_RETRY_MAX_ATTEMPTS, p_stats->max_attempts);
+
+    if (!cps_api_object_list_append(list,obj)) {
+        cps_api_object_delete(obj);
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+t_std_error nas_route_get_audit_stats(cps_api_object_list_t list) {
+
+    const t_fib_audit *p_audit = hal_rt_access_fib_audit();
+    const t_hal_rt_audit_stats *p_stats = hal_rt_access_audit_stats();
+
+    cps_api_object_t obj = cps_api_object_create();
+    if(obj == NULL){
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_AUDIT_OBJ,0);
+
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_STATUS, p_audit->status);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_INTERVAL, p_audit->next_cfg.interval);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_COMPLETED, p_audit->num_audits_completed);
+    cps_api_object_attr_add_u64(obj, NAS_RT_AUDIT_START_TIME, p_audit->last_audit_start_time);
+    cps_api_object_attr_add_u64(obj, NAS_RT_AUDIT_END_TIME, p_audit->last_audit_end_time);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_ROUTES, p_stats->num_routes_audited);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_HOSTS, p_stats->num_hosts_audited);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_ROUTE_MISMATCH, p_stats->num_route_mismatch);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_HOST_MISMATCH, p_stats->num_host_mismatch);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_EGR_MISMATCH, p_stats->num_egr_mismatch);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_SKIPPED, p_stats->num_skipped);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_REPAIRED, p_stats->num_repaired);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_TOT_MISMATCH, p_stats->tot_mismatch);
+    cps_api_object_attr_add_u32(obj, NAS_RT_AUDIT_TOT_REPAIRED, p_stats->tot_repaired);
+
+    if (!cps_api_object_list_append(list,obj)) {
+        cps_api_object_delete(obj);
+        EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
+t_std_error nas_route_get_lock_stats(cps_api_object_list_t list) {
+
+    const t_hal_rt_lock_stats *p_stats = hal_rt_access_lock_stats();
+    const t_hal_rt_lock_site_stats *p_site_stats;
+    uint32_t hist[HAL_RT_LOCK_HIST_BUCKETS];
+    uint32_t site;
+
+    for (site = 0; site < HAL_RT_LOCK_SITE_MAX; site++) {
+        p_site_stats = &p_stats->a_site[site];
+
+        cps_api_object_t obj = cps_api_object_create();
+        if(obj == NULL){
+            EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to allocate memory to cps object");
+            return STD_ERR(ROUTE,FAIL,0);
+        }
+
+        cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                         cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_LOCK_OBJ,0);
+
+        cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_SITE, site);
+        cps_api_object_attr_add(obj, NAS_RT_LOCK_SITE_NAME, hal_rt_lock_site_name(site),
+                                strlen(hal_rt_lock_site_name(site)) + 1);
+        cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_ENABLE, p_stats->is_enabled);
+        cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_ACQUIRED, p_site_stats->num_acquired);
+        cps_api_object_attr_add_u64(obj, NAS_RT_LOCK_TOT_WAIT, p_site_stats->tot_wait_usecs);
+        cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_MAX_WAIT, p_site_stats->max_wait_usecs);
+        cps_api_object_attr_add_u64(obj, NAS_RT_LOCK_TOT_HOLD, p_site_stats->tot_hold_usecs);
+        cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_MAX_HOLD, p_site_stats->max_hold_usecs);
+        cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_IS_MAX_HOLDER,
+                                    ((p_stats->max_hold_site == site) &&
+                                     (p_site_stats->max_hold_usecs > 0)));
+
+        memcpy(hist, p_site_stats->a_wait_hist, sizeof(hist));
+        nas_route_ecmp_grp_stats_add_list(obj, NAS_RT_LOCK_WAIT_HIST, hist,
+                                          HAL_RT_LOCK_HIST_BUCKETS);
+        memcpy(hist, p_site_stats->a_hold_hist, sizeof(hist));
+        nas_route_ecmp_grp_stats_add_list(obj, NAS_RT_LOCK_HOLD_HIST, hist,
+                                          HAL_RT_LOCK_HIST_BUCKETS);
+
+        if (!cps_api_object_list_append(list,obj)) {
+            cps_api_object_delete(obj);
+            EV_LOG(ERR,ROUTE,0,"HAL-RT-API","Failed to append object to object list");
+            return STD_ERR(ROUTE,FAIL,0);
+        }
+    }
+    return STD_ERR_OK;
+}
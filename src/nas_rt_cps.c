@@ -24,10 +24,12 @@
 #include "event_log.h"
 
 #include "cps_class_map.h"
+#include "cps_api_object_category.h"
 #include "cps_api_object_key.h"
 #include "cps_api_operation.h"
 #include "cps_api_events.h"
 #include "hal_rt_util.h"
+#include "hal_rt_mpath_grp.h"
 
 #include <stdlib.h>
 
@@ -119,12 +121,9 @@ static cps_api_return_code_t nas_route_cps_all_route_get_func (void *ctx,
     }
     t_std_error rc;
 
-    nas_l3_lock();
     if((rc = nas_route_get_all_route_info(param->list,vrf, af, ip, pref_len, is_specific_prefix_get)) != STD_ERR_OK){
-        nas_l3_unlock();
         return cps_api_ret_code_ERR;
     }
-    nas_l3_unlock();
     return cps_api_ret_code_OK;
 }
 
@@ -224,7 +223,7 @@ static cps_api_return_code_t nas_route_cps_peer_routing_get_func (void *ctx,
 
     EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Peer Routing Status Get function");
 
-    nas_l3_lock();
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_PEER_CONFIG);
     if((rc = nas_route_get_all_peer_routing_config(param->list)) != STD_ERR_OK){
         nas_l3_unlock();
         return (cps_api_return_code_t)rc;
@@ -234,6 +233,321 @@ static cps_api_return_code_t nas_route_cps_peer_routing_get_func (void *ctx,
     return cps_api_ret_code_OK;
 }
 
+static cps_api_return_code_t nas_route_cps_ecmp_grp_pressure_get_func (void *ctx,
+                                                                       cps_api_get_params_t * param,
+                                                                       size_t ix) {
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "ECMP group pressure Get function");
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_CPS_GET);
+    if((rc = nas_route_get_ecmp_grp_pressure(param->list)) != STD_ERR_OK){
+        nas_l3_unlock();
+        return (cps_api_return_code_t)rc;
+    }
+    nas_l3_unlock();
+
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_cam_get_func (void *ctx,
+                                                         cps_api_get_params_t * param,
+                                                         size_t ix) {
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "CAM usage Get function");
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_CPS_GET);
+    if((rc = nas_route_get_cam_usage(param->list)) != STD_ERR_OK){
+        nas_l3_unlock();
+        return (cps_api_return_code_t)rc;
+    }
+    nas_l3_unlock();
+
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_retry_get_func (void *ctx,
+                                                           cps_api_get_params_t * param,
+                                                           size_t ix) {
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Retry stats Get function");
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_CPS_GET);
+    if((rc = nas_route_get_retry_stats(param->list)) != STD_ERR_OK){
+        nas_l3_unlock();
+        return (cps_api_return_code_t)rc;
+    }
+    nas_l3_unlock();
+
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_audit_get_func (void *ctx,
+                                                           cps_api_get_params_t * param,
+                                                           size_t ix) {
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Audit stats Get function");
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_CPS_GET);
+    if((rc = nas_route_get_audit_stats(param->list)) != STD_ERR_OK){
+        nas_l3_unlock();
+        return (cps_api_return_code_t)rc;
+    }
+    nas_l3_unlock();
+
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_audit_set_func (void *ctx,
+                                                           cps_api_transaction_params_t * param,
+                                                           size_t ix) {
+    cps_api_object_t obj = cps_api_object_list_get(param->change_list,ix);
+    cps_api_object_attr_t attr;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Audit Set function");
+
+    if (obj == NULL) {
+        return cps_api_ret_code_ERR;
+    }
+
+    attr = cps_api_object_attr_get(obj, NAS_RT_AUDIT_INTERVAL);
+    if (attr != NULL) {
+        hal_rt_audit_set_interval(cps_api_object_attr_data_u32(attr));
+    }
+
+    if (cps_api_object_attr_get(obj, NAS_RT_AUDIT_START) != NULL) {
+        hal_rt_audit_start();
+    }
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_lock_get_func (void *ctx,
+                                                          cps_api_get_params_t * param,
+                                                          size_t ix) {
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Lock stats Get function");
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_CPS_GET);
+    if((rc = nas_route_get_lock_stats(param->list)) != STD_ERR_OK){
+        nas_l3_unlock();
+        return (cps_api_return_code_t)rc;
+    }
+    nas_l3_unlock();
+
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_lock_set_func (void *ctx,
+                                                          cps_api_transaction_params_t * param,
+                                                          size_t ix) {
+    cps_api_object_t obj = cps_api_object_list_get(param->change_list,ix);
+    cps_api_object_attr_t attr;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Lock profiler Set function");
+
+    if (obj == NULL) {
+        return cps_api_ret_code_ERR;
+    }
+
+    attr = cps_api_object_attr_get(obj, NAS_RT_LOCK_ENABLE);
+    if (attr != NULL) {
+        hal_rt_lock_prof_enable(cps_api_object_attr_data_u32(attr) != 0);
+    }
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_vrf_cntrs_get_func (void *ctx,
+                                                               cps_api_get_params_t * param,
+                                                               size_t ix) {
+    t_std_error rc;
+    uint32_t    vrf_id = FIB_MAX_VRF;
+    uint32_t    af = FIB_MAX_AFINDEX;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "VRF counters Get function");
+
+    cps_api_object_t filt = cps_api_object_list_get(param->filters,ix);
+    cps_api_object_attr_t vrf_attr = cps_api_object_attr_get(filt, NAS_RT_VRF_CNTRS_VRF_ID);
+    cps_api_object_attr_t af_attr = cps_api_object_attr_get(filt, NAS_RT_VRF_CNTRS_AF);
+
+    if (vrf_attr != NULL) {
+        vrf_id = cps_api_object_attr_data_u32(vrf_attr);
+    }
+    if (af_attr != NULL) {
+        af = cps_api_object_attr_data_u32(af_attr);
+    }
+
+    /* The counters are sharded per thread, no lock is needed to read them */
+    if((rc = nas_route_get_vrf_cntrs(param->list, vrf_id, af)) != STD_ERR_OK){
+        return (cps_api_return_code_t)rc;
+    }
+
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_route_grp_get_func (void *ctx,
+                                                               cps_api_get_params_t * param,
+                                                               size_t ix) {
+    hal_ip_addr_t ip;
+    uint32_t      vrf_id = 0, af;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "Route group Get function");
+
+    cps_api_object_t filt = cps_api_object_list_get(param->filters,ix);
+    cps_api_object_attr_t vrf_attr = cps_api_object_attr_get(filt, NAS_RT_ROUTE_GRP_VRF_ID);
+    cps_api_object_attr_t af_attr = cps_api_object_attr_get(filt, NAS_RT_ROUTE_GRP_AF);
+    cps_api_object_attr_t prefix_attr = cps_api_object_attr_get(filt, NAS_RT_ROUTE_GRP_PREFIX);
+    cps_api_object_attr_t pref_len_attr = cps_api_object_attr_get(filt,
+                                                                  NAS_RT_ROUTE_GRP_PREFIX_LEN);
+
+    if ((af_attr == NULL) || (prefix_attr == NULL) || (pref_len_attr == NULL)) {
+        EV_LOG(ERR,ROUTE,0,"NAS-RT-CPS","AF, prefix and prefix length are needed "
+               "to get the route group");
+        return cps_api_ret_code_ERR;
+    }
+
+    if (vrf_attr != NULL) {
+        vrf_id = cps_api_object_attr_data_u32(vrf_attr);
+    }
+    af = cps_api_object_attr_data_u32(af_attr);
+    if(af == AF_INET) {
+        std_ip_from_inet(&ip, (struct in_addr *) cps_api_object_attr_data_bin(prefix_attr));
+    } else {
+        std_ip_from_inet6(&ip, (struct in6_addr *) cps_api_object_attr_data_bin(prefix_attr));
+    }
+
+    if (nas_route_get_route_grp(param->list, vrf_id, af, &ip,
+                                cps_api_object_attr_data_u32(pref_len_attr)) != STD_ERR_OK) {
+        return cps_api_ret_code_ERR;
+    }
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_ecmp_config_get_func (void *ctx,
+                                                                 cps_api_get_params_t * param,
+                                                                 size_t ix) {
+    t_std_error rc;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "ECMP config Get function");
+
+    if((rc = nas_route_get_ecmp_config(param->list)) != STD_ERR_OK){
+        return (cps_api_return_code_t)rc;
+    }
+    return cps_api_ret_code_OK;
+}
+
+/*
+ * The groups are programmed under the L3 lock of their AF, the config is
+ * changed under the locks of all the AFs so that a group is programmed
+ * with one config.
+ */
+static cps_api_return_code_t nas_route_cps_ecmp_config_set_func (void *ctx,
+                                                                 cps_api_transaction_params_t * param,
+                                                                 size_t ix) {
+    cps_api_object_t obj = cps_api_object_list_get(param->change_list,ix);
+    cps_api_object_attr_t attr;
+    cps_api_return_code_t rc = cps_api_ret_code_OK;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "ECMP config Set function");
+
+    if (obj == NULL) {
+        return cps_api_ret_code_ERR;
+    }
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_OTHER);
+
+    attr = cps_api_object_attr_get(obj, NAS_RT_ECMP_CONFIG_NATIVE_WEIGHT);
+    if (attr != NULL) {
+        hal_fib_set_ecmp_native_weight(cps_api_object_attr_data_u32(attr) != 0);
+    }
+
+    attr = cps_api_object_attr_get(obj, NAS_RT_ECMP_CONFIG_MAX_PATHS);
+    if ((attr != NULL) &&
+        (hal_fib_set_ecmp_max_paths(cps_api_object_attr_data_u32(attr)) != DN_HAL_ROUTE_E_NONE)) {
+        rc = cps_api_ret_code_ERR;
+    }
+
+    attr = cps_api_object_attr_get(obj, NAS_RT_ECMP_CONFIG_RESILIENT_BUCKETS);
+    if ((attr != NULL) &&
+        (hal_fib_set_ecmp_resilient_buckets(cps_api_object_attr_data_u32(attr)) !=
+         DN_HAL_ROUTE_E_NONE)) {
+        rc = cps_api_ret_code_ERR;
+    }
+
+    attr = cps_api_object_attr_get(obj, NAS_RT_ECMP_CONFIG_RESILIENT_HASH);
+    if (attr != NULL) {
+        hal_fib_set_ecmp_resilient_hash(cps_api_object_attr_data_u32(attr) != 0);
+    }
+
+    nas_l3_unlock();
+    return rc;
+}
+
+static cps_api_return_code_t nas_route_cps_vrf_cntrs_set_func (void *ctx,
+                                                               cps_api_transaction_params_t * param,
+                                                               size_t ix) {
+    cps_api_object_t obj = cps_api_object_list_get(param->change_list,ix);
+    cps_api_object_attr_t vrf_attr;
+    cps_api_object_attr_t af_attr;
+    uint32_t vrf_id;
+    uint8_t  af_index;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "VRF counters Set function");
+
+    if (obj == NULL) {
+        return cps_api_ret_code_ERR;
+    }
+
+    if (cps_api_object_attr_get(obj, NAS_RT_VRF_CNTRS_CLEAR) == NULL) {
+        return cps_api_ret_code_OK;
+    }
+
+    vrf_attr = cps_api_object_attr_get(obj, NAS_RT_VRF_CNTRS_VRF_ID);
+    af_attr = cps_api_object_attr_get(obj, NAS_RT_VRF_CNTRS_AF);
+
+    for (vrf_id = FIB_MIN_VRF; vrf_id < FIB_MAX_VRF; vrf_id++) {
+        if ((vrf_attr != NULL) && (cps_api_object_attr_data_u32(vrf_attr) != vrf_id))
+            continue;
+        if (hal_rt_access_fib_vrf(vrf_id) == NULL)
+            continue;
+
+        for (af_index = FIB_MIN_AFINDEX; af_index < FIB_MAX_AFINDEX; af_index++) {
+            if ((af_attr != NULL) && (cps_api_object_attr_data_u32(af_attr) != af_index))
+                continue;
+            hal_rt_fib_vrf_cntrs_clear(vrf_id, af_index);
+        }
+    }
+    return cps_api_ret_code_OK;
+}
+
+static cps_api_return_code_t nas_route_cps_ecmp_grp_stats_get_func (void *ctx,
+                                                                    cps_api_get_params_t * param,
+                                                                    size_t ix) {
+    t_std_error rc;
+    uint32_t    top_n = HAL_RT_ECMP_GRP_STATS_MAX_TOP_N;
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "ECMP group stats Get function");
+
+    cps_api_object_t filt = cps_api_object_list_get(param->filters,ix);
+    cps_api_object_attr_t top_n_attr = cps_api_object_attr_get(filt,
+                                                               NAS_RT_ECMP_GRP_STATS_TOP_N);
+    if (top_n_attr != NULL) {
+        top_n = cps_api_object_attr_data_u32(top_n_attr);
+    }
+
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_CPS_GET);
+    if((rc = nas_route_get_ecmp_grp_stats(param->list, top_n)) != STD_ERR_OK){
+        nas_l3_unlock();
+        return (cps_api_return_code_t)rc;
+    }
+    nas_l3_unlock();
+
+    return cps_api_ret_code_OK;
+}
+
 static cps_api_return_code_t nas_route_cps_peer_routing_rollback_func(void * ctx,
                               cps_api_transaction_params_t * param, size_t ix){
 
@@ -408,6 +722,103 @@ static t_std_error nas_route_object_peer_routing_init(cps_api_operation_handle_t
     return STD_ERR_OK;
 }
 
+static t_std_error nas_route_object_stats_init(cps_api_operation_handle_t nas_route_cps_handle ) {
+
+    cps_api_registration_functions_t f;
+
+    memset(&f,0,sizeof(f));
+
+    EV_LOG_TRACE(ev_log_t_ROUTE, 3, "NAS-RT-CPS", "NAS Routing Stats CPS Initialization");
+
+    f.handle                 = nas_route_cps_handle;
+    f._read_function         = nas_route_cps_ecmp_grp_pressure_get_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_GRP_PRESSURE_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_ecmp_grp_stats_get_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_GRP_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_cam_get_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_CAM_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_retry_get_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_RETRY_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_audit_get_func;
+    f._write_function        = nas_route_cps_audit_set_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_AUDIT_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_lock_get_func;
+    f._write_function        = nas_route_cps_lock_set_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_LOCK_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_vrf_cntrs_get_func;
+    f._write_function        = nas_route_cps_vrf_cntrs_set_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_VRF_CNTRS_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_route_grp_get_func;
+    f._write_function        = NULL;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ROUTE_GRP_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+
+    f._read_function         = nas_route_cps_ecmp_config_get_func;
+    f._write_function        = nas_route_cps_ecmp_config_set_func;
+
+    cps_api_key_init(&f.key,cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_CONFIG_OBJ,0);
+
+    if (cps_api_register(&f)!=cps_api_ret_code_OK) {
+        return STD_ERR(ROUTE,FAIL,0);
+    }
+    return STD_ERR_OK;
+}
+
 
 t_std_error nas_routing_cps_init(cps_api_operation_handle_t nas_route_cps_handle) {
 
@@ -433,6 +844,10 @@ t_std_error nas_routing_cps_init(cps_api_operation_handle_t nas_route_cps_handle
         return ret;
     }
 
+    if((ret = nas_route_object_stats_init(nas_route_cps_handle)) != STD_ERR_OK){
+        return ret;
+    }
+
     if((ret = nas_route_event_handle_init()) != STD_ERR_OK){
         return ret;
     }
@@ -504,7 +919,10 @@ t_std_error nas_route_process_cps_peer_routing(cps_api_transaction_params_t * pa
                  vrf_id, hal_rt_mac_to_str (&peer_routing_config.peer_mac_addr,
                                             p_buf, HAL_RT_MAX_BUFSZ),
                  peer_routing_config.status);
-    if ((rc = hal_rt_process_peer_routing_config(vrf_id, &peer_routing_config)) != STD_ERR_OK) {
+    nas_l3_lock_at(HAL_RT_LOCK_SITE_PEER_CONFIG);
+    rc = hal_rt_process_peer_routing_config(vrf_id, &peer_routing_config);
+    nas_l3_unlock();
+    if (rc != STD_ERR_OK) {
         EV_LOG_ERR (ev_log_t_ROUTE, 3, "NAS-RT-CPS-SET", "hal_rt_process_peer_routing_config failed");
         return cps_api_ret_code_ERR;
     }
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+
+/*
+ * nas_route_addr_fmt_unittest.cpp
+ *
+ * The address formatters of the trace logs against inet_ntop.
+ */
+
+extern "C" {
+#include "hal_rt_util.h"
+}
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RT_FMT_TEST_NUM_RANDOM    10000
+
+static void rt_fmt_test_ipv6 (const uint8_t *p_addr)
+{
+    char exp [INET6_ADDRSTRLEN];
+    char buf [INET6_ADDRSTRLEN];
+
+    ASSERT_TRUE(inet_ntop (AF_INET6, p_addr, exp, sizeof (exp)) != NULL);
+    ASSERT_STREQ(fib_ipv6_addr_to_str (p_addr, buf), exp);
+}
+
+static void rt_fmt_test_ipv6_str (const char *p_str)
+{
+    uint8_t addr [16];
+
+    ASSERT_EQ(inet_pton (AF_INET6, p_str, addr), 1);
+    rt_fmt_test_ipv6 (addr);
+}
+
+static void rt_fmt_test_ipv4_str (const char *p_str)
+{
+    uint8_t addr [4];
+    char    exp [INET_ADDRSTRLEN];
+    char    buf [INET_ADDRSTRLEN];
+
+    ASSERT_EQ(inet_pton (AF_INET, p_str, addr), 1);
+    ASSERT_TRUE(inet_ntop (AF_INET, addr, exp, sizeof (exp)) != NULL);
+    ASSERT_STREQ(fib_ipv4_addr_to_str (addr, buf), exp);
+}
+
+TEST(std_nas_route_test, nas_route_ipv4_addr_fmt) {
+    rt_fmt_test_ipv4_str ("0.0.0.0");
+    rt_fmt_test_ipv4_str ("255.255.255.255");
+    rt_fmt_test_ipv4_str ("10.0.100.9");
+    rt_fmt_test_ipv4_str ("192.168.1.254");
+}
+
+TEST(std_nas_route_test, nas_route_ipv6_addr_fmt) {
+    /* All zero, loopback and a trailing zero run */
+    rt_fmt_test_ipv6_str ("::");
+    rt_fmt_test_ipv6_str ("::1");
+    rt_fmt_test_ipv6_str ("1::");
+
+    /* IPv4 mapped and compatible */
+    rt_fmt_test_ipv6_str ("::ffff:1.2.3.4");
+    rt_fmt_test_ipv6_str ("::ffff:0.0.0.0");
+    rt_fmt_test_ipv6_str ("::1.2.3.4");
+    rt_fmt_test_ipv6_str ("::0.0.1.0");
+    rt_fmt_test_ipv6_str ("::ffff:0:1.2.3.4");
+
+    /* Two zero runs of the same length, the first one is compressed */
+    rt_fmt_test_ipv6_str ("1:0:0:2:3:0:0:4");
+    rt_fmt_test_ipv6_str ("1:0:0:2:0:0:3:4");
+
+    /* A single zero word is not compressed */
+    rt_fmt_test_ipv6_str ("1:2:3:0:4:5:6:7");
+    rt_fmt_test_ipv6_str ("0:1:2:3:4:5:6:7");
+    rt_fmt_test_ipv6_str ("1:2:3:4:5:6:7:0");
+
+    /* No zero word, leading zeros and upper hex digits */
+    rt_fmt_test_ipv6_str ("2001:db8:a:b:c:d:e:f");
+    rt_fmt_test_ipv6_str ("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff");
+    rt_fmt_test_ipv6_str ("fe80::10:200:3000");
+}
+
+/* Random addresses, most words are zero to get many zero runs */
+TEST(std_nas_route_test, nas_route_ipv6_addr_fmt_random) {
+    uint8_t  addr [16];
+    int      ix, word;
+
+    srand (1);
+    for (ix = 0; ix < RT_FMT_TEST_NUM_RANDOM; ix++) {
+        memset (addr, 0, sizeof (addr));
+        for (word = 0; word < 8; word++) {
+            if ((rand () % 3) == 0) {
+                addr [2 * word] = (uint8_t) (rand () & 0xff);
+                addr [(2 * word) + 1] = (uint8_t) (rand () & 0xff);
+            }
+        }
+        rt_fmt_test_ipv6 (addr);
+        if (HasFatalFailure ())
+            return;
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
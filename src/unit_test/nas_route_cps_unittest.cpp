@@ -36,6 +36,7 @@
 #include "cps_api_operation.h"
 #include "cps_class_map.h"
 #include "cps_api_object_key.h"
+#include "cps_api_object_category.h"
 
 
 
@@ -45,6 +46,13 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <net/if.h>
+#include <string.h>
+#include <time.h>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <string>
+#include <unistd.h>
 
 cps_api_object_list_t list_of_objects;
 
@@ -510,6 +518,155 @@ TEST(std_nas_route_test, nas_route_mp_set) {
 
 }
 
+/*
+ * Group of a route as written to NPU 0, read from the route group stats
+ * object. The first hops are mapped by address to {member count, weight}.
+ */
+typedef struct {
+    uint64_t gid;
+    uint32_t num_members;
+    bool     is_indirect;
+    bool     is_resilient;
+    std::map<std::string, std::pair<uint32_t, uint32_t> > fh;
+} nas_rt_ut_grp_t;
+
+#define NAS_RT_UT_GRP_WAIT_MS  5000
+
+static bool nas_rt_ut_route_grp_get(const char *prefix, uint32_t prefix_len,
+                                    nas_rt_ut_grp_t *p_grp) {
+    cps_api_get_params_t gp;
+    uint32_t ip;
+    struct in_addr a;
+    bool rc = false;
+
+    if (cps_api_get_request_init(&gp) != cps_api_ret_code_OK) return false;
+
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append(gp.filters);
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ROUTE_GRP_OBJ,0);
+    inet_aton(prefix,&a);
+    ip=a.s_addr;
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_VRF_ID, 0);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_AF, AF_INET);
+    cps_api_object_attr_add(obj, NAS_RT_ROUTE_GRP_PREFIX, &ip, sizeof(ip));
+    cps_api_object_attr_add_u32(obj, NAS_RT_ROUTE_GRP_PREFIX_LEN, prefix_len);
+
+    p_grp->fh.clear();
+    if ((cps_api_get(&gp) == cps_api_ret_code_OK) && (cps_api_object_list_size(gp.list) == 1)) {
+        obj = cps_api_object_list_get(gp.list,0);
+        p_grp->gid = cps_api_object_attr_data_u64(
+                         cps_api_object_attr_get(obj, NAS_RT_ROUTE_GRP_GID));
+        p_grp->num_members = cps_api_object_attr_data_u32(
+                                 cps_api_object_attr_get(obj, NAS_RT_ROUTE_GRP_NUM_MEMBERS));
+        p_grp->is_indirect = cps_api_object_attr_data_u32(
+                                 cps_api_object_attr_get(obj, NAS_RT_ROUTE_GRP_IS_INDIRECT));
+        p_grp->is_resilient = cps_api_object_attr_data_u32(
+                                  cps_api_object_attr_get(obj, NAS_RT_ROUTE_GRP_IS_RESILIENT));
+
+        cps_api_attr_id_t ids[3] = {NAS_RT_ROUTE_GRP_FH, 0, NAS_RT_ROUTE_GRP_FH_ADDR};
+        for (ids[1] = 0; ; ids[1]++) {
+            char addr[INET_ADDRSTRLEN];
+            ids[2] = NAS_RT_ROUTE_GRP_FH_ADDR;
+            cps_api_object_attr_t addr_attr = cps_api_object_e_get(obj, ids, 3);
+            if (addr_attr == NULL) break;
+            inet_ntop(AF_INET, cps_api_object_attr_data_bin(addr_attr), addr, sizeof(addr));
+
+            ids[2] = NAS_RT_ROUTE_GRP_FH_COUNT;
+            uint32_t count = cps_api_object_attr_data_u32(cps_api_object_e_get(obj, ids, 3));
+            ids[2] = NAS_RT_ROUTE_GRP_FH_WEIGHT;
+            uint32_t weight = cps_api_object_attr_data_u32(cps_api_object_e_get(obj, ids, 3));
+            p_grp->fh[addr] = std::make_pair(count, weight);
+        }
+        rc = true;
+    }
+    cps_api_get_request_close(&gp);
+    return rc;
+}
+
+/*
+ * The routes are written by the FIB walkers after the CPS commit returns,
+ * wait until the group of the route has the first hop (or not).
+ */
+static bool nas_rt_ut_route_grp_wait(const char *prefix, uint32_t prefix_len,
+                                     const char *fh_ip, bool is_present,
+                                     nas_rt_ut_grp_t *p_grp) {
+    for (uint32_t ms = 0; ms < NAS_RT_UT_GRP_WAIT_MS; ms += 100) {
+        if ((nas_rt_ut_route_grp_get(prefix, prefix_len, p_grp)) &&
+            ((p_grp->fh.count(fh_ip) != 0) == is_present))
+            return true;
+        usleep(100 * 1000);
+    }
+    return false;
+}
+
+/*
+ * Keep two of the NHs from nas_route_mp_set and add a new one, so that the
+ * existing ECMP group is updated in place (one member add, one member remove)
+ */
+TEST(std_nas_route_test, nas_route_mp_member_update) {
+    nas_rt_ut_grp_t old_grp, grp;
+
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("6.6.6.6", 32, "2.2.2.3", true, &old_grp));
+    ASSERT_NE(old_grp.gid, 0u);
+
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+              BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_AF,AF_INET);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,32);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_VRF_ID,0);
+
+    uint32_t ip;
+    struct in_addr a;
+    inet_aton("6.6.6.6",&a);
+    ip=a.s_addr;
+
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&ip,sizeof(ip));
+    cps_api_attr_id_t ids[3];
+    const int ids_len = sizeof(ids)/sizeof(*ids);
+    ids[0] = BASE_ROUTE_OBJ_ENTRY_NH_LIST;
+    ids[1] = 0;
+    ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+
+    inet_aton("4.4.4.3",&a);
+    ip=a.s_addr;
+    cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+                    &ip,sizeof(ip));
+    ids[1] = 1;
+    inet_aton("1.1.1.3",&a);
+    ip=a.s_addr;
+    cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+            &ip,sizeof(ip));
+
+    ids[1] = 2;
+    inet_aton("2.2.2.4",&a);
+    ip=a.s_addr;
+    cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+            &ip,sizeof(ip));
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_NH_COUNT,3);
+
+    /*
+     * CPS transaction
+     */
+    cps_api_transaction_params_t tr;
+    ASSERT_TRUE(cps_api_transaction_init(&tr)==cps_api_ret_code_OK);
+    cps_api_set(&tr,obj);
+    ASSERT_TRUE(cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+
+    /* The same group now has 2.2.2.4 in place of 2.2.2.3, once each */
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("6.6.6.6", 32, "2.2.2.4", true, &grp));
+    ASSERT_EQ(grp.gid, old_grp.gid);
+    ASSERT_EQ(grp.fh.count("2.2.2.3"), 0u);
+    ASSERT_EQ(grp.fh.size(), 3u);
+    ASSERT_EQ(grp.num_members, 3u);
+    for (auto &fh : grp.fh) {
+        ASSERT_EQ(fh.second.first, 1u) << fh.first;
+    }
+}
+
 
 TEST(std_nas_route_test, nas_route_mp_delete) {
 
@@ -657,6 +814,656 @@ TEST(std_nas_route_test, nas_route_delete_scale) {
 
 }
 
+/*
+ * NH failure fast reroute benchmark:
+ * 500k routes spread over 16 ECMP groups, every group shares the NH 6.6.6.2.
+ * Deleting the neighbor 6.6.6.2 should shrink the 16 groups once, instead of
+ * re-programming the 500k routes.
+ */
+#define NAS_RT_FRR_SCALE_ROUTES  500000
+#define NAS_RT_FRR_SCALE_GROUPS  16
+#define NAS_RT_FRR_SHARED_NH     "6.6.6.2"
+
+static double nas_rt_ut_time_diff_ms(struct timespec *start, struct timespec *end) {
+    return ((end->tv_sec - start->tv_sec) * 1000.0) +
+           ((end->tv_nsec - start->tv_nsec) / 1000000.0);
+}
+
+static bool nas_rt_ut_nbr_cfg(const char *nbr_ip, bool is_add) {
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+              BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_NBR_AF,AF_INET);
+
+    uint32_t ip;
+    struct in_addr a;
+    inet_aton(nbr_ip,&a);
+    ip=a.s_addr;
+
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_NBR_ADDRESS,&ip,sizeof(ip));
+    int port_index = if_nametoindex("e101-001-0");
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_NBR_IFINDEX, port_index);
+
+    if (is_add) {
+        hal_mac_addr_t mac_addr = {0x00, 0x00, 0x00, 0xaa, 0xbb, (uint8_t)(ip >> 24)};
+        cps_api_object_attr_add(obj, BASE_ROUTE_OBJ_NBR_MAC_ADDR, &mac_addr, HAL_MAC_ADDR_LEN);
+    }
+
+    cps_api_transaction_params_t tr;
+    if (cps_api_transaction_init(&tr)!=cps_api_ret_code_OK) return false;
+    if (is_add) cps_api_create(&tr,obj);
+    else cps_api_delete(&tr,obj);
+    bool rc = (cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+    return rc;
+}
+
+static bool nas_rt_ut_frr_route_cfg(uint32_t route_ix, bool is_add) {
+    char ip_addr[256];
+    uint32_t ip;
+    struct in_addr a;
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+           BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_AF,AF_INET);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_VRF_ID,0);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,32);
+
+    snprintf(ip_addr,sizeof(ip_addr), "12.%d.%d.%d",(route_ix >> 16) & 0xff,
+             (route_ix >> 8) & 0xff, route_ix & 0xff);
+    inet_aton(ip_addr,&a);
+    ip=a.s_addr;
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&ip,sizeof(ip));
+
+    if (is_add) {
+        /* Group g: shared NH + 6.6.6.(10+3g), 6.6.6.(11+3g), 6.6.6.(12+3g) */
+        uint32_t grp = route_ix % NAS_RT_FRR_SCALE_GROUPS;
+        cps_api_attr_id_t ids[3];
+        const int ids_len = sizeof(ids)/sizeof(*ids);
+        ids[0] = BASE_ROUTE_OBJ_ENTRY_NH_LIST;
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+
+        for (int nh = 0; nh < 4; nh++) {
+            if (nh == 0) {
+                snprintf(ip_addr,sizeof(ip_addr), NAS_RT_FRR_SHARED_NH);
+            } else {
+                snprintf(ip_addr,sizeof(ip_addr), "6.6.6.%d", 9 + (3 * grp) + nh);
+            }
+            inet_aton(ip_addr,&a);
+            ip=a.s_addr;
+            ids[1] = nh;
+            cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+                    &ip,sizeof(ip));
+        }
+        cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_NH_COUNT,4);
+    }
+
+    cps_api_transaction_params_t tr;
+    if (cps_api_transaction_init(&tr)!=cps_api_ret_code_OK) return false;
+    if (is_add) cps_api_create(&tr,obj);
+    else cps_api_delete(&tr,obj);
+    bool rc = (cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+    return rc;
+}
+
+TEST(std_nas_route_test, nas_route_nh_fast_reroute_scale) {
+    char nbr_ip[64];
+    char prefix[64];
+    uint32_t ix;
+    struct timespec start, end;
+    nas_rt_ut_grp_t grp;
+    uint64_t a_gid[NAS_RT_FRR_SCALE_GROUPS];
+
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(NAS_RT_FRR_SHARED_NH, true));
+    for (ix = 0; ix < (3 * NAS_RT_FRR_SCALE_GROUPS); ix++) {
+        snprintf(nbr_ip, sizeof(nbr_ip), "6.6.6.%d", 10 + ix);
+        ASSERT_TRUE(nas_rt_ut_nbr_cfg(nbr_ip, true));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (ix = 0; ix < NAS_RT_FRR_SCALE_ROUTES; ix++) {
+        ASSERT_TRUE(nas_rt_ut_frr_route_cfg(ix, true));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Sent %d ECMP Routes over %d groups in %.2f ms\n", NAS_RT_FRR_SCALE_ROUTES,
+           NAS_RT_FRR_SCALE_GROUPS, nas_rt_ut_time_diff_ms(&start, &end));
+
+    /* The first route of each group, 12.0.0.g */
+    for (ix = 0; ix < NAS_RT_FRR_SCALE_GROUPS; ix++) {
+        snprintf(prefix, sizeof(prefix), "12.0.0.%d", ix);
+        ASSERT_TRUE(nas_rt_ut_route_grp_wait(prefix, 32, NAS_RT_FRR_SHARED_NH, true, &grp));
+        ASSERT_EQ(grp.num_members, 4u) << prefix;
+        a_gid[ix] = grp.gid;
+    }
+
+    /*
+     * Fail the NH shared by all the groups
+     */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(NAS_RT_FRR_SHARED_NH, false));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Shared NH %s failure processed in %.2f ms\n", NAS_RT_FRR_SHARED_NH,
+           nas_rt_ut_time_diff_ms(&start, &end));
+
+    /* Each group is shrunk in place, the routes keep their group */
+    for (ix = 0; ix < NAS_RT_FRR_SCALE_GROUPS; ix++) {
+        snprintf(prefix, sizeof(prefix), "12.0.0.%d", ix);
+        ASSERT_TRUE(nas_rt_ut_route_grp_wait(prefix, 32, NAS_RT_FRR_SHARED_NH, false, &grp));
+        ASSERT_EQ(grp.gid, a_gid[ix]) << prefix;
+        ASSERT_EQ(grp.fh.size(), 3u) << prefix;
+        ASSERT_EQ(grp.num_members, 3u) << prefix;
+    }
+
+    for (ix = 0; ix < NAS_RT_FRR_SCALE_ROUTES; ix++) {
+        ASSERT_TRUE(nas_rt_ut_frr_route_cfg(ix, false));
+    }
+    for (ix = 0; ix < (3 * NAS_RT_FRR_SCALE_GROUPS); ix++) {
+        snprintf(nbr_ip, sizeof(nbr_ip), "6.6.6.%d", 10 + ix);
+        ASSERT_TRUE(nas_rt_ut_nbr_cfg(nbr_ip, false));
+    }
+}
+
+#define NAS_RT_RECUR_SCALE_ROUTES  100000
+#define NAS_RT_RECUR_NH            "13.0.0.1"
+
+static bool nas_rt_ut_route_cfg(const char *prefix, uint32_t prefix_len,
+                                const char *nh_ip[], uint32_t nh_count,
+                                cps_api_operation_types_t op) {
+    uint32_t ip;
+    struct in_addr a;
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+           BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_AF,AF_INET);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_VRF_ID,0);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,prefix_len);
+
+    inet_aton(prefix,&a);
+    ip=a.s_addr;
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&ip,sizeof(ip));
+
+    if (op != cps_api_oper_DELETE) {
+        cps_api_attr_id_t ids[3];
+        const int ids_len = sizeof(ids)/sizeof(*ids);
+        ids[0] = BASE_ROUTE_OBJ_ENTRY_NH_LIST;
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+
+        for (uint32_t nh = 0; nh < nh_count; nh++) {
+            inet_aton(nh_ip[nh],&a);
+            ip=a.s_addr;
+            ids[1] = nh;
+            cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+                    &ip,sizeof(ip));
+        }
+        cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_NH_COUNT,nh_count);
+    }
+
+    cps_api_transaction_params_t tr;
+    if (cps_api_transaction_init(&tr)!=cps_api_ret_code_OK) return false;
+    if (op == cps_api_oper_CREATE) cps_api_create(&tr,obj);
+    else if (op == cps_api_oper_SET) cps_api_set(&tr,obj);
+    else cps_api_delete(&tr,obj);
+    bool rc = (cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+    return rc;
+}
+
+/*
+ * Routes resolved through one recursive NH share the indirect group of the
+ * NH, the underlay change has to update only that group.
+ */
+TEST(std_nas_route_test, nas_route_recursive_nh_underlay_change) {
+    const char *igp_nh[] = {"6.6.6.40", "6.6.6.41"};
+    const char *recur_nh[] = {NAS_RT_RECUR_NH};
+    char prefix[64];
+    uint32_t ix;
+    struct timespec start, end;
+    nas_rt_ut_grp_t old_grp, grp;
+
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(igp_nh[0], true));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(igp_nh[1], true));
+    ASSERT_TRUE(nas_rt_ut_route_cfg(NAS_RT_RECUR_NH, 32, igp_nh, 2, cps_api_oper_CREATE));
+
+    for (ix = 0; ix < NAS_RT_RECUR_SCALE_ROUTES; ix++) {
+        snprintf(prefix, sizeof(prefix), "14.%d.%d.%d", (ix >> 16) & 0xff,
+                 (ix >> 8) & 0xff, ix & 0xff);
+        ASSERT_TRUE(nas_rt_ut_route_cfg(prefix, 32, recur_nh, 1, cps_api_oper_CREATE));
+    }
+
+    /* The routes point to the indirect group of the recursive NH */
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("14.0.0.0", 32, igp_nh[1], true, &old_grp));
+    ASSERT_TRUE(old_grp.is_indirect);
+    ASSERT_NE(old_grp.gid, 0u);
+    ASSERT_EQ(old_grp.fh.size(), 2u);
+
+    /*
+     * Underlay change: remove one of the IGP paths to the recursive NH
+     */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ASSERT_TRUE(nas_rt_ut_route_cfg(NAS_RT_RECUR_NH, 32, igp_nh, 1, cps_api_oper_SET));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Underlay change for %d recursive routes processed in %.2f ms\n",
+           NAS_RT_RECUR_SCALE_ROUTES, nas_rt_ut_time_diff_ms(&start, &end));
+
+    /* The indirect group is updated in place, the routes are not rewritten */
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("14.0.0.0", 32, igp_nh[1], false, &grp));
+    ASSERT_TRUE(grp.is_indirect);
+    ASSERT_EQ(grp.gid, old_grp.gid);
+    ASSERT_EQ(grp.fh.size(), 1u);
+    ASSERT_EQ(grp.fh.count(igp_nh[0]), 1u);
+
+    for (ix = 0; ix < NAS_RT_RECUR_SCALE_ROUTES; ix++) {
+        snprintf(prefix, sizeof(prefix), "14.%d.%d.%d", (ix >> 16) & 0xff,
+                 (ix >> 8) & 0xff, ix & 0xff);
+        ASSERT_TRUE(nas_rt_ut_route_cfg(prefix, 32, NULL, 0, cps_api_oper_DELETE));
+    }
+    ASSERT_TRUE(nas_rt_ut_route_cfg(NAS_RT_RECUR_NH, 32, NULL, 0, cps_api_oper_DELETE));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(igp_nh[0], false));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(igp_nh[1], false));
+}
+
+/*
+ * Weighted ECMP: 3:1 traffic split between the two NHs
+ */
+TEST(std_nas_route_test, nas_route_wecmp_add) {
+    const char *nh_ip[] = {"6.6.6.40", "6.6.6.41"};
+    const uint32_t nh_weight[] = {3, 1};
+    uint32_t ip;
+    struct in_addr a;
+
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[0], true));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[1], true));
+
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+           BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_AF,AF_INET);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_VRF_ID,0);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,32);
+
+    inet_aton("15.0.0.1",&a);
+    ip=a.s_addr;
+    cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&ip,sizeof(ip));
+
+    cps_api_attr_id_t ids[3];
+    const int ids_len = sizeof(ids)/sizeof(*ids);
+    ids[0] = BASE_ROUTE_OBJ_ENTRY_NH_LIST;
+
+    for (uint32_t nh = 0; nh < 2; nh++) {
+        ids[1] = nh;
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+        inet_aton(nh_ip[nh],&a);
+        ip=a.s_addr;
+        cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+                &ip,sizeof(ip));
+        ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_WEIGHT;
+        cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_U32,
+                &nh_weight[nh],sizeof(nh_weight[nh]));
+    }
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_NH_COUNT,2);
+
+    cps_api_transaction_params_t tr;
+    ASSERT_TRUE(cps_api_transaction_init(&tr)==cps_api_ret_code_OK);
+    cps_api_create(&tr,obj);
+    ASSERT_TRUE(cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+
+    /*
+     * 3:1 either as the member weights or as the member replicas,
+     * depending on NAS_RT_ECMP_CONFIG_NATIVE_WEIGHT
+     */
+    nas_rt_ut_grp_t grp;
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("15.0.0.1", 32, nh_ip[1], true, &grp));
+    ASSERT_NE(grp.gid, 0u);
+    ASSERT_EQ(grp.fh.size(), 2u);
+    ASSERT_EQ(grp.fh[nh_ip[0]].first * grp.fh[nh_ip[0]].second, 3u);
+    ASSERT_EQ(grp.fh[nh_ip[1]].first * grp.fh[nh_ip[1]].second, 1u);
+    ASSERT_EQ(grp.num_members, grp.fh[nh_ip[0]].first + grp.fh[nh_ip[1]].first);
+
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.1", 32, NULL, 0, cps_api_oper_DELETE));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[0], false));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[1], false));
+}
+
+static bool nas_rt_ut_ecmp_config_set(cps_api_attr_id_t attr_id, uint32_t value) {
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_CONFIG_OBJ,0);
+    cps_api_object_attr_add_u32(obj, attr_id, value);
+
+    cps_api_transaction_params_t tr;
+    if (cps_api_transaction_init(&tr)!=cps_api_ret_code_OK) return false;
+    cps_api_set(&tr,obj);
+    bool rc = (cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+    return rc;
+}
+
+/*
+ * ECMP width of 2: a route to 4 NHs gets a group of 2 members
+ */
+TEST(std_nas_route_test, nas_route_ecmp_max_paths_set) {
+    const char *nh_ip[] = {"6.6.6.40", "6.6.6.41", "6.6.6.42", "6.6.6.43"};
+    nas_rt_ut_grp_t grp;
+    uint32_t nh;
+
+    ASSERT_FALSE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_MAX_PATHS, 0));
+    ASSERT_TRUE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_MAX_PATHS, 2));
+
+    for (nh = 0; nh < 4; nh++) {
+        ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[nh], true));
+    }
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.2", 32, nh_ip, 4, cps_api_oper_CREATE));
+
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("15.0.0.2", 32, nh_ip[0], true, &grp));
+    ASSERT_EQ(grp.num_members, 2u);
+
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.2", 32, NULL, 0, cps_api_oper_DELETE));
+    for (nh = 0; nh < 4; nh++) {
+        ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[nh], false));
+    }
+    ASSERT_TRUE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_MAX_PATHS, 64));
+}
+
+/*
+ * Resilient group of 16 buckets shared equally by 2 NHs
+ */
+TEST(std_nas_route_test, nas_route_ecmp_resilient_add) {
+    const char *nh_ip[] = {"6.6.6.40", "6.6.6.41"};
+    nas_rt_ut_grp_t grp;
+
+    ASSERT_TRUE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_RESILIENT_BUCKETS, 16));
+    ASSERT_TRUE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_RESILIENT_HASH, 1));
+
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[0], true));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[1], true));
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.3", 32, nh_ip, 2, cps_api_oper_CREATE));
+
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("15.0.0.3", 32, nh_ip[1], true, &grp));
+    ASSERT_TRUE(grp.is_resilient);
+    ASSERT_EQ(grp.num_members, 16u);
+    ASSERT_EQ(grp.fh[nh_ip[0]].first, 8u);
+    ASSERT_EQ(grp.fh[nh_ip[1]].first, 8u);
+
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.3", 32, NULL, 0, cps_api_oper_DELETE));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[0], false));
+    ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[1], false));
+    ASSERT_TRUE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_RESILIENT_HASH, 0));
+    ASSERT_TRUE(nas_rt_ut_ecmp_config_set(NAS_RT_ECMP_CONFIG_RESILIENT_BUCKETS, 64));
+}
+
+/*
+ * A third NH does not fit in the group of 2, the group is replaced and the
+ * old one is parked. Going back to the 2 NHs reuses the parked group, which
+ * has to be still present in the NPU for the route to be written.
+ */
+#define NAS_RT_UT_GRP_GC_WAIT_S  10  /* Twice the default GC grace period */
+
+TEST(std_nas_route_test, nas_route_ecmp_grp_replace_revert) {
+    const char *nh_ip[] = {"6.6.6.40", "6.6.6.41", "6.6.6.42"};
+    nas_rt_ut_grp_t old_grp, grp;
+    uint32_t nh;
+
+    for (nh = 0; nh < 3; nh++) {
+        ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[nh], true));
+    }
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.4", 32, nh_ip, 2, cps_api_oper_CREATE));
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("15.0.0.4", 32, nh_ip[1], true, &old_grp));
+    ASSERT_NE(old_grp.gid, 0u);
+
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.4", 32, nh_ip, 3, cps_api_oper_SET));
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("15.0.0.4", 32, nh_ip[2], true, &grp));
+    ASSERT_NE(grp.gid, old_grp.gid);
+    ASSERT_EQ(grp.num_members, 3u);
+
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.4", 32, nh_ip, 2, cps_api_oper_SET));
+    ASSERT_TRUE(nas_rt_ut_route_grp_wait("15.0.0.4", 32, nh_ip[2], false, &grp));
+    ASSERT_EQ(grp.gid, old_grp.gid);
+    ASSERT_EQ(grp.num_members, 2u);
+    ASSERT_EQ(grp.fh.count(nh_ip[0]), 1u);
+    ASSERT_EQ(grp.fh.count(nh_ip[1]), 1u);
+
+    /* The route is still resolved once the grace period of the GC is over */
+    sleep(NAS_RT_UT_GRP_GC_WAIT_S);
+    ASSERT_TRUE(nas_rt_ut_route_grp_get("15.0.0.4", 32, &grp));
+    ASSERT_EQ(grp.gid, old_grp.gid);
+    ASSERT_EQ(grp.num_members, 2u);
+
+    ASSERT_TRUE(nas_rt_ut_route_cfg("15.0.0.4", 32, NULL, 0, cps_api_oper_DELETE));
+    for (nh = 0; nh < 3; nh++) {
+        ASSERT_TRUE(nas_rt_ut_nbr_cfg(nh_ip[nh], false));
+    }
+}
+
+/*
+ * IPv4 and IPv6 routes from concurrent clients: the routes are added one
+ * AF after the other, then by a thread per AF at the same time, and the
+ * IPv4 routes are read while the IPv6 routes are deleted. The test checks
+ * that no request fails and prints the routes/sec of each AF, the
+ * concurrent v4+v6 routes/sec and its speedup over the sequential adds.
+ * The L3 lock profiler gives the wait of the route ingest for the L3
+ * locks during the concurrent adds, the writers of the AFs take the locks
+ * of their own AF only. The requests of the AFs are handled concurrently
+ * only with NAS_RT_CPS_THREADS set to 2 or more in the process under test.
+ */
+#define NAS_RT_AF_SCALE_ROUTES  50000
+
+static bool nas_rt_ut_af_route_cfg(uint32_t af, uint32_t route_ix, bool is_add) {
+    char ip_addr[256];
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),
+           BASE_ROUTE_OBJ_OBJ,cps_api_qualifier_TARGET);
+
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_AF,af);
+    cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_VRF_ID,0);
+
+    cps_api_attr_id_t ids[3];
+    const int ids_len = sizeof(ids)/sizeof(*ids);
+    ids[0] = BASE_ROUTE_OBJ_ENTRY_NH_LIST;
+    ids[1] = 0;
+    ids[2] = BASE_ROUTE_OBJ_ENTRY_NH_LIST_NH_ADDR;
+
+    if (af == AF_INET) {
+        struct in_addr a;
+        cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,32);
+        snprintf(ip_addr,sizeof(ip_addr), "16.%d.%d.%d",(route_ix >> 16) & 0xff,
+                 (route_ix >> 8) & 0xff, route_ix & 0xff);
+        inet_pton(AF_INET,ip_addr,&a);
+        cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&a,sizeof(a));
+        if (is_add) {
+            inet_pton(AF_INET,"6.6.6.2",&a);
+            cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+                    &a,sizeof(a));
+        }
+    } else {
+        struct in6_addr a6;
+        cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_PREFIX_LEN,128);
+        snprintf(ip_addr,sizeof(ip_addr), "2016::%x:%x",(route_ix >> 16) & 0xffff,
+                 route_ix & 0xffff);
+        inet_pton(AF_INET6,ip_addr,&a6);
+        cps_api_object_attr_add(obj,BASE_ROUTE_OBJ_ENTRY_ROUTE_PREFIX,&a6,sizeof(a6));
+        if (is_add) {
+            inet_pton(AF_INET6,"6666::2",&a6);
+            cps_api_object_e_add(obj,ids,ids_len,cps_api_object_ATTR_T_BIN,
+                    &a6,sizeof(a6));
+        }
+    }
+    if (is_add)
+        cps_api_object_attr_add_u32(obj,BASE_ROUTE_OBJ_ENTRY_NH_COUNT,1);
+
+    cps_api_transaction_params_t tr;
+    if (cps_api_transaction_init(&tr)!=cps_api_ret_code_OK) return false;
+    if (is_add) cps_api_create(&tr,obj);
+    else cps_api_delete(&tr,obj);
+    bool rc = (cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+    return rc;
+}
+
+static void nas_rt_ut_af_routes_cfg(uint32_t af, bool is_add, std::atomic<uint32_t> *p_failed) {
+    for (uint32_t ix = 0; ix < NAS_RT_AF_SCALE_ROUTES; ix++) {
+        if (!nas_rt_ut_af_route_cfg(af, ix, is_add))
+            (*p_failed)++;
+    }
+}
+
+static void nas_rt_ut_af_routes_cfg_timed(uint32_t af, bool is_add,
+                                          std::atomic<uint32_t> *p_failed, double *p_ms) {
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    nas_rt_ut_af_routes_cfg(af, is_add, p_failed);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *p_ms = nas_rt_ut_time_diff_ms(&start, &end);
+}
+
+static bool nas_rt_ut_lock_prof_set(bool is_enabled) {
+    cps_api_object_t obj = cps_api_object_create();
+
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_LOCK_OBJ,0);
+    cps_api_object_attr_add_u32(obj, NAS_RT_LOCK_ENABLE, is_enabled);
+
+    cps_api_transaction_params_t tr;
+    if (cps_api_transaction_init(&tr)!=cps_api_ret_code_OK) return false;
+    cps_api_set(&tr,obj);
+    bool rc = (cps_api_commit(&tr)==cps_api_ret_code_OK);
+    cps_api_transaction_close(&tr);
+    return rc;
+}
+
+/* The acquires and the total wait in usecs of the call site of the name */
+static bool nas_rt_ut_lock_wait_get(const char *site_name, uint32_t *p_acquired,
+                                    uint64_t *p_tot_wait) {
+    cps_api_get_params_t gp;
+    bool rc = false;
+
+    cps_api_get_request_init(&gp);
+    cps_api_object_t flt = cps_api_object_list_create_obj_and_append(gp.filters);
+    cps_api_key_init(cps_api_object_key(flt),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_LOCK_OBJ,0);
+
+    if (cps_api_get(&gp)==cps_api_ret_code_OK) {
+        size_t mx = cps_api_object_list_size(gp.list);
+        for (size_t ix = 0; ix < mx; ix++) {
+            cps_api_object_t obj = cps_api_object_list_get(gp.list,ix);
+            cps_api_object_attr_t name = cps_api_object_attr_get(obj, NAS_RT_LOCK_SITE_NAME);
+            cps_api_object_attr_t acquired = cps_api_object_attr_get(obj, NAS_RT_LOCK_ACQUIRED);
+            cps_api_object_attr_t tot_wait = cps_api_object_attr_get(obj, NAS_RT_LOCK_TOT_WAIT);
+
+            if ((name == NULL) || (acquired == NULL) || (tot_wait == NULL) ||
+                (strcmp((const char *)cps_api_object_attr_data_bin(name), site_name) != 0))
+                continue;
+
+            *p_acquired = cps_api_object_attr_data_u32(acquired);
+            *p_tot_wait = cps_api_object_attr_data_u64(tot_wait);
+            rc = true;
+            break;
+        }
+    }
+    cps_api_get_request_close(&gp);
+    return rc;
+}
+
+static bool nas_rt_ut_af_routes_get(uint32_t af) {
+    cps_api_get_params_t gp;
+    cps_api_get_request_init(&gp);
+
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append(gp.filters);
+    cps_api_key_from_attr_with_qual(cps_api_object_key(obj),BASE_ROUTE_OBJ_ENTRY,
+                                        cps_api_qualifier_TARGET);
+    cps_api_set_key_data(obj,BASE_ROUTE_OBJ_ENTRY_AF,cps_api_object_ATTR_T_U32,
+                                 &af,sizeof(af));
+
+    bool rc = (cps_api_get(&gp)==cps_api_ret_code_OK);
+    cps_api_get_request_close(&gp);
+    return rc;
+}
+
+TEST(std_nas_route_test, nas_route_v4_v6_concurrent_scale) {
+    std::atomic<uint32_t> failed(0);
+    std::atomic<bool> is_done(false);
+    uint32_t num_gets = 0;
+    uint32_t num_acquired = 0;
+    uint64_t tot_wait = 0;
+    struct timespec start, end;
+    double ms, seq_ms, v4_ms, v6_ms;
+
+    /*
+     * One AF after the other
+     */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    nas_rt_ut_af_routes_cfg(AF_INET, true, &failed);
+    nas_rt_ut_af_routes_cfg(AF_INET6, true, &failed);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seq_ms = nas_rt_ut_time_diff_ms(&start, &end);
+    printf("Sequential: %d IPv4 + %d IPv6 routes in %.2f ms, %.0f routes/sec\n",
+           NAS_RT_AF_SCALE_ROUTES, NAS_RT_AF_SCALE_ROUTES, seq_ms,
+           (2 * NAS_RT_AF_SCALE_ROUTES * 1000.0) / seq_ms);
+
+    nas_rt_ut_af_routes_cfg(AF_INET, false, &failed);
+    nas_rt_ut_af_routes_cfg(AF_INET6, false, &failed);
+    ASSERT_EQ(failed.load(), 0u);
+
+    /*
+     * A thread per AF, with the lock profiler on
+     */
+    ASSERT_TRUE(nas_rt_ut_lock_prof_set(false));
+    ASSERT_TRUE(nas_rt_ut_lock_prof_set(true));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    std::thread v4_thr(nas_rt_ut_af_routes_cfg_timed, AF_INET, true, &failed, &v4_ms);
+    std::thread v6_thr(nas_rt_ut_af_routes_cfg_timed, AF_INET6, true, &failed, &v6_ms);
+    v4_thr.join();
+    v6_thr.join();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ms = nas_rt_ut_time_diff_ms(&start, &end);
+    ASSERT_TRUE(nas_rt_ut_lock_wait_get("Route ingest", &num_acquired, &tot_wait));
+    ASSERT_TRUE(nas_rt_ut_lock_prof_set(false));
+
+    printf("Concurrent IPv4: %d routes in %.2f ms, %.0f routes/sec\n",
+           NAS_RT_AF_SCALE_ROUTES, v4_ms, (NAS_RT_AF_SCALE_ROUTES * 1000.0) / v4_ms);
+    printf("Concurrent IPv6: %d routes in %.2f ms, %.0f routes/sec\n",
+           NAS_RT_AF_SCALE_ROUTES, v6_ms, (NAS_RT_AF_SCALE_ROUTES * 1000.0) / v6_ms);
+    printf("Concurrent: %d IPv4 + %d IPv6 routes in %.2f ms, %.0f routes/sec, "
+           "%.2fx of sequential\n",
+           NAS_RT_AF_SCALE_ROUTES, NAS_RT_AF_SCALE_ROUTES, ms,
+           (2 * NAS_RT_AF_SCALE_ROUTES * 1000.0) / ms, seq_ms / ms);
+    printf("Route ingest L3 lock: %u acquires, %.2f usecs average wait\n",
+           num_acquired, (num_acquired > 0) ? ((double) tot_wait / num_acquired) : 0.0);
+    ASSERT_EQ(failed.load(), 0u);
+
+    /*
+     * The IPv4 routes are read while the IPv6 routes are deleted
+     */
+    std::thread v6_del_thr([&]() {
+        nas_rt_ut_af_routes_cfg(AF_INET6, false, &failed);
+        is_done = true;
+    });
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (!is_done) {
+        if (!nas_rt_ut_af_routes_get(AF_INET))
+            failed++;
+        num_gets++;
+    }
+    v6_del_thr.join();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%d IPv4 route table GETs during the IPv6 delete, %.2f ms\n",
+           num_gets, nas_rt_ut_time_diff_ms(&start, &end));
+
+    nas_rt_ut_af_routes_cfg(AF_INET, false, &failed);
+    ASSERT_EQ(failed.load(), 0u);
+}
+
 void nas_route_dump_arp_object_content(cps_api_object_t obj){
     cps_api_object_it_t it;
     cps_api_object_it_begin(obj,&it);
@@ -734,6 +1541,61 @@ TEST(std_nas_route_test, nas_route_arp_get) {
 
 }
 
+TEST(std_nas_route_test, nas_route_ecmp_grp_pressure_get) {
+    cps_api_get_params_t gp;
+    cps_api_get_request_init(&gp);
+
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append(gp.filters);
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_GRP_PRESSURE_OBJ,0);
+
+    ASSERT_EQ(cps_api_get(&gp), cps_api_ret_code_OK);
+    ASSERT_EQ(cps_api_object_list_size(gp.list), 1);
+
+    obj = cps_api_object_list_get(gp.list,0);
+    cps_api_object_attr_t in_use = cps_api_object_attr_get(obj,
+                                       NAS_RT_ECMP_GRP_PRESSURE_GRPS_IN_USE);
+    cps_api_object_attr_t degraded = cps_api_object_attr_get(obj,
+                                       NAS_RT_ECMP_GRP_PRESSURE_DEGRADED_ROUTES);
+    ASSERT_TRUE(in_use != NULL);
+    ASSERT_TRUE(degraded != NULL);
+    std::cout<<"ECMP groups in use: "<<cps_api_object_attr_data_u32(in_use)
+             <<" Degraded routes: "<<cps_api_object_attr_data_u32(degraded)<<std::endl;
+
+    cps_api_get_request_close(&gp);
+}
+
+TEST(std_nas_route_test, nas_route_ecmp_grp_stats_get) {
+    cps_api_get_params_t gp;
+    cps_api_get_request_init(&gp);
+
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append(gp.filters);
+    cps_api_key_init(cps_api_object_key(obj),cps_api_qualifier_TARGET,
+                     cps_api_obj_CAT_BASE_ROUTE, NAS_RT_STATS_ECMP_GRP_OBJ,0);
+    cps_api_object_attr_add_u32(obj, NAS_RT_ECMP_GRP_STATS_TOP_N, 4);
+
+    ASSERT_EQ(cps_api_get(&gp), cps_api_ret_code_OK);
+
+    size_t mx = cps_api_object_list_size(gp.list);
+    for (size_t ix = 0 ; ix < mx ; ++ix ) {
+        obj = cps_api_object_list_get(gp.list,ix);
+        cps_api_object_attr_t vrf_id = cps_api_object_attr_get(obj,
+                                           NAS_RT_ECMP_GRP_STATS_VRF_ID);
+        cps_api_object_attr_t num_grps = cps_api_object_attr_get(obj,
+                                           NAS_RT_ECMP_GRP_STATS_NUM_GRPS);
+        cps_api_object_attr_t collisions = cps_api_object_attr_get(obj,
+                                           NAS_RT_ECMP_GRP_STATS_COLLISIONS);
+        ASSERT_TRUE(vrf_id != NULL);
+        ASSERT_TRUE(num_grps != NULL);
+        ASSERT_TRUE(collisions != NULL);
+        std::cout<<"VRF: "<<cps_api_object_attr_data_u32(vrf_id)
+                 <<" ECMP groups: "<<cps_api_object_attr_data_u32(num_grps)
+                 <<" MD5 collisions: "<<cps_api_object_attr_data_u32(collisions)<<std::endl;
+    }
+
+    cps_api_get_request_close(&gp);
+}
+
 TEST(std_nas_route_test, nas_peer_routing_config_enable) {
     cps_api_object_t obj = cps_api_object_create();
 
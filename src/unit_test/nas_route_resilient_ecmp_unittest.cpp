@@ -0,0 +1,153 @@
+
+/*
+ * Copyright (c) 2016 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+
+/*
+ * nas_route_resilient_ecmp_unittest.cpp
+ *
+ * Flow disruption benchmark of the resilient ECMP bucket table against
+ * the modulo-N member selection of a regular ECMP group.
+ */
+
+extern "C" {
+#include "hal_rt_mpath_grp.h"
+}
+
+#include <gtest/gtest.h>
+#include <iostream>
+#include <stdint.h>
+
+#define RT_RES_TEST_NUM_FLOWS     100000
+#define RT_RES_TEST_NUM_BUCKETS   64
+#define RT_RES_TEST_NUM_MEMBERS   8
+
+static uint32_t rt_res_test_flow_hash (uint32_t flow)
+{
+    flow ^= flow >> 16;
+    flow *= 0x85ebca6b;
+    flow ^= flow >> 13;
+    flow *= 0xc2b2ae35;
+    flow ^= flow >> 16;
+    return flow;
+}
+
+/* Percentage of the flows that are mapped to a different member */
+static double rt_res_test_bucket_disruption (next_hop_id_t a_old [], next_hop_id_t a_new [],
+                                             int num_buckets)
+{
+    int flow, moved = 0;
+
+    for (flow = 0; flow < RT_RES_TEST_NUM_FLOWS; flow++) {
+        uint32_t bucket = rt_res_test_flow_hash (flow) % num_buckets;
+        if (a_old [bucket] != a_new [bucket])
+            moved++;
+    }
+    return (100.0 * moved) / RT_RES_TEST_NUM_FLOWS;
+}
+
+static double rt_res_test_modulo_disruption (next_hop_id_t a_old [], int old_count,
+                                             next_hop_id_t a_new [], int new_count)
+{
+    int flow, moved = 0;
+
+    for (flow = 0; flow < RT_RES_TEST_NUM_FLOWS; flow++) {
+        uint32_t hash = rt_res_test_flow_hash (flow);
+        if (a_old [hash % old_count] != a_new [hash % new_count])
+            moved++;
+    }
+    return (100.0 * moved) / RT_RES_TEST_NUM_FLOWS;
+}
+
+TEST(std_nas_route_test, nas_route_resilient_ecmp_disruption) {
+
+    next_hop_id_t a_member [RT_RES_TEST_NUM_MEMBERS];
+    next_hop_id_t a_less_member [RT_RES_TEST_NUM_MEMBERS];
+    uint32_t      a_weight [RT_RES_TEST_NUM_MEMBERS];
+    next_hop_id_t a_bucket [RT_RES_TEST_NUM_BUCKETS];
+    next_hop_id_t a_down_bucket [RT_RES_TEST_NUM_BUCKETS];
+    next_hop_id_t a_up_bucket [RT_RES_TEST_NUM_BUCKETS];
+    int           ix, num_less = 0;
+    double        res_down, res_up, mod_down, mod_up;
+    /* Share of the departing member, with some slack for the hash spread */
+    double        max_disruption = (100.0 / RT_RES_TEST_NUM_MEMBERS) + 2.0;
+
+    for (ix = 0; ix < RT_RES_TEST_NUM_MEMBERS; ix++) {
+        a_member [ix] = 100 + ix;
+        a_weight [ix] = 1;
+        if (ix != 3)
+            a_less_member [num_less++] = a_member [ix];
+    }
+
+    hal_rt_fib_form_resilient_buckets (NULL, 0, a_member, a_weight, RT_RES_TEST_NUM_MEMBERS,
+                                       a_bucket, RT_RES_TEST_NUM_BUCKETS);
+    /* Member 3 goes down */
+    hal_rt_fib_form_resilient_buckets (a_bucket, RT_RES_TEST_NUM_BUCKETS, a_less_member,
+                                       a_weight, num_less, a_down_bucket,
+                                       RT_RES_TEST_NUM_BUCKETS);
+    /* And comes back */
+    hal_rt_fib_form_resilient_buckets (a_down_bucket, RT_RES_TEST_NUM_BUCKETS, a_member,
+                                       a_weight, RT_RES_TEST_NUM_MEMBERS, a_up_bucket,
+                                       RT_RES_TEST_NUM_BUCKETS);
+
+    for (ix = 0; ix < RT_RES_TEST_NUM_BUCKETS; ix++) {
+        ASSERT_NE(a_down_bucket [ix], a_member [3]);
+        /* Only the buckets of the departing member move */
+        if (a_bucket [ix] != a_member [3])
+            ASSERT_EQ(a_down_bucket [ix], a_bucket [ix]);
+    }
+
+    res_down = rt_res_test_bucket_disruption (a_bucket, a_down_bucket, RT_RES_TEST_NUM_BUCKETS);
+    res_up   = rt_res_test_bucket_disruption (a_down_bucket, a_up_bucket,
+                                              RT_RES_TEST_NUM_BUCKETS);
+    mod_down = rt_res_test_modulo_disruption (a_member, RT_RES_TEST_NUM_MEMBERS,
+                                              a_less_member, num_less);
+    mod_up   = rt_res_test_modulo_disruption (a_less_member, num_less,
+                                              a_member, RT_RES_TEST_NUM_MEMBERS);
+
+    std::cout << "Flows: " << RT_RES_TEST_NUM_FLOWS << " Buckets: " << RT_RES_TEST_NUM_BUCKETS
+              << " Members: " << RT_RES_TEST_NUM_MEMBERS << std::endl;
+    std::cout << "Member down - resilient: " << res_down << "% modulo-N: "
+              << mod_down << "%" << std::endl;
+    std::cout << "Member up   - resilient: " << res_up << "% modulo-N: "
+              << mod_up << "%" << std::endl;
+
+    ASSERT_LE(res_down, max_disruption);
+    ASSERT_LE(res_up, max_disruption);
+    ASSERT_LT(res_down, mod_down);
+    ASSERT_LT(res_up, mod_up);
+}
+
+TEST(std_nas_route_test, nas_route_resilient_ecmp_weighted_share) {
+
+    next_hop_id_t a_member [2] = {200, 201};
+    uint32_t      a_weight [2] = {3, 1};
+    next_hop_id_t a_bucket [RT_RES_TEST_NUM_BUCKETS];
+    int           ix, count = 0;
+
+    hal_rt_fib_form_resilient_buckets (NULL, 0, a_member, a_weight, 2,
+                                       a_bucket, RT_RES_TEST_NUM_BUCKETS);
+    for (ix = 0; ix < RT_RES_TEST_NUM_BUCKETS; ix++) {
+        if (a_bucket [ix] == a_member [0])
+            count++;
+    }
+    ASSERT_EQ(count, (RT_RES_TEST_NUM_BUCKETS * 3) / 4);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}